@@ -166,6 +166,8 @@ if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
     # On Windows platform Direct3D11 can be optionally chosen
     # Using Direct3D11 on non-MSVC compiler may require copying and renaming Microsoft official libraries (.lib to .a), else link failures or non-functioning graphics may result
     cmake_dependent_option (URHO3D_D3D11 "Use Direct3D11 instead of Direct3D9 (Windows platform only); overrides URHO3D_OPENGL option" FALSE "WIN32" FALSE)
+    # The null graphics backend records API calls without creating a window or GPU device, for headless CPU-side rendering benchmarks
+    option (URHO3D_NULL_GRAPHICS "Use null graphics backend that records API calls without a window or GPU; overrides URHO3D_OPENGL and URHO3D_D3D11 options" FALSE)
     if (MINGW AND CMAKE_CXX_COMPILER_VERSION VERSION_LESS 4.9.1)
         if (NOT DEFINED URHO3D_SSE)     # Only give the warning once during initial configuration
             # Certain MinGW versions fail to compile SSE code. This is the initial guess for known "bad" version range, and can be tightened later
@@ -241,6 +243,8 @@ if (NOT WEB)
     set (THREADING_DEFAULT TRUE)
 endif ()
 option (URHO3D_THREADING "Enable thread support, on Web platform default to 0, on other platforms default to 1" ${THREADING_DEFAULT})
+# Atomic reference counts allow SharedPtr and WeakPtr to be copied and released from worker threads, at the cost of an atomic operation per reference change
+cmake_dependent_option (URHO3D_ATOMIC_REFCOUNT "Use atomic reference counts in RefCounted so that SharedPtr and WeakPtr can be shared between threads (threading only)" FALSE URHO3D_THREADING FALSE)
 if (URHO3D_TESTING)
     if (WEB)
         set (DEFAULT_TIMEOUT 10)
@@ -345,6 +349,12 @@ if (RPI)
     set_property (CACHE RPI_ABI PROPERTY STRINGS ${RPI_SUPPORTED_ABIS})
 endif ()
 # Handle mutually exclusive options and implied options
+if (URHO3D_NULL_GRAPHICS)
+    set (URHO3D_OPENGL 0)
+    unset (URHO3D_OPENGL CACHE)
+    set (URHO3D_D3D11 0)
+    unset (URHO3D_D3D11 CACHE)
+endif ()
 if (URHO3D_D3D11)
     set (URHO3D_OPENGL 0)
     unset (URHO3D_OPENGL CACHE)
@@ -451,7 +461,7 @@ endforeach ()
 if (WIN32 AND NOT CMAKE_PROJECT_NAME MATCHES ^Urho3D-ExternalProject-)
     set (DIRECTX_REQUIRED_COMPONENTS)
     set (DIRECTX_OPTIONAL_COMPONENTS DInput DSound XAudio2 XInput)
-    if (NOT URHO3D_OPENGL)
+    if (NOT URHO3D_OPENGL AND NOT URHO3D_NULL_GRAPHICS)
         if (URHO3D_D3D11)
             list (APPEND DIRECTX_REQUIRED_COMPONENTS D3D11)
         else ()
@@ -19,11 +19,15 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Math.h"
 
+#include <string.h>
+
 b2StackAllocator::b2StackAllocator()
 {
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_entries = m_entryData;
+	m_entryCapacity = b2_maxStackEntries;
 	m_entryCount = 0;
 }
 
@@ -31,11 +35,26 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+
+	if (m_entries != m_entryData)
+	{
+		b2Free(m_entries);
+	}
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
-	b2Assert(m_entryCount < b2_maxStackEntries);
+	if (m_entryCount == m_entryCapacity)
+	{
+		b2StackEntry* oldEntries = m_entries;
+		m_entryCapacity *= 2;
+		m_entries = (b2StackEntry*)b2Alloc(m_entryCapacity * sizeof(b2StackEntry));
+		memcpy(m_entries, oldEntries, m_entryCount * sizeof(b2StackEntry));
+		if (oldEntries != m_entryData)
+		{
+			b2Free(oldEntries);
+		}
+	}
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
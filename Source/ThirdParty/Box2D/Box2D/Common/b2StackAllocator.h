@@ -53,7 +53,10 @@ private:
 	int32 m_allocation;
 	int32 m_maxAllocation;
 
-	b2StackEntry m_entries[b2_maxStackEntries];
+	// Urho3D: the entries grow beyond b2_maxStackEntries when islands are kept allocated for parallel solving
+	b2StackEntry m_entryData[b2_maxStackEntries];
+	b2StackEntry* m_entries;
+	int32 m_entryCapacity;
 	int32 m_entryCount;
 };
 
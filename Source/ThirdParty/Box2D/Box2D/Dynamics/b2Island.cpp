@@ -27,6 +27,8 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Timer.h"
 
+#include <new>
+
 /*
 Position Correction Notes
 =========================
@@ -161,6 +163,8 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_contactSolver = NULL;
+	m_positionSolved = false;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
@@ -172,6 +176,8 @@ b2Island::b2Island(
 
 b2Island::~b2Island()
 {
+	DestroyContactSolver();
+
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
@@ -181,6 +187,17 @@ b2Island::~b2Island()
 }
 
 void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+{
+	SolveInit(profile, step, gravity);
+	SolveConstraints(profile);
+	SolveFinish(allowSleep);
+	DestroyContactSolver();
+}
+
+// Urho3D: the island solve is split in phases so that b2World can solve the constraints of multiple islands in parallel.
+// Only SolveConstraints may run concurrently with other islands, as the other phases access the island indices of
+// static bodies shared between islands, or call the contact listener.
+void b2Island::SolveInit(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity)
 {
 	b2Timer timer;
 
@@ -226,10 +243,9 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	timer.Reset();
 
 	// Solver data
-	b2SolverData solverData;
-	solverData.step = step;
-	solverData.positions = m_positions;
-	solverData.velocities = m_velocities;
+	m_solverData.step = step;
+	m_solverData.positions = m_positions;
+	m_solverData.velocities = m_velocities;
 
 	// Initialize velocity constraints.
 	b2ContactSolverDef contactSolverDef;
@@ -240,35 +256,43 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.velocities = m_velocities;
 	contactSolverDef.allocator = m_allocator;
 
-	b2ContactSolver contactSolver(&contactSolverDef);
-	contactSolver.InitializeVelocityConstraints();
+	void* mem = m_allocator->Allocate(sizeof(b2ContactSolver));
+	m_contactSolver = new (mem) b2ContactSolver(&contactSolverDef);
+	m_contactSolver->InitializeVelocityConstraints();
 
 	if (step.warmStarting)
 	{
-		contactSolver.WarmStart();
+		m_contactSolver->WarmStart();
 	}
 	
 	for (int32 i = 0; i < m_jointCount; ++i)
 	{
-		m_joints[i]->InitVelocityConstraints(solverData);
+		m_joints[i]->InitVelocityConstraints(m_solverData);
 	}
 
 	profile->solveInit = timer.GetMilliseconds();
+}
+
+void b2Island::SolveConstraints(b2Profile* profile)
+{
+	b2Timer timer;
+
+	const b2TimeStep& step = m_solverData.step;
+	float32 h = step.dt;
 
 	// Solve velocity constraints
-	timer.Reset();
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
 		for (int32 j = 0; j < m_jointCount; ++j)
 		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
+			m_joints[j]->SolveVelocityConstraints(m_solverData);
 		}
 
-		contactSolver.SolveVelocityConstraints();
+		m_contactSolver->SolveVelocityConstraints();
 	}
 
 	// Store impulses for warm starting
-	contactSolver.StoreImpulses();
+	m_contactSolver->StoreImpulses();
 	profile->solveVelocity = timer.GetMilliseconds();
 
 	// Integrate positions
@@ -306,22 +330,22 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	// Solve position constraints
 	timer.Reset();
-	bool positionSolved = false;
+	m_positionSolved = false;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
-		bool contactsOkay = contactSolver.SolvePositionConstraints();
+		bool contactsOkay = m_contactSolver->SolvePositionConstraints();
 
 		bool jointsOkay = true;
 		for (int32 j = 0; j < m_jointCount; ++j)
 		{
-			bool jointOkay = m_joints[j]->SolvePositionConstraints(solverData);
+			bool jointOkay = m_joints[j]->SolvePositionConstraints(m_solverData);
 			jointsOkay = jointsOkay && jointOkay;
 		}
 
 		if (contactsOkay && jointsOkay)
 		{
 			// Exit early if the position errors are small.
-			positionSolved = true;
+			m_positionSolved = true;
 			break;
 		}
 	}
@@ -330,6 +354,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
+		// Urho3D: static bodies do not move, and may be shared with islands being solved concurrently
+		if (body->m_type == b2_staticBody)
+		{
+			continue;
+		}
 		body->m_sweep.c = m_positions[i].c;
 		body->m_sweep.a = m_positions[i].a;
 		body->m_linearVelocity = m_velocities[i].v;
@@ -338,8 +367,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
+}
 
-	Report(contactSolver.m_velocityConstraints);
+void b2Island::SolveFinish(bool allowSleep)
+{
+	Report(m_contactSolver->m_velocityConstraints);
 
 	if (allowSleep)
 	{
@@ -365,12 +397,12 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			}
 			else
 			{
-				b->m_sleepTime += h;
+				b->m_sleepTime += m_solverData.step.dt;
 				minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
 			}
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		if (minSleepTime >= b2_timeToSleep && m_positionSolved)
 		{
 			for (int32 i = 0; i < m_bodyCount; ++i)
 			{
@@ -381,6 +413,16 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 }
 
+void b2Island::DestroyContactSolver()
+{
+	if (m_contactSolver)
+	{
+		m_contactSolver->~b2ContactSolver();
+		m_allocator->Free(m_contactSolver);
+		m_contactSolver = NULL;
+	}
+}
+
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
 {
 	b2Assert(toiIndexA < m_bodyCount);
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactSolver;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -47,6 +48,12 @@ public:
 
 	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
 
+	// Urho3D: phases of Solve. Only SolveConstraints is safe to run concurrently for different islands.
+	void SolveInit(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity);
+	void SolveConstraints(b2Profile* profile);
+	void SolveFinish(bool allowSleep);
+	void DestroyContactSolver();
+
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
 	void Add(b2Body* body)
@@ -81,6 +88,10 @@ public:
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	b2ContactSolver* m_contactSolver;
+	b2SolverData m_solverData;
+	bool m_positionSolved;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
@@ -38,6 +38,7 @@ b2World::b2World(const b2Vec2& gravity)
 {
 	m_destructionListener = NULL;
 	g_debugDraw = NULL;
+	m_taskExecutor = NULL;
 
 	m_bodyList = NULL;
 	m_jointList = NULL;
@@ -99,6 +100,11 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+	m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	g_debugDraw = debugDraw;
@@ -382,6 +388,22 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
+// Urho3D: solves the constraints of islands in parallel.
+class b2IslandSolveTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end)
+	{
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_islands[i]->SolveConstraints(&m_profiles[i]);
+		}
+	}
+
+	b2Island** m_islands;
+	b2Profile* m_profiles;
+};
+
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
@@ -413,6 +435,15 @@ void b2World::Solve(const b2TimeStep& step)
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+
+	// Urho3D: when solving in parallel, islands are kept until all of them have been built. There can be at most
+	// one island per body.
+	b2Island** islands = NULL;
+	int32 islandCount = 0;
+	if (m_taskExecutor)
+	{
+		islands = (b2Island**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Island*));
+	}
 	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
 	{
 		if (seed->m_flags & b2Body::e_islandFlag)
@@ -527,11 +558,39 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		if (islands)
+		{
+			// Copy to an island of the exact size. The initialization accesses the island indices of static bodies,
+			// so it has to be done before building the next island.
+			void* mem = m_stackAllocator.Allocate(sizeof(b2Island));
+			b2Island* solveIsland = new (mem) b2Island(island.m_bodyCount, island.m_contactCount, island.m_jointCount,
+				&m_stackAllocator, m_contactManager.m_contactListener);
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				solveIsland->Add(island.m_bodies[i]);
+			}
+			for (int32 i = 0; i < island.m_contactCount; ++i)
+			{
+				solveIsland->Add(island.m_contacts[i]);
+			}
+			for (int32 i = 0; i < island.m_jointCount; ++i)
+			{
+				solveIsland->Add(island.m_joints[i]);
+			}
+
+			b2Profile profile;
+			solveIsland->SolveInit(&profile, step, m_gravity);
+			m_profile.solveInit += profile.solveInit;
+			islands[islandCount++] = solveIsland;
+		}
+		else
+		{
+			b2Profile profile;
+			island.Solve(&profile, step, m_gravity, m_allowSleep);
+			m_profile.solveInit += profile.solveInit;
+			m_profile.solveVelocity += profile.solveVelocity;
+			m_profile.solvePosition += profile.solvePosition;
+		}
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -545,6 +604,42 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 	}
 
+	if (islands)
+	{
+		b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(b2Max(islandCount, 1) * sizeof(b2Profile));
+
+		b2IslandSolveTask task;
+		task.m_islands = islands;
+		task.m_profiles = profiles;
+		if (islandCount > 1)
+		{
+			m_taskExecutor->ParallelFor(&task, islandCount);
+		}
+		else
+		{
+			task.Execute(0, islandCount);
+		}
+
+		// Report contacts and put bodies to sleep in the same order as the serial solve
+		for (int32 i = 0; i < islandCount; ++i)
+		{
+			m_profile.solveVelocity += profiles[i].solveVelocity;
+			m_profile.solvePosition += profiles[i].solvePosition;
+			islands[i]->SolveFinish(m_allowSleep);
+		}
+
+		m_stackAllocator.Free(profiles);
+
+		// Free the islands in reverse order of allocation
+		for (int32 i = islandCount - 1; i >= 0; --i)
+		{
+			islands[i]->~b2Island();
+			m_stackAllocator.Free(islands[i]);
+		}
+
+		m_stackAllocator.Free(islands);
+	}
+
 	m_stackAllocator.Free(stack);
 
 	{
@@ -66,6 +66,11 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Urho3D: register an executor to solve the constraints of independent islands in parallel.
+	/// The contact listener is still called from the thread stepping the world. The executor is
+	/// owned by you and must remain in scope. Null (default) solves the islands serially.
+	void SetTaskExecutor(b2TaskExecutor* executor);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -248,6 +253,7 @@ private:
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* g_debugDraw;
+	b2TaskExecutor* m_taskExecutor;
 
 	// This is used to compute the time step ratio to
 	// support a variable time step.
@@ -152,4 +152,25 @@ public:
 									const b2Vec2& normal, float32 fraction) = 0;
 };
 
+/// Urho3D: a task executed in index ranges by b2TaskExecutor.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Execute the items in [begin, end). Called concurrently for disjoint ranges.
+	virtual void Execute(int32 begin, int32 end) = 0;
+};
+
+/// Urho3D: implement this class to solve the islands of a world step on multiple threads.
+/// See b2World::SetTaskExecutor
+class b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// Execute the task for all items in [0, count) and return once they have completed.
+	virtual void ParallelFor(b2Task* task, int32 count) = 0;
+};
+
 #endif
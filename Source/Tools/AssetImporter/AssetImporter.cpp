@@ -23,6 +23,7 @@
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/ProcessUtils.h>
 #include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/Graphics/AnimatedModel.h>
 #include <Urho3D/Graphics/Animation.h>
@@ -49,11 +50,14 @@
 #endif
 
 #include <assimp/config.h>
+#include <assimp/cfileio.h>
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/DefaultLogger.hpp>
 
+#include "MeshOptimizer.h"
+
 #include <Urho3D/DebugNew.h>
 
 using namespace Urho3D;
@@ -91,6 +95,25 @@ struct OutScene
     PODVector<unsigned> nodeModelIndices_;
 };
 
+struct BatchJob
+{
+    BatchJob() :
+        hash_(0),
+        exitCode_(0),
+        skipped_(false)
+    {
+    }
+
+    String commandLine_;
+    Vector<String> arguments_;
+    Vector<String> inputFiles_;
+    String outputFile_;
+    String inputListFile_;
+    unsigned hash_;
+    int exitCode_;
+    bool skipped_;
+};
+
 // FBX transform chain
 enum TransformationComp
 {
@@ -142,6 +165,7 @@ const char *transformSuffix[TransformationComp_MAXIMUM] =
 };
 
 static const unsigned MAX_CHANNELS = 4;
+static const float OVERDRAW_THRESHOLD = 1.05f;
 
 SharedPtr<Context> context_(new Context());
 const aiScene* scene_ = nullptr;
@@ -171,6 +195,13 @@ bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
 bool moveToBindPose_ = false;
 unsigned maxBones_ = 64;
+unsigned numGeneratedLods_ = 0;
+float generatedLodRatio_ = 0.5f;
+float generatedLodDistance_ = 20.0f;
+float generatedLodMaxError_ = 0.05f;
+bool optimizeVertexCache_ = false;
+bool optimizeOverdraw_ = false;
+bool optimizeVertexFetch_ = false;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
 
@@ -183,8 +214,26 @@ float importStartTime_ = 0.0f;
 float importEndTime_ = 0.0f;
 bool suppressFbxPivotNodes_ = true;
 
+// For batch mode
+unsigned batchThreads_ = 0;
+bool batchForce_ = false;
+String importerExecutable_;
+unsigned importerModifiedTime_ = 0;
+HashMap<String, unsigned> batchCache_;
+HashMap<String, Vector<String> > batchCacheInputs_;
+String batchInputListFile_;
+Vector<String> importedFiles_;
+Mutex batchMutex_;
+unsigned batchNumFinished_ = 0;
+
 int main(int argc, char** argv);
 void Run(const Vector<String>& arguments);
+void RunBatch(const Vector<String>& arguments);
+void RunBatchJob(const WorkItem* item, unsigned threadIndex);
+unsigned GetBatchJobHash(const BatchJob& job);
+aiFile* OpenImportFile(aiFileIO* fileIO, const char* fileName, const char* mode);
+void CloseImportFile(aiFileIO* fileIO, aiFile* file);
+void AddImportedFile(const String& fileName);
 void DumpNodes(aiNode* rootNode, unsigned level);
 
 void ExportModel(const String& outName, bool animationOnly);
@@ -222,9 +271,9 @@ String GetMaterialTextureName(const String& nameIn);
 String GenerateMaterialName(aiMaterial* material);
 String GenerateTextureName(unsigned texIndex);
 unsigned GetNumValidFaces(aiMesh* mesh);
+void BuildGeometryIndices(aiMesh* mesh, unsigned geomIndex, Vector<PODVector<unsigned> >& lodIndices,
+    PODVector<unsigned>& vertexOrder);
 
-void WriteShortIndices(unsigned short*& dest, aiMesh* mesh, unsigned index, unsigned offset);
-void WriteLargeIndices(unsigned*& dest, aiMesh* mesh, unsigned index, unsigned offset);
 void WriteVertex(float*& dest, aiMesh* mesh, unsigned index, bool isSkinned, BoundingBox& box,
     const Matrix3x4& vertexTransform, const Matrix3& normalTransform, Vector<PODVector<unsigned char> >& blendIndices,
     Vector<PODVector<float> >& blendWeights);
@@ -277,6 +326,9 @@ void Run(const Vector<String>& arguments)
             "dump        Dump scene node structure. No output file is generated\n"
             "lod         Combine several Urho3D models as LOD levels of the output model\n"
             "            Syntax: lod <dist0> <mdl0> <dist1 <mdl1> ... <output file>\n"
+            "batch       Run the commands listed in a manifest file in parallel, one command\n"
+            "            per line. Options given after the manifest are added to each command\n"
+            "            Syntax: batch <manifest file> [options]\n"
             "\n"
             "Options:\n"
             "-b          Save scene in binary format, default format is XML\n"
@@ -313,6 +365,17 @@ void Run(const Vector<String>& arguments)
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-lod <n>    Generate n simplified LOD levels for each geometry\n"
+            "-lr <ratio> Triangle count ratio between generated LOD levels. Default 0.5\n"
+            "-ld <dist>  Generated LOD level n is used from distance n * dist. Default 20\n"
+            "-le <error> Maximum simplification error relative to geometry size. Default 0.05\n"
+            "-oc         Optimize triangle order for the post-transform vertex cache\n"
+            "-od         Optimize triangle order for the vertex cache and overdraw\n"
+            "-of         Optimize vertex order for vertex fetch\n"
+            "-bt <n>     Number of parallel batch jobs. Default is the number of CPU cores\n"
+            "-bf         Run all batch jobs, even if their input files have not changed\n"
+            "-bi <file>  Write the names of all files read during import to a file. Used by\n"
+            "            batch mode to detect changes also in files referenced by the input\n"
         );
     }
 
@@ -463,6 +526,44 @@ void Run(const Vector<String>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "lod" && !value.Empty())
+            {
+                numGeneratedLods_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "lr" && !value.Empty())
+            {
+                generatedLodRatio_ = Clamp(ToFloat(value), 0.0f, 1.0f);
+                ++i;
+            }
+            else if (argument == "ld" && !value.Empty())
+            {
+                generatedLodDistance_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
+            else if (argument == "le" && !value.Empty())
+            {
+                generatedLodMaxError_ = Max(ToFloat(value), 0.0f);
+                ++i;
+            }
+            else if (argument == "oc")
+                optimizeVertexCache_ = true;
+            else if (argument == "od")
+                optimizeOverdraw_ = true;
+            else if (argument == "of")
+                optimizeVertexFetch_ = true;
+            else if (argument == "bt" && !value.Empty())
+            {
+                batchThreads_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "bf")
+                batchForce_ = true;
+            else if (argument == "bi" && !value.Empty())
+            {
+                batchInputListFile_ = value;
+                ++i;
+            }
             else if (argument == "split")
             {
                 String value2 = i + 2 < arguments.Size() ? arguments[i + 2] : String::EMPTY;
@@ -475,7 +576,9 @@ void Run(const Vector<String>& arguments)
         }
     }
 
-    if (command == "model" || command == "scene" || command == "anim" || command == "node" || command == "dump")
+    if (command == "batch")
+        RunBatch(arguments);
+    else if (command == "model" || command == "scene" || command == "anim" || command == "node" || command == "dump")
     {
         String inFile = arguments[1];
         String outFile;
@@ -512,6 +615,13 @@ void Run(const Vector<String>& arguments)
         if (!inFile.EndsWith(".fbx", false))
             suppressFbxPivotNodes_ = false;
 
+        // When run from a batch, record the files Assimp opens, such as material libraries and external buffers
+        aiFileIO fileIO;
+        fileIO.OpenProc = OpenImportFile;
+        fileIO.CloseProc = CloseImportFile;
+        fileIO.UserData = nullptr;
+        aiFileIO* importFileIO = batchInputListFile_.Empty() ? nullptr : &fileIO;
+
         // Only do this for the "model" command. "anim" command extrapolates animation from the original bone definition
         if (suppressFbxPivotNodes_ && command == "model")
         {
@@ -527,13 +637,13 @@ void Run(const Vector<String>& arguments)
             aiSetImportPropertyInteger(aiprops, AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, 0);                //**false, default = true;
             aiSetImportPropertyInteger(aiprops, AI_CONFIG_IMPORT_FBX_OPTIMIZE_EMPTY_ANIMATION_CURVES, 1);//default = true;
 
-            scene_ = aiImportFileExWithProperties(GetNativePath(inFile).CString(), flags, nullptr, aiprops);
+            scene_ = aiImportFileExWithProperties(GetNativePath(inFile).CString(), flags, importFileIO, aiprops);
 
             // prevent processing animation suppression, both cannot work simultaneously
             suppressFbxPivotNodes_ = false;
         }
         else
-            scene_ = aiImportFile(GetNativePath(inFile).CString(), flags);
+            scene_ = aiImportFileEx(GetNativePath(inFile).CString(), flags, importFileIO);
 
         if (!scene_)
             ErrorExit("Could not open or parse input file " + inFile + ": " + String(aiGetErrorString()));
@@ -579,6 +689,15 @@ void Run(const Vector<String>& arguments)
             if (!noTextures_)
                 CopyTextures(usedTextures, GetPath(inFile));
         }
+
+        if (!batchInputListFile_.Empty())
+        {
+            File inputList(context_);
+            if (!inputList.Open(batchInputListFile_, FILE_WRITE))
+                ErrorExit("Could not open input list " + batchInputListFile_ + " for writing");
+            for (unsigned i = 0; i < importedFiles_.Size(); ++i)
+                inputList.WriteLine(importedFiles_[i]);
+        }
     }
     else if (command == "lod")
     {
@@ -623,6 +742,358 @@ void Run(const Vector<String>& arguments)
         ErrorExit("Unrecognized command " + command);
 }
 
+void RunBatch(const Vector<String>& arguments)
+{
+    const String& manifestName = arguments[1];
+    String cacheName = manifestName + ".cache";
+    auto* fileSystem = context_->GetSubsystem<FileSystem>();
+
+    // Pass the other options on to each job, except the ones that control the batch itself
+    Vector<String> commonArguments;
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        String argument = arguments[i].ToLower();
+        if (argument == "-bt")
+            ++i;
+        else if (argument != "-bf")
+            commonArguments.Push(arguments[i]);
+    }
+
+    File manifest(context_);
+    if (!manifest.Open(manifestName))
+        ErrorExit("Could not open batch manifest " + manifestName);
+
+    Vector<BatchJob> jobs;
+    while (!manifest.IsEof())
+    {
+        String line = manifest.ReadLine().Trimmed();
+        if (line.Empty() || line[0] == '#')
+            continue;
+
+        BatchJob job;
+        job.arguments_ = ParseArguments(line, false);
+        job.arguments_.Push(commonArguments);
+        job.commandLine_ = String::Joined(job.arguments_, " ");
+
+        String command = job.arguments_[0].ToLower();
+        if (job.arguments_.Size() < 2 || command == "batch")
+            ErrorExit("Invalid batch command " + line);
+
+        // The input files of the lod command are the models between the LOD distances
+        if (command == "lod")
+        {
+            unsigned numLodArguments = 0;
+            for (unsigned i = 1; i < job.arguments_.Size() && job.arguments_[i][0] != '-'; ++i)
+                ++numLodArguments;
+            for (unsigned i = 2; i < numLodArguments; i += 2)
+                job.inputFiles_.Push(job.arguments_[i]);
+            job.outputFile_ = job.arguments_[numLodArguments];
+        }
+        else
+        {
+            job.inputFiles_.Push(job.arguments_[1]);
+            if (command != "dump" && job.arguments_.Size() > 2 && job.arguments_[2][0] != '-')
+                job.outputFile_ = job.arguments_[2];
+
+            // Have the job list the other files it reads, so that changes in them are detected on the next run
+            if (!job.outputFile_.Empty())
+            {
+                job.inputListFile_ = cacheName + "." + String(jobs.Size()) + ".inputs";
+                job.arguments_.Push("-bi");
+                job.arguments_.Push(job.inputListFile_);
+            }
+        }
+
+#ifdef _WIN32
+        // The arguments are joined to a single command line for the child process, so quote the ones with spaces
+        for (unsigned i = 0; i < job.arguments_.Size(); ++i)
+        {
+            if (job.arguments_[i].Contains(' '))
+                job.arguments_[i] = "\"" + job.arguments_[i] + "\"";
+        }
+#endif
+
+        jobs.Push(job);
+    }
+    manifest.Close();
+
+    if (jobs.Empty())
+        ErrorExit("No commands in batch manifest " + manifestName);
+
+    // Load the input hashes of the previous run. Jobs whose inputs still hash the same are skipped. Each command is
+    // followed by the other files it read, indented with a tab
+    if (!batchForce_ && fileSystem->FileExists(cacheName))
+    {
+        File cacheFile(context_);
+        if (cacheFile.Open(cacheName))
+        {
+            String commandLine;
+            while (!cacheFile.IsEof())
+            {
+                String line = cacheFile.ReadLine();
+                if (line.StartsWith("\t"))
+                {
+                    if (!commandLine.Empty())
+                        batchCacheInputs_[commandLine].Push(line.Substring(1));
+                    continue;
+                }
+
+                unsigned separator = line.Find(' ');
+                if (separator != String::NPOS)
+                {
+                    commandLine = line.Substring(separator + 1);
+                    batchCache_[commandLine] = ToUInt(line.Substring(0, separator), 16);
+                }
+            }
+        }
+
+        for (unsigned i = 0; i < jobs.Size(); ++i)
+        {
+            HashMap<String, Vector<String> >::ConstIterator j = batchCacheInputs_.Find(jobs[i].commandLine_);
+            if (j != batchCacheInputs_.End())
+                jobs[i].inputFiles_.Push(j->second_);
+        }
+    }
+
+    // Rebuilding the importer invalidates its previous output, so seed the hashes with its modification time
+#ifdef _WIN32
+    importerExecutable_ = fileSystem->GetProgramDir() + "AssetImporter.exe";
+#else
+    importerExecutable_ = fileSystem->GetProgramDir() + "AssetImporter";
+#endif
+    importerModifiedTime_ = fileSystem->GetLastModifiedTime(importerExecutable_);
+
+    unsigned numThreads = batchThreads_ ? batchThreads_ : GetNumLogicalCPUs();
+    PrintLine("Running " + String(jobs.Size()) + " batch jobs using " + String(numThreads) + " threads");
+
+    Timer batchTimer;
+    auto* queue = context_->GetSubsystem<WorkQueue>();
+    queue->CreateThreads(numThreads);
+
+    // The lod commands combine models output by the other commands, so run them in a second pass
+    unsigned numSubmitted = 0;
+    for (unsigned pass = 0; pass < 2; ++pass)
+    {
+        for (unsigned i = 0; i < jobs.Size(); ++i)
+        {
+            if ((jobs[i].arguments_[0].ToLower() == "lod") != (pass == 1))
+                continue;
+
+            // Start the jobs with the largest input first to finish the whole batch sooner
+            File input(context_);
+            unsigned inputSize = fileSystem->FileExists(jobs[i].inputFiles_[0]) && input.Open(jobs[i].inputFiles_[0]) ?
+                input.GetSize() : 0;
+            input.Close();
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->workFunction_ = RunBatchJob;
+            item->start_ = &jobs[i];
+            item->priority_ = inputSize;
+            queue->AddWorkItem(item);
+            ++numSubmitted;
+        }
+
+        // The jobs spend their time waiting for the child processes, so sleep instead of working on the queue.
+        // Without worker threads the jobs are run in the main thread when completing
+        while (queue->GetNumThreads())
+        {
+            {
+                MutexLock lock(batchMutex_);
+                if (batchNumFinished_ == numSubmitted)
+                    break;
+            }
+            Time::Sleep(10);
+        }
+        queue->Complete(0);
+    }
+
+    unsigned numConverted = 0;
+    unsigned numSkipped = 0;
+    unsigned numFailed = 0;
+    String cacheData;
+    for (unsigned i = 0; i < jobs.Size(); ++i)
+    {
+        const BatchJob& job = jobs[i];
+        if (job.exitCode_)
+        {
+            ++numFailed;
+            continue;
+        }
+
+        if (job.skipped_)
+            ++numSkipped;
+        else
+            ++numConverted;
+        if (job.hash_)
+        {
+            cacheData += ToStringHex(job.hash_) + " " + job.commandLine_ + "\n";
+            if (!job.inputListFile_.Empty())
+            {
+                for (unsigned j = 1; j < job.inputFiles_.Size(); ++j)
+                    cacheData += "\t" + job.inputFiles_[j] + "\n";
+            }
+        }
+    }
+
+    File cacheFile(context_);
+    if (!cacheFile.Open(cacheName, FILE_WRITE))
+        ErrorExit("Could not open batch cache " + cacheName + " for writing");
+    cacheFile.Write(cacheData.CString(), cacheData.Length());
+    cacheFile.Close();
+
+    PrintLine(ToString("Batch finished in %u ms: %u converted, %u unchanged, %u failed",
+        batchTimer.GetMSec(false), numConverted, numSkipped, numFailed));
+
+    if (numFailed)
+        ErrorExit(String(numFailed) + " batch jobs failed");
+}
+
+void RunBatchJob(const WorkItem* item, unsigned threadIndex)
+{
+    BatchJob& job = *reinterpret_cast<BatchJob*>(item->start_);
+    auto* fileSystem = context_->GetSubsystem<FileSystem>();
+    Timer jobTimer;
+
+    job.hash_ = GetBatchJobHash(job);
+    HashMap<String, unsigned>::ConstIterator i = batchCache_.Find(job.commandLine_);
+    if (job.hash_ && i != batchCache_.End() && i->second_ == job.hash_ && !job.outputFile_.Empty() &&
+        fileSystem->FileExists(job.outputFile_))
+        job.skipped_ = true;
+    else
+    {
+        job.exitCode_ = fileSystem->SystemRun(importerExecutable_, job.arguments_);
+
+        // Replace the input files of the previous run with the ones actually read, and hash them for the next run
+        if (!job.inputListFile_.Empty())
+        {
+            File inputList(context_);
+            if (!job.exitCode_ && fileSystem->FileExists(job.inputListFile_) && inputList.Open(job.inputListFile_))
+            {
+                job.inputFiles_.Resize(1);
+                while (!inputList.IsEof())
+                {
+                    String fileName = inputList.ReadLine();
+                    if (!fileName.Empty() && !job.inputFiles_.Contains(fileName))
+                        job.inputFiles_.Push(fileName);
+                }
+                inputList.Close();
+                job.hash_ = GetBatchJobHash(job);
+            }
+            fileSystem->Delete(job.inputListFile_);
+        }
+    }
+
+    const char* status = job.exitCode_ ? "failed" : (job.skipped_ ? "unchanged" : "converted");
+    unsigned jobTime = jobTimer.GetMSec(false);
+
+    MutexLock lock(batchMutex_);
+    ++batchNumFinished_;
+    PrintLine(ToString("[%u] %s in %u ms: ", batchNumFinished_, status, jobTime) + job.commandLine_);
+}
+
+unsigned GetBatchJobHash(const BatchJob& job)
+{
+    unsigned hash = importerModifiedTime_;
+    for (unsigned i = 0; i < job.commandLine_.Length(); ++i)
+        hash = SDBMHash(hash, (unsigned char)job.commandLine_[i]);
+
+    unsigned char buffer[65536];
+    for (unsigned i = 0; i < job.inputFiles_.Size(); ++i)
+    {
+        File file(context_);
+        // A missing input can not be hashed. Return zero so that the job is always run
+        if (!file.Open(job.inputFiles_[i]))
+            return 0;
+
+        while (!file.IsEof())
+        {
+            unsigned numBytes = file.Read(buffer, sizeof buffer);
+            if (!numBytes)
+                return 0;
+            for (unsigned j = 0; j < numBytes; ++j)
+                hash = SDBMHash(hash, buffer[j]);
+        }
+    }
+
+    return hash;
+}
+
+static size_t ReadImportFile(aiFile* file, char* buffer, size_t size, size_t count)
+{
+    auto* source = reinterpret_cast<File*>(file->UserData);
+    return size ? source->Read(buffer, (unsigned)(size * count)) / size : 0;
+}
+
+static size_t WriteImportFile(aiFile* file, const char* buffer, size_t size, size_t count)
+{
+    return 0;
+}
+
+static size_t TellImportFile(aiFile* file)
+{
+    return reinterpret_cast<File*>(file->UserData)->GetPosition();
+}
+
+static size_t GetImportFileSize(aiFile* file)
+{
+    return reinterpret_cast<File*>(file->UserData)->GetSize();
+}
+
+static aiReturn SeekImportFile(aiFile* file, size_t offset, aiOrigin origin)
+{
+    auto* source = reinterpret_cast<File*>(file->UserData);
+    // Backward seeks pass a wrapped around offset, which the unsigned addition undoes
+    unsigned position = (unsigned)offset;
+    if (origin == aiOrigin_CUR)
+        position += source->GetPosition();
+    else if (origin == aiOrigin_END)
+        position += source->GetSize();
+    return source->Seek(position) == position ? aiReturn_SUCCESS : aiReturn_FAILURE;
+}
+
+static void FlushImportFile(aiFile* file)
+{
+}
+
+aiFile* OpenImportFile(aiFileIO* fileIO, const char* fileName, const char* mode)
+{
+    // Importing only reads files
+    if (strchr(mode, 'w') || strchr(mode, 'a'))
+        return nullptr;
+
+    SharedPtr<File> source(new File(context_));
+    if (!source->Open(fileName))
+        return nullptr;
+    AddImportedFile(fileName);
+
+    auto* file = new aiFile();
+    file->ReadProc = ReadImportFile;
+    file->WriteProc = WriteImportFile;
+    file->TellProc = TellImportFile;
+    file->FileSizeProc = GetImportFileSize;
+    file->SeekProc = SeekImportFile;
+    file->FlushProc = FlushImportFile;
+    file->UserData = reinterpret_cast<aiUserData>(source.Get());
+    source->AddRef();
+    return file;
+}
+
+void CloseImportFile(aiFileIO* fileIO, aiFile* file)
+{
+    if (!file)
+        return;
+
+    reinterpret_cast<File*>(file->UserData)->ReleaseRef();
+    delete file;
+}
+
+void AddImportedFile(const String& fileName)
+{
+    String internalName = GetInternalPath(fileName);
+    if (!importedFiles_.Contains(internalName))
+        importedFiles_.Push(internalName);
+}
+
 void DumpNodes(aiNode* rootNode, unsigned level)
 {
     if (!rootNode)
@@ -1012,6 +1483,20 @@ void BuildAndSaveModel(OutModel& model)
 
     unsigned numValidGeometries = 0;
 
+    // Build the index data of each geometry and its LOD levels in advance, as the buffer sizes depend on them
+    Vector<Vector<PODVector<unsigned> > > allLodIndices(model.meshes_.Size());
+    Vector<PODVector<unsigned> > allVertexOrders(model.meshes_.Size());
+    unsigned totalIndices = 0;
+    for (unsigned i = 0; i < model.meshes_.Size(); ++i)
+    {
+        if (GetNumValidFaces(model.meshes_[i]))
+        {
+            BuildGeometryIndices(model.meshes_[i], i, allLodIndices[i], allVertexOrders[i]);
+            for (unsigned j = 0; j < allLodIndices[i].Size(); ++j)
+                totalIndices += allLodIndices[i][j].Size();
+        }
+    }
+
     bool combineBuffers = true;
     // Check if buffers can be combined (same vertex elements, under 65535 vertices)
     PODVector<VertexElement> elements = GetVertexElements(model.meshes_[0], model.bones_.Size() > 0);
@@ -1060,6 +1545,12 @@ void BuildAndSaveModel(OutModel& model)
         if (!validFaces)
             continue;
 
+        const Vector<PODVector<unsigned> >& lodIndices = allLodIndices[i];
+        const PODVector<unsigned>& vertexOrder = allVertexOrders[i];
+        unsigned numIndices = 0;
+        for (unsigned j = 0; j < lodIndices.Size(); ++j)
+            numIndices += lodIndices[j].Size();
+
         bool largeIndices;
         if (combineBuffers)
             largeIndices = model.totalIndices_ > 65535;
@@ -1074,12 +1565,12 @@ void BuildAndSaveModel(OutModel& model)
 
             if (combineBuffers)
             {
-                ib->SetSize(model.totalIndices_, largeIndices);
+                ib->SetSize(totalIndices, largeIndices);
                 vb->SetSize(model.totalVertices_, elements);
             }
             else
             {
-                ib->SetSize(validFaces * 3, largeIndices);
+                ib->SetSize(numIndices, largeIndices);
                 vb->SetSize(mesh->mNumVertices, elements);
             }
 
@@ -1098,8 +1589,6 @@ void BuildAndSaveModel(OutModel& model)
         vertexTransform = Matrix3x4(pos, rot, scale);
         normalTransform = rot.RotationMatrix();
 
-        SharedPtr<Geometry> geom(new Geometry(context_));
-
         PrintLine("Writing geometry " + String(i) + " with " + String(mesh->mNumVertices) + " vertices " +
             String(validFaces * 3) + " indices");
 
@@ -1109,20 +1598,6 @@ void BuildAndSaveModel(OutModel& model)
         unsigned char* vertexData = vb->GetShadowData();
         unsigned char* indexData = ib->GetShadowData();
 
-        // Build the index data
-        if (!largeIndices)
-        {
-            unsigned short* dest = (unsigned short*)indexData + startIndexOffset;
-            for (unsigned j = 0; j < mesh->mNumFaces; ++j)
-                WriteShortIndices(dest, mesh, j, startVertexOffset);
-        }
-        else
-        {
-            unsigned* dest = (unsigned*)indexData + startIndexOffset;
-            for (unsigned j = 0; j < mesh->mNumFaces; ++j)
-                WriteLargeIndices(dest, mesh, j, startVertexOffset);
-        }
-
         // Build the vertex data
         // If there are bones, get blend data
         Vector<PODVector<unsigned char> > blendIndices;
@@ -1133,7 +1608,10 @@ void BuildAndSaveModel(OutModel& model)
 
         float* dest = (float*)((unsigned char*)vertexData + startVertexOffset * vb->GetVertexSize());
         for (unsigned j = 0; j < mesh->mNumVertices; ++j)
-            WriteVertex(dest, mesh, j, isSkinned, box, vertexTransform, normalTransform, blendIndices, blendWeights);
+        {
+            WriteVertex(dest, mesh, vertexOrder.Empty() ? j : vertexOrder[j], isSkinned, box, vertexTransform, normalTransform,
+                blendIndices, blendWeights);
+        }
 
         // Calculate the geometry center
         Vector3 center = Vector3::ZERO;
@@ -1152,18 +1630,38 @@ void BuildAndSaveModel(OutModel& model)
             center /= (float)validFaces * 3;
         }
 
-        // Define the geometry
-        geom->SetIndexBuffer(ib);
-        geom->SetVertexBuffer(0, vb);
-        geom->SetDrawRange(TRIANGLE_LIST, startIndexOffset, validFaces * 3, true);
-        outModel->SetNumGeometryLodLevels(destGeomIndex, 1);
-        outModel->SetGeometry(destGeomIndex, 0, geom);
+        // Build the index data and define the geometry LOD levels. The levels share the vertex data
+        outModel->SetNumGeometryLodLevels(destGeomIndex, lodIndices.Size());
+        for (unsigned j = 0; j < lodIndices.Size(); ++j)
+        {
+            const PODVector<unsigned>& indices = lodIndices[j];
+            if (!largeIndices)
+            {
+                unsigned short* indexDest = (unsigned short*)indexData + startIndexOffset;
+                for (unsigned k = 0; k < indices.Size(); ++k)
+                    *indexDest++ = (unsigned short)(indices[k] + startVertexOffset);
+            }
+            else
+            {
+                unsigned* indexDest = (unsigned*)indexData + startIndexOffset;
+                for (unsigned k = 0; k < indices.Size(); ++k)
+                    *indexDest++ = indices[k] + startVertexOffset;
+            }
+
+            SharedPtr<Geometry> geom(new Geometry(context_));
+            geom->SetIndexBuffer(ib);
+            geom->SetVertexBuffer(0, vb);
+            geom->SetDrawRange(TRIANGLE_LIST, startIndexOffset, indices.Size(), true);
+            geom->SetLodDistance(j * generatedLodDistance_);
+            outModel->SetGeometry(destGeomIndex, j, geom);
+            startIndexOffset += indices.Size();
+        }
+
         outModel->SetGeometryCenter(destGeomIndex, center);
         if (model.bones_.Size() > maxBones_)
             allBoneMappings.Push(boneMappings);
 
         startVertexOffset += mesh->mNumVertices;
-        startIndexOffset += validFaces * 3;
         ++destGeomIndex;
     }
 
@@ -2033,6 +2531,7 @@ void CopyTextures(const HashSet<String>& usedTextures, const String& sourcePath)
                     continue;
                 }
             }
+            AddImportedFile(fullSourceName);
 
             bool destExists = fileSystem->FileExists(fullDestName);
             if (destExists && noOverwriteTexture_)
@@ -2407,24 +2906,64 @@ unsigned GetNumValidFaces(aiMesh* mesh)
     return ret;
 }
 
-void WriteShortIndices(unsigned short*& dest, aiMesh* mesh, unsigned index, unsigned offset)
+void BuildGeometryIndices(aiMesh* mesh, unsigned geomIndex, Vector<PODVector<unsigned> >& lodIndices,
+    PODVector<unsigned>& vertexOrder)
 {
-    if (mesh->mFaces[index].mNumIndices == 3)
+    lodIndices.Resize(1);
+    lodIndices[0].Clear();
+    for (unsigned i = 0; i < mesh->mNumFaces; ++i)
     {
-        *dest++ = mesh->mFaces[index].mIndices[0] + offset;
-        *dest++ = mesh->mFaces[index].mIndices[1] + offset;
-        *dest++ = mesh->mFaces[index].mIndices[2] + offset;
+        if (mesh->mFaces[i].mNumIndices == 3)
+        {
+            lodIndices[0].Push(mesh->mFaces[i].mIndices[0]);
+            lodIndices[0].Push(mesh->mFaces[i].mIndices[1]);
+            lodIndices[0].Push(mesh->mFaces[i].mIndices[2]);
+        }
     }
-}
+    vertexOrder.Clear();
 
-void WriteLargeIndices(unsigned*& dest, aiMesh* mesh, unsigned index, unsigned offset)
-{
-    if (mesh->mFaces[index].mNumIndices == 3)
+    if (!numGeneratedLods_ && !optimizeVertexCache_ && !optimizeOverdraw_ && !optimizeVertexFetch_)
+        return;
+
+    PODVector<Vector3> positions(mesh->mNumVertices);
+    for (unsigned i = 0; i < mesh->mNumVertices; ++i)
+        positions[i] = ToVector3(mesh->mVertices[i]);
+
+    // Simplify each level from the full detail geometry, so that the errors do not accumulate
+    for (unsigned i = 1; i <= numGeneratedLods_; ++i)
     {
-        *dest++ = mesh->mFaces[index].mIndices[0] + offset;
-        *dest++ = mesh->mFaces[index].mIndices[1] + offset;
-        *dest++ = mesh->mFaces[index].mIndices[2] + offset;
+        unsigned targetIndexCount = (unsigned)(lodIndices[0].Size() / 3 * powf(generatedLodRatio_, (float)i)) * 3;
+        PODVector<unsigned> indices;
+        float error = SimplifyMesh(indices, lodIndices[0], positions, targetIndexCount, generatedLodMaxError_);
+
+        // Stop when the error limit or the mesh topology prevents further meaningful simplification
+        if (indices.Empty() || (float)indices.Size() > 0.9f * (float)lodIndices.Back().Size())
+        {
+            PrintLine("Geometry " + String(geomIndex) + " can not be simplified further than LOD level " +
+                String(lodIndices.Size() - 1) + " within the error limit");
+            break;
+        }
+
+        PrintLine("Generated geometry " + String(geomIndex) + " LOD level " + String(i) + " with " + String(indices.Size()) +
+            " indices, error " + String(error));
+        lodIndices.Push(indices);
     }
+
+    if (optimizeVertexCache_ || optimizeOverdraw_)
+    {
+        for (unsigned i = 0; i < lodIndices.Size(); ++i)
+        {
+            float oldMissRatio = GetVertexCacheMissRatio(lodIndices[i], mesh->mNumVertices);
+            OptimizeVertexCache(lodIndices[i], mesh->mNumVertices);
+            if (optimizeOverdraw_)
+                OptimizeOverdraw(lodIndices[i], positions, OVERDRAW_THRESHOLD);
+            PrintLine("Optimized geometry " + String(geomIndex) + " LOD level " + String(i) + " vertex cache miss ratio " +
+                String(oldMissRatio) + " -> " + String(GetVertexCacheMissRatio(lodIndices[i], mesh->mNumVertices)));
+        }
+    }
+
+    if (optimizeVertexFetch_)
+        OptimizeVertexFetch(lodIndices, mesh->mNumVertices, vertexOrder);
 }
 
 void WriteVertex(float*& dest, aiMesh* mesh, unsigned index, bool isSkinned, BoundingBox& box,
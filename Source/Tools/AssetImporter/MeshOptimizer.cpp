@@ -0,0 +1,915 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Math/BoundingBox.h>
+#include <Urho3D/Container/Sort.h>
+
+#include "MeshOptimizer.h"
+
+// Overdraw optimization, vertex fetch optimization and mesh simplification based on the meshoptimizer library,
+// modified for Urho3D
+
+/* -----------------------------------------------------------------------------
+
+    Copyright (c) 2016-2017 Arseny Kapoulkine
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use,
+    copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following
+    conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+    OTHER DEALINGS IN THE SOFTWARE.
+
+   -------------------------------------------------------------------------- */
+
+static const unsigned FORSYTH_CACHE_SIZE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+static const unsigned OVERDRAW_CACHE_SIZE = 16;
+static const float SIMPLIFY_EDGE_WEIGHT = 10.0f;
+static const float SIMPLIFY_MIN_NORMAL_COSINE = 0.25f;
+
+/// Vertex classification for simplification.
+enum SimplifyVertexKind
+{
+    /// Interior vertex with a unique position.
+    VK_MANIFOLD = 0,
+    /// Vertex on an open border.
+    VK_BORDER,
+    /// Vertex on a vertex attribute seam, sharing its position with exactly one other vertex.
+    VK_SEAM,
+    /// Vertex that must not move.
+    VK_LOCKED,
+    MAX_VERTEX_KINDS
+};
+
+/// Whether a vertex of the first kind may collapse onto a vertex of the second kind.
+static const bool canCollapse[MAX_VERTEX_KINDS][MAX_VERTEX_KINDS] =
+{
+    {true, true, true, true},
+    {false, true, false, true},
+    {false, false, true, false},
+    {false, false, false, false}
+};
+
+/// Whether an edge between vertices of the given kinds is guaranteed to also exist in the opposite direction in the welded mesh.
+static const bool hasOpposite[MAX_VERTEX_KINDS][MAX_VERTEX_KINDS] =
+{
+    {true, true, true, true},
+    {true, false, true, false},
+    {true, true, true, true},
+    {true, false, true, false}
+};
+
+/// Symmetric quadric error matrix, weighted by area.
+struct SimplifyQuadric
+{
+    /// Construct as zero.
+    SimplifyQuadric() :
+        a00_(0.0f), a11_(0.0f), a22_(0.0f),
+        a10_(0.0f), a20_(0.0f), a21_(0.0f),
+        b0_(0.0f), b1_(0.0f), b2_(0.0f),
+        c_(0.0f),
+        weight_(0.0f)
+    {
+    }
+
+    /// Construct from a plane and a weight.
+    SimplifyQuadric(const Vector3& normal, float d, float weight) :
+        a00_(normal.x_ * normal.x_ * weight), a11_(normal.y_ * normal.y_ * weight), a22_(normal.z_ * normal.z_ * weight),
+        a10_(normal.y_ * normal.x_ * weight), a20_(normal.z_ * normal.x_ * weight), a21_(normal.z_ * normal.y_ * weight),
+        b0_(normal.x_ * d * weight), b1_(normal.y_ * d * weight), b2_(normal.z_ * d * weight),
+        c_(d * d * weight),
+        weight_(weight)
+    {
+    }
+
+    /// Add another quadric.
+    SimplifyQuadric& operator +=(const SimplifyQuadric& rhs)
+    {
+        a00_ += rhs.a00_; a11_ += rhs.a11_; a22_ += rhs.a22_;
+        a10_ += rhs.a10_; a20_ += rhs.a20_; a21_ += rhs.a21_;
+        b0_ += rhs.b0_; b1_ += rhs.b1_; b2_ += rhs.b2_;
+        c_ += rhs.c_;
+        weight_ += rhs.weight_;
+        return *this;
+    }
+
+    /// Return the weighted mean squared distance of a position from the accumulated planes.
+    float GetError(const Vector3& v) const
+    {
+        float rx = a00_ * v.x_ + 2.0f * (a10_ * v.y_ + a20_ * v.z_ + b0_);
+        float ry = a11_ * v.y_ + 2.0f * (a21_ * v.z_ + b1_);
+        float rz = a22_ * v.z_ + 2.0f * b2_;
+        float r = c_ + v.x_ * rx + v.y_ * ry + v.z_ * rz;
+        return weight_ > 0.0f ? Abs(r) / weight_ : 0.0f;
+    }
+
+    float a00_, a11_, a22_;
+    float a10_, a20_, a21_;
+    float b0_, b1_, b2_;
+    float c_;
+    float weight_;
+};
+
+/// Edge collapse candidate.
+struct SimplifyCollapse
+{
+    /// Vertex to remove.
+    unsigned v0_;
+    /// Vertex to collapse onto.
+    unsigned v1_;
+    /// Whether the direction may be swapped.
+    bool bidirectional_;
+    /// Squared error of the collapse.
+    float error_;
+};
+
+/// Triangle corners around each vertex, storing the other two vertices of the triangle in winding order.
+struct EdgeAdjacency
+{
+    PODVector<unsigned> offsets_;
+    PODVector<unsigned> counts_;
+    PODVector<unsigned> next_;
+    PODVector<unsigned> prev_;
+};
+
+/// Less-than comparison of vertices by position, then by index.
+class VertexPositionLess
+{
+public:
+    VertexPositionLess(const Vector3* positions) :
+        positions_(positions)
+    {
+    }
+
+    bool operator ()(unsigned lhs, unsigned rhs) const
+    {
+        const Vector3& a = positions_[lhs];
+        const Vector3& b = positions_[rhs];
+        if (a.x_ != b.x_)
+            return a.x_ < b.x_;
+        if (a.y_ != b.y_)
+            return a.y_ < b.y_;
+        if (a.z_ != b.z_)
+            return a.z_ < b.z_;
+        return lhs < rhs;
+    }
+
+private:
+    const Vector3* positions_;
+};
+
+static float GetForsythVertexScore(int cachePosition, unsigned remainingTriangles)
+{
+    if (!remainingTriangles)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score so that the next triangle does not simply reuse its edge
+        if (cachePosition < 3)
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (float)(FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+    }
+
+    // Favor vertices with few triangles left so that they are finished off instead of leaving lone triangles for later
+    return score + FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+void OptimizeVertexCache(PODVector<unsigned>& indices, unsigned numVertices)
+{
+    unsigned numTriangles = indices.Size() / 3;
+    if (!numTriangles)
+        return;
+
+    // Build the list of triangles using each vertex
+    PODVector<unsigned> remaining(numVertices, 0);
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        ++remaining[indices[i]];
+
+    PODVector<unsigned> offsets(numVertices);
+    unsigned offset = 0;
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        offsets[i] = offset;
+        offset += remaining[i];
+    }
+
+    PODVector<unsigned> vertexTriangles(numTriangles * 3);
+    PODVector<unsigned> fill(offsets);
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        vertexTriangles[fill[indices[i]]++] = i / 3;
+
+    PODVector<int> cachePositions(numVertices, -1);
+    PODVector<float> vertexScores(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        vertexScores[i] = GetForsythVertexScore(-1, remaining[i]);
+
+    PODVector<float> triangleScores(numTriangles);
+    PODVector<unsigned char> emitted(numTriangles, 0);
+    int bestTriangle = 0;
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+        if (triangleScores[i] > triangleScores[bestTriangle])
+            bestTriangle = i;
+    }
+
+    // The simulated LRU cache has room for the vertices pushed out by the latest triangle, so that their scores get updated
+    unsigned cache[FORSYTH_CACHE_SIZE + 3];
+    unsigned newCache[FORSYTH_CACHE_SIZE + 3];
+    unsigned cacheSize = 0;
+    unsigned scanPosition = 0;
+
+    PODVector<unsigned> result;
+    result.Reserve(numTriangles * 3);
+
+    for (unsigned emittedCount = 0; emittedCount < numTriangles; ++emittedCount)
+    {
+        // When no triangle in the cache is left, continue from the next unused triangle in the original order
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanPosition])
+                ++scanPosition;
+            bestTriangle = scanPosition;
+        }
+
+        const unsigned* triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = 1;
+        result.Push(triangle[0]);
+        result.Push(triangle[1]);
+        result.Push(triangle[2]);
+
+        unsigned newCacheSize = 0;
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            unsigned vertex = triangle[i];
+            newCache[newCacheSize++] = vertex;
+
+            // Remove the triangle from the vertex's list of remaining triangles
+            unsigned begin = offsets[vertex];
+            unsigned end = begin + remaining[vertex];
+            for (unsigned j = begin; j < end; ++j)
+            {
+                if (vertexTriangles[j] == (unsigned)bestTriangle)
+                {
+                    vertexTriangles[j] = vertexTriangles[end - 1];
+                    break;
+                }
+            }
+            --remaining[vertex];
+        }
+
+        for (unsigned i = 0; i < cacheSize; ++i)
+        {
+            unsigned vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                newCache[newCacheSize++] = vertex;
+        }
+
+        // Rescore the vertices whose cache position changed, including those that dropped out, and their triangles
+        for (unsigned i = 0; i < newCacheSize; ++i)
+        {
+            unsigned vertex = newCache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+            float score = GetForsythVertexScore(cachePositions[vertex], remaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            for (unsigned j = offsets[vertex]; j < offsets[vertex] + remaining[vertex]; ++j)
+                triangleScores[vertexTriangles[j]] += delta;
+        }
+
+        // Pick the best remaining triangle that uses a cached vertex
+        bestTriangle = -1;
+        float bestScore = -M_INFINITY;
+        cacheSize = Min(newCacheSize, FORSYTH_CACHE_SIZE);
+        for (unsigned i = 0; i < cacheSize; ++i)
+        {
+            unsigned vertex = newCache[i];
+            cache[i] = vertex;
+
+            for (unsigned j = offsets[vertex]; j < offsets[vertex] + remaining[vertex]; ++j)
+            {
+                unsigned candidate = vertexTriangles[j];
+                if (triangleScores[candidate] > bestScore)
+                {
+                    bestScore = triangleScores[candidate];
+                    bestTriangle = candidate;
+                }
+            }
+        }
+    }
+
+    indices.Swap(result);
+}
+
+/// Add a triangle to a simulated FIFO cache and return the number of cache misses.
+static unsigned UpdateFifoCache(const unsigned* triangle, unsigned cacheSize, PODVector<unsigned>& timestamps, unsigned& timestamp)
+{
+    unsigned misses = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        if (timestamp - timestamps[triangle[i]] > cacheSize)
+        {
+            timestamps[triangle[i]] = timestamp++;
+            ++misses;
+        }
+    }
+
+    return misses;
+}
+
+void OptimizeOverdraw(PODVector<unsigned>& indices, const PODVector<Vector3>& positions, float threshold)
+{
+    unsigned numTriangles = indices.Size() / 3;
+    if (!numTriangles)
+        return;
+
+    PODVector<unsigned> timestamps(positions.Size(), 0);
+    unsigned timestamp = OVERDRAW_CACHE_SIZE + 1;
+
+    // A triangle that misses the cache with all its vertices usually starts a new disjoint patch of the mesh. Patches are the
+    // hard cluster boundaries, as reordering them does not affect the vertex cache
+    PODVector<unsigned> hardClusters;
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        if (UpdateFifoCache(&indices[i * 3], OVERDRAW_CACHE_SIZE, timestamps, timestamp) == 3 || !i)
+            hardClusters.Push(i);
+    }
+
+    // Split the patches further whenever the miss ratio from the split point onward is low enough compared to the whole patch
+    PODVector<unsigned> clusters;
+    for (unsigned i = 0; i < hardClusters.Size(); ++i)
+    {
+        unsigned start = hardClusters[i];
+        unsigned end = i + 1 < hardClusters.Size() ? hardClusters[i + 1] : numTriangles;
+
+        timestamp += OVERDRAW_CACHE_SIZE + 1;
+        unsigned misses = 0;
+        for (unsigned j = start; j < end; ++j)
+            misses += UpdateFifoCache(&indices[j * 3], OVERDRAW_CACHE_SIZE, timestamps, timestamp);
+        float clusterThreshold = threshold * (float)misses / (float)(end - start);
+
+        clusters.Push(start);
+        timestamp += OVERDRAW_CACHE_SIZE + 1;
+        unsigned runningMisses = 0;
+        unsigned runningTriangles = 0;
+        for (unsigned j = start; j < end; ++j)
+        {
+            runningMisses += UpdateFifoCache(&indices[j * 3], OVERDRAW_CACHE_SIZE, timestamps, timestamp);
+            ++runningTriangles;
+            if ((float)runningMisses <= clusterThreshold * (float)runningTriangles)
+            {
+                clusters.Push(j + 1);
+                timestamp += OVERDRAW_CACHE_SIZE + 1;
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+
+        // The tail after the last split is usually a few triangles with a bad miss ratio, so merge it into the previous
+        // cluster. This also removes a split that landed exactly on the patch end
+        if (clusters.Back() != start)
+            clusters.Pop();
+    }
+
+    Vector3 meshCentroid = Vector3::ZERO;
+    for (unsigned i = 0; i < numTriangles * 3; ++i)
+        meshCentroid += positions[indices[i]];
+    meshCentroid /= (float)(numTriangles * 3);
+
+    // Sort the clusters by how far their area-weighted centroid lies in front of the mesh centroid along their average
+    // normal. Clusters facing outward on the convex parts of the mesh tend to occlude the rest, so they are drawn first
+    PODVector<Pair<unsigned, unsigned> > order(clusters.Size());
+    PODVector<Pair<unsigned, unsigned> > temp(clusters.Size());
+    for (unsigned i = 0; i < clusters.Size(); ++i)
+    {
+        unsigned start = clusters[i];
+        unsigned end = i + 1 < clusters.Size() ? clusters[i + 1] : numTriangles;
+
+        Vector3 centroid = Vector3::ZERO;
+        Vector3 normal = Vector3::ZERO;
+        float area = 0.0f;
+        for (unsigned j = start; j < end; ++j)
+        {
+            const Vector3& v0 = positions[indices[j * 3]];
+            const Vector3& v1 = positions[indices[j * 3 + 1]];
+            const Vector3& v2 = positions[indices[j * 3 + 2]];
+            Vector3 faceNormal = (v1 - v0).CrossProduct(v2 - v0);
+            float faceArea = faceNormal.Length();
+            centroid += (v0 + v1 + v2) * (faceArea / 3.0f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+
+        if (area > 0.0f)
+            centroid /= area;
+        normal.Normalize();
+
+        // Invert the key for descending order
+        order[i] = MakePair(~FloatToSortKey((centroid - meshCentroid).DotProduct(normal)), i);
+    }
+
+    RadixSort(order.Begin(), order.End(), temp.Begin());
+
+    PODVector<unsigned> result;
+    result.Reserve(numTriangles * 3);
+    for (unsigned i = 0; i < order.Size(); ++i)
+    {
+        unsigned cluster = order[i].second_;
+        unsigned start = clusters[cluster];
+        unsigned end = cluster + 1 < clusters.Size() ? clusters[cluster + 1] : numTriangles;
+        for (unsigned j = start * 3; j < end * 3; ++j)
+            result.Push(indices[j]);
+    }
+
+    indices.Swap(result);
+}
+
+void OptimizeVertexFetch(Vector<PODVector<unsigned> >& indexLists, unsigned numVertices, PODVector<unsigned>& vertexOrder)
+{
+    PODVector<unsigned> remap(numVertices, M_MAX_UNSIGNED);
+    vertexOrder.Clear();
+    vertexOrder.Reserve(numVertices);
+
+    for (unsigned i = 0; i < indexLists.Size(); ++i)
+    {
+        PODVector<unsigned>& indices = indexLists[i];
+        for (unsigned j = 0; j < indices.Size(); ++j)
+        {
+            unsigned vertex = indices[j];
+            if (remap[vertex] == M_MAX_UNSIGNED)
+            {
+                remap[vertex] = vertexOrder.Size();
+                vertexOrder.Push(vertex);
+            }
+            indices[j] = remap[vertex];
+        }
+    }
+
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        if (remap[i] == M_MAX_UNSIGNED)
+            vertexOrder.Push(i);
+    }
+}
+
+float GetVertexCacheMissRatio(const PODVector<unsigned>& indices, unsigned numVertices, unsigned cacheSize)
+{
+    unsigned numTriangles = indices.Size() / 3;
+    if (!numTriangles)
+        return 0.0f;
+
+    PODVector<unsigned> timestamps(numVertices, 0);
+    unsigned timestamp = cacheSize + 1;
+    unsigned misses = 0;
+    for (unsigned i = 0; i < numTriangles; ++i)
+        misses += UpdateFifoCache(&indices[i * 3], cacheSize, timestamps, timestamp);
+
+    return (float)misses / (float)numTriangles;
+}
+
+/// Build triangle adjacency for the first indexCount indices, optionally mapping the vertices through a remap table first.
+static void BuildEdgeAdjacency(EdgeAdjacency& adjacency, const PODVector<unsigned>& indices, unsigned indexCount,
+    unsigned numVertices, const unsigned* remap)
+{
+    adjacency.counts_.Resize(numVertices);
+    adjacency.offsets_.Resize(numVertices);
+    adjacency.next_.Resize(indexCount);
+    adjacency.prev_.Resize(indexCount);
+
+    for (unsigned i = 0; i < numVertices; ++i)
+        adjacency.counts_[i] = 0;
+    for (unsigned i = 0; i < indexCount; ++i)
+        ++adjacency.counts_[remap ? remap[indices[i]] : indices[i]];
+
+    unsigned offset = 0;
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        adjacency.offsets_[i] = offset;
+        offset += adjacency.counts_[i];
+    }
+
+    // Fill using the offsets as write positions, then restore them
+    for (unsigned i = 0; i < indexCount; i += 3)
+    {
+        unsigned a = remap ? remap[indices[i]] : indices[i];
+        unsigned b = remap ? remap[indices[i + 1]] : indices[i + 1];
+        unsigned c = remap ? remap[indices[i + 2]] : indices[i + 2];
+
+        adjacency.next_[adjacency.offsets_[a]] = b;
+        adjacency.prev_[adjacency.offsets_[a]++] = c;
+        adjacency.next_[adjacency.offsets_[b]] = c;
+        adjacency.prev_[adjacency.offsets_[b]++] = a;
+        adjacency.next_[adjacency.offsets_[c]] = a;
+        adjacency.prev_[adjacency.offsets_[c]++] = b;
+    }
+
+    for (unsigned i = 0; i < numVertices; ++i)
+        adjacency.offsets_[i] -= adjacency.counts_[i];
+}
+
+static bool HasEdge(const EdgeAdjacency& adjacency, unsigned a, unsigned b)
+{
+    for (unsigned i = adjacency.offsets_[a]; i < adjacency.offsets_[a] + adjacency.counts_[a]; ++i)
+    {
+        if (adjacency.next_[i] == b)
+            return true;
+    }
+
+    return false;
+}
+
+/// Return whether triangle (a, b, c) flips its facing when c moves to d. Turning nearly sideways counts as a flip, as such
+/// slivers have numerically unreliable normals and would flip in later collapses.
+static bool HasTriangleFlip(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d)
+{
+    Vector3 eb = b - a;
+    Vector3 nbc = eb.CrossProduct(c - a);
+    Vector3 nbd = eb.CrossProduct(d - a);
+    return nbc.DotProduct(nbd) <= SIMPLIFY_MIN_NORMAL_COSINE * nbc.Length() * nbd.Length();
+}
+
+/// Return whether collapsing welded vertex i0 onto i1 would flip any triangle that survives the collapse.
+static bool HasTriangleFlips(const EdgeAdjacency& adjacency, const PODVector<Vector3>& positions,
+    const PODVector<unsigned>& collapseRemap, unsigned i0, unsigned i1)
+{
+    const Vector3& v0 = positions[i0];
+    const Vector3& v1 = positions[i1];
+
+    for (unsigned i = adjacency.offsets_[i0]; i < adjacency.offsets_[i0] + adjacency.counts_[i0]; ++i)
+    {
+        unsigned a = collapseRemap[adjacency.next_[i]];
+        unsigned b = collapseRemap[adjacency.prev_[i]];
+
+        // Triangles containing the collapsed edge are removed
+        if (a == i1 || b == i1)
+            continue;
+        if (HasTriangleFlip(positions[a], positions[b], v0, v1))
+            return true;
+    }
+
+    return false;
+}
+
+/// Point the edge loop links past collapsed vertices.
+static void RemapEdgeLoops(PODVector<unsigned>& loop, const PODVector<unsigned>& collapseRemap)
+{
+    for (unsigned i = 0; i < loop.Size(); ++i)
+    {
+        if (loop[i] != M_MAX_UNSIGNED)
+        {
+            unsigned l = loop[i];
+            unsigned r = collapseRemap[l];
+            // A seam or border edge collapsed against the loop direction points back to the vertex itself
+            loop[i] = i == r ? loop[l] : r;
+        }
+    }
+}
+
+float SimplifyMesh(PODVector<unsigned>& dest, const PODVector<unsigned>& indices, const PODVector<Vector3>& positions,
+    unsigned targetIndexCount, float maxError)
+{
+    dest = indices;
+    unsigned numVertices = positions.Size();
+    unsigned indexCount = indices.Size() / 3 * 3;
+    if (indexCount <= targetIndexCount || !numVertices)
+        return 0.0f;
+
+    // Scale the positions so that errors are relative to the mesh size
+    BoundingBox box(&positions[0], numVertices);
+    Vector3 size = box.Size();
+    float extent = Max(size.x_, Max(size.y_, size.z_));
+    float invExtent = extent > 0.0f ? 1.0f / extent : 0.0f;
+    PODVector<Vector3> scaledPositions(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        scaledPositions[i] = (positions[i] - box.min_) * invExtent;
+
+    // Weld the vertices by position. Remap points to the lowest vertex index at the same position, and wedge links all the
+    // vertices at the same position to a ring
+    PODVector<unsigned> remap(numVertices);
+    PODVector<unsigned> wedge(numVertices);
+    PODVector<unsigned> sorted(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        sorted[i] = i;
+    Sort(sorted.Begin(), sorted.End(), VertexPositionLess(&positions[0]));
+    for (unsigned start = 0; start < numVertices;)
+    {
+        unsigned end = start + 1;
+        while (end < numVertices && positions[sorted[end]] == positions[sorted[start]])
+            ++end;
+        for (unsigned i = start; i < end; ++i)
+        {
+            remap[sorted[i]] = sorted[start];
+            wedge[sorted[i]] = sorted[i + 1 < end ? i + 1 : start];
+        }
+        start = end;
+    }
+
+    // Find the open edges, which have no opposite edge in the unwelded mesh. Each vertex records the one open edge leading
+    // in and out of it, or itself if it has several
+    EdgeAdjacency adjacency;
+    BuildEdgeAdjacency(adjacency, dest, indexCount, numVertices, nullptr);
+    PODVector<unsigned> loop(numVertices, M_MAX_UNSIGNED);
+    PODVector<unsigned> loopback(numVertices, M_MAX_UNSIGNED);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        for (unsigned j = adjacency.offsets_[i]; j < adjacency.offsets_[i] + adjacency.counts_[i]; ++j)
+        {
+            unsigned target = adjacency.next_[j];
+            if (!HasEdge(adjacency, target, i))
+            {
+                loopback[target] = loopback[target] == M_MAX_UNSIGNED ? i : target;
+                loop[i] = loop[i] == M_MAX_UNSIGNED ? target : i;
+            }
+        }
+    }
+
+    PODVector<unsigned char> kinds(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        if (remap[i] != i)
+            continue;
+
+        SimplifyVertexKind kind = VK_LOCKED;
+        if (wedge[i] == i)
+        {
+            // Unique position: manifold when it has no open edges, border when it has exactly one open edge in and out
+            if (loop[i] == M_MAX_UNSIGNED && loopback[i] == M_MAX_UNSIGNED)
+                kind = VK_MANIFOLD;
+            else if (loop[i] != M_MAX_UNSIGNED && loop[i] != i && loopback[i] != M_MAX_UNSIGNED && loopback[i] != i)
+                kind = VK_BORDER;
+        }
+        else if (wedge[wedge[i]] == i)
+        {
+            // Two vertices at the same position: a seam when each has one open edge in and out, and the edges of the two
+            // vertices lead to the same positions in opposite directions
+            unsigned w = wedge[i];
+            if (loop[i] != M_MAX_UNSIGNED && loop[i] != i && loopback[i] != M_MAX_UNSIGNED && loopback[i] != i &&
+                loop[w] != M_MAX_UNSIGNED && loop[w] != w && loopback[w] != M_MAX_UNSIGNED && loopback[w] != w &&
+                remap[loopback[i]] == remap[loop[w]] && remap[loop[i]] == remap[loopback[w]])
+                kind = VK_SEAM;
+        }
+
+        kinds[i] = (unsigned char)kind;
+    }
+    for (unsigned i = 0; i < numVertices; ++i)
+        kinds[i] = kinds[remap[i]];
+
+    // Accumulate the planes of the triangles around each welded vertex, and planes perpendicular to the border and seam
+    // edges, weighted more heavily so that the outlines keep their shape
+    PODVector<SimplifyQuadric> quadrics(numVertices);
+    for (unsigned i = 0; i < indexCount; i += 3)
+    {
+        unsigned i0 = dest[i];
+        unsigned i1 = dest[i + 1];
+        unsigned i2 = dest[i + 2];
+        const Vector3& p0 = scaledPositions[i0];
+        const Vector3& p1 = scaledPositions[i1];
+        const Vector3& p2 = scaledPositions[i2];
+
+        Vector3 normal = (p1 - p0).CrossProduct(p2 - p0);
+        float area = normal.Length();
+        if (area > 0.0f)
+            normal /= area;
+        SimplifyQuadric quadric(normal, -normal.DotProduct(p0), area);
+        quadrics[remap[i0]] += quadric;
+        quadrics[remap[i1]] += quadric;
+        quadrics[remap[i2]] += quadric;
+
+        for (unsigned e = 0; e < 3; ++e)
+        {
+            unsigned e0 = dest[i + e];
+            unsigned e1 = dest[i + (e + 1) % 3];
+            unsigned e2 = dest[i + (e + 2) % 3];
+            unsigned k0 = kinds[e0];
+            unsigned k1 = kinds[e1];
+
+            // Both vertices need not be on the loop, but the edge must belong to the loop of those that are. This also
+            // accounts for the edges from a loop to its locked corners
+            bool onLoop0 = k0 == VK_BORDER || k0 == VK_SEAM;
+            bool onLoop1 = k1 == VK_BORDER || k1 == VK_SEAM;
+            if (!onLoop0 && !onLoop1)
+                continue;
+            if ((onLoop0 && loop[e0] != e1) || (onLoop1 && loopback[e1] != e0))
+                continue;
+            // Seam edges are found from both sides
+            if (hasOpposite[k0][k1] && remap[e1] > remap[e0])
+                continue;
+
+            const Vector3& q0 = scaledPositions[e0];
+            const Vector3& q1 = scaledPositions[e1];
+            const Vector3& q2 = scaledPositions[e2];
+            Vector3 edge = q1 - q0;
+            float length = edge.Length();
+            if (length > 0.0f)
+                edge /= length;
+            // The plane contains the edge and is perpendicular to the triangle
+            Vector3 edgeNormal = (q2 - q0) - edge * (q2 - q0).DotProduct(edge);
+            edgeNormal.Normalize();
+            SimplifyQuadric edgeQuadric(edgeNormal, -edgeNormal.DotProduct(q0), length * length * SIMPLIFY_EDGE_WEIGHT);
+            quadrics[remap[e0]] += edgeQuadric;
+            quadrics[remap[e1]] += edgeQuadric;
+        }
+    }
+
+    PODVector<SimplifyCollapse> collapses;
+    PODVector<Pair<unsigned, unsigned> > order;
+    PODVector<Pair<unsigned, unsigned> > temp;
+    PODVector<unsigned> collapseRemap(numVertices);
+    PODVector<unsigned char> collapseLocked(numVertices);
+    float errorLimit = maxError * maxError;
+    float resultError = 0.0f;
+
+    // Collapse edges in passes. Each pass collapses the cheapest edges whose vertices are not touched by an earlier
+    // collapse of the same pass, then compacts the triangles
+    while (indexCount > targetIndexCount)
+    {
+        BuildEdgeAdjacency(adjacency, dest, indexCount, numVertices, &remap[0]);
+
+        collapses.Clear();
+        for (unsigned i = 0; i < indexCount; i += 3)
+        {
+            for (unsigned e = 0; e < 3; ++e)
+            {
+                unsigned i0 = dest[i + e];
+                unsigned i1 = dest[i + (e + 1) % 3];
+                unsigned k0 = kinds[i0];
+                unsigned k1 = kinds[i1];
+
+                if (!canCollapse[k0][k1] && !canCollapse[k1][k0])
+                    continue;
+                // Interior edges are found from both sides
+                if (hasOpposite[k0][k1] && remap[i1] > remap[i0])
+                    continue;
+                // Border and seam vertices may only move along their own loop
+                if (k0 == k1 && (k0 == VK_BORDER || k0 == VK_SEAM) && loop[i0] != i1)
+                    continue;
+                if (k0 == VK_BORDER && k1 == VK_LOCKED && loop[i0] != i1)
+                    continue;
+                if (k1 == VK_BORDER && k0 == VK_LOCKED && loopback[i1] != i0)
+                    continue;
+
+                SimplifyCollapse collapse;
+                collapse.bidirectional_ = canCollapse[k0][k1] && canCollapse[k1][k0];
+                collapse.v0_ = canCollapse[k0][k1] ? i0 : i1;
+                collapse.v1_ = canCollapse[k0][k1] ? i1 : i0;
+                collapses.Push(collapse);
+            }
+        }
+
+        if (collapses.Empty())
+            break;
+
+        order.Resize(collapses.Size());
+        temp.Resize(collapses.Size());
+        for (unsigned i = 0; i < collapses.Size(); ++i)
+        {
+            SimplifyCollapse& collapse = collapses[i];
+            unsigned i0 = collapse.v0_;
+            unsigned i1 = collapse.v1_;
+            collapse.error_ = quadrics[remap[i0]].GetError(scaledPositions[i1]);
+            if (collapse.bidirectional_)
+            {
+                float reverseError = quadrics[remap[i1]].GetError(scaledPositions[i0]);
+                if (reverseError < collapse.error_)
+                {
+                    collapse.v0_ = i1;
+                    collapse.v1_ = i0;
+                    collapse.error_ = reverseError;
+                }
+            }
+            order[i] = MakePair(FloatToSortKey(collapse.error_), i);
+        }
+        RadixSort(order.Begin(), order.End(), temp.Begin());
+
+        for (unsigned i = 0; i < numVertices; ++i)
+        {
+            collapseRemap[i] = i;
+            collapseLocked[i] = 0;
+        }
+
+        // Most collapses remove two triangles. Many cheap collapses get locked out by their neighbors, so allow some more
+        // error than the collapse that would reach the goal in an ideal case, but abort the pass early if it is going badly
+        unsigned triangleCollapseGoal = (indexCount - targetIndexCount) / 3;
+        unsigned edgeCollapseGoal = triangleCollapseGoal / 2;
+        unsigned triangleCollapses = 0;
+        unsigned edgeCollapses = 0;
+
+        for (unsigned i = 0; i < order.Size(); ++i)
+        {
+            const SimplifyCollapse& collapse = collapses[order[i].second_];
+            unsigned i0 = collapse.v0_;
+            unsigned i1 = collapse.v1_;
+            unsigned r0 = remap[i0];
+            unsigned r1 = remap[i1];
+
+            if (collapseLocked[r0] || collapseLocked[r1])
+                continue;
+            if (collapse.error_ > errorLimit || triangleCollapses >= triangleCollapseGoal)
+                break;
+            float errorGoal = edgeCollapseGoal < order.Size() ? 1.5f * collapses[order[edgeCollapseGoal].second_].error_ :
+                M_INFINITY;
+            if (collapse.error_ > errorGoal && triangleCollapses > triangleCollapseGoal / 6)
+                break;
+
+            if (HasTriangleFlips(adjacency, scaledPositions, collapseRemap, r0, r1))
+            {
+                // This collapse does not count towards the goal, so move the error goal on
+                ++edgeCollapseGoal;
+                continue;
+            }
+
+            quadrics[r1] += quadrics[r0];
+
+            unsigned kind = kinds[i0];
+            if (kind == VK_SEAM)
+            {
+                // Collapse both sides of the seam
+                collapseRemap[i0] = i1;
+                collapseRemap[wedge[i0]] = wedge[i1];
+            }
+            else
+            {
+                unsigned v = i0;
+                do
+                {
+                    collapseRemap[v] = i1;
+                    v = wedge[v];
+                } while (v != i0);
+            }
+
+            collapseLocked[r0] = 1;
+            collapseLocked[r1] = 1;
+            triangleCollapses += kind == VK_BORDER ? 1 : 2;
+            ++edgeCollapses;
+            resultError = Max(resultError, collapse.error_);
+        }
+
+        if (!edgeCollapses)
+            break;
+
+        RemapEdgeLoops(loop, collapseRemap);
+        RemapEdgeLoops(loopback, collapseRemap);
+
+        // Remap the triangles and drop the degenerate ones. Collapsing onto a locked vertex with several attribute sets can
+        // leave triangles between its different vertices, which have zero area
+        unsigned newIndexCount = 0;
+        for (unsigned i = 0; i < indexCount; i += 3)
+        {
+            unsigned a = collapseRemap[dest[i]];
+            unsigned b = collapseRemap[dest[i + 1]];
+            unsigned c = collapseRemap[dest[i + 2]];
+            if (remap[a] != remap[b] && remap[b] != remap[c] && remap[c] != remap[a])
+            {
+                dest[newIndexCount++] = a;
+                dest[newIndexCount++] = b;
+                dest[newIndexCount++] = c;
+            }
+        }
+        indexCount = newIndexCount;
+    }
+
+    dest.Resize(indexCount);
+    return sqrtf(resultError);
+}
@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Vector3.h>
+
+using namespace Urho3D;
+
+/// Reorder triangles to maximize post-transform vertex cache hits, using Tom Forsyth's linear-speed algorithm.
+void OptimizeVertexCache(PODVector<unsigned>& indices, unsigned numVertices);
+/// Reorder vertex cache optimized triangles in clusters so that outward-facing clusters are drawn first to reduce overdraw.
+/// Clusters are split so that the vertex cache miss ratio grows at most by the threshold factor, for example 1.05.
+void OptimizeOverdraw(PODVector<unsigned>& indices, const PODVector<Vector3>& positions, float threshold);
+/// Renumber vertices in order of first use by the index lists so that vertex fetch is sequential. Rewrite the index lists and
+/// return the old vertex index for each new vertex. Unreferenced vertices are kept last in their original order.
+void OptimizeVertexFetch(Vector<PODVector<unsigned> >& indexLists, unsigned numVertices, PODVector<unsigned>& vertexOrder);
+/// Simplify a triangle list with quadric error edge collapses until it has at most the target number of indices, or the next
+/// collapse would exceed the maximum error, relative to the largest bounding box dimension. Open borders and vertex attribute
+/// seams are preserved. The result references a subset of the original vertices. Return the largest error of the collapses.
+float SimplifyMesh(PODVector<unsigned>& dest, const PODVector<unsigned>& indices, const PODVector<Vector3>& positions,
+    unsigned targetIndexCount, float maxError);
+/// Return the average number of vertex shader invocations per triangle with a FIFO post-transform cache of the given size.
+float GetVertexCacheMissRatio(const PODVector<unsigned>& indices, unsigned numVertices, unsigned cacheSize = 16);
@@ -0,0 +1,491 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/InterestGrid.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkPriority.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <cstdio>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Remote event broadcast by the server every tick.
+URHO3D_EVENT(E_BENCHMARKEVENT, BenchmarkEvent)
+{
+    URHO3D_PARAM(P_TICK, Tick);                 // int
+    URHO3D_PARAM(P_PAYLOAD, Payload);           // Buffer
+}
+
+static const float NODE_SPACING = 2.0f;
+static const float MOVE_RADIUS = 1.0f;
+static const float CONNECT_TIMEOUT = 10.0f;
+static const float WARMUP_TIME = 1.0f;
+static const StringHash VAR_TICK("Tick");
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void RunTicks(unsigned numTicks, bool waitConnect);
+void ServerTick();
+bool IsMeasuredTick(int tick);
+String FormatSamples(PODVector<float>& samples, unsigned numExpected = 0);
+
+/// Simulated client with its own context and network subsystem.
+class BenchmarkClient : public Object
+{
+    URHO3D_OBJECT(BenchmarkClient, Object);
+
+public:
+    /// Construct.
+    BenchmarkClient(Context* context);
+
+    /// Connect to the server.
+    bool Connect(unsigned short port);
+    /// Process incoming and send outgoing network messages, and check the probe node for new ticks.
+    void Update(float timeStep);
+    /// Return whether the scene has been received from the server.
+    bool IsReady() const;
+
+    /// Replication latency samples in milliseconds.
+    PODVector<float> replicationLatencies_;
+    /// Remote event latency samples in milliseconds.
+    PODVector<float> eventLatencies_;
+
+private:
+    /// Handle the server's remote event.
+    void HandleBenchmarkEvent(StringHash eventType, VariantMap& eventData);
+
+    /// Replicated scene.
+    SharedPtr<Scene> scene_;
+    /// Latest tick seen on the probe node.
+    int lastProbeTick_;
+};
+
+SharedPtr<Context> context_(new Context());
+Vector<SharedPtr<Context> > clientContexts_;
+Vector<SharedPtr<BenchmarkClient> > clients_;
+SharedPtr<Scene> scene_;
+PODVector<Node*> nodes_;
+PODVector<Vector3> nodePositions_;
+Node* probeNode_ = nullptr;
+HiresTimer benchmarkTimer_;
+PODVector<long long> tickStartTimes_;
+PODVector<float> serverTickTimes_;
+PODVector<float> bytesOutSamples_;
+PODVector<float> bytesInSamples_;
+PODVector<unsigned char> eventPayload_;
+unsigned numMovingNodes_ = 0;
+unsigned numEvents_ = 1;
+int updateFps_ = 30;
+int firstMeasuredTick_ = 0;
+int lastMeasuredTick_ = 0;
+bool measuring_ = false;
+
+BenchmarkClient::BenchmarkClient(Context* context) :
+    Object(context),
+    scene_(new Scene(context)),
+    lastProbeTick_(0)
+{
+    GetSubsystem<Network>()->RegisterRemoteEvent(E_BENCHMARKEVENT);
+    SubscribeToEvent(E_BENCHMARKEVENT, URHO3D_HANDLER(BenchmarkClient, HandleBenchmarkEvent));
+}
+
+bool BenchmarkClient::Connect(unsigned short port)
+{
+    return GetSubsystem<Network>()->Connect("127.0.0.1", port, scene_);
+}
+
+void BenchmarkClient::Update(float timeStep)
+{
+    Network* network = GetSubsystem<Network>();
+    network->Update(timeStep);
+    network->PostUpdate(timeStep);
+
+    // The server writes the tick number into a variable of the probe node. Variables are sent in reliable ordered delta
+    // updates, so unlike the latest data of the moving nodes, no tick is superseded before it arrives
+    Node* probe = probeNode_ ? scene_->GetNode(probeNode_->GetID()) : nullptr;
+    if (!probe)
+        return;
+
+    int tick = probe->GetVar(VAR_TICK).GetInt();
+    if (tick > lastProbeTick_)
+    {
+        lastProbeTick_ = tick;
+        if (IsMeasuredTick(tick))
+            replicationLatencies_.Push((benchmarkTimer_.GetUSec(false) - tickStartTimes_[tick - 1]) / 1000.0f);
+    }
+}
+
+bool BenchmarkClient::IsReady() const
+{
+    Connection* connection = GetSubsystem<Network>()->GetServerConnection();
+    return connection && connection->IsSceneLoaded();
+}
+
+void BenchmarkClient::HandleBenchmarkEvent(StringHash eventType, VariantMap& eventData)
+{
+    using namespace BenchmarkEvent;
+
+    int tick = eventData[P_TICK].GetInt();
+    if (IsMeasuredTick(tick))
+        eventLatencies_.Push((benchmarkTimer_.GetUSec(false) - tickStartTimes_[tick - 1]) / 1000.0f);
+}
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned numClients = 8;
+    unsigned numNodes = 500;
+    unsigned numTicks = 300;
+    unsigned numThreads = Max((int)GetNumPhysicalCPUs() - 1, 0);
+    unsigned eventSize = 64;
+    unsigned short port = 2345;
+    int latency = 0;
+    float packetLoss = 0.0f;
+    float relevanceDistance = 0.0f;
+    bool snapshots = false;
+    bool movingSet = false;
+    bool help = false;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "s")
+                snapshots = true;
+            else if (argument == "h")
+                help = true;
+            else if (value.Empty())
+                ErrorExit("Missing value for option " + arguments[i]);
+            else
+            {
+                if (argument == "c")
+                    numClients = ToUInt(value);
+                else if (argument == "n")
+                    numNodes = ToUInt(value);
+                else if (argument == "m")
+                {
+                    numMovingNodes_ = ToUInt(value);
+                    movingSet = true;
+                }
+                else if (argument == "t")
+                    numTicks = ToUInt(value);
+                else if (argument == "f")
+                    updateFps_ = Max(ToInt(value), 1);
+                else if (argument == "e")
+                    numEvents_ = ToUInt(value);
+                else if (argument == "es")
+                    eventSize = ToUInt(value);
+                else if (argument == "l")
+                    latency = ToInt(value);
+                else if (argument == "pl")
+                    packetLoss = Clamp(ToFloat(value), 0.0f, 1.0f);
+                else if (argument == "i")
+                    relevanceDistance = ToFloat(value);
+                else if (argument == "w")
+                    numThreads = ToUInt(value);
+                else if (argument == "p")
+                    port = (unsigned short)ToUInt(value);
+                else
+                    ErrorExit("Unrecognized option " + arguments[i]);
+                ++i;
+            }
+        }
+    }
+
+    if (help || !numClients || !numTicks)
+    {
+        ErrorExit(
+            "Usage: NetworkBenchmark [options]\n"
+            "Runs a server and simulated clients over loopback in one process and reports replication cost\n\n"
+            "Options:\n"
+            "-c <num>    Number of clients. Default 8\n"
+            "-n <num>    Number of replicated nodes. Default 500\n"
+            "-m <num>    Number of nodes moved per tick. Default all\n"
+            "-t <num>    Number of measured server ticks. Default 300\n"
+            "-f <fps>    Server network update rate. Default 30\n"
+            "-e <num>    Remote events broadcast per tick. Default 1\n"
+            "-es <bytes> Remote event payload size. Default 64\n"
+            "-l <ms>     Simulated latency\n"
+            "-pl <prob>  Simulated packet loss probability between 0.0 - 1.0\n"
+            "-s          Use snapshot replication\n"
+            "-i <dist>   Use an InterestGrid with the given relevance distance\n"
+            "-w <num>    Number of server worker threads. Default number of physical CPUs - 1\n"
+            "-p <port>   Server port. Default 2345\n"
+            "-h          Show this help\n"
+        );
+    }
+
+    if (!movingSet)
+        numMovingNodes_ = numNodes;
+    numMovingNodes_ = Min(numMovingNodes_, numNodes);
+
+    context_->RegisterSubsystem(new Time(context_));
+    context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    context_->RegisterSubsystem(new Log(context_));
+    context_->GetSubsystem<Log>()->SetLevel(LOG_WARNING);
+    context_->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+    RegisterSceneLibrary(context_);
+    context_->RegisterSubsystem(new Network(context_));
+    benchmarkTimer_.Reset();
+
+    // Create the server scene: a grid of nodes, plus a probe node that carries the tick number to the clients. The probe is
+    // always relevant and has no update priority of its own, so it is sent on every network update
+    scene_ = new Scene(context_);
+    unsigned gridSize = (unsigned)ceilf(sqrtf((float)numNodes));
+    float gridOffset = (gridSize - 1) * NODE_SPACING * 0.5f;
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        Node* node = scene_->CreateChild("Node");
+        node->SetPosition(Vector3((i % gridSize) * NODE_SPACING - gridOffset, 0.0f, (i / gridSize) * NODE_SPACING - gridOffset));
+        nodes_.Push(node);
+        nodePositions_.Push(node->GetPosition());
+    }
+    probeNode_ = scene_->CreateChild("Probe");
+    if (relevanceDistance > 0.0f)
+    {
+        InterestGrid* grid = scene_->CreateComponent<InterestGrid>(LOCAL);
+        grid->SetRelevanceDistance(relevanceDistance);
+        probeNode_->CreateComponent<NetworkPriority>(LOCAL)->SetAlwaysRelevant(true);
+    }
+    eventPayload_.Resize(eventSize);
+    for (unsigned i = 0; i < eventSize; ++i)
+        eventPayload_[i] = (unsigned char)Rand();
+
+    Network* network = context_->GetSubsystem<Network>();
+    network->SetUpdateFps(updateFps_);
+    network->SetSimulatedLatency(latency);
+    network->SetSimulatedPacketLoss(packetLoss);
+    network->SetSnapshotReplication(snapshots);
+    if (!network->StartServer(port))
+        ErrorExit("Failed to start server on port " + String(port));
+
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        SharedPtr<Context> clientContext(new Context());
+        clientContext->RegisterSubsystem(new WorkQueue(clientContext));
+        clientContext->RegisterSubsystem(new FileSystem(clientContext));
+        clientContext->RegisterSubsystem(new ResourceCache(clientContext));
+        RegisterSceneLibrary(clientContext);
+        clientContext->RegisterSubsystem(new Network(clientContext));
+        clientContext->GetSubsystem<Network>()->SetSimulatedLatency(latency);
+        clientContext->GetSubsystem<Network>()->SetSimulatedPacketLoss(packetLoss);
+        clientContexts_.Push(clientContext);
+
+        SharedPtr<BenchmarkClient> client(new BenchmarkClient(clientContext));
+        if (!client->Connect(port))
+            ErrorExit("Failed to connect client " + String(i));
+        clients_.Push(client);
+    }
+
+    // Assign the scene to clients as they connect, and place their observers randomly over the node grid
+    RunTicks(M_MAX_UNSIGNED, true);
+    for (unsigned i = 0; i < clients_.Size(); ++i)
+    {
+        Connection* connection = clientContexts_[i]->GetSubsystem<Network>()->GetServerConnection();
+        connection->SetPosition(Vector3(Random(-gridOffset, gridOffset), 0.0f, Random(-gridOffset, gridOffset)));
+    }
+
+    RunTicks((unsigned)(WARMUP_TIME * updateFps_), false);
+    firstMeasuredTick_ = tickStartTimes_.Size() + 1;
+    measuring_ = true;
+    RunTicks(numTicks, false);
+    measuring_ = false;
+    lastMeasuredTick_ = tickStartTimes_.Size();
+    // Keep running so that the messages of the last measured ticks still arrive and are counted
+    RunTicks((unsigned)(WARMUP_TIME * updateFps_), false);
+
+    PODVector<float> replicationLatencies;
+    PODVector<float> eventLatencies;
+    for (unsigned i = 0; i < clients_.Size(); ++i)
+    {
+        replicationLatencies.Push(clients_[i]->replicationLatencies_);
+        eventLatencies.Push(clients_[i]->eventLatencies_);
+    }
+
+    PrintLine(ToString("Clients %u, nodes %u (%u moving), update rate %d, events per tick %u (%u bytes), latency %d ms, "
+        "packet loss %s, %s replication, %s, worker threads %u", numClients, numNodes, numMovingNodes_, updateFps_, numEvents_,
+        eventSize, latency, String(packetLoss).CString(), snapshots ? "snapshot" : "reliable", relevanceDistance > 0.0f ?
+        ("relevance distance " + String(relevanceDistance)).CString() : "no interest management", numThreads));
+    PrintLine("Server tick time (ms):      " + FormatSamples(serverTickTimes_));
+    PrintLine("Bytes out per client (/s):  " + FormatSamples(bytesOutSamples_));
+    PrintLine("Bytes in per client (/s):   " + FormatSamples(bytesInSamples_));
+    PrintLine("Replication latency (ms):   " + FormatSamples(replicationLatencies, numClients * numTicks));
+    PrintLine("Remote event latency (ms):  " + FormatSamples(eventLatencies, numClients * numTicks * numEvents_));
+
+    for (unsigned i = 0; i < clientContexts_.Size(); ++i)
+        clientContexts_[i]->GetSubsystem<Network>()->Disconnect();
+    network->StopServer();
+    clients_.Clear();
+    clientContexts_.Clear();
+}
+
+void RunTicks(unsigned numTicks, bool waitConnect)
+{
+    Network* network = context_->GetSubsystem<Network>();
+    long long tickInterval = 1000000LL / updateFps_;
+    long long startTime = benchmarkTimer_.GetUSec(false);
+    long long nextTickTime = startTime;
+    long long lastClientTime = startTime;
+    unsigned ticks = 0;
+
+    while (ticks < numTicks)
+    {
+        long long time = benchmarkTimer_.GetUSec(false);
+        if (time >= nextTickTime)
+        {
+            ServerTick();
+            nextTickTime += tickInterval;
+            ++ticks;
+
+            if (waitConnect)
+            {
+                Vector<SharedPtr<Connection> > connections = network->GetClientConnections();
+                for (unsigned i = 0; i < connections.Size(); ++i)
+                {
+                    if (!connections[i]->GetScene())
+                        connections[i]->SetScene(scene_);
+                }
+
+                bool ready = true;
+                for (unsigned i = 0; i < clients_.Size() && ready; ++i)
+                    ready = clients_[i]->IsReady();
+                if (ready)
+                    break;
+                if (time - startTime > (long long)(CONNECT_TIMEOUT * 1000000.0f))
+                    ErrorExit("Timed out waiting for clients to connect");
+            }
+        }
+
+        // Clients process messages as often as possible, so that latency is measured close to when the data arrives
+        time = benchmarkTimer_.GetUSec(false);
+        float timeStep = (time - lastClientTime) / 1000000.0f;
+        lastClientTime = time;
+        for (unsigned i = 0; i < clients_.Size(); ++i)
+            clients_[i]->Update(timeStep);
+
+        Time::Sleep(1);
+    }
+}
+
+void ServerTick()
+{
+    tickStartTimes_.Push(benchmarkTimer_.GetUSec(false));
+    int tick = (int)tickStartTimes_.Size();
+
+    // Move nodes in circles around their grid position
+    float time = (float)tick / updateFps_;
+    for (unsigned i = 0; i < numMovingNodes_; ++i)
+    {
+        float angle = time * 90.0f + i * 37.0f;
+        nodes_[i]->SetPosition(nodePositions_[i] + Vector3(Cos(angle), 0.0f, Sin(angle)) * MOVE_RADIUS);
+        nodes_[i]->SetRotation(Quaternion(angle, Vector3::UP));
+    }
+    probeNode_->SetVar(VAR_TICK, tick);
+
+    Network* network = context_->GetSubsystem<Network>();
+    if (numEvents_)
+    {
+        using namespace BenchmarkEvent;
+
+        VariantMap eventData;
+        eventData[P_TICK] = tick;
+        eventData[P_PAYLOAD] = eventPayload_;
+        for (unsigned i = 0; i < numEvents_; ++i)
+            network->BroadcastRemoteEvent(E_BENCHMARKEVENT, true, eventData);
+    }
+
+    // Measure the server's network processing: receiving messages, and building and sending the scene updates
+    float timeStep = 1.0f / updateFps_;
+    HiresTimer tickTimer;
+    network->Update(timeStep);
+    network->PostUpdate(timeStep);
+    long long tickTime = tickTimer.GetUSec(false);
+
+    if (measuring_)
+    {
+        serverTickTimes_.Push(tickTime / 1000.0f);
+        Vector<SharedPtr<Connection> > connections = network->GetClientConnections();
+        for (unsigned i = 0; i < connections.Size(); ++i)
+        {
+            bytesOutSamples_.Push(connections[i]->GetBytesOutPerSec());
+            bytesInSamples_.Push(connections[i]->GetBytesInPerSec());
+        }
+    }
+}
+
+bool IsMeasuredTick(int tick)
+{
+    return firstMeasuredTick_ && tick >= firstMeasuredTick_ && tick <= (lastMeasuredTick_ ? lastMeasuredTick_ :
+        (int)tickStartTimes_.Size());
+}
+
+String FormatSamples(PODVector<float>& samples, unsigned numExpected)
+{
+    if (samples.Empty())
+        return numExpected ? ToString("no samples (%u missing)", numExpected) : String("no samples");
+
+    // Samples that were expected but never arrived are reported as missing, so that they do not go unnoticed
+    String missing = numExpected ? ToString(", %u missing", numExpected - Min(samples.Size(), numExpected)) : String::EMPTY;
+
+    Sort(samples.Begin(), samples.End());
+    float total = 0.0f;
+    for (unsigned i = 0; i < samples.Size(); ++i)
+        total += samples[i];
+
+    unsigned last = samples.Size() - 1;
+    char line[256];
+    sprintf(line, "avg %8.2f  p50 %8.2f  p95 %8.2f  p99 %8.2f  max %8.2f  (%u samples%s)", total / samples.Size(),
+        samples[last * 50 / 100], samples[last * 95 / 100], samples[last * 99 / 100], samples[last], samples.Size(),
+        missing.CString());
+    return String(line);
+}
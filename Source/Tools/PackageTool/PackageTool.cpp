@@ -22,7 +22,10 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Container/Sort.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
@@ -39,6 +42,8 @@
 using namespace Urho3D;
 
 static const unsigned COMPRESSED_BLOCK_SIZE = 32768;
+/// Maximum amount of source file data to read and compress in parallel before writing it to the package.
+static const unsigned MAX_PENDING_DATA_SIZE = 64 * 1024 * 1024;
 
 struct FileEntry
 {
@@ -46,16 +51,25 @@ struct FileEntry
     unsigned offset_;
     unsigned size_;
     unsigned checksum_;
+    SharedArrayPtr<unsigned char> data_;
+    unsigned dataSize_;
+    bool reused_;
+    unsigned time_;
+    String error_;
 };
 
 SharedPtr<Context> context_(new Context());
 SharedPtr<FileSystem> fileSystem_(new FileSystem(context_));
+SharedPtr<WorkQueue> workQueue_(new WorkQueue(context_));
 String basePath_;
 Vector<FileEntry> entries_;
 unsigned checksum_ = 0;
 bool compress_ = false;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
+String oldPackageName_;
+HashMap<String, PackageEntry> oldEntries_;
+HashMap<String, unsigned> oldPackedSizes_;
 
 String ignoreExtensions_[] = {
     ".bak",
@@ -68,6 +82,10 @@ void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
 void WritePackageFile(const String& fileName, const String& rootDir);
 void WriteHeader(File& dest);
+void ReadOldPackage(const String& fileName);
+void PackFile(const WorkItem* item, unsigned threadIndex);
+bool ReuseOldPackedData(FileEntry& entry);
+unsigned CombineSDBMHash(unsigned hash, unsigned dataHash, unsigned dataSize);
 
 int main(int argc, char** argv)
 {
@@ -93,7 +111,9 @@ void Run(const Vector<String>& arguments)
             "-c      Enable package file LZ4 compression\n"
             "-q      Enable quiet mode\n"
             "\n"
-            "Basepath is an optional prefix that will be added to the file entries.\n\n"
+            "Basepath is an optional prefix that will be added to the file entries.\n"
+            "Instead of a directory, a text file listing the files to process, one per line\n"
+            "relative to the list file, can be given.\n\n"
             "Alternative output usage: PackageTool <output option> <package name>\n"
             "Output option:\n"
             "-i      Output package file information\n"
@@ -132,33 +152,60 @@ void Run(const Vector<String>& arguments)
 
     if (!isOutputMode)
     {
-        if (!quiet_)
-            PrintLine("Scanning directory " + dirName + " for files");
-
-        // Get the file list recursively
         Vector<String> fileNames;
-        fileSystem_->ScanDir(fileNames, dirName, "*.*", SCAN_FILES, true);
-        if (!fileNames.Size())
-            ErrorExit("No files found");
+        String rootDir = dirName;
 
-        // Check for extensions to ignore
-        for (unsigned i = fileNames.Size() - 1; i < fileNames.Size(); --i)
+        if (fileSystem_->FileExists(dirName))
         {
-            String extension = GetExtension(fileNames[i]);
-            for (unsigned j = 0; j < ignoreExtensions_[j].Length(); ++j)
+            if (!quiet_)
+                PrintLine("Reading file list " + dirName);
+
+            // The listed files are relative to the list file
+            rootDir = RemoveTrailingSlash(GetPath(dirName));
+            if (rootDir.Empty())
+                rootDir = ".";
+
+            File listFile(context_);
+            if (!listFile.Open(dirName))
+                ErrorExit("Could not open file list " + dirName);
+            while (!listFile.IsEof())
+            {
+                String line = listFile.ReadLine().Trimmed();
+                if (!line.Empty() && line[0] != '#')
+                    fileNames.Push(GetInternalPath(line));
+            }
+            if (!fileNames.Size())
+                ErrorExit("No files listed");
+        }
+        else
+        {
+            if (!quiet_)
+                PrintLine("Scanning directory " + dirName + " for files");
+
+            // Get the file list recursively
+            fileSystem_->ScanDir(fileNames, dirName, "*.*", SCAN_FILES, true);
+            if (!fileNames.Size())
+                ErrorExit("No files found");
+
+            // Check for extensions to ignore
+            for (unsigned i = fileNames.Size() - 1; i < fileNames.Size(); --i)
             {
-                if (extension == ignoreExtensions_[j])
+                String extension = GetExtension(fileNames[i]);
+                for (unsigned j = 0; j < ignoreExtensions_[j].Length(); ++j)
                 {
-                    fileNames.Erase(fileNames.Begin() + i);
-                    break;
+                    if (extension == ignoreExtensions_[j])
+                    {
+                        fileNames.Erase(fileNames.Begin() + i);
+                        break;
+                    }
                 }
             }
         }
 
         for (unsigned i = 0; i < fileNames.Size(); ++i)
-            ProcessFile(fileNames[i], dirName);
+            ProcessFile(fileNames[i], rootDir);
 
-        WritePackageFile(packageName, dirName);
+        WritePackageFile(packageName, rootDir);
     }
     else
     {
@@ -217,6 +264,9 @@ void ProcessFile(const String& fileName, const String& rootDir)
     newEntry.offset_ = 0; // Offset not yet known
     newEntry.size_ = file.GetSize();
     newEntry.checksum_ = 0; // Will be calculated later
+    newEntry.dataSize_ = 0;
+    newEntry.reused_ = false;
+    newEntry.time_ = 0;
     entries_.Push(newEntry);
 }
 
@@ -225,9 +275,15 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     if (!quiet_)
         PrintLine("Writing package");
 
+    // Files which have not changed since the previous package was written are copied from it without compressing again
+    if (compress_ && fileSystem_->FileExists(fileName))
+        ReadOldPackage(fileName);
+
+    // Write to a temporary file first, as the previous package is still read from during the writing
+    String tempFileName = fileName + ".tmp";
     File dest(context_);
-    if (!dest.Open(fileName, FILE_WRITE))
-        ErrorExit("Could not open output file " + fileName);
+    if (!dest.Open(tempFileName, FILE_WRITE))
+        ErrorExit("Could not open output file " + tempFileName);
 
     // Write ID, number of files & placeholder for checksum
     WriteHeader(dest);
@@ -242,70 +298,69 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     }
 
     unsigned totalDataSize = 0;
-    unsigned lastOffset;
+    unsigned numReused = 0;
+    Timer packTimer;
+#ifdef URHO3D_THREADING
+    // Reserve one core for the main thread, which also takes work items while waiting for them to complete
+    unsigned numThreads = GetNumLogicalCPUs() - 1;
+    if (numThreads)
+        workQueue_->CreateThreads(numThreads);
+#endif
 
-    // Write file data, calculate checksums & correct offsets
-    for (unsigned i = 0; i < entries_.Size(); ++i)
+    // Read, checksum & compress the files in parallel, a limited amount of data at a time. Then write them in order
+    // and correct the offsets
+    for (unsigned start = 0; start < entries_.Size();)
     {
-        lastOffset = entries_[i].offset_ = dest.GetSize();
-        String fileFullPath = rootDir + "/" + entries_[i].name_;
-
-        File srcFile(context_, fileFullPath);
-        if (!srcFile.IsOpen())
-            ErrorExit("Could not open file " + fileFullPath);
-
-        unsigned dataSize = entries_[i].size_;
-        totalDataSize += dataSize;
-        SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
-
-        if (srcFile.Read(&buffer[0], dataSize) != dataSize)
-            ErrorExit("Could not read file " + fileFullPath);
-        srcFile.Close();
-
-        for (unsigned j = 0; j < dataSize; ++j)
+        unsigned end = start;
+        unsigned pendingDataSize = 0;
+        while (end < entries_.Size() && (end == start || pendingDataSize + entries_[end].size_ <= MAX_PENDING_DATA_SIZE))
         {
-            checksum_ = SDBMHash(checksum_, buffer[j]);
-            entries_[i].checksum_ = SDBMHash(entries_[i].checksum_, buffer[j]);
+            pendingDataSize += entries_[end].size_;
+
+            SharedPtr<WorkItem> item = workQueue_->GetFreeItem();
+            item->workFunction_ = PackFile;
+            item->start_ = &entries_[end];
+            item->aux_ = const_cast<String*>(&rootDir);
+            workQueue_->AddWorkItem(item);
+            ++end;
         }
 
-        if (!compress_)
-        {
-            if (!quiet_)
-                PrintLine(entries_[i].name_ + " size " + String(dataSize));
-            dest.Write(&buffer[0], entries_[i].size_);
-        }
-        else
-        {
-            SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
-
-            unsigned pos = 0;
+        workQueue_->Complete(0);
 
-            while (pos < dataSize)
-            {
-                unsigned unpackedSize = blockSize_;
-                if (pos + unpackedSize > dataSize)
-                    unpackedSize = dataSize - pos;
-
-                unsigned packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
-                if (!packedSize)
-                    ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
-
-                dest.WriteUShort((unsigned short)unpackedSize);
-                dest.WriteUShort((unsigned short)packedSize);
-                dest.Write(compressBuffer.Get(), packedSize);
+        for (unsigned i = start; i < end; ++i)
+        {
+            FileEntry& entry = entries_[i];
+            if (!entry.error_.Empty())
+                ErrorExit(entry.error_);
 
-                pos += unpackedSize;
-            }
+            entry.offset_ = dest.GetSize();
+            dest.Write(entry.data_.Get(), entry.dataSize_);
+            totalDataSize += entry.size_;
+            checksum_ = CombineSDBMHash(checksum_, entry.checksum_, entry.size_);
+            if (entry.reused_)
+                ++numReused;
 
             if (!quiet_)
             {
-                unsigned totalPackedBytes = dest.GetSize() - lastOffset;
-                String fileEntry(entries_[i].name_);
-                fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", dataSize, totalPackedBytes,
-                    totalPackedBytes ? 1.f * dataSize / totalPackedBytes : 0.f);
+                String fileEntry(entry.name_);
+                if (!compress_)
+                    fileEntry.AppendWithFormat(" size %u", entry.size_);
+                else
+                {
+                    fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", entry.size_, entry.dataSize_,
+                        entry.dataSize_ ? 1.f * entry.size_ / entry.dataSize_ : 0.f);
+                }
+                if (entry.reused_)
+                    fileEntry += "\treused";
+                else
+                    fileEntry.AppendWithFormat("\ttime: %u ms", entry.time_);
                 PrintLine(fileEntry);
             }
+
+            entry.data_.Reset();
         }
+
+        start = end;
     }
 
     // Write package size to the end of file to allow finding it linked to an executable file
@@ -324,14 +379,169 @@ void WritePackageFile(const String& fileName, const String& rootDir)
         dest.WriteUInt(entries_[i].checksum_);
     }
 
+    unsigned packageSize = dest.GetSize();
+    dest.Close();
+
+    if (fileSystem_->FileExists(fileName) && !fileSystem_->Delete(fileName))
+        ErrorExit("Could not overwrite output file " + fileName);
+    if (!fileSystem_->Rename(tempFileName, fileName))
+        ErrorExit("Could not rename " + tempFileName + " to " + fileName);
+
     if (!quiet_)
     {
         PrintLine("Number of files: " + String(entries_.Size()));
         PrintLine("File data size: " + String(totalDataSize));
-        PrintLine("Package size: " + String(dest.GetSize()));
+        PrintLine("Package size: " + String(packageSize));
         PrintLine("Checksum: " + String(checksum_));
         PrintLine("Compressed: " + String(compress_ ? "yes" : "no"));
+        if (compress_)
+            PrintLine("Reused from previous package: " + String(numReused));
+        PrintLine("Time: " + String(packTimer.GetMSec(false)) + " ms");
+    }
+}
+
+void ReadOldPackage(const String& fileName)
+{
+    SharedPtr<PackageFile> oldPackage(new PackageFile(context_));
+    if (!oldPackage->Open(fileName) || !oldPackage->IsCompressed())
+        return;
+
+    oldPackageName_ = fileName;
+    oldEntries_ = oldPackage->GetEntries();
+
+    // The compressed size of an entry is the distance to the next entry in the file
+    PODVector<unsigned> offsets;
+    for (HashMap<String, PackageEntry>::ConstIterator i = oldEntries_.Begin(); i != oldEntries_.End(); ++i)
+        offsets.Push(i->second_.offset_);
+    offsets.Push(oldPackage->GetTotalSize() - sizeof(unsigned));
+    Sort(offsets.Begin(), offsets.End());
+
+    HashMap<unsigned, unsigned> nextOffsets;
+    for (unsigned i = 0; i + 1 < offsets.Size(); ++i)
+        nextOffsets[offsets[i]] = offsets[i + 1];
+
+    for (HashMap<String, PackageEntry>::ConstIterator i = oldEntries_.Begin(); i != oldEntries_.End(); ++i)
+        oldPackedSizes_[i->first_] = nextOffsets[i->second_.offset_] - i->second_.offset_;
+}
+
+void PackFile(const WorkItem* item, unsigned threadIndex)
+{
+    FileEntry& entry = *reinterpret_cast<FileEntry*>(item->start_);
+    const String& rootDir = *reinterpret_cast<String*>(item->aux_);
+    String fileFullPath = rootDir + "/" + entry.name_;
+    Timer timer;
+
+    File srcFile(context_, fileFullPath);
+    if (!srcFile.IsOpen())
+    {
+        entry.error_ = "Could not open file " + fileFullPath;
+        return;
+    }
+
+    unsigned dataSize = entry.size_;
+    SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
+
+    if (srcFile.Read(&buffer[0], dataSize) != dataSize)
+    {
+        entry.error_ = "Could not read file " + fileFullPath;
+        return;
+    }
+    srcFile.Close();
+
+    for (unsigned j = 0; j < dataSize; ++j)
+        entry.checksum_ = SDBMHash(entry.checksum_, buffer[j]);
+
+    if (!compress_)
+    {
+        entry.data_ = buffer;
+        entry.dataSize_ = dataSize;
+    }
+    else if (!ReuseOldPackedData(entry))
+    {
+        unsigned numBlocks = (dataSize + blockSize_ - 1) / blockSize_;
+        entry.data_ = new unsigned char[numBlocks * (2 * sizeof(unsigned short) + LZ4_compressBound(blockSize_))];
+        unsigned char* dest = entry.data_.Get();
+
+        unsigned pos = 0;
+
+        while (pos < dataSize)
+        {
+            unsigned unpackedSize = blockSize_;
+            if (pos + unpackedSize > dataSize)
+                unpackedSize = dataSize - pos;
+
+            unsigned char* header = dest;
+            dest += 2 * sizeof(unsigned short);
+            unsigned packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)dest, unpackedSize, LZ4_compressBound(unpackedSize), 0);
+            if (!packedSize)
+            {
+                entry.error_ = "LZ4 compression failed for file " + entry.name_ + " at offset " + String(pos);
+                return;
+            }
+
+            unsigned short blockSizes[] = { (unsigned short)unpackedSize, (unsigned short)packedSize };
+            memcpy(header, blockSizes, sizeof blockSizes);
+            dest += packedSize;
+
+            pos += unpackedSize;
+        }
+
+        entry.dataSize_ = (unsigned)(dest - entry.data_.Get());
+    }
+
+    entry.time_ = timer.GetMSec(false);
+}
+
+bool ReuseOldPackedData(FileEntry& entry)
+{
+    String oldName = basePath_ + entry.name_;
+    HashMap<String, PackageEntry>::ConstIterator i = oldEntries_.Find(oldName);
+    HashMap<String, unsigned>::ConstIterator j = oldPackedSizes_.Find(oldName);
+    if (i == oldEntries_.End() || j == oldPackedSizes_.End() || i->second_.size_ != entry.size_ ||
+        i->second_.checksum_ != entry.checksum_)
+        return false;
+
+    unsigned packedSize = j->second_;
+    SharedArrayPtr<unsigned char> data(new unsigned char[packedSize]);
+    File oldFile(context_, oldPackageName_);
+    if (!oldFile.IsOpen() || !oldFile.Seek(i->second_.offset_) || oldFile.Read(data.Get(), packedSize) != packedSize)
+        return false;
+
+    // Check that the block headers cover exactly the file, in case the previous package was written differently
+    unsigned pos = 0;
+    unsigned unpackedSize = 0;
+    while (pos + 2 * sizeof(unsigned short) <= packedSize)
+    {
+        unsigned short blockSizes[2];
+        memcpy(blockSizes, &data[pos], sizeof blockSizes);
+        if (!blockSizes[0] || blockSizes[0] > blockSize_)
+            return false;
+        unpackedSize += blockSizes[0];
+        pos += sizeof blockSizes + blockSizes[1];
     }
+    if (pos != packedSize || unpackedSize != entry.size_)
+        return false;
+
+    entry.data_ = data;
+    entry.dataSize_ = packedSize;
+    entry.reused_ = true;
+    return true;
+}
+
+unsigned CombineSDBMHash(unsigned hash, unsigned dataHash, unsigned dataSize)
+{
+    // Hashing a byte multiplies the previous hash by 65599, so the hash of the preceding data is multiplied by
+    // 65599 ^ dataSize when continuing over data whose hash from zero is known
+    unsigned multiplier = 1;
+    unsigned power = 65599;
+    for (unsigned n = dataSize; n; n >>= 1)
+    {
+        if (n & 1)
+            multiplier *= power;
+        power *= power;
+    }
+
+    return hash * multiplier + dataHash;
 }
 
 void WriteHeader(File& dest)
@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <cstdio>
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+/// Reference counted object used in the benchmarks.
+class BenchmarkObject : public RefCounted
+{
+public:
+    /// Construct.
+    BenchmarkObject() :
+        value_(1)
+    {
+    }
+
+    /// Value read through the pointers so that the copies are not optimized away.
+    int value_;
+};
+
+/// Benchmark thread copying shared pointers or locking weak pointers.
+class BenchmarkThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    BenchmarkThread(BenchmarkObject* object, unsigned iterations, bool weak) :
+        object_(object),
+        weakObject_(object),
+        iterations_(iterations),
+        weak_(weak),
+        sum_(0)
+    {
+    }
+
+    /// Run the benchmark loop.
+    virtual void ThreadFunction() override
+    {
+        for (unsigned i = 0; i < iterations_; ++i)
+        {
+            if (weak_)
+            {
+                SharedPtr<BenchmarkObject> locked = weakObject_.Lock();
+                sum_ += locked->value_;
+            }
+            else
+            {
+                SharedPtr<BenchmarkObject> copy(object_);
+                sum_ += copy->value_;
+            }
+        }
+    }
+
+    /// Object copied by this thread.
+    SharedPtr<BenchmarkObject> object_;
+    /// Weak pointer to the object.
+    WeakPtr<BenchmarkObject> weakObject_;
+    /// Number of iterations.
+    unsigned iterations_;
+    /// Whether to lock the weak pointer instead of copying the shared pointer.
+    bool weak_;
+    /// Sum of values read.
+    unsigned sum_;
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void PrintResult(const String& name, long long usec, unsigned operations);
+void RunThreaded(const String& name, unsigned numThreads, unsigned iterations, bool shared, bool weak);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    unsigned iterations = 10000000;
+    unsigned numThreads = Max(GetNumPhysicalCPUs(), 2U);
+    bool help = false;
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "h")
+                help = true;
+            else if (value.Empty())
+                ErrorExit("Missing value for option " + arguments[i]);
+            else
+            {
+                if (argument == "n")
+                    iterations = ToUInt(value);
+                else if (argument == "t")
+                    numThreads = ToUInt(value);
+                else
+                    ErrorExit("Unrecognized option " + arguments[i]);
+                ++i;
+            }
+        }
+    }
+
+    if (help || !iterations || !numThreads)
+    {
+        ErrorExit(
+            "Usage: RefCountBenchmark [options]\n"
+            "Measures the cost of SharedPtr and WeakPtr operations. Build with and without the URHO3D_ATOMIC_REFCOUNT option to compare\n\n"
+            "Options:\n"
+            "-n <num>    Number of iterations per benchmark and thread. Default 10000000\n"
+            "-t <num>    Number of threads in the threaded benchmarks. Default number of physical CPUs, at least 2\n"
+            "-h          Display this help and exit\n"
+        );
+    }
+
+    // The Time subsystem initializes the high-resolution timer frequency
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new Time(context));
+
+#ifdef URHO3D_ATOMIC_REFCOUNT
+    PrintLine("Reference counting: atomic");
+#else
+    PrintLine("Reference counting: non-atomic");
+#endif
+
+    HiresTimer timer;
+    unsigned sum = 0;
+
+    {
+        SharedPtr<BenchmarkObject> object(new BenchmarkObject());
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            SharedPtr<BenchmarkObject> copy(object);
+            sum += copy->value_;
+        }
+        PrintResult("SharedPtr copy", timer.GetUSec(false), iterations);
+    }
+
+    {
+        SharedPtr<BenchmarkObject> object(new BenchmarkObject());
+        WeakPtr<BenchmarkObject> weak(object);
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            SharedPtr<BenchmarkObject> locked = weak.Lock();
+            sum += locked->value_;
+        }
+        PrintResult("WeakPtr lock", timer.GetUSec(false), iterations);
+    }
+
+    {
+        SharedPtr<BenchmarkObject> object(new BenchmarkObject());
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            WeakPtr<BenchmarkObject> weak(object);
+            sum += weak->value_;
+        }
+        PrintResult("WeakPtr copy", timer.GetUSec(false), iterations);
+    }
+
+    {
+        unsigned numObjects = Max(iterations / 10, 1U);
+        timer.Reset();
+        for (unsigned i = 0; i < numObjects; ++i)
+        {
+            SharedPtr<BenchmarkObject> object(new BenchmarkObject());
+            sum += object->value_;
+        }
+        PrintResult("Object create and destroy", timer.GetUSec(false), numObjects);
+    }
+
+    // Keep the sum alive so that the loops are not optimized away
+    if (sum == 0)
+        PrintLine("");
+
+#ifdef URHO3D_ATOMIC_REFCOUNT
+    RunThreaded("Threaded SharedPtr copy, separate objects", numThreads, iterations, false, false);
+    RunThreaded("Threaded SharedPtr copy, shared object", numThreads, iterations, true, false);
+    RunThreaded("Threaded WeakPtr lock, shared object", numThreads, iterations, true, true);
+#else
+    PrintLine("Threaded benchmarks skipped, they require the URHO3D_ATOMIC_REFCOUNT build option");
+#endif
+}
+
+void PrintResult(const String& name, long long usec, unsigned operations)
+{
+    // String::AppendWithFormat does not support field widths, so format with the C library
+    char buffer[256];
+    snprintf(buffer, sizeof buffer, "%-55s %9.2f ms %7.2f ns/op", name.CString(), usec / 1000.0, usec * 1000.0 / operations);
+    PrintLine(buffer);
+}
+
+void RunThreaded(const String& name, unsigned numThreads, unsigned iterations, bool shared, bool weak)
+{
+    SharedPtr<BenchmarkObject> sharedObject(new BenchmarkObject());
+    Vector<SharedPtr<BenchmarkThread> > threads;
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        BenchmarkObject* object = shared ? sharedObject.Get() : new BenchmarkObject();
+        threads.Push(SharedPtr<BenchmarkThread>(new BenchmarkThread(object, iterations, weak)));
+    }
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < threads.Size(); ++i)
+        threads[i]->Run();
+    for (unsigned i = 0; i < threads.Size(); ++i)
+        threads[i]->Stop();
+    long long usec = timer.GetUSec(false);
+
+    unsigned sum = 0;
+    for (unsigned i = 0; i < threads.Size(); ++i)
+        sum += threads[i]->sum_;
+
+    PrintResult(name + ToString(" (%u threads)", numThreads), usec, iterations * numThreads);
+
+    // Each thread and the benchmark itself hold one reference to the shared object
+    if (sum != iterations * numThreads || (shared && sharedObject->Refs() != (int)numThreads + 1))
+        ErrorExit("Reference count mismatch after threaded benchmark");
+}
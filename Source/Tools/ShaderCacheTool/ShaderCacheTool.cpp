@@ -0,0 +1,386 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/RenderPath.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Shader.h>
+#include <Urho3D/Graphics/ShaderPrecache.h>
+#include <Urho3D/Graphics/ShaderVariation.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+#ifdef URHO3D_OPENGL
+static const String SHADER_PATH("Shaders/GLSL/");
+static const String SHADER_EXTENSION(".glsl");
+#else
+static const String SHADER_PATH("Shaders/HLSL/");
+static const String SHADER_EXTENSION(".hlsl");
+#endif
+
+/// Shader defines of a render path command or a material.
+struct ExtraDefines
+{
+    /// Construct with no defines.
+    ExtraDefines()
+    {
+    }
+
+    /// Construct.
+    ExtraDefines(const String& vsDefines, const String& psDefines) :
+        vsDefines_(vsDefines.Trimmed()),
+        psDefines_(psDefines.Trimmed())
+    {
+    }
+
+    /// Test for equality with another.
+    bool operator ==(const ExtraDefines& rhs) const { return vsDefines_ == rhs.vsDefines_ && psDefines_ == rhs.psDefines_; }
+
+    /// Test for inequality with another.
+    bool operator !=(const ExtraDefines& rhs) const { return !(*this == rhs); }
+
+    /// Vertex shader defines.
+    String vsDefines_;
+    /// Pixel shader defines.
+    String psDefines_;
+};
+
+SharedPtr<Context> context_(new Context());
+SharedPtr<Renderer> renderer_;
+/// Preprocessed shaders by resource name. Null if the shader failed to load.
+HashMap<String, SharedPtr<Shader> > shaders_;
+/// Render path command defines by pass name.
+HashMap<String, Vector<ExtraDefines> > passDefines_;
+/// Shadow qualities to expand the pass shaders for.
+PODVector<ShadowQuality> shadowQualities_;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+void AddRenderPath(const String& fileName);
+void AddPassDefines(const String& passName, const ExtraDefines& defines);
+void ExpandTechnique(Technique* technique);
+void AddShaderList(const String& fileName);
+void AddVariation(ShaderType type, const String& name, const String& defines);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+    {
+        ErrorExit(
+            "Usage: ShaderCacheTool <output file> <resource path(s)> [options]\n"
+            "\n"
+            "Writes the preprocessed source code of the shaders and the shader variations\n"
+            "the renderer uses for all techniques into a packed shader cache, which can be\n"
+            "loaded with Graphics::PrecacheShaders(). Resource paths are separated with\n"
+            "semicolons. The techniques in the Techniques directories are expanded also with\n"
+            "the shader defines of the materials in the Materials directories.\n"
+            "\n"
+            "Options:\n"
+            "-r <file>  Render path resource whose command shader defines to expand with.\n"
+            "           May be given several times\n"
+            "-x <file>  Shader list written by Graphics::BeginDumpShaders() to add, for\n"
+            "           example to include deferred light volume shaders. May be given\n"
+            "           several times\n"
+            "-q <n>     Shadow quality (0-5) to expand the shadowed variations for, default 2.\n"
+            "           May be given several times\n"
+        );
+    }
+
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    context_->RegisterSubsystem(new Log(context_));
+    RegisterGraphicsLibrary(context_);
+    // Without the graphics subsystem the renderer is not initialized, but can still list the pass shader variations
+    renderer_ = new Renderer(context_);
+
+    FileSystem* fileSystem = context_->GetSubsystem<FileSystem>();
+    ResourceCache* cache = context_->GetSubsystem<ResourceCache>();
+    Log* log = context_->GetSubsystem<Log>();
+    if (log)
+    {
+        log->SetLevel(LOG_WARNING);
+        log->SetTimeStamp(false);
+    }
+
+    String outputFile = arguments[0];
+    Vector<String> resourcePaths = arguments[1].Split(';');
+    Vector<String> renderPaths;
+    Vector<String> shaderLists;
+
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "r" && !value.Empty())
+            {
+                renderPaths.Push(value);
+                ++i;
+            }
+            else if (argument == "x" && !value.Empty())
+            {
+                shaderLists.Push(value);
+                ++i;
+            }
+            else if (argument == "q" && !value.Empty())
+            {
+                shadowQualities_.Push((ShadowQuality)Clamp(ToInt(value), (int)SHADOWQUALITY_SIMPLE_16BIT, (int)SHADOWQUALITY_BLUR_VSM));
+                ++i;
+            }
+            else
+                ErrorExit("Unknown option " + arguments[i]);
+        }
+    }
+
+    if (shadowQualities_.Empty())
+        shadowQualities_.Push(SHADOWQUALITY_PCF_16BIT);
+
+    for (unsigned i = 0; i < resourcePaths.Size(); ++i)
+    {
+        if (!cache->AddResourceDir(resourcePaths[i].Trimmed()))
+            ErrorExit("Could not add resource path " + resourcePaths[i]);
+    }
+
+    for (unsigned i = 0; i < renderPaths.Size(); ++i)
+        AddRenderPath(renderPaths[i]);
+
+    // Find the techniques, and the shader defines materials use them with
+    HashMap<String, Vector<ExtraDefines> > techniques;
+    const Vector<String>& resourceDirs = cache->GetResourceDirs();
+    for (unsigned i = 0; i < resourceDirs.Size(); ++i)
+    {
+        Vector<String> fileNames;
+        fileSystem->ScanDir(fileNames, resourceDirs[i] + "Techniques", "*.xml", SCAN_FILES, true);
+        for (unsigned j = 0; j < fileNames.Size(); ++j)
+        {
+            Vector<ExtraDefines>& techniqueDefines = techniques["Techniques/" + fileNames[j]];
+            if (!techniqueDefines.Contains(ExtraDefines()))
+                techniqueDefines.Push(ExtraDefines());
+        }
+
+        // Materials can not be loaded without the graphics subsystem, so read their XML directly
+        fileSystem->ScanDir(fileNames, resourceDirs[i] + "Materials", "*.xml", SCAN_FILES, true);
+        for (unsigned j = 0; j < fileNames.Size(); ++j)
+        {
+            XMLFile* materialFile = cache->GetResource<XMLFile>("Materials/" + fileNames[j]);
+            XMLElement materialElem = materialFile ? materialFile->GetRoot("material") : XMLElement();
+            XMLElement shaderElem = materialElem.GetChild("shader");
+            if (!shaderElem)
+                continue;
+
+            ExtraDefines materialDefines(shaderElem.GetAttribute("vsdefines"), shaderElem.GetAttribute("psdefines"));
+            for (XMLElement techniqueElem = materialElem.GetChild("technique"); techniqueElem;
+                 techniqueElem = techniqueElem.GetNext("technique"))
+            {
+                Vector<ExtraDefines>& techniqueDefines = techniques[techniqueElem.GetAttribute("name")];
+                if (!techniqueDefines.Contains(materialDefines))
+                    techniqueDefines.Push(materialDefines);
+            }
+        }
+    }
+
+    for (HashMap<String, Vector<ExtraDefines> >::ConstIterator i = techniques.Begin(); i != techniques.End(); ++i)
+    {
+        SharedPtr<Technique> technique(cache->GetResource<Technique>(i->first_));
+        if (!technique)
+            continue;
+
+        for (unsigned j = 0; j < i->second_.Size(); ++j)
+        {
+            const ExtraDefines& defines = i->second_[j];
+            if (defines.vsDefines_.Empty() && defines.psDefines_.Empty())
+                ExpandTechnique(technique);
+            else
+                ExpandTechnique(technique->CloneWithDefines(defines.vsDefines_, defines.psDefines_));
+        }
+    }
+
+    for (unsigned i = 0; i < shaderLists.Size(); ++i)
+        AddShaderList(shaderLists[i]);
+
+    // Write the shaders in name order so that the output only changes with the shaders
+    Vector<String> shaderNames;
+    for (HashMap<String, SharedPtr<Shader> >::ConstIterator i = shaders_.Begin(); i != shaders_.End(); ++i)
+    {
+        if (i->second_)
+            shaderNames.Push(i->first_);
+    }
+    Sort(shaderNames.Begin(), shaderNames.End());
+
+    Vector<SharedPtr<Shader> > shaders;
+    StringVector variationDefines;
+    unsigned numVariations = 0;
+    for (unsigned i = 0; i < shaderNames.Size(); ++i)
+    {
+        Shader* shader = shaders_[shaderNames[i]];
+        shaders.Push(SharedPtr<Shader>(shader));
+        shader->GetVariationDefines(VS, variationDefines);
+        numVariations += variationDefines.Size();
+        shader->GetVariationDefines(PS, variationDefines);
+        numVariations += variationDefines.Size();
+    }
+
+    File dest(context_);
+    if (!dest.Open(outputFile, FILE_WRITE))
+        ErrorExit("Could not open output file " + outputFile);
+    if (!ShaderPrecache::SaveCache(dest, shaders))
+        ErrorExit("Could not write output file " + outputFile);
+
+    PrintLine("Wrote " + String(shaders.Size()) + " shaders with " + String(numVariations) + " variations from " +
+        String(techniques.Size()) + " techniques to " + outputFile + " (" + String(dest.GetSize()) + " bytes)");
+}
+
+void AddRenderPath(const String& fileName)
+{
+    XMLFile* file = context_->GetSubsystem<ResourceCache>()->GetResource<XMLFile>(fileName);
+    RenderPath renderPath;
+    if (!file || !renderPath.Load(file))
+        ErrorExit("Could not load render path " + fileName);
+
+    for (unsigned i = 0; i < renderPath.GetNumCommands(); ++i)
+    {
+        const RenderPathCommand& command = *renderPath.GetCommand(i);
+        ExtraDefines defines(command.vertexShaderDefines_, command.pixelShaderDefines_);
+
+        // The forward lights command defines apply also to the lit base pass
+        if (command.type_ == CMD_SCENEPASS)
+            AddPassDefines(command.pass_, defines);
+        else if (command.type_ == CMD_FORWARDLIGHTS)
+        {
+            AddPassDefines(command.pass_, defines);
+            AddPassDefines("litbase", defines);
+        }
+    }
+}
+
+void AddPassDefines(const String& passName, const ExtraDefines& defines)
+{
+    if (defines.vsDefines_.Empty() && defines.psDefines_.Empty())
+        return;
+
+    Vector<ExtraDefines>& allDefines = passDefines_[passName.ToLower()];
+    if (!allDefines.Contains(defines))
+        allDefines.Push(defines);
+}
+
+void ExpandTechnique(Technique* technique)
+{
+    PODVector<Pass*> passes = technique->GetPasses();
+    Vector<String> vsDefines;
+    Vector<String> psDefines;
+
+    for (unsigned i = 0; i < passes.Size(); ++i)
+    {
+        Pass* pass = passes[i];
+
+        // Passes are drawn without extra defines unless the render path specifies them
+        Vector<ExtraDefines> extraDefines;
+        extraDefines.Push(ExtraDefines());
+        HashMap<String, Vector<ExtraDefines> >::ConstIterator j = passDefines_.Find(pass->GetName());
+        if (j != passDefines_.End())
+            extraDefines.Push(j->second_);
+
+        for (unsigned k = 0; k < extraDefines.Size(); ++k)
+        {
+            for (unsigned l = 0; l < shadowQualities_.Size(); ++l)
+            {
+                renderer_->GetPassShaderDefines(pass, extraDefines[k].vsDefines_, extraDefines[k].psDefines_, shadowQualities_[l],
+                    vsDefines, psDefines);
+                for (unsigned m = 0; m < vsDefines.Size(); ++m)
+                    AddVariation(VS, pass->GetVertexShader(), vsDefines[m]);
+                for (unsigned m = 0; m < psDefines.Size(); ++m)
+                    AddVariation(PS, pass->GetPixelShader(), psDefines[m]);
+            }
+        }
+    }
+}
+
+void AddShaderList(const String& fileName)
+{
+    File source(context_);
+    XMLFile xmlFile(context_);
+    if (!source.Open(fileName) || !xmlFile.Load(source))
+        ErrorExit("Could not load shader list " + fileName);
+
+    for (XMLElement shaderElem = xmlFile.GetRoot().GetChild("shader"); shaderElem; shaderElem = shaderElem.GetNext("shader"))
+    {
+        AddVariation(VS, shaderElem.GetAttribute("vs"), shaderElem.GetAttribute("vsdefines"));
+        AddVariation(PS, shaderElem.GetAttribute("ps"), shaderElem.GetAttribute("psdefines"));
+    }
+}
+
+void AddVariation(ShaderType type, const String& name, const String& defines)
+{
+    if (name.Empty())
+        return;
+
+    String fullName = SHADER_PATH + name + SHADER_EXTENSION;
+    HashMap<String, SharedPtr<Shader> >::Iterator i = shaders_.Find(fullName);
+    if (i == shaders_.End())
+    {
+        SharedPtr<Shader> shader(new Shader(context_));
+        shader->SetName(fullName);
+
+        SharedPtr<File> file = context_->GetSubsystem<ResourceCache>()->GetFile(fullName);
+        if (!file || !shader->LoadSource(*file))
+        {
+            PrintLine("Warning: could not load shader " + fullName);
+            shader.Reset();
+        }
+
+        i = shaders_.Insert(MakePair(fullName, shader));
+    }
+
+    if (i->second_)
+        i->second_->GetVariation(type, defines);
+}
@@ -37,6 +37,7 @@
 #include "../Graphics/Light.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/PagedTerrain.h"
 #include "../Graphics/ParticleEffect.h"
 #include "../Graphics/ParticleEmitter.h"
 #include "../Graphics/Renderer.h"
@@ -1775,6 +1776,9 @@ static void RegisterDecalSet(asIScriptEngine* engine)
     engine->RegisterObjectMethod("DecalSet", "uint get_maxIndices() const", asMETHOD(DecalSet, GetMaxIndices), asCALL_THISCALL);
     engine->RegisterObjectMethod("DecalSet", "void set_optimizeBufferSize(bool)", asMETHOD(DecalSet, SetOptimizeBufferSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("DecalSet", "bool get_optimizeBufferSize() const", asMETHOD(DecalSet, GetOptimizeBufferSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DecalSet", "void set_asyncGeneration(bool)", asMETHOD(DecalSet, SetAsyncGeneration), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DecalSet", "bool get_asyncGeneration() const", asMETHOD(DecalSet, GetAsyncGeneration), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DecalSet", "uint get_numPendingDecals() const", asMETHOD(DecalSet, GetNumPendingDecals), asCALL_THISCALL);
     engine->RegisterObjectMethod("DecalSet", "Zone@+ get_zone() const", asMETHOD(DecalSet, GetZone), asCALL_THISCALL);
 }
 
@@ -1783,6 +1787,7 @@ static void RegisterTerrain(asIScriptEngine* engine)
     RegisterDrawable<TerrainPatch>(engine, "TerrainPatch");
     RegisterComponent<Terrain>(engine, "Terrain");
     engine->RegisterObjectMethod("Terrain", "void ApplyHeightMap()", asMETHOD(Terrain, ApplyHeightMap), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void ApplyHeightMapRegion(const IntRect&in)", asMETHOD(Terrain, ApplyHeightMapRegion), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "float GetHeight(const Vector3&in) const", asMETHOD(Terrain, GetHeight), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "Vector3 GetNormal(const Vector3&in) const", asMETHOD(Terrain, GetNormal), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "TerrainPatch@+ GetPatch(int, int) const", asMETHODPR(Terrain, GetPatch, (int, int) const, TerrainPatch*), asCALL_THISCALL);
@@ -1837,6 +1842,45 @@ static void RegisterTerrain(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Terrain", "Terrain@+ get_westNeighbor() const", asMETHOD(Terrain, GetEastNeighbor), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_eastNeighbor(Terrain@+)", asMETHOD(Terrain, SetWestNeighbor), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "Terrain@+ get_eastNeighbor() const", asMETHOD(Terrain, GetWestNeighbor), asCALL_THISCALL);
+
+    RegisterComponent<PagedTerrain>(engine, "PagedTerrain");
+    engine->RegisterObjectMethod("PagedTerrain", "void RemoveAllTiles()", asMETHOD(PagedTerrain, RemoveAllTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Terrain@+ GetTile(int, int) const", asMETHOD(PagedTerrain, GetTile), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Terrain@+ GetTileAt(const Vector3&in) const", asMETHOD(PagedTerrain, GetTileAt), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float GetHeight(const Vector3&in) const", asMETHOD(PagedTerrain, GetHeight), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Vector3 GetNormal(const Vector3&in) const", asMETHOD(PagedTerrain, GetNormal), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_heightMapPrefix(const String&in)", asMETHOD(PagedTerrain, SetHeightMapPrefix), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const String& get_heightMapPrefix() const", asMETHOD(PagedTerrain, GetHeightMapPrefix), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_numTiles(const IntVector2&in)", asMETHOD(PagedTerrain, SetNumTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const IntVector2& get_numTiles() const", asMETHOD(PagedTerrain, GetNumTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_tileSize(int)", asMETHOD(PagedTerrain, SetTileSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "int get_tileSize() const", asMETHOD(PagedTerrain, GetTileSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_spacing(const Vector3&in)", asMETHOD(PagedTerrain, SetSpacing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const Vector3& get_spacing() const", asMETHOD(PagedTerrain, GetSpacing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_patchSize(int)", asMETHOD(PagedTerrain, SetPatchSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "int get_patchSize() const", asMETHOD(PagedTerrain, GetPatchSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_maxLodLevels(uint)", asMETHOD(PagedTerrain, SetMaxLodLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_maxLodLevels() const", asMETHOD(PagedTerrain, GetMaxLodLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_smoothing(bool)", asMETHOD(PagedTerrain, SetSmoothing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "bool get_smoothing() const", asMETHOD(PagedTerrain, GetSmoothing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_material(Material@+)", asMETHOD(PagedTerrain, SetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Material@+ get_material() const", asMETHOD(PagedTerrain, GetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_loadDistance(float)", asMETHOD(PagedTerrain, SetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_loadDistance() const", asMETHOD(PagedTerrain, GetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_unloadDistance(float)", asMETHOD(PagedTerrain, SetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_unloadDistance() const", asMETHOD(PagedTerrain, GetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_maxTileBuildsPerFrame(uint)", asMETHOD(PagedTerrain, SetMaxTileBuildsPerFrame), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_maxTileBuildsPerFrame() const", asMETHOD(PagedTerrain, GetMaxTileBuildsPerFrame), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_focusNode(Node@+)", asMETHOD(PagedTerrain, SetFocusNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Node@+ get_focusNode() const", asMETHOD(PagedTerrain, GetFocusNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_drawDistance(float)", asMETHOD(PagedTerrain, SetDrawDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_drawDistance() const", asMETHOD(PagedTerrain, GetDrawDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_castShadows(bool)", asMETHOD(PagedTerrain, SetCastShadows), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "bool get_castShadows() const", asMETHOD(PagedTerrain, GetCastShadows), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_occluder(bool)", asMETHOD(PagedTerrain, SetOccluder), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "bool get_occluder() const", asMETHOD(PagedTerrain, IsOccluder), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_numActiveTiles() const", asMETHOD(PagedTerrain, GetNumActiveTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_numCreatedTiles() const", asMETHOD(PagedTerrain, GetNumCreatedTiles), asCALL_THISCALL);
 }
 
 
@@ -26,6 +26,7 @@
 
 #include "../AngelScript/APITemplates.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestGrid.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkPriority.h"
 
@@ -43,6 +44,20 @@ static void RegisterNetworkPriority(asIScriptEngine* engine)
     engine->RegisterObjectMethod("NetworkPriority", "float get_minPriority() const", asMETHOD(NetworkPriority, GetMinPriority), asCALL_THISCALL);
     engine->RegisterObjectMethod("NetworkPriority", "void set_alwaysUpdateOwner(bool)", asMETHOD(NetworkPriority, SetAlwaysUpdateOwner), asCALL_THISCALL);
     engine->RegisterObjectMethod("NetworkPriority", "bool get_alwaysUpdateOwner() const", asMETHOD(NetworkPriority, GetAlwaysUpdateOwner), asCALL_THISCALL);
+    engine->RegisterObjectMethod("NetworkPriority", "void set_alwaysRelevant(bool)", asMETHOD(NetworkPriority, SetAlwaysRelevant), asCALL_THISCALL);
+    engine->RegisterObjectMethod("NetworkPriority", "bool get_alwaysRelevant() const", asMETHOD(NetworkPriority, GetAlwaysRelevant), asCALL_THISCALL);
+}
+
+static void RegisterInterestGrid(asIScriptEngine* engine)
+{
+    RegisterComponent<InterestGrid>(engine, "InterestGrid");
+    engine->RegisterObjectMethod("InterestGrid", "void set_cellSize(float)", asMETHOD(InterestGrid, SetCellSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "float get_cellSize() const", asMETHOD(InterestGrid, GetCellSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "void set_relevanceDistance(float)", asMETHOD(InterestGrid, SetRelevanceDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "float get_relevanceDistance() const", asMETHOD(InterestGrid, GetRelevanceDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "void set_exitMargin(float)", asMETHOD(InterestGrid, SetExitMargin), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "float get_exitMargin() const", asMETHOD(InterestGrid, GetExitMargin), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestGrid", "uint get_numCells() const", asMETHOD(InterestGrid, GetNumCells), asCALL_THISCALL);
 }
 
 void SendRemoteEvent(const String& eventType, bool inOrder, const VariantMap& eventData, Connection* ptr)
@@ -188,6 +203,10 @@ void RegisterNetwork(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Network", "int get_simulatedLatency() const", asMETHOD(Network, GetSimulatedLatency), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_simulatedPacketLoss(float)", asMETHOD(Network, SetSimulatedPacketLoss), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "float get_simulatedPacketLoss() const", asMETHOD(Network, GetSimulatedPacketLoss), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "void set_snapshotReplication(bool)", asMETHOD(Network, SetSnapshotReplication), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "bool get_snapshotReplication() const", asMETHOD(Network, GetSnapshotReplication), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "void set_snapshotQuantization(float)", asMETHOD(Network, SetSnapshotQuantization), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Network", "float get_snapshotQuantization() const", asMETHOD(Network, GetSnapshotQuantization), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "void set_packageCacheDir(const String&in)", asMETHOD(Network, SetPackageCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "const String& get_packageCacheDir() const", asMETHOD(Network, GetPackageCacheDir), asCALL_THISCALL);
     engine->RegisterObjectMethod("Network", "bool get_serverRunning() const", asMETHOD(Network, IsServerRunning), asCALL_THISCALL);
@@ -199,6 +218,7 @@ void RegisterNetwork(asIScriptEngine* engine)
 void RegisterNetworkAPI(asIScriptEngine* engine)
 {
     RegisterNetworkPriority(engine);
+    RegisterInterestGrid(engine);
     RegisterConnection(engine);
     RegisterHttpRequest(engine);
     RegisterNetwork(engine);
@@ -368,6 +368,15 @@ static void RegisterListView(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ListView", "bool get_clearSelectionOnDefocus() const", asMETHOD(ListView, GetClearSelectionOnDefocus), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "void set_selectOnClickEnd(bool)", asMETHOD(ListView, SetSelectOnClickEnd), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "bool get_selectOnClickEnd() const", asMETHOD(ListView, GetSelectOnClickEnd), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void RefreshVirtualItems()", asMETHOD(ListView, RefreshVirtualItems), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualMode(bool)", asMETHOD(ListView, SetVirtualMode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "bool get_virtualMode() const", asMETHOD(ListView, GetVirtualMode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_numVirtualItems(uint)", asMETHOD(ListView, SetNumVirtualItems), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "uint get_numVirtualItems() const", asMETHOD(ListView, GetNumItems), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualItemHeight(int)", asMETHOD(ListView, SetVirtualItemHeight), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "int get_virtualItemHeight() const", asMETHOD(ListView, GetVirtualItemHeight), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualItemType(StringHash)", asMETHOD(ListView, SetVirtualItemType), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "StringHash get_virtualItemType() const", asMETHOD(ListView, GetVirtualItemType), asCALL_THISCALL);
 }
 
 static void RegisterText(asIScriptEngine* engine)
@@ -787,6 +796,8 @@ static void RegisterUI(asIScriptEngine* engine)
     engine->RegisterObjectMethod("UI", "bool get_useScreenKeyboard() const", asMETHOD(UI, GetUseScreenKeyboard), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_useMutableGlyphs(bool)", asMETHOD(UI, SetUseMutableGlyphs), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool get_useMutableGlyphs() const", asMETHOD(UI, GetUseMutableGlyphs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_useBatchCaching(bool)", asMETHOD(UI, SetUseBatchCaching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_useBatchCaching() const", asMETHOD(UI, GetUseBatchCaching), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_forceAutoHint(bool)", asMETHOD(UI, SetForceAutoHint), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool get_forceAutoHint() const", asMETHOD(UI, GetForceAutoHint), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_fontHintLevel(FontHintLevel)", asMETHOD(UI, SetFontHintLevel), asCALL_THISCALL);
@@ -795,6 +806,8 @@ static void RegisterUI(asIScriptEngine* engine)
     engine->RegisterObjectMethod("UI", "float get_fontSubpixelThreshold() const", asMETHOD(UI, GetFontSubpixelThreshold), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_fontOversampling(int)", asMETHOD(UI, SetFontOversampling), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "int get_fontOversampling() const", asMETHOD(UI, GetFontOversampling), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_fontCachePath(const String&in)", asMETHOD(UI, SetFontCachePath), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "const String& get_fontCachePath() const", asMETHOD(UI, GetFontCachePath), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_scale(float value)", asMETHOD(UI, SetScale), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "float get_scale() const", asMETHOD(UI, GetScale), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_customSize(const IntVector2&in)", asMETHODPR(UI, SetCustomSize, (const IntVector2&), void), asCALL_THISCALL);
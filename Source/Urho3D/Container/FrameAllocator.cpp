@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static inline unsigned char* GetBlockData(FrameAllocatorBlock* block)
+{
+    return reinterpret_cast<unsigned char*>(block + 1);
+}
+
+FrameAllocator::FrameAllocator(unsigned blockSize) :
+    block_(nullptr),
+    blockSize_(blockSize ? blockSize : FRAME_ALLOCATOR_BLOCK_SIZE),
+    generation_(0),
+    peakUsedSize_(0)
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    while (block_)
+    {
+        FrameAllocatorBlock* next = block_->next_;
+        delete[] reinterpret_cast<unsigned char*>(block_);
+        block_ = next;
+    }
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned alignment)
+{
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    if (block_)
+    {
+        size_t address = reinterpret_cast<size_t>(GetBlockData(block_)) + block_->used_;
+        unsigned padding = (unsigned)((alignment - (address & (alignment - 1))) & (alignment - 1));
+        if (block_->used_ + padding + size <= block_->size_)
+        {
+            void* ret = GetBlockData(block_) + block_->used_ + padding;
+            block_->used_ += padding + size;
+            return ret;
+        }
+    }
+
+    // Does not fit, start a new block at least twice the size of the previous. The previous block keeps its allocations until reset
+    unsigned newSize = size + alignment;
+    if (block_ && newSize < block_->size_ * 2)
+        newSize = block_->size_ * 2;
+    AllocateBlock(newSize);
+    size_t address = reinterpret_cast<size_t>(GetBlockData(block_));
+    unsigned padding = (unsigned)((alignment - (address & (alignment - 1))) & (alignment - 1));
+    block_->used_ = padding + size;
+    return GetBlockData(block_) + padding;
+}
+
+void* FrameAllocator::Reallocate(void* ptr, unsigned oldSize, unsigned newSize, unsigned copySize, unsigned alignment)
+{
+    if (!ptr)
+        return Allocate(newSize, alignment);
+
+    unsigned char* data = static_cast<unsigned char*>(ptr);
+    if (block_ && data + oldSize == GetBlockData(block_) + block_->used_)
+    {
+        unsigned start = (unsigned)(data - GetBlockData(block_));
+        if (start + newSize <= block_->size_)
+        {
+            block_->used_ = start + newSize;
+            return ptr;
+        }
+    }
+
+    void* ret = Allocate(newSize, alignment);
+    if (copySize)
+        memcpy(ret, ptr, copySize);
+    return ret;
+}
+
+void FrameAllocator::Free(void* ptr, unsigned size)
+{
+    if (!ptr || !block_)
+        return;
+
+    unsigned char* end = static_cast<unsigned char*>(ptr) + size;
+    if (end == GetBlockData(block_) + block_->used_)
+        block_->used_ -= size;
+}
+
+void FrameAllocator::Reset()
+{
+    unsigned usedSize = GetUsedSize();
+    if (usedSize > peakUsedSize_)
+        peakUsedSize_ = usedSize;
+
+    // If the frame overflowed into several blocks, replace them with a single block that holds them all
+    if (block_ && block_->next_)
+    {
+        unsigned capacity = GetCapacity();
+        while (block_)
+        {
+            FrameAllocatorBlock* next = block_->next_;
+            delete[] reinterpret_cast<unsigned char*>(block_);
+            block_ = next;
+        }
+        AllocateBlock(capacity);
+    }
+
+    if (block_)
+        block_->used_ = 0;
+    ++generation_;
+}
+
+unsigned FrameAllocator::GetUsedSize() const
+{
+    unsigned used = 0;
+    for (FrameAllocatorBlock* block = block_; block; block = block->next_)
+        used += block->used_;
+    return used;
+}
+
+unsigned FrameAllocator::GetCapacity() const
+{
+    unsigned capacity = 0;
+    for (FrameAllocatorBlock* block = block_; block; block = block->next_)
+        capacity += block->size_;
+    return capacity;
+}
+
+void FrameAllocator::AllocateBlock(unsigned size)
+{
+    if (size < blockSize_)
+        size = blockSize_;
+
+    unsigned char* blockPtr = new unsigned char[sizeof(FrameAllocatorBlock) + size];
+    FrameAllocatorBlock* newBlock = reinterpret_cast<FrameAllocatorBlock*>(blockPtr);
+    newBlock->size_ = size;
+    newBlock->used_ = 0;
+    newBlock->next_ = block_;
+    block_ = newBlock;
+}
+
+}
@@ -0,0 +1,323 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Container/VectorBase.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Default frame allocator block size in bytes.
+static const unsigned FRAME_ALLOCATOR_BLOCK_SIZE = 64 * 1024;
+/// Default frame allocator alignment in bytes.
+static const unsigned FRAME_ALLOCATOR_ALIGNMENT = 16;
+
+/// %Frame allocator memory block.
+struct FrameAllocatorBlock
+{
+    /// Size of the data.
+    unsigned size_;
+    /// Bytes in use.
+    unsigned used_;
+    /// Previous, fully used block.
+    FrameAllocatorBlock* next_;
+    /// Data follows.
+};
+
+/// Linear allocator for transient memory that is only needed until the end of the frame. Allocation bumps a pointer and
+/// individual allocations are not freed, except for the most recent one. Reset() frees everything at once and keeps the memory
+/// for the next frame. Not thread-safe.
+class URHO3D_API FrameAllocator
+{
+public:
+    /// Construct with the initial block size.
+    FrameAllocator(unsigned blockSize = FRAME_ALLOCATOR_BLOCK_SIZE);
+    /// Destruct. Free all blocks.
+    ~FrameAllocator();
+
+    /// Allocate memory, valid until the next Reset(). The alignment must be a power of two.
+    void* Allocate(unsigned size, unsigned alignment = FRAME_ALLOCATOR_ALIGNMENT);
+    /// Resize an allocation, copying the first copySize bytes if it has to move. Grows in place if it was the most recent allocation and the block has room.
+    void* Reallocate(void* ptr, unsigned oldSize, unsigned newSize, unsigned copySize, unsigned alignment = FRAME_ALLOCATOR_ALIGNMENT);
+    /// Free memory. The space is reused immediately only if it was the most recent allocation, otherwise at the next Reset().
+    void Free(void* ptr, unsigned size);
+    /// Free all allocations. If the frame needed several blocks, they are replaced with one block large enough for all of them.
+    void Reset();
+
+    /// Return reset counter. Memory allocated before a reset is invalid if the counter has changed since.
+    unsigned GetGeneration() const { return generation_; }
+    /// Return bytes allocated since the last reset.
+    unsigned GetUsedSize() const;
+    /// Return total size of the blocks.
+    unsigned GetCapacity() const;
+    /// Return the largest number of bytes used in a frame so far.
+    unsigned GetPeakUsedSize() const { return peakUsedSize_; }
+
+private:
+    /// Prevent copy construction.
+    FrameAllocator(const FrameAllocator& rhs);
+    /// Prevent assignment.
+    FrameAllocator& operator =(const FrameAllocator& rhs);
+
+    /// Allocate a new current block.
+    void AllocateBlock(unsigned size);
+
+    /// Current block. Earlier blocks of the frame are chained after it.
+    FrameAllocatorBlock* block_;
+    /// Minimum block size.
+    unsigned blockSize_;
+    /// Reset counter.
+    unsigned generation_;
+    /// Largest number of bytes used in a frame.
+    unsigned peakUsedSize_;
+};
+
+/// Vector of plain data elements that stores its elements in a FrameAllocator. The contents are valid until the allocator is
+/// reset. After that the vector reads as empty, and adding elements starts from a new buffer.
+template <class T> class FrameVector
+{
+public:
+    typedef T ValueType;
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty without an allocator. An allocator must be set before adding elements.
+    FrameVector() :
+        allocator_(nullptr),
+        buffer_(nullptr),
+        size_(0),
+        capacity_(0),
+        generation_(0)
+    {
+    }
+
+    /// Construct empty with an allocator.
+    explicit FrameVector(FrameAllocator* allocator) :
+        allocator_(allocator),
+        buffer_(nullptr),
+        size_(0),
+        capacity_(0),
+        generation_(0)
+    {
+    }
+
+    /// Construct from another vector, using the same allocator.
+    FrameVector(const FrameVector<T>& vector) :
+        allocator_(vector.allocator_),
+        buffer_(nullptr),
+        size_(0),
+        capacity_(0),
+        generation_(0)
+    {
+        *this = vector;
+    }
+
+    /// Destruct.
+    ~FrameVector()
+    {
+        ReleaseBuffer();
+    }
+
+    /// Assign from another vector. Uses the allocator of the other vector if this has none.
+    FrameVector<T>& operator =(const FrameVector<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            if (!allocator_)
+                allocator_ = rhs.allocator_;
+            Resize(rhs.Size());
+            if (size_)
+                memcpy(buffer_, rhs.buffer_, size_ * sizeof(T));
+        }
+        return *this;
+    }
+
+    /// Set the allocator. Releases the current elements.
+    void SetAllocator(FrameAllocator* allocator)
+    {
+        ReleaseBuffer();
+        allocator_ = allocator;
+    }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < Size());
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < Size());
+        return buffer_[index];
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_ || !IsBufferValid())
+        {
+            // The value may be in the old buffer
+            T copy = value;
+            Reserve(capacity_ && IsBufferValid() ? capacity_ * 2 : 8);
+            buffer_[size_++] = copy;
+        }
+        else
+            buffer_[size_++] = value;
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        if (Size())
+            --size_;
+    }
+
+    /// Resize the vector. New elements are uninitialized.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_ || !IsBufferValid())
+            Reserve(newSize > capacity_ * 2 ? newSize : capacity_ * 2);
+        size_ = newSize;
+    }
+
+    /// Set new capacity.
+    void Reserve(unsigned newCapacity)
+    {
+        if (!IsBufferValid())
+        {
+            buffer_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        }
+        if (newCapacity <= capacity_)
+            return;
+
+        assert(allocator_);
+        buffer_ = static_cast<T*>(allocator_->Reallocate(buffer_, capacity_ * sizeof(T), newCapacity * sizeof(T), size_ * sizeof(T)));
+        capacity_ = newCapacity;
+        generation_ = allocator_->GetGeneration();
+    }
+
+    /// Remove all elements. Keeps the buffer if it is still valid.
+    void Clear()
+    {
+        if (!IsBufferValid())
+        {
+            buffer_ = nullptr;
+            capacity_ = 0;
+        }
+        size_ = 0;
+    }
+
+    /// Return whether contains a specific value.
+    bool Contains(const T& value) const
+    {
+        for (unsigned i = 0; i < Size(); ++i)
+        {
+            if (buffer_[i] == value)
+                return true;
+        }
+        return false;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + Size()); }
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + Size()); }
+    /// Return first element.
+    T& Front()
+    {
+        assert(Size());
+        return buffer_[0];
+    }
+    /// Return const first element.
+    const T& Front() const
+    {
+        assert(Size());
+        return buffer_[0];
+    }
+    /// Return last element.
+    T& Back()
+    {
+        assert(Size());
+        return buffer_[size_ - 1];
+    }
+    /// Return const last element.
+    const T& Back() const
+    {
+        assert(Size());
+        return buffer_[size_ - 1];
+    }
+    /// Return number of elements. A vector whose buffer was invalidated by resetting the allocator is empty.
+    unsigned Size() const { return IsBufferValid() ? size_ : 0; }
+    /// Return capacity of the buffer.
+    unsigned Capacity() const { return IsBufferValid() ? capacity_ : 0; }
+    /// Return whether vector is empty.
+    bool Empty() const { return Size() == 0; }
+    /// Return the buffer, or null if it was invalidated by resetting the allocator.
+    T* Buffer() const { return IsBufferValid() ? buffer_ : nullptr; }
+    /// Return the allocator.
+    FrameAllocator* GetAllocator() const { return allocator_; }
+
+private:
+    /// Return whether the buffer was allocated after the last reset of the allocator.
+    bool IsBufferValid() const { return !buffer_ || allocator_->GetGeneration() == generation_; }
+
+    /// Return the buffer to the allocator if it is still valid.
+    void ReleaseBuffer()
+    {
+        if (buffer_ && IsBufferValid())
+            allocator_->Free(buffer_, capacity_ * sizeof(T));
+        buffer_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+    }
+
+    /// Allocator.
+    FrameAllocator* allocator_;
+    /// Element buffer.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Capacity of the buffer.
+    unsigned capacity_;
+    /// Allocator generation of the buffer.
+    unsigned generation_;
+};
+
+}
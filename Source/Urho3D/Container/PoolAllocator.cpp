@@ -0,0 +1,256 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/PoolAllocator.h"
+
+#include <atomic>
+#include <thread>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Free pool allocator node.
+struct PoolNode
+{
+    /// Next free node in the same batch.
+    PoolNode* next_;
+    /// Next batch in the global free list. Only valid in the first node of a batch.
+    PoolNode* nextBatch_;
+};
+
+/// Global free list and chunk of a pool allocator size class.
+struct PoolSizeClass
+{
+    /// Batches of free nodes returned by threads. Batches are pushed without locking. Popping is serialized by the pool lock, so the list has no ABA problem.
+    std::atomic<PoolNode*> batches_;
+    /// Chunk being carved into nodes.
+    unsigned char* chunk_;
+    /// Bytes of the chunk carved so far.
+    unsigned chunkUsed_;
+};
+
+/// Per-thread cache of free pool allocator nodes.
+struct PoolThreadCache
+{
+    /// Free nodes per size class.
+    PoolNode* free_[POOL_ALLOCATOR_NUM_SIZE_CLASSES];
+    /// Number of free nodes per size class.
+    unsigned count_[POOL_ALLOCATOR_NUM_SIZE_CLASSES];
+    /// Whether the cache flusher has been initialized for this thread.
+    bool registered_;
+    /// Whether the thread has exited and returned its cache. Later allocations and frees go directly to the global pool.
+    bool exited_;
+};
+
+/// Returns the thread cache to the global pool when the thread exits.
+struct PoolThreadCacheFlusher
+{
+    /// Destruct. Return the cached nodes.
+    ~PoolThreadCacheFlusher();
+
+    /// Touched on first use to register the destructor.
+    bool active_;
+};
+
+/// Size classes. Zero-initialized and trivially destructible, so they are usable during static initialization and destruction.
+static PoolSizeClass sizeClasses[POOL_ALLOCATOR_NUM_SIZE_CLASSES];
+/// Lock for popping batches and carving chunks.
+static std::atomic<bool> poolLock;
+/// Thread cache. Trivially destructible so that it stays usable while other thread-local objects are destroyed.
+static thread_local PoolThreadCache threadCache;
+/// Thread cache flusher.
+static thread_local PoolThreadCacheFlusher threadCacheFlusher;
+
+static unsigned GetPoolBatchSize(unsigned sizeClass)
+{
+    unsigned batchSize = POOL_ALLOCATOR_CACHE_SIZE / 2 / GetPoolSizeClassSize(sizeClass);
+    return batchSize > 8 ? batchSize : 8;
+}
+
+static void LockPool()
+{
+    while (poolLock.exchange(true, std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+static void UnlockPool()
+{
+    poolLock.store(false, std::memory_order_release);
+}
+
+static void PushBatch(PoolSizeClass& sizeClass, PoolNode* batch)
+{
+    PoolNode* head = sizeClass.batches_.load(std::memory_order_relaxed);
+    do
+        batch->nextBatch_ = head;
+    while (!sizeClass.batches_.compare_exchange_weak(head, batch, std::memory_order_release, std::memory_order_relaxed));
+}
+
+static PoolNode* CarveNodes(unsigned sizeClassIndex, unsigned count)
+{
+    PoolSizeClass& sizeClass = sizeClasses[sizeClassIndex];
+    unsigned nodeSize = GetPoolSizeClassSize(sizeClassIndex);
+    PoolNode* first = nullptr;
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        // The remainder of a chunk too small for a node is left unused
+        if (!sizeClass.chunk_ || sizeClass.chunkUsed_ + nodeSize > POOL_ALLOCATOR_CHUNK_SIZE)
+        {
+            sizeClass.chunk_ = new unsigned char[POOL_ALLOCATOR_CHUNK_SIZE];
+            sizeClass.chunkUsed_ = 0;
+        }
+
+        PoolNode* node = reinterpret_cast<PoolNode*>(sizeClass.chunk_ + sizeClass.chunkUsed_);
+        sizeClass.chunkUsed_ += nodeSize;
+        node->next_ = first;
+        first = node;
+    }
+
+    return first;
+}
+
+static void RefillCache(PoolThreadCache& cache, unsigned sizeClassIndex)
+{
+    PoolSizeClass& sizeClass = sizeClasses[sizeClassIndex];
+    PoolNode* batch;
+
+    LockPool();
+    batch = sizeClass.batches_.load(std::memory_order_acquire);
+    while (batch && !sizeClass.batches_.compare_exchange_weak(batch, batch->nextBatch_, std::memory_order_acquire,
+        std::memory_order_acquire))
+        ;
+    if (!batch)
+        batch = CarveNodes(sizeClassIndex, GetPoolBatchSize(sizeClassIndex));
+    UnlockPool();
+
+    unsigned count = 0;
+    for (PoolNode* node = batch; node; node = node->next_)
+        ++count;
+
+    cache.free_[sizeClassIndex] = batch;
+    cache.count_[sizeClassIndex] = count;
+}
+
+static void TrimCache(PoolThreadCache& cache, unsigned sizeClassIndex)
+{
+    // Return the most recently freed nodes to the global pool as one batch
+    unsigned batchSize = GetPoolBatchSize(sizeClassIndex);
+    PoolNode* first = cache.free_[sizeClassIndex];
+    PoolNode* last = first;
+    for (unsigned i = 1; i < batchSize; ++i)
+        last = last->next_;
+
+    cache.free_[sizeClassIndex] = last->next_;
+    cache.count_[sizeClassIndex] -= batchSize;
+    last->next_ = nullptr;
+    PushBatch(sizeClasses[sizeClassIndex], first);
+}
+
+static PoolThreadCache& GetThreadCache()
+{
+    PoolThreadCache& cache = threadCache;
+    if (!cache.registered_)
+    {
+        cache.registered_ = true;
+        threadCacheFlusher.active_ = true;
+    }
+    return cache;
+}
+
+PoolThreadCacheFlusher::~PoolThreadCacheFlusher()
+{
+    PoolThreadCache& cache = threadCache;
+    for (unsigned i = 0; i < POOL_ALLOCATOR_NUM_SIZE_CLASSES; ++i)
+    {
+        while (cache.count_[i] > GetPoolBatchSize(i))
+            TrimCache(cache, i);
+        if (cache.free_[i])
+            PushBatch(sizeClasses[i], cache.free_[i]);
+
+        cache.free_[i] = nullptr;
+        cache.count_[i] = 0;
+    }
+
+    cache.exited_ = true;
+}
+
+void* PoolAllocate(unsigned size)
+{
+    if (size > POOL_ALLOCATOR_MAX_SIZE)
+        return new unsigned char[size];
+    if (!size)
+        size = 1;
+
+    unsigned sizeClassIndex = GetPoolSizeClass(size);
+    PoolThreadCache& cache = GetThreadCache();
+    if (cache.exited_)
+    {
+        LockPool();
+        void* ret = CarveNodes(sizeClassIndex, 1);
+        UnlockPool();
+        return ret;
+    }
+
+    if (!cache.free_[sizeClassIndex])
+        RefillCache(cache, sizeClassIndex);
+
+    PoolNode* node = cache.free_[sizeClassIndex];
+    cache.free_[sizeClassIndex] = node->next_;
+    --cache.count_[sizeClassIndex];
+    return node;
+}
+
+void PoolFree(void* ptr, unsigned size)
+{
+    if (!ptr)
+        return;
+    if (size > POOL_ALLOCATOR_MAX_SIZE)
+    {
+        delete[] static_cast<unsigned char*>(ptr);
+        return;
+    }
+    if (!size)
+        size = 1;
+
+    unsigned sizeClassIndex = GetPoolSizeClass(size);
+    PoolNode* node = static_cast<PoolNode*>(ptr);
+    PoolThreadCache& cache = GetThreadCache();
+    if (cache.exited_)
+    {
+        node->next_ = nullptr;
+        PushBatch(sizeClasses[sizeClassIndex], node);
+        return;
+    }
+
+    node->next_ = cache.free_[sizeClassIndex];
+    cache.free_[sizeClassIndex] = node;
+    if (++cache.count_[sizeClassIndex] > 2 * GetPoolBatchSize(sizeClassIndex))
+        TrimCache(cache, sizeClassIndex);
+}
+
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include <stddef.h>
+
+namespace Urho3D
+{
+
+/// Largest allocation served by the pool allocator. Larger sizes go to the system allocator.
+static const unsigned POOL_ALLOCATOR_MAX_SIZE = 4096;
+/// Number of pool allocator size classes: 16 byte steps up to 256 bytes, then 256 byte steps up to the maximum size.
+static const unsigned POOL_ALLOCATOR_NUM_SIZE_CLASSES = 16 + (POOL_ALLOCATOR_MAX_SIZE - 256) / 256;
+/// Size of the memory chunks the pool allocator carves its nodes from.
+static const unsigned POOL_ALLOCATOR_CHUNK_SIZE = 64 * 1024;
+/// Bytes per size class a thread may keep cached before returning nodes to the global pool.
+static const unsigned POOL_ALLOCATOR_CACHE_SIZE = 32 * 1024;
+
+/// Return the pool allocator size class for an allocation size. The size must be nonzero and at most POOL_ALLOCATOR_MAX_SIZE.
+inline unsigned GetPoolSizeClass(unsigned size) { return size <= 256 ? (size - 1) >> 4 : 16 + ((size - 257) >> 8); }
+/// Return the node size of a pool allocator size class.
+inline unsigned GetPoolSizeClassSize(unsigned sizeClass) { return sizeClass < 16 ? (sizeClass + 1) << 4 : (sizeClass - 14) << 8; }
+
+/// Allocate memory from the size class pool. Thread-safe. Each thread allocates from its own cache of free nodes, which is refilled from the global pool in batches.
+URHO3D_API void* PoolAllocate(unsigned size);
+/// Free memory allocated with PoolAllocate(). The size must be the same as in the allocation. Thread-safe, memory may be freed from a different thread than it was allocated in.
+URHO3D_API void PoolFree(void* ptr, unsigned size);
+
+}
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+// Class-specific operator new would hide the debug operator new used by DebugNew.h, so use the default allocation for leak tracking
+#define URHO3D_POOL_ALLOCATION
+#else
+/// Allocate instances of the class and its subclasses from the size class pool. The class must have a virtual destructor if subclasses are deleted through a base pointer.
+#define URHO3D_POOL_ALLOCATION \
+    public: \
+        static void* operator new(size_t size) { return Urho3D::PoolAllocate((unsigned)size); } \
+        static void* operator new(size_t, void* ptr) { return ptr; } \
+        static void operator delete(void* ptr, size_t size) { Urho3D::PoolFree(ptr, (unsigned)size); } \
+        static void operator delete(void*, void*) { }
+#endif
@@ -202,6 +202,7 @@ public:
 
 private:
     template <class U> friend class SharedPtr;
+    template <class U> friend class WeakPtr;
 
     /// Add a reference to the object pointed to.
     void AddRef()
@@ -357,10 +358,21 @@ public:
     /// Convert to a shared pointer. If expired, return a null shared pointer.
     SharedPtr<T> Lock() const
     {
+#ifdef URHO3D_ATOMIC_REFCOUNT
+        // Take the reference atomically, as the object may be releasing its last reference in another thread
+        if (!refCount_ || !refCount_->TryAddRef())
+            return SharedPtr<T>();
+
+        // Adopt the reference taken above
+        SharedPtr<T> ret;
+        ret.ptr_ = ptr_;
+        return ret;
+#else
         if (Expired())
             return SharedPtr<T>();
         else
             return SharedPtr<T>(ptr_);
+#endif
     }
 
     /// Return raw pointer. If expired, return null.
@@ -442,7 +454,7 @@ public:
     bool NotNull() const { return refCount_ != 0; }
 
     /// Return the object's reference count, or 0 if null pointer or if object has expired.
-    int Refs() const { return (refCount_ && refCount_->refs_ >= 0) ? refCount_->refs_ : 0; }
+    int Refs() const { return (refCount_ && refCount_->refs_ >= 0) ? (int)refCount_->refs_ : 0; }
 
     /// Return the object's weak reference count.
     int WeakRefs() const
@@ -450,7 +462,7 @@ public:
         if (!Expired())
             return ptr_->WeakRefs();
         else
-            return refCount_ ? refCount_->weakRefs_ : 0;
+            return refCount_ ? (int)refCount_->weakRefs_ : 0;
     }
 
     /// Return whether the object has expired. If null pointer, always return true.
@@ -481,9 +493,8 @@ private:
         if (refCount_)
         {
             assert(refCount_->weakRefs_ > 0);
-            --(refCount_->weakRefs_);
 
-            if (Expired() && !refCount_->weakRefs_)
+            if (!--(refCount_->weakRefs_) && Expired())
                 delete refCount_;
         }
 
@@ -39,13 +39,12 @@ RefCounted::RefCounted() :
 RefCounted::~RefCounted()
 {
     assert(refCount_);
-    assert(refCount_->refs_ == 0);
+    assert(refCount_->refs_ <= 0);
     assert(refCount_->weakRefs_ > 0);
 
     // Mark object as expired, release the self weak ref and delete the refcount if no other weak refs exist
     refCount_->refs_ = -1;
-    (refCount_->weakRefs_)--;
-    if (!refCount_->weakRefs_)
+    if (!--(refCount_->weakRefs_))
         delete refCount_;
 
     refCount_ = nullptr;
@@ -59,10 +58,17 @@ void RefCounted::AddRef()
 
 void RefCounted::ReleaseRef()
 {
+#ifdef URHO3D_ATOMIC_REFCOUNT
     assert(refCount_->refs_ > 0);
-    (refCount_->refs_)--;
-    if (!refCount_->refs_)
+    // WeakPtr::Lock() never takes a reference from zero, so the thread releasing the last reference is the only one left
+    // with access to the object
+    if (refCount_->refs_.fetch_sub(1) == 1)
         delete this;
+#else
+    assert(refCount_->refs_ > 0);
+    if (!--(refCount_->refs_))
+        delete this;
+#endif
 }
 
 int RefCounted::Refs() const
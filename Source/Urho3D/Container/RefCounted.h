@@ -28,12 +28,20 @@
 #include <Urho3D/Urho3D.h>
 #endif
 
+#include "../Container/PoolAllocator.h"
+
+#ifdef URHO3D_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
+
 namespace Urho3D
 {
 
-/// Reference count structure.
+/// Reference count structure. With the URHO3D_ATOMIC_REFCOUNT build option the counts are atomic, so that strong and weak references may be added and released from several threads.
 struct RefCount
 {
+    URHO3D_POOL_ALLOCATION;
+
     /// Construct.
     RefCount() :
         refs_(0),
@@ -49,10 +57,36 @@ struct RefCount
         weakRefs_ = -1;
     }
 
+    /// Add a reference only while the object still has references. A zero count means the last reference has been released and the object is being destroyed, so it is never resurrected. Return true if added.
+    bool TryAddRef()
+    {
+#ifdef URHO3D_ATOMIC_REFCOUNT
+        int refs = refs_.load();
+        while (refs > 0)
+        {
+            if (refs_.compare_exchange_weak(refs, refs + 1))
+                return true;
+        }
+        return false;
+#else
+        if (refs_ <= 0)
+            return false;
+        ++refs_;
+        return true;
+#endif
+    }
+
+#ifdef URHO3D_ATOMIC_REFCOUNT
+    /// Reference count. If below zero, the object has been destroyed.
+    std::atomic<int> refs_;
+    /// Weak reference count.
+    std::atomic<int> weakRefs_;
+#else
     /// Reference count. If below zero, the object has been destroyed.
     int refs_;
     /// Weak reference count.
     int weakRefs_;
+#endif
 };
 
 /// Base class for intrusively reference-counted objects. These are noncopyable and non-assignable.
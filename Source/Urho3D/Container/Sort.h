@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/Pair.h"
 #include "../Container/Swap.h"
 #include "../Container/VectorBase.h"
 
@@ -29,6 +30,8 @@ namespace Urho3D
 {
 
 static const int QUICKSORT_THRESHOLD = 16;
+static const int MERGESORT_THRESHOLD = 16;
+static const int RADIX_SORT_THRESHOLD = 64;
 
 // Based on Comparison of several sorting algorithms by Juha Nieminen
 // http://warp.povusers.org/SortComparison/
@@ -65,11 +68,94 @@ template <class T, class U> void InsertionSort(RandomAccessIterator<T> begin, Ra
     }
 }
 
-/// Perform quick sort initial pass on an array. Does not sort fully.
-template <class T> void InitialQuickSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end)
+/// Move an element of a binary max-heap down until the heap is valid.
+template <class T> void SiftDown(RandomAccessIterator<T> begin, int index, int count)
+{
+    T value = *(begin + index);
+    for (;;)
+    {
+        int child = index * 2 + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && *(begin + child) < *(begin + child + 1))
+            ++child;
+        if (!(value < *(begin + child)))
+            break;
+        *(begin + index) = *(begin + child);
+        index = child;
+    }
+    *(begin + index) = value;
+}
+
+/// Move an element of a binary max-heap down until the heap is valid, using a compare function.
+template <class T, class U> void SiftDown(RandomAccessIterator<T> begin, int index, int count, U compare)
+{
+    T value = *(begin + index);
+    for (;;)
+    {
+        int child = index * 2 + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && compare(*(begin + child), *(begin + child + 1)))
+            ++child;
+        if (!compare(value, *(begin + child)))
+            break;
+        *(begin + index) = *(begin + child);
+        index = child;
+    }
+    *(begin + index) = value;
+}
+
+/// Perform heap sort on an array. Slower than quicksort on average, but always O(n log n).
+template <class T> void HeapSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end)
+{
+    int count = end - begin;
+    for (int i = count / 2 - 1; i >= 0; --i)
+        SiftDown(begin, i, count);
+    for (int i = count - 1; i > 0; --i)
+    {
+        Swap(*begin, *(begin + i));
+        SiftDown(begin, 0, i);
+    }
+}
+
+/// Perform heap sort on an array using a compare function. Slower than quicksort on average, but always O(n log n).
+template <class T, class U> void HeapSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, U compare)
+{
+    int count = end - begin;
+    for (int i = count / 2 - 1; i >= 0; --i)
+        SiftDown(begin, i, count, compare);
+    for (int i = count - 1; i > 0; --i)
+    {
+        Swap(*begin, *(begin + i));
+        SiftDown(begin, 0, i, compare);
+    }
+}
+
+/// Return the quicksort recursion depth after which introsort switches to heap sort.
+inline int GetIntroSortDepthLimit(int count)
+{
+    int depth = 0;
+    while (count > 1)
+    {
+        count >>= 1;
+        ++depth;
+    }
+    return depth * 2;
+}
+
+/// Perform introsort initial pass on an array. Does not sort fully. Ranges still unsorted after depthLimit partitions are heap sorted.
+template <class T> void InitialIntroSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, int depthLimit)
 {
     while (end - begin > QUICKSORT_THRESHOLD)
     {
+        // Repeated bad pivots, fall back to heap sort to avoid quadratic time
+        if (depthLimit-- <= 0)
+        {
+            HeapSort(begin, end);
+            return;
+        }
+
         // Choose the pivot by median
         RandomAccessIterator<T> pivot = begin + ((end - begin) / 2);
         if (*begin < *pivot && *(end - 1) < *begin)
@@ -91,16 +177,23 @@ template <class T> void InitialQuickSort(RandomAccessIterator<T> begin, RandomAc
                 break;
         }
 
-        InitialQuickSort(begin, j + 1);
+        InitialIntroSort(begin, j + 1, depthLimit);
         begin = j + 1;
     }
 }
 
-/// Perform quick sort initial pass on an array using a compare function. Does not sort fully.
-template <class T, class U> void InitialQuickSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, U compare)
+/// Perform introsort initial pass on an array using a compare function. Does not sort fully. Ranges still unsorted after depthLimit partitions are heap sorted.
+template <class T, class U> void InitialIntroSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, int depthLimit, U compare)
 {
     while (end - begin > QUICKSORT_THRESHOLD)
     {
+        // Repeated bad pivots, fall back to heap sort to avoid quadratic time
+        if (depthLimit-- <= 0)
+        {
+            HeapSort(begin, end, compare);
+            return;
+        }
+
         // Choose the pivot by median
         RandomAccessIterator<T> pivot = begin + ((end - begin) / 2);
         if (compare(*begin, *pivot) && compare(*(end - 1), *begin))
@@ -122,23 +215,270 @@ template <class T, class U> void InitialQuickSort(RandomAccessIterator<T> begin,
                 break;
         }
 
-        InitialQuickSort(begin, j + 1, compare);
+        InitialIntroSort(begin, j + 1, depthLimit, compare);
         begin = j + 1;
     }
 }
 
-/// Sort in ascending order using quicksort for initial passes, then an insertion sort to finalize.
+/// Perform quick sort initial pass on an array. Does not sort fully.
+template <class T> void InitialQuickSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end)
+{
+    InitialIntroSort(begin, end, GetIntroSortDepthLimit(end - begin));
+}
+
+/// Perform quick sort initial pass on an array using a compare function. Does not sort fully.
+template <class T, class U> void InitialQuickSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, U compare)
+{
+    InitialIntroSort(begin, end, GetIntroSortDepthLimit(end - begin), compare);
+}
+
+/// Sort in ascending order using introsort (quicksort falling back to heap sort on bad partitions) for initial passes, then an insertion sort to finalize. Always O(n log n), not stable.
 template <class T> void Sort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end)
 {
     InitialQuickSort(begin, end);
     InsertionSort(begin, end);
 }
 
-/// Sort in ascending order using quicksort for initial passes, then an insertion sort to finalize, using a compare function.
+/// Sort in ascending order using introsort (quicksort falling back to heap sort on bad partitions) for initial passes, then an insertion sort to finalize, using a compare function. Always O(n log n), not stable.
 template <class T, class U> void Sort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, U compare)
 {
     InitialQuickSort(begin, end, compare);
     InsertionSort(begin, end, compare);
 }
 
+/// Merge two adjacent sorted ranges [begin, middle) and [middle, end) into a destination that does not overlap them. Equal elements keep their order.
+template <class T> void MergeSortedRanges(RandomAccessIterator<T> begin, RandomAccessIterator<T> middle, RandomAccessIterator<T> end,
+    RandomAccessIterator<T> dest)
+{
+    RandomAccessIterator<T> i = begin;
+    RandomAccessIterator<T> j = middle;
+    while (i < middle && j < end)
+        *dest++ = *j < *i ? *j++ : *i++;
+    while (i < middle)
+        *dest++ = *i++;
+    while (j < end)
+        *dest++ = *j++;
+}
+
+/// Merge two adjacent sorted ranges [begin, middle) and [middle, end) into a destination that does not overlap them, using a compare function. Equal elements keep their order.
+template <class T, class U> void MergeSortedRanges(RandomAccessIterator<T> begin, RandomAccessIterator<T> middle,
+    RandomAccessIterator<T> end, RandomAccessIterator<T> dest, U compare)
+{
+    RandomAccessIterator<T> i = begin;
+    RandomAccessIterator<T> j = middle;
+    while (i < middle && j < end)
+        *dest++ = compare(*j, *i) ? *j++ : *i++;
+    while (i < middle)
+        *dest++ = *i++;
+    while (j < end)
+        *dest++ = *j++;
+}
+
+/// Sort in ascending order using merge sort. The sort is stable, so equal elements keep their order. Requires a temporary buffer at least as large as the array.
+template <class T> void StableSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, RandomAccessIterator<T> temp)
+{
+    int count = end - begin;
+
+    // Insertion sort is stable as well, use it for the initial runs
+    for (int start = 0; start < count; start += MERGESORT_THRESHOLD)
+        InsertionSort(begin + start, begin + (count - start > MERGESORT_THRESHOLD ? start + MERGESORT_THRESHOLD : count));
+
+    RandomAccessIterator<T> src = begin;
+    RandomAccessIterator<T> dest = temp;
+    for (int width = MERGESORT_THRESHOLD; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += width * 2)
+        {
+            int middle = count - start > width ? start + width : count;
+            int last = count - middle > width ? middle + width : count;
+            MergeSortedRanges(src + start, src + middle, src + last, dest + start);
+        }
+        Swap(src, dest);
+    }
+
+    // After an odd number of passes the result is in the temporary buffer
+    if (src != begin)
+    {
+        for (int i = 0; i < count; ++i)
+            *(begin + i) = *(src + i);
+    }
+}
+
+/// Sort in ascending order using merge sort and a compare function. The sort is stable, so equal elements keep their order. Requires a temporary buffer at least as large as the array.
+template <class T, class U> void StableSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, RandomAccessIterator<T> temp,
+    U compare)
+{
+    int count = end - begin;
+
+    // Insertion sort is stable as well, use it for the initial runs
+    for (int start = 0; start < count; start += MERGESORT_THRESHOLD)
+        InsertionSort(begin + start, begin + (count - start > MERGESORT_THRESHOLD ? start + MERGESORT_THRESHOLD : count), compare);
+
+    RandomAccessIterator<T> src = begin;
+    RandomAccessIterator<T> dest = temp;
+    for (int width = MERGESORT_THRESHOLD; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += width * 2)
+        {
+            int middle = count - start > width ? start + width : count;
+            int last = count - middle > width ? middle + width : count;
+            MergeSortedRanges(src + start, src + middle, src + last, dest + start, compare);
+        }
+        Swap(src, dest);
+    }
+
+    // After an odd number of passes the result is in the temporary buffer
+    if (src != begin)
+    {
+        for (int i = 0; i < count; ++i)
+            *(begin + i) = *(src + i);
+    }
+}
+
+/// Return an unsigned radix sort key that orders signed integers ascending.
+inline unsigned GetRadixSortKey(int value)
+{
+    return (unsigned)value ^ 0x80000000;
+}
+
+/// Sort key-value pairs in ascending order of their unsigned integer keys. The sort is stable, so it can be applied
+/// repeatedly from the least to the most significant key. Requires a temporary buffer at least as large as the array.
+template <class K, class V> void RadixSort(RandomAccessIterator<Pair<K, V> > begin, RandomAccessIterator<Pair<K, V> > end,
+    RandomAccessIterator<Pair<K, V> > temp)
+{
+    int count = end - begin;
+    if (count < 2)
+        return;
+
+    // Insertion sort is stable as well, and faster for short arrays
+    if (count <= RADIX_SORT_THRESHOLD)
+    {
+        for (RandomAccessIterator<Pair<K, V> > i = begin + 1; i < end; ++i)
+        {
+            Pair<K, V> entry = *i;
+            RandomAccessIterator<Pair<K, V> > j = i;
+            while (j > begin && entry.first_ < (j - 1)->first_)
+            {
+                *j = *(j - 1);
+                --j;
+            }
+            *j = entry;
+        }
+        return;
+    }
+
+    // Gather the histograms of all 8-bit digits in one pass
+    static const unsigned NUM_DIGITS = sizeof(K);
+    unsigned histograms[NUM_DIGITS][256] = {};
+    for (RandomAccessIterator<Pair<K, V> > i = begin; i < end; ++i)
+    {
+        K key = i->first_;
+        for (unsigned digit = 0; digit < NUM_DIGITS; ++digit)
+            ++histograms[digit][(key >> (digit * 8)) & 0xff];
+    }
+
+    Pair<K, V>* src = &(*begin);
+    Pair<K, V>* dest = &(*temp);
+    for (unsigned digit = 0; digit < NUM_DIGITS; ++digit)
+    {
+        unsigned* histogram = histograms[digit];
+        unsigned shift = digit * 8;
+
+        // Skip the pass if all keys have the same value in this digit
+        if (histogram[(src->first_ >> shift) & 0xff] == (unsigned)count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned bucket = 0; bucket < 256; ++bucket)
+        {
+            unsigned bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (Pair<K, V>* i = src; i < src + count; ++i)
+            dest[histogram[(i->first_ >> shift) & 0xff]++] = *i;
+
+        Swap(src, dest);
+    }
+
+    // After an odd number of passes the result is in the temporary buffer
+    if (src != &(*begin))
+    {
+        for (int i = 0; i < count; ++i)
+            *(begin + i) = src[i];
+    }
+}
+
+/// Sort elements in ascending order of the unsigned keys returned by a key function, for example FloatToSortKey() of a float or
+/// GetRadixSortKey() of an integer member. The sort is stable. The key function is called once per element and 8-bit digit
+/// pass, so it should be cheap. Requires a temporary buffer at least as large as the array.
+template <class T, class U> void RadixSort(RandomAccessIterator<T> begin, RandomAccessIterator<T> end, RandomAccessIterator<T> temp,
+    U getKey)
+{
+    int count = end - begin;
+    if (count < 2)
+        return;
+
+    // Insertion sort is stable as well, and faster for short arrays
+    if (count <= RADIX_SORT_THRESHOLD)
+    {
+        for (RandomAccessIterator<T> i = begin + 1; i < end; ++i)
+        {
+            T entry = *i;
+            unsigned key = getKey(entry);
+            RandomAccessIterator<T> j = i;
+            while (j > begin && key < getKey(*(j - 1)))
+            {
+                *j = *(j - 1);
+                --j;
+            }
+            *j = entry;
+        }
+        return;
+    }
+
+    // Gather the histograms of all 8-bit digits in one pass
+    static const unsigned NUM_DIGITS = sizeof(unsigned);
+    unsigned histograms[NUM_DIGITS][256] = {};
+    for (RandomAccessIterator<T> i = begin; i < end; ++i)
+    {
+        unsigned key = getKey(*i);
+        for (unsigned digit = 0; digit < NUM_DIGITS; ++digit)
+            ++histograms[digit][(key >> (digit * 8)) & 0xff];
+    }
+
+    T* src = &(*begin);
+    T* dest = &(*temp);
+    for (unsigned digit = 0; digit < NUM_DIGITS; ++digit)
+    {
+        unsigned* histogram = histograms[digit];
+        unsigned shift = digit * 8;
+
+        // Skip the pass if all keys have the same value in this digit
+        if (histogram[(getKey(*src) >> shift) & 0xff] == (unsigned)count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned bucket = 0; bucket < 256; ++bucket)
+        {
+            unsigned bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (T* i = src; i < src + count; ++i)
+            dest[histogram[(getKey(*i) >> shift) & 0xff]++] = *i;
+
+        Swap(src, dest);
+    }
+
+    // After an odd number of passes the result is in the temporary buffer
+    if (src != &(*begin))
+    {
+        for (int i = 0; i < count; ++i)
+            *(begin + i) = src[i];
+    }
+}
+
 }
@@ -32,6 +32,25 @@
 namespace Urho3D
 {
 
+/// Number of already processed specific receivers up to which they are searched linearly when sending an event.
+static const unsigned MAX_LINEAR_RECEIVER_SEARCH = 16;
+
+/// Return whether a sorted vector contains an object.
+static bool ContainsSorted(const FrameVector<Object*>& objects, Object* object)
+{
+    unsigned first = 0;
+    unsigned last = objects.Size();
+    while (first < last)
+    {
+        unsigned middle = (first + last) / 2;
+        if (objects[middle] < object)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first < objects.Size() && objects[first] == object;
+}
+
 TypeInfo::TypeInfo(const char* typeName, const TypeInfo* baseTypeInfo) :
     type_(typeName),
     typeName_(typeName),
@@ -302,7 +321,9 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
+    // If a handler runs a frame, the frame allocator is reset and the list of processed specific receivers empties. The
+    // non-specific receivers may then also include receivers that already got the event
+    FrameVector<Object*> processed(context->GetFrameAllocator());
 
     context->BeginSendEvent(this, eventType);
 
@@ -331,7 +352,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 return;
             }
 
-            processed.Insert(receiver);
+            processed.Push(receiver);
         }
 
         group->EndSendEvent();
@@ -364,12 +385,16 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
         }
         else
         {
-            // If there were specific receivers, check that the event is not sent doubly to them
+            // If there were specific receivers, check that the event is not sent doubly to them. Search many of them by bisection
+            bool bisect = processed.Size() > MAX_LINEAR_RECEIVER_SEARCH;
+            if (bisect)
+                Sort(processed.Begin(), processed.End());
+
             const unsigned numReceivers = group->receivers_.Size();
             for (unsigned i = 0; i < numReceivers; ++i)
             {
                 Object* receiver = group->receivers_[i];
-                if (!receiver || processed.Contains(receiver))
+                if (!receiver || (bisect ? ContainsSorted(processed, receiver) : processed.Contains(receiver)))
                     continue;
 
                 receiver->OnEvent(this, eventType, eventData);
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Sort.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
+#include "../Math/MathDefs.h"
+
+namespace Urho3D
+{
+
+/// Minimum number of elements per worker thread in ParallelSort.
+static const int PARALLEL_SORT_THRESHOLD = 4096;
+
+/// Compare function object using operator <.
+template <class T> struct ParallelSortLess
+{
+    /// Compare elements.
+    bool operator ()(const T& lhs, const T& rhs) const { return lhs < rhs; }
+};
+
+/// Range sorted or merged by one ParallelSort work item.
+template <class T, class U> struct ParallelSortRange
+{
+    /// Source start.
+    RandomAccessIterator<T> begin_;
+    /// Source middle when merging.
+    RandomAccessIterator<T> middle_;
+    /// Source end.
+    RandomAccessIterator<T> end_;
+    /// Destination start. When sorting, the source is copied here first unless they are the same.
+    RandomAccessIterator<T> dest_;
+    /// Compare function.
+    U compare_;
+    /// Merge [begin, middle) and [middle, end) into the destination instead of sorting.
+    bool merge_;
+};
+
+/// ParallelSort work function.
+template <class T, class U> void ParallelSortWork(const WorkItem* item, unsigned threadIndex)
+{
+    const ParallelSortRange<T, U>* range = reinterpret_cast<const ParallelSortRange<T, U>*>(item->aux_);
+    U compare = range->compare_;
+
+    if (range->merge_)
+        MergeSortedRanges(range->begin_, range->middle_, range->end_, range->dest_, compare);
+    else
+    {
+        int count = range->end_ - range->begin_;
+        if (range->dest_ != range->begin_)
+        {
+            for (int i = 0; i < count; ++i)
+                *(range->dest_ + i) = *(range->begin_ + i);
+        }
+        Sort(range->dest_, range->dest_ + count, compare);
+    }
+}
+
+/// Sort in ascending order using a compare function and the work queue's worker threads. Each thread sorts a part of the array
+/// with Sort(), then the parts are merged pairwise in parallel. Not stable. Sorts on the calling thread if the array is small,
+/// there are no worker threads, or when not called from the main thread. Requires a temporary buffer at least as large as the array.
+template <class T, class U> void ParallelSort(WorkQueue* queue, RandomAccessIterator<T> begin, RandomAccessIterator<T> end,
+    RandomAccessIterator<T> temp, U compare)
+{
+    int count = end - begin;
+    unsigned numParts = queue ? Min(queue->GetNumThreads() + 1, (unsigned)(count / PARALLEL_SORT_THRESHOLD)) : 0;
+    if (numParts < 2 || !Thread::IsMainThread() || queue->IsCompleting())
+    {
+        Sort(begin, end, compare);
+        return;
+    }
+
+    PODVector<int> bounds(numParts + 1);
+    for (unsigned i = 0; i <= numParts; ++i)
+        bounds[i] = (int)((long long)count * i / numParts);
+
+    // Each merge round moves the data between the array and the temporary buffer. Sort the parts into the temporary buffer
+    // if the number of rounds is odd, so that the result ends up in the array
+    unsigned numRounds = 0;
+    for (unsigned parts = numParts; parts > 1; parts = (parts + 1) / 2)
+        ++numRounds;
+    RandomAccessIterator<T> src = (numRounds & 1) ? temp : begin;
+    RandomAccessIterator<T> dest = (numRounds & 1) ? begin : temp;
+
+    PODVector<ParallelSortRange<T, U> > ranges(numParts);
+    for (unsigned i = 0; i < numParts; ++i)
+    {
+        ParallelSortRange<T, U>& range = ranges[i];
+        range.begin_ = begin + bounds[i];
+        range.end_ = begin + bounds[i + 1];
+        range.dest_ = src + bounds[i];
+        range.compare_ = compare;
+        range.merge_ = false;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = ParallelSortWork<T, U>;
+        item->aux_ = &range;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+
+    while (numParts > 1)
+    {
+        // An odd part left over at the end is merged with an empty range, which copies it
+        unsigned numMerged = (numParts + 1) / 2;
+        for (unsigned i = 0; i < numMerged; ++i)
+        {
+            ParallelSortRange<T, U>& range = ranges[i];
+            range.begin_ = src + bounds[i * 2];
+            range.middle_ = src + bounds[Min(i * 2 + 1, numParts)];
+            range.end_ = src + bounds[Min(i * 2 + 2, numParts)];
+            range.dest_ = dest + bounds[i * 2];
+            range.merge_ = true;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ParallelSortWork<T, U>;
+            item->aux_ = &range;
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+
+        for (unsigned i = 0; i <= numMerged; ++i)
+            bounds[i] = bounds[Min(i * 2, numParts)];
+        numParts = numMerged;
+        Swap(src, dest);
+    }
+}
+
+/// Sort in ascending order using the work queue's worker threads. Not stable. Requires a temporary buffer at least as large as the array.
+template <class T> void ParallelSort(WorkQueue* queue, RandomAccessIterator<T> begin, RandomAccessIterator<T> end,
+    RandomAccessIterator<T> temp)
+{
+    ParallelSort(queue, begin, end, temp, ParallelSortLess<T>());
+}
+
+}
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 
@@ -134,6 +135,9 @@ void Time::EndFrame()
 
         // Frame end event
         SendEvent(E_ENDFRAME);
+
+        // Release the transient memory of the frame after all end frame handlers have run
+        context_->GetFrameAllocator()->Reset();
     }
 
     Profiler* profiler = GetSubsystem<Profiler>();
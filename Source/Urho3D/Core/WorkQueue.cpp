@@ -47,17 +47,21 @@ public:
     {
         // Init FPU state first
         InitFPU();
-        owner_->ProcessItems(index_);
+        owner_->ProcessItems(index_, executeMutex_);
     }
 
     /// Return thread index.
     unsigned GetIndex() const { return index_; }
+    /// Return the mutex held while executing a work item.
+    Mutex& GetExecuteMutex() { return executeMutex_; }
 
 private:
     /// Work queue.
     WorkQueue* owner_;
     /// Thread index.
     unsigned index_;
+    /// Mutex held from taking a work item from the queue until it is completed.
+    Mutex executeMutex_;
 };
 
 WorkQueue::WorkQueue(Context* context) :
@@ -218,6 +222,19 @@ unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
     return removed;
 }
 
+bool WorkQueue::CancelWorkItem(SharedPtr<WorkItem> item)
+{
+    if (!item || RemoveWorkItem(item))
+        return true;
+
+    // The item is no longer queued, so it has either completed or a worker thread is executing it while holding its execute
+    // mutex. Block on the mutexes until it completes
+    for (unsigned i = 0; i < threads_.Size() && !item->completed_; ++i)
+        MutexLock lock(threads_[i]->GetExecuteMutex());
+
+    return false;
+}
+
 void WorkQueue::Pause()
 {
     if (!paused_)
@@ -304,7 +321,7 @@ bool WorkQueue::IsCompleted(unsigned priority) const
     return true;
 }
 
-void WorkQueue::ProcessItems(unsigned threadIndex)
+void WorkQueue::ProcessItems(unsigned threadIndex, Mutex& executeMutex)
 {
     bool wasActive = false;
 
@@ -322,11 +339,14 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
             {
                 wasActive = true;
 
+                // Hold the execute mutex before the item leaves the queue, so that CancelWorkItem() can wait for it
                 WorkItem* item = queue_.Front();
                 queue_.PopFront();
+                executeMutex.Acquire();
                 queueMutex_.Release();
                 item->workFunction_(item, threadIndex);
                 item->completed_ = true;
+                executeMutex.Release();
             }
             else
             {
@@ -40,6 +40,8 @@ class WorkerThread;
 /// Work queue item.
 struct WorkItem : public RefCounted
 {
+    URHO3D_POOL_ALLOCATION;
+
     friend class WorkQueue;
 
 public:
@@ -94,6 +96,8 @@ public:
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
+    /// Remove a work item if it has not started executing, otherwise wait for it to complete. Afterward the data it uses can be freed. Return true if removed before executing.
+    bool CancelWorkItem(SharedPtr<WorkItem> item);
     /// Pause worker threads.
     void Pause();
     /// Resume worker threads.
@@ -123,7 +127,7 @@ public:
 
 private:
     /// Process work items until shut down. Called by the worker threads.
-    void ProcessItems(unsigned threadIndex);
+    void ProcessItems(unsigned threadIndex, Mutex& executeMutex);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
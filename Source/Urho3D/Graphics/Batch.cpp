@@ -40,44 +40,61 @@
 namespace Urho3D
 {
 
-inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
+inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->sortKey_ != rhs->sortKey_)
-        return lhs->sortKey_ < rhs->sortKey_;
-    else
-        return lhs->distance_ < rhs->distance_;
+    return lhs.distance_ < rhs.distance_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    return lhs->renderOrder_ < rhs->renderOrder_;
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+inline unsigned long long GetBatchStateKey(Batch* batch)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    return batch->sortKey_;
 }
 
-inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
+inline unsigned long long GetBatchDistanceKey(Batch* batch)
 {
-    return lhs.distance_ < rhs.distance_;
+    return FloatToSortKey(batch->distance_);
 }
 
-inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
+inline unsigned long long GetBatchRenderOrderKey(Batch* batch)
 {
-    return lhs->renderOrder_ < rhs->renderOrder_;
+    return batch->renderOrder_;
+}
+
+inline unsigned long long GetBatchFrontToBackKey(Batch* batch)
+{
+    return (((unsigned long long)batch->renderOrder_) << 32) | FloatToSortKey(batch->distance_);
+}
+
+inline unsigned long long GetBatchBackToFrontKey(Batch* batch)
+{
+    return (((unsigned long long)batch->renderOrder_) << 32) | (~FloatToSortKey(batch->distance_));
+}
+
+/// Sort batches stably by a key calculated from each batch. The keys are gathered up front so that the radix sort passes
+/// do not need to access the batches themselves.
+template <class T> void RadixSortBatches(PODVector<Batch*>& batches, PODVector<Pair<unsigned long long, Batch*> >& entries,
+    PODVector<Pair<unsigned long long, Batch*> >& temp, T key)
+{
+    unsigned count = batches.Size();
+    entries.Resize(count);
+    temp.Resize(count);
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        Batch* batch = batches[i];
+        entries[i].first_ = key(batch);
+        entries[i].second_ = batch;
+    }
+
+    RadixSort(entries.Begin(), entries.End(), temp.Begin());
+
+    for (unsigned i = 0; i < count; ++i)
+        batches[i] = entries[i].second_;
 }
 
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer)
@@ -732,7 +749,10 @@ void BatchQueue::SortBackToFront()
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    // Sort by render order and descending distance, with state as the tiebreaker. The radix sort is stable, so sort by the
+    // least significant key first
+    RadixSortBatches(sortedBatches_, sortEntries_, sortTemp_, GetBatchStateKey);
+    RadixSortBatches(sortedBatches_, sortEntries_, sortTemp_, GetBatchBackToFrontKey);
 
     sortedBatchGroups_.Resize(batchGroups_.Size());
     
@@ -764,7 +784,7 @@ void BatchQueue::SortFrontToBack()
         else
         {
             float minDistance = M_INFINITY;
-            for (PODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (FrameVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
             i->second_.distance_ = minDistance;
         }
@@ -784,10 +804,11 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
 #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    SortBatchesByState(batches);
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    RadixSortBatches(batches, sortEntries_, sortTemp_, GetBatchStateKey);
+    RadixSortBatches(batches, sortEntries_, sortTemp_, GetBatchFrontToBackKey);
 
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
@@ -835,10 +856,18 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     geometryRemapping_.Clear();
 
     // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    SortBatchesByState(batches);
 #endif
 }
 
+void BatchQueue::SortBatchesByState(PODVector<Batch*>& batches)
+{
+    // The radix sort is stable, so sort from the least significant key up
+    RadixSortBatches(batches, sortEntries_, sortTemp_, GetBatchDistanceKey);
+    RadixSortBatches(batches, sortEntries_, sortTemp_, GetBatchStateKey);
+    RadixSortBatches(batches, sortEntries_, sortTemp_, GetBatchRenderOrderKey);
+}
+
 void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
 {
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/FrameAllocator.h"
 #include "../Container/Ptr.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
@@ -176,8 +177,8 @@ struct BatchGroup : public Batch
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// Instance data.
-    PODVector<InstanceData> instances_;
+    /// Instance data. Allocated from the frame allocator, so it is only valid during the frame the batch queues were built.
+    FrameVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -244,6 +245,8 @@ public:
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
     void SortFrontToBack2Pass(PODVector<Batch*>& batches);
+    /// Sort batches by render order and state, then distance.
+    void SortBatchesByState(PODVector<Batch*>& batches);
     /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
     void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
     /// Draw.
@@ -262,6 +265,10 @@ public:
     HashMap<unsigned short, unsigned short> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
     HashMap<unsigned short, unsigned short> geometryRemapping_;
+    /// Sort keys and draw calls for radix sorting.
+    PODVector<Pair<unsigned long long, Batch*> > sortEntries_;
+    /// Temporary buffer for radix sorting.
+    PODVector<Pair<unsigned long long, Batch*> > sortTemp_;
 
     /// Unsorted non-instanced draw calls.
     PODVector<Batch> batches_;
@@ -205,6 +205,10 @@ private:
     Vector3 previousOffset_;
     /// Billboard pointers for sorting.
     Vector<Billboard*> sortedBillboards_;
+    /// Sort keys and billboard pointers for radix sorting.
+    PODVector<Pair<unsigned, Billboard*> > sortEntries_;
+    /// Temporary buffer for radix sorting.
+    PODVector<Pair<unsigned, Billboard*> > sortTemp_;
     /// Attribute buffer for network replication.
     mutable VectorBuffer attrBuffer_;
 };
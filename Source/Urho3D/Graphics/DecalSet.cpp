@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/AnimatedModel.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
@@ -40,6 +41,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -57,6 +62,7 @@ static const unsigned MAX_VERTICES = 65536;
 static const unsigned DEFAULT_MAX_VERTICES = 512;
 static const unsigned DEFAULT_MAX_INDICES = 1024;
 static const unsigned STATIC_ELEMENT_MASK = MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT;
+static const unsigned char UNKNOWN_OUTCODE = 0xff;
 static const unsigned SKINNED_ELEMENT_MASK = MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT | MASK_BLENDWEIGHTS |
                                              MASK_BLENDINDICES;
 
@@ -128,6 +134,75 @@ static void ClipPolygon(PODVector<DecalVertex>& dest, const PODVector<DecalVerte
         dest.Push(ClipEdge(src[last], src[0], lastDistance, distance, skinned));
 }
 
+static void DefineClipPlanes(DecalBuild& build)
+{
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        if (i < NUM_FRUSTUM_PLANES)
+        {
+            const Plane& plane = build.frustum_.planes_[i];
+            build.planeX_[i] = plane.normal_.x_;
+            build.planeY_[i] = plane.normal_.y_;
+            build.planeZ_[i] = plane.normal_.z_;
+            build.planeD_[i] = plane.d_;
+        }
+        else
+        {
+            // Padding planes that every vertex is inside of
+            build.planeX_[i] = build.planeY_[i] = build.planeZ_[i] = 0.0f;
+            build.planeD_[i] = 1.0f;
+        }
+    }
+}
+
+/// Return a mask of the decal frustum planes a vertex is outside of.
+static unsigned char GetVertexOutcode(const DecalBuild& build, const Vector3& vertex)
+{
+    unsigned outcode = 0;
+
+#ifdef URHO3D_SSE
+    __m128 x = _mm_set1_ps(vertex.x_);
+    __m128 y = _mm_set1_ps(vertex.y_);
+    __m128 z = _mm_set1_ps(vertex.z_);
+
+    // Test against four planes at a time
+    for (unsigned i = 0; i < 8; i += 4)
+    {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&build.planeX_[i]), x),
+            _mm_mul_ps(_mm_loadu_ps(&build.planeY_[i]), y)), _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&build.planeZ_[i]), z),
+            _mm_loadu_ps(&build.planeD_[i])));
+        outcode |= (unsigned)_mm_movemask_ps(_mm_cmplt_ps(distance, _mm_setzero_ps())) << i;
+    }
+#else
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        if (build.frustum_.planes_[i].Distance(vertex) < 0.0f)
+            outcode |= 1u << i;
+    }
+#endif
+
+    return (unsigned char)outcode;
+}
+
+/// Return the frustum plane mask of a target vertex, using the cached value if already calculated.
+static unsigned char GetCachedVertexOutcode(DecalBuild& build, unsigned index, const Vector3& vertex)
+{
+    if (index >= build.outcodes_.Size())
+        return GetVertexOutcode(build, vertex);
+
+    unsigned char& outcode = build.outcodes_[index];
+    if (outcode == UNKNOWN_OUTCODE)
+        outcode = GetVertexOutcode(build, vertex);
+    return outcode;
+}
+
+void GenerateDecalWork(const WorkItem* item, unsigned threadIndex)
+{
+    DecalSet* decalSet = reinterpret_cast<DecalSet*>(item->aux_);
+    DecalBuild* build = reinterpret_cast<DecalBuild*>(item->start_);
+    decalSet->GenerateDecal(*build, nullptr);
+}
+
 void Decal::AddVertex(const DecalVertex& vertex)
 {
     for (unsigned i = 0; i < vertices_.Size(); ++i)
@@ -161,6 +236,7 @@ DecalSet::DecalSet(Context* context) :
     maxVertices_(DEFAULT_MAX_VERTICES),
     maxIndices_(DEFAULT_MAX_INDICES),
     optimizeBufferSize_(false),
+    asyncGeneration_(false),
     skinned_(false),
     bufferDirty_(true),
     boundingBoxDirty_(true),
@@ -177,6 +253,7 @@ DecalSet::DecalSet(Context* context) :
 
 DecalSet::~DecalSet()
 {
+    CancelPendingDecals();
 }
 
 void DecalSet::RegisterObject(Context* context)
@@ -189,6 +266,7 @@ void DecalSet::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Max Vertices", GetMaxVertices, SetMaxVertices, unsigned, DEFAULT_MAX_VERTICES, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Max Indices", GetMaxIndices, SetMaxIndices, unsigned, DEFAULT_MAX_INDICES, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Optimize Buffer Size", GetOptimizeBufferSize, SetOptimizeBufferSize, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Async Generation", GetAsyncGeneration, SetAsyncGeneration, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
@@ -300,6 +378,15 @@ void DecalSet::SetOptimizeBufferSize(bool enable)
     }
 }
 
+void DecalSet::SetAsyncGeneration(bool enable)
+{
+    if (enable != asyncGeneration_)
+    {
+        asyncGeneration_ = enable;
+        MarkNetworkUpdate();
+    }
+}
+
 bool DecalSet::AddDecal(Drawable* target, const Vector3& worldPosition, const Quaternion& worldRotation, float size,
     float aspectRatio, float depth, const Vector2& topLeftUV, const Vector2& bottomRightUV, float timeToLive, float normalCutoff,
     unsigned subGeometry)
@@ -374,114 +461,73 @@ bool DecalSet::AddDecal(Drawable* target, const Vector3& worldPosition, const Qu
             targetTransform = (bestBone->node_->GetWorldTransform() * bestBone->offsetMatrix_).Inverse();
     }
 
+    // Skinned decals need to be generated in the main thread, as they add bones to the decal set
+    bool async = asyncGeneration_ && !skinned_;
+    DecalBuild immediateBuild;
+    if (async)
+        pendingDecals_.Resize(pendingDecals_.Size() + 1);
+    DecalBuild& build = async ? pendingDecals_.Back() : immediateBuild;
+
     // Build the decal frustum
-    Frustum decalFrustum;
     Matrix3x4 frustumTransform = targetTransform * Matrix3x4(adjustedWorldPosition, worldRotation, 1.0f);
-    decalFrustum.DefineOrtho(size, aspectRatio, 1.0, 0.0f, depth, frustumTransform);
-
-    Vector3 decalNormal = (targetTransform * Vector4(worldRotation * Vector3::BACK, 0.0f)).Normalized();
-
-    decals_.Resize(decals_.Size() + 1);
-    Decal& newDecal = decals_.Back();
-    newDecal.timeToLive_ = timeToLive;
-
-    Vector<PODVector<DecalVertex> > faces;
-    PODVector<DecalVertex> tempFace;
-
+    build.frustum_.DefineOrtho(size, aspectRatio, 1.0, 0.0f, depth, frustumTransform);
+    DefineClipPlanes(build);
+
+    build.view_ = frustumTransform.Inverse();
+    build.projection_ = Matrix4::ZERO;
+    build.projection_.m11_ = (1.0f / (size * 0.5f));
+    build.projection_.m00_ = build.projection_.m11_ / aspectRatio;
+    build.projection_.m22_ = 1.0f / depth;
+    build.projection_.m33_ = 1.0f;
+    build.transform_ = node_->GetWorldTransform().Inverse() * target->GetNode()->GetWorldTransform();
+    build.decalNormal_ = (targetTransform * Vector4(worldRotation * Vector3::BACK, 0.0f)).Normalized();
+    build.topLeftUV_ = topLeftUV;
+    build.bottomRightUV_ = bottomRightUV;
+    build.normalCutoff_ = normalCutoff;
+    build.skinned_ = skinned_;
+    build.decal_.timeToLive_ = timeToLive;
+
+    // Use either a specified subgeometry in the target, or all. Try to use the most accurate LOD level if possible
     unsigned numBatches = target->GetBatches().Size();
-
-    // Use either a specified subgeometry in the target, or all
-    if (subGeometry < numBatches)
-        GetFaces(faces, target, subGeometry, decalFrustum, decalNormal, normalCutoff);
-    else
+    for (unsigned i = 0; i < numBatches; ++i)
     {
-        for (unsigned i = 0; i < numBatches; ++i)
-            GetFaces(faces, target, i, decalFrustum, decalNormal, normalCutoff);
-    }
+        if (subGeometry < numBatches && i != subGeometry)
+            continue;
 
-    // Clip the acquired faces against all frustum planes
-    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
-    {
-        for (unsigned j = 0; j < faces.Size(); ++j)
+        Geometry* geometry = target->GetLodGeometry(i, 0);
+        if (geometry && geometry->GetPrimitiveType() == TRIANGLE_LIST)
         {
-            PODVector<DecalVertex>& face = faces[j];
-            if (face.Empty())
-                continue;
-
-            ClipPolygon(tempFace, face, decalFrustum.planes_[i], skinned_);
-            face = tempFace;
+            build.geometries_.Push(SharedPtr<Geometry>(geometry));
+            build.batchIndices_.Push(i);
         }
     }
 
-    // Now triangulate the resulting faces into decal vertices
-    for (unsigned i = 0; i < faces.Size(); ++i)
+    if (async)
     {
-        PODVector<DecalVertex>& face = faces[i];
-        if (face.Size() < 3)
-            continue;
-
-        for (unsigned j = 2; j < face.Size(); ++j)
+        // Not taken from the work queue's item pool, as the item is polled across frames
+        build.workItem_ = new WorkItem();
+        build.workItem_->workFunction_ = GenerateDecalWork;
+        build.workItem_->aux_ = this;
+        build.workItem_->start_ = &build;
+        build.workItem_->priority_ = 0;
+
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue)
+            queue->AddWorkItem(build.workItem_);
+        else
         {
-            newDecal.AddVertex(face[0]);
-            newDecal.AddVertex(face[j - 1]);
-            newDecal.AddVertex(face[j]);
+            GenerateDecal(build, nullptr);
+            build.workItem_->completed_ = true;
         }
-    }
 
-    // Check if resulted in no triangles
-    if (newDecal.vertices_.Empty())
-    {
-        decals_.Pop();
+        // Commit the decal in scene post-update once finished
+        if (!subscribed_)
+            UpdateEventSubscription(false);
         return true;
     }
 
-    if (newDecal.vertices_.Size() > maxVertices_)
-    {
-        URHO3D_LOGWARNING("Can not add decal, vertex count " + String(newDecal.vertices_.Size()) + " exceeds maximum " +
-                   String(maxVertices_));
-        decals_.Pop();
-        return false;
-    }
-    if (newDecal.indices_.Size() > maxIndices_)
-    {
-        URHO3D_LOGWARNING("Can not add decal, index count " + String(newDecal.indices_.Size()) + " exceeds maximum " +
-                   String(maxIndices_));
-        decals_.Pop();
-        return false;
-    }
-
-    // Calculate UVs
-    Matrix4 projection(Matrix4::ZERO);
-    projection.m11_ = (1.0f / (size * 0.5f));
-    projection.m00_ = projection.m11_ / aspectRatio;
-    projection.m22_ = 1.0f / depth;
-    projection.m33_ = 1.0f;
-
-    CalculateUVs(newDecal, frustumTransform.Inverse(), projection, topLeftUV, bottomRightUV);
-
-    // Transform vertices to this node's local space and generate tangents
-    Matrix3x4 decalTransform = node_->GetWorldTransform().Inverse() * target->GetNode()->GetWorldTransform();
-    TransformVertices(newDecal, skinned_ ? Matrix3x4::IDENTITY : decalTransform);
-    GenerateTangents(&newDecal.vertices_[0], sizeof(DecalVertex), &newDecal.indices_[0], sizeof(unsigned short), 0,
-        newDecal.indices_.Size(), offsetof(DecalVertex, normal_), offsetof(DecalVertex, texCoord_), offsetof(DecalVertex,
-        tangent_));
-
-    newDecal.CalculateBoundingBox();
-    numVertices_ += newDecal.vertices_.Size();
-    numIndices_ += newDecal.indices_.Size();
-
-    // Remove oldest decals if total vertices exceeded
-    while (decals_.Size() && (numVertices_ > maxVertices_ || numIndices_ > maxIndices_))
-        RemoveDecals(1);
-
-    URHO3D_LOGDEBUG("Added decal with " + String(newDecal.vertices_.Size()) + " vertices");
-
-    // If new decal is time limited, subscribe to scene post-update
-    if (newDecal.timeToLive_ > 0.0f && !subscribed_)
-        UpdateEventSubscription(false);
-
-    MarkDecalsDirty();
-    return true;
+    GenerateDecal(build, target);
+    return CommitDecal(build);
 }
 
 void DecalSet::RemoveDecals(unsigned num)
@@ -492,6 +538,8 @@ void DecalSet::RemoveDecals(unsigned num)
 
 void DecalSet::RemoveAllDecals()
 {
+    CancelPendingDecals();
+
     if (!decals_.Empty())
     {
         decals_.Clear();
@@ -696,13 +744,10 @@ void DecalSet::OnWorldBoundingBoxUpdate()
     }
 }
 
-void DecalSet::GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target, unsigned batchIndex, const Frustum& frustum,
-    const Vector3& decalNormal, float normalCutoff)
+void DecalSet::GetFaces(DecalBuild& build, Drawable* target, unsigned index)
 {
-    // Try to use the most accurate LOD level if possible
-    Geometry* geometry = target->GetLodGeometry(batchIndex, 0);
-    if (!geometry || geometry->GetPrimitiveType() != TRIANGLE_LIST)
-        return;
+    Geometry* geometry = build.geometries_[index];
+    unsigned batchIndex = build.batchIndices_[index];
 
     const unsigned char* positionData = nullptr;
     const unsigned char* normalData = nullptr;
@@ -762,6 +807,12 @@ void DecalSet::GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target
         }
     }
 
+    // Cache the frustum plane tests of the vertices, as they are shared by several triangles
+    unsigned vertexEnd = geometry->GetVertexStart() + geometry->GetVertexCount();
+    build.outcodes_.Resize(vertexEnd);
+    if (vertexEnd)
+        memset(&build.outcodes_[0], UNKNOWN_OUTCODE, vertexEnd);
+
     if (indexData)
     {
         unsigned indexStart = geometry->GetIndexStart();
@@ -775,8 +826,8 @@ void DecalSet::GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target
 
             while (indices < indicesEnd)
             {
-                GetFace(faces, target, batchIndex, indices[0], indices[1], indices[2], positionData, normalData, skinningData,
-                    positionStride, normalStride, skinningStride, frustum, decalNormal, normalCutoff);
+                GetFace(build, target, batchIndex, indices[0], indices[1], indices[2], positionData, normalData, skinningData,
+                    positionStride, normalStride, skinningStride);
                 indices += 3;
             }
         }
@@ -788,8 +839,8 @@ void DecalSet::GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target
 
             while (indices < indicesEnd)
             {
-                GetFace(faces, target, batchIndex, indices[0], indices[1], indices[2], positionData, normalData, skinningData,
-                    positionStride, normalStride, skinningStride, frustum, decalNormal, normalCutoff);
+                GetFace(build, target, batchIndex, indices[0], indices[1], indices[2], positionData, normalData, skinningData,
+                    positionStride, normalStride, skinningStride);
                 indices += 3;
             }
         }
@@ -802,25 +853,32 @@ void DecalSet::GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target
 
         while (indices + 2 < indicesEnd)
         {
-            GetFace(faces, target, batchIndex, indices, indices + 1, indices + 2, positionData, normalData, skinningData,
-                positionStride, normalStride, skinningStride, frustum, decalNormal, normalCutoff);
+            GetFace(build, target, batchIndex, indices, indices + 1, indices + 2, positionData, normalData, skinningData,
+                positionStride, normalStride, skinningStride);
             indices += 3;
         }
     }
 }
 
-void DecalSet::GetFace(Vector<PODVector<DecalVertex> >& faces, Drawable* target, unsigned batchIndex, unsigned i0, unsigned i1,
-    unsigned i2, const unsigned char* positionData, const unsigned char* normalData, const unsigned char* skinningData,
-    unsigned positionStride, unsigned normalStride, unsigned skinningStride, const Frustum& frustum, const Vector3& decalNormal,
-    float normalCutoff)
+void DecalSet::GetFace(DecalBuild& build, Drawable* target, unsigned batchIndex, unsigned i0, unsigned i1, unsigned i2,
+    const unsigned char* positionData, const unsigned char* normalData, const unsigned char* skinningData, unsigned positionStride,
+    unsigned normalStride, unsigned skinningStride)
 {
     bool hasNormals = normalData != nullptr;
-    bool hasSkinning = skinned_ && skinningData != nullptr;
+    bool hasSkinning = build.skinned_ && skinningData != nullptr;
 
     const Vector3& v0 = *((const Vector3*)(&positionData[i0 * positionStride]));
     const Vector3& v1 = *((const Vector3*)(&positionData[i1 * positionStride]));
     const Vector3& v2 = *((const Vector3*)(&positionData[i2 * positionStride]));
 
+    // Check if face is culled completely by any of the planes. Otherwise it needs to be clipped against the planes it crosses
+    unsigned char outcode0 = GetCachedVertexOutcode(build, i0, v0);
+    unsigned char outcode1 = GetCachedVertexOutcode(build, i1, v1);
+    unsigned char outcode2 = GetCachedVertexOutcode(build, i2, v2);
+    if (outcode0 & outcode1 & outcode2)
+        return;
+    unsigned clipMask = (unsigned)(outcode0 | outcode1 | outcode2);
+
     // Calculate unsmoothed face normals if no normal data
     Vector3 faceNormal = Vector3::ZERO;
     if (!hasNormals)
@@ -839,19 +897,11 @@ void DecalSet::GetFace(Vector<PODVector<DecalVertex> >& faces, Drawable* target,
     const unsigned char* s2 = hasSkinning ? &skinningData[i2 * skinningStride] : nullptr;
 
     // Check if face is too much away from the decal normal
-    if (decalNormal.DotProduct((n0 + n1 + n2) / 3.0f) < normalCutoff)
+    if (build.decalNormal_.DotProduct((n0 + n1 + n2) / 3.0f) < build.normalCutoff_)
         return;
 
-    // Check if face is culled completely by any of the planes
-    for (unsigned i = PLANE_FAR; i < NUM_FRUSTUM_PLANES; --i)
-    {
-        const Plane& plane = frustum.planes_[i];
-        if (plane.Distance(v0) < 0.0f && plane.Distance(v1) < 0.0f && plane.Distance(v2) < 0.0f)
-            return;
-    }
-
-    faces.Resize(faces.Size() + 1);
-    PODVector<DecalVertex>& face = faces.Back();
+    PODVector<DecalVertex>& face = build.face_;
+    face.Clear();
     if (!hasSkinning)
     {
         face.Reserve(3);
@@ -881,6 +931,27 @@ void DecalSet::GetFace(Vector<PODVector<DecalVertex> >& faces, Drawable* target,
         face.Push(DecalVertex(v1, n1, bw1, nbi1));
         face.Push(DecalVertex(v2, n2, bw2, nbi2));
     }
+
+    // Clip against the crossed planes only, as clipping against the others would not change the face
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES && face.Size() >= 3; ++i)
+    {
+        if (clipMask & (1u << i))
+        {
+            ClipPolygon(build.clippedFace_, face, build.frustum_.planes_[i], build.skinned_);
+            face.Swap(build.clippedFace_);
+        }
+    }
+
+    // Now triangulate the resulting face into decal vertices
+    if (face.Size() < 3)
+        return;
+
+    for (unsigned i = 2; i < face.Size(); ++i)
+    {
+        build.decal_.AddVertex(face[0]);
+        build.decal_.AddVertex(face[i - 1]);
+        build.decal_.AddVertex(face[i]);
+    }
 }
 
 bool DecalSet::GetBones(Drawable* target, unsigned batchIndex, const float* blendWeights, const unsigned char* blendIndices,
@@ -983,6 +1054,92 @@ void DecalSet::TransformVertices(Decal& decal, const Matrix3x4& transform)
     }
 }
 
+void DecalSet::GenerateDecal(DecalBuild& build, Drawable* target)
+{
+    for (unsigned i = 0; i < build.geometries_.Size(); ++i)
+        GetFaces(build, target, i);
+
+    Decal& decal = build.decal_;
+    if (decal.vertices_.Empty())
+        return;
+
+    CalculateUVs(decal, build.view_, build.projection_, build.topLeftUV_, build.bottomRightUV_);
+
+    // Transform vertices to this node's local space and generate tangents
+    TransformVertices(decal, build.skinned_ ? Matrix3x4::IDENTITY : build.transform_);
+    GenerateTangents(&decal.vertices_[0], sizeof(DecalVertex), &decal.indices_[0], sizeof(unsigned short), 0,
+        decal.indices_.Size(), offsetof(DecalVertex, normal_), offsetof(DecalVertex, texCoord_), offsetof(DecalVertex,
+        tangent_));
+
+    decal.CalculateBoundingBox();
+}
+
+bool DecalSet::CommitDecal(DecalBuild& build)
+{
+    const Decal& decal = build.decal_;
+
+    // Check if resulted in no triangles
+    if (decal.vertices_.Empty())
+        return true;
+
+    if (decal.vertices_.Size() > maxVertices_)
+    {
+        URHO3D_LOGWARNING("Can not add decal, vertex count " + String(decal.vertices_.Size()) + " exceeds maximum " +
+                   String(maxVertices_));
+        return false;
+    }
+    if (decal.indices_.Size() > maxIndices_)
+    {
+        URHO3D_LOGWARNING("Can not add decal, index count " + String(decal.indices_.Size()) + " exceeds maximum " +
+                   String(maxIndices_));
+        return false;
+    }
+
+    decals_.Push(decal);
+    numVertices_ += decal.vertices_.Size();
+    numIndices_ += decal.indices_.Size();
+
+    // Remove oldest decals if total vertices exceeded
+    while (decals_.Size() && (numVertices_ > maxVertices_ || numIndices_ > maxIndices_))
+        RemoveDecals(1);
+
+    URHO3D_LOGDEBUG("Added decal with " + String(decal.vertices_.Size()) + " vertices");
+
+    // If new decal is time limited, subscribe to scene post-update
+    if (decal.timeToLive_ > 0.0f && !subscribed_)
+        UpdateEventSubscription(false);
+
+    MarkDecalsDirty();
+    return true;
+}
+
+void DecalSet::CommitPendingDecals()
+{
+    // Commit in the order the decals were added, so that the oldest are removed first if the limits are exceeded
+    while (!pendingDecals_.Empty() && pendingDecals_.Front().workItem_->completed_)
+    {
+        CommitDecal(pendingDecals_.Front());
+        pendingDecals_.PopFront();
+    }
+}
+
+void DecalSet::CancelPendingDecals()
+{
+    if (pendingDecals_.Empty())
+        return;
+
+    // The work items use the build data, so remove them or wait for them to finish if already started. If the work queue is
+    // gone, its threads have stopped and the items will never execute
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+    {
+        for (List<DecalBuild>::Iterator i = pendingDecals_.Begin(); i != pendingDecals_.End(); ++i)
+            queue->CancelWorkItem(i->workItem_);
+    }
+
+    pendingDecals_.Clear();
+}
+
 List<Decal>::Iterator DecalSet::RemoveDecal(List<Decal>::Iterator i)
 {
     numVertices_ -= i->vertices_.Size();
@@ -1142,8 +1299,8 @@ void DecalSet::UpdateEventSubscription(bool checkAllDecals)
             }
         }
 
-        // If no time limited decals, no need to subscribe to scene update
-        enabled = hasTimeLimitedDecals;
+        // If no time limited or pending decals, no need to subscribe to scene update
+        enabled = hasTimeLimitedDecals || !pendingDecals_.Empty();
     }
 
     if (enabled && !subscribed_)
@@ -1164,6 +1321,13 @@ void DecalSet::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData
 
     float timeStep = eventData[P_TIMESTEP].GetFloat();
 
+    if (!pendingDecals_.Empty())
+    {
+        CommitPendingDecals();
+        if (pendingDecals_.Empty())
+            UpdateEventSubscription(true);
+    }
+
     for (List<Decal>::Iterator i = decals_.Begin(); i != decals_.End();)
     {
         i->timer_ += timeStep;
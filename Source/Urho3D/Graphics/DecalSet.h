@@ -32,6 +32,7 @@ namespace Urho3D
 
 class IndexBuffer;
 class VertexBuffer;
+struct WorkItem;
 
 /// %Decal vertex.
 struct DecalVertex
@@ -101,11 +102,58 @@ struct Decal
     PODVector<unsigned short> indices_;
 };
 
+/// %Decal geometry generation parameters and result. Generated in a worker thread when asynchronous generation is enabled.
+struct DecalBuild
+{
+    /// Target geometries. The references keep the CPU-side geometry data valid during asynchronous generation.
+    Vector<SharedPtr<Geometry> > geometries_;
+    /// Target batch indices of the geometries.
+    PODVector<unsigned> batchIndices_;
+    /// %Decal frustum in the target's model space.
+    Frustum frustum_;
+    /// Frustum plane normal X components, padded to two groups of four planes.
+    float planeX_[8];
+    /// Frustum plane normal Y components.
+    float planeY_[8];
+    /// Frustum plane normal Z components.
+    float planeZ_[8];
+    /// Frustum plane constants.
+    float planeD_[8];
+    /// %Decal view matrix in the target's model space.
+    Matrix3x4 view_;
+    /// %Decal projection matrix.
+    Matrix4 projection_;
+    /// Transform from the target's model space to the decal set's local space.
+    Matrix3x4 transform_;
+    /// %Decal normal in the target's model space.
+    Vector3 decalNormal_;
+    /// Top-left texture coordinates.
+    Vector2 topLeftUV_;
+    /// Bottom-right texture coordinates.
+    Vector2 bottomRightUV_;
+    /// Normal cutoff for faces.
+    float normalCutoff_;
+    /// Skinned mode flag.
+    bool skinned_;
+    /// Resulting decal.
+    Decal decal_;
+    /// Cached frustum plane masks of the target vertices.
+    PODVector<unsigned char> outcodes_;
+    /// Face being clipped.
+    PODVector<DecalVertex> face_;
+    /// Clipping result buffer.
+    PODVector<DecalVertex> clippedFace_;
+    /// Work item for asynchronous generation.
+    SharedPtr<WorkItem> workItem_;
+};
+
 /// %Decal renderer component.
 class URHO3D_API DecalSet : public Drawable
 {
     URHO3D_OBJECT(DecalSet, Drawable);
 
+    friend void GenerateDecalWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     DecalSet(Context* context);
@@ -135,13 +183,15 @@ public:
     void SetMaxIndices(unsigned num);
     /// Set whether to optimize GPU buffer sizes according to current amount of decals. Default false, which will size the buffers according to the maximum vertices/indices. When true, buffers will be reallocated whenever decals are added/removed, which can be worse for performance.
     void SetOptimizeBufferSize(bool enable);
-    /// Add a decal at world coordinates, using a target drawable's geometry for reference. If the decal needs to move with the target, the decal component should be created to the target's node. Return true if successful.
+    /// Set whether to generate decal geometry from static targets asynchronously in worker threads. Default false. When true, AddDecal() returns after queuing the work and the decal is added on a following frame. The target's CPU-side geometry data must not be modified while decals are pending.
+    void SetAsyncGeneration(bool enable);
+    /// Add a decal at world coordinates, using a target drawable's geometry for reference. If the decal needs to move with the target, the decal component should be created to the target's node. Return true if successful, or if queued for asynchronous generation.
     bool AddDecal(Drawable* target, const Vector3& worldPosition, const Quaternion& worldRotation, float size, float aspectRatio,
         float depth, const Vector2& topLeftUV, const Vector2& bottomRightUV, float timeToLive = 0.0f, float normalCutoff = 0.1f,
         unsigned subGeometry = M_MAX_UNSIGNED);
     /// Remove n oldest decals.
     void RemoveDecals(unsigned num);
-    /// Remove all decals.
+    /// Remove all decals, including pending asynchronous decals.
     void RemoveAllDecals();
 
     /// Return material.
@@ -150,6 +200,9 @@ public:
     /// Return number of decals.
     unsigned GetNumDecals() const { return decals_.Size(); }
 
+    /// Return number of decals waiting for asynchronous generation.
+    unsigned GetNumPendingDecals() const { return pendingDecals_.Size(); }
+
     /// Retur number of vertices in the decals.
     unsigned GetNumVertices() const { return numVertices_; }
 
@@ -165,6 +218,9 @@ public:
     /// Return whether is optimizing GPU buffer sizes according to current amount of decals.
     bool GetOptimizeBufferSize() const { return optimizeBufferSize_; }
 
+    /// Return whether decal geometry is generated asynchronously.
+    bool GetAsyncGeneration() const { return asyncGeneration_; }
+
     /// Set material attribute.
     void SetMaterialAttr(const ResourceRef& value);
     /// Set decals attribute.
@@ -181,15 +237,20 @@ protected:
     virtual void OnMarkedDirty(Node* node) override;
 
 private:
-    /// Get triangle faces from the target geometry.
-    void GetFaces(Vector<PODVector<DecalVertex> >& faces, Drawable* target, unsigned batchIndex, const Frustum& frustum,
-        const Vector3& decalNormal, float normalCutoff);
-    /// Get triangle face from the target geometry.
-    void GetFace
-        (Vector<PODVector<DecalVertex> >& faces, Drawable* target, unsigned batchIndex, unsigned i0, unsigned i1, unsigned i2,
-            const unsigned char* positionData, const unsigned char* normalData, const unsigned char* skinningData,
-            unsigned positionStride, unsigned normalStride, unsigned skinningStride, const Frustum& frustum,
-            const Vector3& decalNormal, float normalCutoff);
+    /// Generate decal geometry. The target drawable is only accessed in skinned mode. Called from a worker thread for asynchronous generation.
+    void GenerateDecal(DecalBuild& build, Drawable* target);
+    /// Add a generated decal to the set. Return true if successful.
+    bool CommitDecal(DecalBuild& build);
+    /// Add pending decals that have finished generating.
+    void CommitPendingDecals();
+    /// Remove pending decals. Wait for generation already in progress to finish.
+    void CancelPendingDecals();
+    /// Get clipped triangle faces from a target geometry.
+    void GetFaces(DecalBuild& build, Drawable* target, unsigned index);
+    /// Get clipped triangle face from a target geometry.
+    void GetFace(DecalBuild& build, Drawable* target, unsigned batchIndex, unsigned i0, unsigned i1, unsigned i2,
+        const unsigned char* positionData, const unsigned char* normalData, const unsigned char* skinningData,
+        unsigned positionStride, unsigned normalStride, unsigned skinningStride);
     /// Get bones referenced by skinning data and remap the skinning indices. Return true if successful.
     bool GetBones(Drawable* target, unsigned batchIndex, const float* blendWeights, const unsigned char* blendIndices,
         unsigned char* newBlendIndices);
@@ -225,6 +286,8 @@ private:
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Decals.
     List<Decal> decals_;
+    /// Decals waiting for asynchronous generation, in the order they were added.
+    List<DecalBuild> pendingDecals_;
     /// Bones used for skinned decals.
     Vector<Bone> bones_;
     /// Skinning matrices.
@@ -239,6 +302,8 @@ private:
     unsigned maxIndices_;
     /// Optimize buffer sizes flag.
     bool optimizeBufferSize_;
+    /// Asynchronous generation flag.
+    bool asyncGeneration_;
     /// Skinned mode flag.
     bool skinned_;
     /// Vertex buffer needs rewrite / resizing flag.
@@ -27,6 +27,8 @@
 
 #if defined(URHO3D_OPENGL)
 #include "OpenGL/OGLGraphicsImpl.h"
+#elif defined(URHO3D_NULL_GRAPHICS)
+#include "Null/NullGraphicsImpl.h"
 #elif defined(URHO3D_D3D11)
 #include "Direct3D11/D3D11GraphicsImpl.h"
 #else
@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../../Container/HashMap.h"
+#include "../../Graphics/ConstantBuffer.h"
+#include "../../Graphics/GraphicsDefs.h"
+#include "../../Graphics/ShaderProgram.h"
+
+namespace Urho3D
+{
+
+/// Texture formats of the null graphics backend. Only used for bookkeeping, as no texture data is ever uploaded.
+enum NullTextureFormat
+{
+    NULL_FORMAT_UNKNOWN = 0,
+    NULL_FORMAT_A8,
+    NULL_FORMAT_R8,
+    NULL_FORMAT_RG8,
+    NULL_FORMAT_RGBA8,
+    NULL_FORMAT_RGBA16,
+    NULL_FORMAT_RGBA16F,
+    NULL_FORMAT_RGBA32F,
+    NULL_FORMAT_RG16,
+    NULL_FORMAT_RG16F,
+    NULL_FORMAT_RG32F,
+    NULL_FORMAT_R16F,
+    NULL_FORMAT_R32F,
+    NULL_FORMAT_D16,
+    NULL_FORMAT_D24S8,
+    NULL_FORMAT_D32,
+    NULL_FORMAT_DXT1,
+    NULL_FORMAT_DXT3,
+    NULL_FORMAT_DXT5
+};
+
+using ShaderProgramMap = HashMap<Pair<ShaderVariation*, ShaderVariation*>, SharedPtr<ShaderProgram> >;
+
+/// %Graphics implementation. Holds the API call records of the null (headless) backend.
+class URHO3D_API GraphicsImpl
+{
+    friend class Graphics;
+
+public:
+    /// Construct.
+    GraphicsImpl();
+
+    /// Return number of shader parameter updates this frame.
+    unsigned GetNumShaderParameterUpdates() const { return numShaderParameterUpdates_; }
+
+    /// Return number of shader program changes this frame.
+    unsigned GetNumShaderChanges() const { return numShaderChanges_; }
+
+    /// Return number of texture binding changes this frame.
+    unsigned GetNumTextureChanges() const { return numTextureChanges_; }
+
+    /// Return number of rendertarget or depth-stencil binding changes this frame.
+    unsigned GetNumRenderTargetChanges() const { return numRenderTargetChanges_; }
+
+    /// Return number of render state (blend, depth, rasterizer, scissor, stencil) changes this frame.
+    unsigned GetNumStateChanges() const { return numStateChanges_; }
+
+    /// Return number of bytes written to vertex, index and constant buffers this frame.
+    unsigned long long GetBufferUploadBytes() const { return bufferUploadBytes_; }
+
+    /// Record a buffer upload of the given size. Called by the null vertex, index and constant buffers.
+    void RecordBufferUpload(unsigned bytes) { bufferUploadBytes_ += bytes; }
+
+private:
+    /// Reset the per-frame records.
+    void ResetFrameRecords();
+
+    /// Shader parameter updates this frame.
+    unsigned numShaderParameterUpdates_;
+    /// Shader program changes this frame.
+    unsigned numShaderChanges_;
+    /// Texture binding changes this frame.
+    unsigned numTextureChanges_;
+    /// Rendertarget binding changes this frame.
+    unsigned numRenderTargetChanges_;
+    /// Render state changes this frame.
+    unsigned numStateChanges_;
+    /// Bytes uploaded to buffers this frame.
+    unsigned long long bufferUploadBytes_;
+    /// Constant buffer search map.
+    HashMap<unsigned, SharedPtr<ConstantBuffer> > allConstantBuffers_;
+    /// Shader programs.
+    ShaderProgramMap shaderPrograms_;
+    /// Shader program in use.
+    ShaderProgram* shaderProgram_;
+};
+
+}
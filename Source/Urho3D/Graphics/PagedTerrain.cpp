@@ -0,0 +1,621 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/Sort.h"
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/PagedTerrain.h"
+#include "../Graphics/Renderer.h"
+#include "../Graphics/Terrain.h"
+#include "../Graphics/Viewport.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Scene/Node.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+static const Vector3 DEFAULT_SPACING(1.0f, 0.25f, 1.0f);
+static const IntVector2 DEFAULT_NUM_TILES(16, 16);
+static const int DEFAULT_TILE_SIZE = 256;
+static const int DEFAULT_PATCH_SIZE = 32;
+static const unsigned DEFAULT_MAX_LOD_LEVELS = 4;
+static const float DEFAULT_LOAD_DISTANCE = 512.0f;
+static const float DEFAULT_UNLOAD_DISTANCE = 640.0f;
+static const unsigned DEFAULT_MAX_TILE_BUILDS = 1;
+
+/// Tile waiting for terrain creation, sorted by distance to focus.
+struct PendingTerrainTile
+{
+    /// Tile coordinates.
+    IntVector2 coords_;
+    /// Distance to focus.
+    float distance_;
+};
+
+static inline bool CompareTileDistances(const PendingTerrainTile& lhs, const PendingTerrainTile& rhs)
+{
+    return lhs.distance_ < rhs.distance_;
+}
+
+PagedTerrain::PagedTerrain(Context* context) :
+    Component(context),
+    numTiles_(DEFAULT_NUM_TILES),
+    tileSize_(DEFAULT_TILE_SIZE),
+    spacing_(DEFAULT_SPACING),
+    patchSize_(DEFAULT_PATCH_SIZE),
+    maxLodLevels_(DEFAULT_MAX_LOD_LEVELS),
+    smoothing_(false),
+    loadDistance_(DEFAULT_LOAD_DISTANCE),
+    unloadDistance_(DEFAULT_UNLOAD_DISTANCE),
+    maxTileBuildsPerFrame_(DEFAULT_MAX_TILE_BUILDS),
+    drawDistance_(0.0f),
+    castShadows_(false),
+    occluder_(false)
+{
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(PagedTerrain, HandleResourceBackgroundLoaded));
+}
+
+PagedTerrain::~PagedTerrain()
+{
+    RemoveAllTiles();
+}
+
+void PagedTerrain::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PagedTerrain>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Height Map Prefix", GetHeightMapPrefix, SetHeightMapPrefix, String, String::EMPTY, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Num Tiles", GetNumTiles, SetNumTiles, IntVector2, DEFAULT_NUM_TILES, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Tile Size", GetTileSize, SetTileSize, int, DEFAULT_TILE_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Vertex Spacing", GetSpacing, SetSpacing, Vector3, DEFAULT_SPACING, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Patch Size", GetPatchSize, SetPatchSize, int, DEFAULT_PATCH_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max LOD Levels", GetMaxLodLevels, SetMaxLodLevels, unsigned, DEFAULT_MAX_LOD_LEVELS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Smooth Height Map", GetSmoothing, SetSmoothing, bool, false, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()),
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Load Distance", GetLoadDistance, SetLoadDistance, float, DEFAULT_LOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Unload Distance", GetUnloadDistance, SetUnloadDistance, float, DEFAULT_UNLOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Tile Builds Per Frame", GetMaxTileBuildsPerFrame, SetMaxTileBuildsPerFrame, unsigned,
+        DEFAULT_MAX_TILE_BUILDS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Occluder", IsOccluder, SetOccluder, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cast Shadows", GetCastShadows, SetCastShadows, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Draw Distance", GetDrawDistance, SetDrawDistance, float, 0.0f, AM_DEFAULT);
+}
+
+void PagedTerrain::OnSetEnabled()
+{
+    bool enabled = IsEnabledEffective();
+
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.node_)
+            i->second_.node_->SetEnabled(enabled);
+    }
+
+    Scene* scene = GetScene();
+    if (scene)
+    {
+        if (enabled)
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(PagedTerrain, HandleScenePostUpdate));
+        else
+            UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
+    }
+}
+
+void PagedTerrain::SetHeightMapPrefix(const String& prefix)
+{
+    if (prefix != heightMapPrefix_)
+    {
+        RemoveAllTiles();
+        heightMapPrefix_ = prefix;
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetNumTiles(const IntVector2& numTiles)
+{
+    IntVector2 newNumTiles(Max(numTiles.x_, 1), Max(numTiles.y_, 1));
+    if (newNumTiles != numTiles_)
+    {
+        RemoveAllTiles();
+        numTiles_ = newNumTiles;
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetTileSize(int size)
+{
+    if (size < 1)
+        return;
+
+    if (size != tileSize_)
+    {
+        RemoveAllTiles();
+        tileSize_ = size;
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetSpacing(const Vector3& spacing)
+{
+    if (spacing != spacing_)
+    {
+        RemoveAllTiles();
+        spacing_ = spacing;
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetPatchSize(int size)
+{
+    if (size != patchSize_)
+    {
+        patchSize_ = size;
+        for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+        {
+            Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+            if (terrain)
+                terrain->SetPatchSize(size);
+        }
+
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetMaxLodLevels(unsigned levels)
+{
+    if (levels != maxLodLevels_)
+    {
+        maxLodLevels_ = levels;
+        for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+        {
+            Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+            if (terrain)
+                terrain->SetMaxLodLevels(levels);
+        }
+
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetSmoothing(bool enable)
+{
+    if (enable != smoothing_)
+    {
+        smoothing_ = enable;
+        for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+        {
+            Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+            if (terrain)
+                terrain->SetSmoothing(enable);
+        }
+
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetMaterial(Material* material)
+{
+    material_ = material;
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+        if (terrain)
+            terrain->SetMaterial(material);
+    }
+
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetLoadDistance(float distance)
+{
+    loadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetUnloadDistance(float distance)
+{
+    unloadDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetMaxTileBuildsPerFrame(unsigned num)
+{
+    maxTileBuildsPerFrame_ = Max(num, 1U);
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetFocusNode(Node* node)
+{
+    focusNode_ = node;
+}
+
+void PagedTerrain::SetDrawDistance(float distance)
+{
+    drawDistance_ = distance;
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+        if (terrain)
+            terrain->SetDrawDistance(distance);
+    }
+
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetCastShadows(bool enable)
+{
+    castShadows_ = enable;
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+        if (terrain)
+            terrain->SetCastShadows(enable);
+    }
+
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetOccluder(bool enable)
+{
+    occluder_ = enable;
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        Terrain* terrain = i->second_.node_ ? i->second_.node_->GetComponent<Terrain>() : nullptr;
+        if (terrain)
+            terrain->SetOccluder(enable);
+    }
+
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::RemoveAllTiles()
+{
+    while (tiles_.Size())
+        RemoveTile(tiles_.Begin());
+}
+
+Material* PagedTerrain::GetMaterial() const
+{
+    return material_;
+}
+
+Node* PagedTerrain::GetFocusNode() const
+{
+    return focusNode_;
+}
+
+Terrain* PagedTerrain::GetTile(int x, int z) const
+{
+    HashMap<IntVector2, TerrainTile>::ConstIterator i = tiles_.Find(IntVector2(x, z));
+    if (i == tiles_.End() || !i->second_.node_)
+        return nullptr;
+    else
+        return i->second_.node_->GetComponent<Terrain>();
+}
+
+Terrain* PagedTerrain::GetTileAt(const Vector3& worldPosition) const
+{
+    if (!node_)
+        return nullptr;
+
+    IntVector2 coords = GetTileCoords(node_->GetWorldTransform().Inverse() * worldPosition);
+    return GetTile(coords.x_, coords.y_);
+}
+
+unsigned PagedTerrain::GetNumCreatedTiles() const
+{
+    unsigned num = 0;
+    for (HashMap<IntVector2, TerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.state_ == TILE_CREATED)
+            ++num;
+    }
+
+    return num;
+}
+
+float PagedTerrain::GetHeight(const Vector3& worldPosition) const
+{
+    Terrain* terrain = GetTileAt(worldPosition);
+    return terrain ? terrain->GetHeight(worldPosition) : 0.0f;
+}
+
+Vector3 PagedTerrain::GetNormal(const Vector3& worldPosition) const
+{
+    Terrain* terrain = GetTileAt(worldPosition);
+    return terrain ? terrain->GetNormal(worldPosition) : Vector3::UP;
+}
+
+void PagedTerrain::SetMaterialAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetMaterial(cache->GetResource<Material>(value.name_));
+}
+
+ResourceRef PagedTerrain::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+void PagedTerrain::OnSceneSet(Scene* scene)
+{
+    if (scene && IsEnabledEffective())
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(PagedTerrain, HandleScenePostUpdate));
+    else if (!scene)
+    {
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        RemoveAllTiles();
+    }
+}
+
+void PagedTerrain::UpdateTiles(const Vector3& focusPosition)
+{
+    URHO3D_PROFILE(UpdatePagedTerrain);
+
+    Vector3 position = node_->GetWorldTransform().Inverse() * focusPosition;
+
+    // Evict tiles that have moved out of range
+    for (HashMap<IntVector2, TerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End();)
+    {
+        HashMap<IntVector2, TerrainTile>::Iterator current = i++;
+        if (GetTileDistance(current->first_, position) > Max(unloadDistance_, loadDistance_))
+            RemoveTile(current);
+    }
+
+    // Request tiles that have come into range
+    float tileWorldSizeX = tileSize_ * spacing_.x_;
+    float tileWorldSizeZ = tileSize_ * spacing_.z_;
+    if (tileWorldSizeX <= 0.0f || tileWorldSizeZ <= 0.0f)
+        return;
+
+    IntVector2 center = GetTileCoords(position);
+    int rangeX = (int)(loadDistance_ / tileWorldSizeX) + 1;
+    int rangeZ = (int)(loadDistance_ / tileWorldSizeZ) + 1;
+    int minX = Max(center.x_ - rangeX, 0);
+    int maxX = Min(center.x_ + rangeX, numTiles_.x_ - 1);
+    int minZ = Max(center.y_ - rangeZ, 0);
+    int maxZ = Min(center.y_ + rangeZ, numTiles_.y_ - 1);
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            IntVector2 coords(x, z);
+            if (!tiles_.Contains(coords) && GetTileDistance(coords, position) <= loadDistance_)
+                RequestTile(coords);
+        }
+    }
+
+    // Turn the nearest loaded tiles into terrain, limited per frame to bound the geometry build cost
+    PODVector<PendingTerrainTile> pending;
+    for (HashMap<IntVector2, TerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.state_ == TILE_LOADED)
+        {
+            PendingTerrainTile tile;
+            tile.coords_ = i->first_;
+            tile.distance_ = GetTileDistance(i->first_, position);
+            pending.Push(tile);
+        }
+    }
+
+    if (pending.Empty())
+        return;
+
+    Sort(pending.Begin(), pending.End(), CompareTileDistances);
+    unsigned numBuilds = Min(pending.Size(), maxTileBuildsPerFrame_);
+    for (unsigned i = 0; i < numBuilds; ++i)
+        CreateTile(pending[i].coords_, tiles_[pending[i].coords_]);
+}
+
+void PagedTerrain::RequestTile(const IntVector2& coords)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    TerrainTile& tile = tiles_[coords];
+    tile.name_ = GetTileName(coords);
+
+    // If already loaded (or loaded synchronously when threading is not supported) the tile is ready immediately.
+    // Otherwise wait for the background load finished event
+    bool queued = cache->BackgroundLoadResource<Image>(tile.name_);
+    tile.heightMap_ = cache->GetExistingResource<Image>(tile.name_);
+    if (tile.heightMap_)
+        tile.state_ = TILE_LOADED;
+    else if (queued || cache->GetNumBackgroundLoadResources())
+        loadingTiles_[StringHash(tile.name_)] = coords;
+    else
+        tile.state_ = TILE_FAILED;
+}
+
+void PagedTerrain::CreateTile(const IntVector2& coords, TerrainTile& tile)
+{
+    URHO3D_PROFILE(CreateTerrainTile);
+
+    Node* tileNode = node_->CreateTemporaryChild("Tile_" + String(coords.x_) + "_" + String(coords.y_), LOCAL);
+    tileNode->SetPosition(GetTileCenter(coords));
+    tileNode->SetEnabled(IsEnabledEffective());
+
+    Terrain* terrain = tileNode->CreateComponent<Terrain>(LOCAL);
+    terrain->SetSpacing(spacing_);
+    terrain->SetPatchSize(patchSize_);
+    terrain->SetMaxLodLevels(maxLodLevels_);
+    terrain->SetSmoothing(smoothing_);
+    terrain->SetMaterial(material_);
+    terrain->SetDrawDistance(drawDistance_);
+    terrain->SetCastShadows(castShadows_);
+    terrain->SetOccluder(occluder_);
+
+    const int size = tileSize_ + 1;
+    if (tile.heightMap_->GetWidth() != size || tile.heightMap_->GetHeight() != size)
+        URHO3D_LOGWARNING("Terrain tile " + tile.name_ + " is not " + String(size) + "x" + String(size) + " pixels");
+
+    tile.node_ = tileNode;
+    if (!terrain->SetHeightMap(tile.heightMap_))
+    {
+        tileNode->Remove();
+        tile.node_.Reset();
+        tile.state_ = TILE_FAILED;
+        return;
+    }
+
+    tile.state_ = TILE_CREATED;
+
+    // Stitch LOD seams with the neighboring tiles
+    UpdateTileNeighbors(coords);
+    UpdateTileNeighbors(coords + IntVector2(0, 1));
+    UpdateTileNeighbors(coords + IntVector2(0, -1));
+    UpdateTileNeighbors(coords + IntVector2(-1, 0));
+    UpdateTileNeighbors(coords + IntVector2(1, 0));
+}
+
+void PagedTerrain::RemoveTile(HashMap<IntVector2, TerrainTile>::Iterator i)
+{
+    IntVector2 coords = i->first_;
+    String name = i->second_.name_;
+    bool created = i->second_.state_ == TILE_CREATED;
+
+    if (i->second_.node_)
+        i->second_.node_->Remove();
+    tiles_.Erase(i);
+
+    // Release the heightmap if nothing else refers to it. If still loading, it is released when the load finishes
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (cache && !name.Empty())
+        cache->ReleaseResource<Image>(name);
+
+    if (created)
+    {
+        UpdateTileNeighbors(coords + IntVector2(0, 1));
+        UpdateTileNeighbors(coords + IntVector2(0, -1));
+        UpdateTileNeighbors(coords + IntVector2(-1, 0));
+        UpdateTileNeighbors(coords + IntVector2(1, 0));
+    }
+}
+
+void PagedTerrain::UpdateTileNeighbors(const IntVector2& coords)
+{
+    Terrain* terrain = GetTile(coords.x_, coords.y_);
+    if (!terrain)
+        return;
+
+    terrain->SetNeighbors(GetTile(coords.x_, coords.y_ + 1), GetTile(coords.x_, coords.y_ - 1), GetTile(coords.x_ - 1, coords.y_),
+        GetTile(coords.x_ + 1, coords.y_));
+}
+
+String PagedTerrain::GetTileName(const IntVector2& coords) const
+{
+    return heightMapPrefix_ + "_" + String(coords.x_) + "_" + String(coords.y_) + ".png";
+}
+
+Vector3 PagedTerrain::GetTileCenter(const IntVector2& coords) const
+{
+    return Vector3(((float)coords.x_ + 0.5f - numTiles_.x_ * 0.5f) * tileSize_ * spacing_.x_, 0.0f,
+        ((float)coords.y_ + 0.5f - numTiles_.y_ * 0.5f) * tileSize_ * spacing_.z_);
+}
+
+float PagedTerrain::GetTileDistance(const IntVector2& coords, const Vector3& position) const
+{
+    Vector3 center = GetTileCenter(coords);
+    float halfSizeX = 0.5f * tileSize_ * spacing_.x_;
+    float halfSizeZ = 0.5f * tileSize_ * spacing_.z_;
+    float dx = Max(Abs(position.x_ - center.x_) - halfSizeX, 0.0f);
+    float dz = Max(Abs(position.z_ - center.z_) - halfSizeZ, 0.0f);
+    return sqrtf(dx * dx + dz * dz);
+}
+
+IntVector2 PagedTerrain::GetTileCoords(const Vector3& position) const
+{
+    return IntVector2(FloorToInt(position.x_ / (tileSize_ * spacing_.x_) + numTiles_.x_ * 0.5f),
+        FloorToInt(position.z_ / (tileSize_ * spacing_.z_) + numTiles_.y_ * 0.5f));
+}
+
+bool PagedTerrain::GetFocusPosition(Vector3& position) const
+{
+    if (focusNode_)
+    {
+        position = focusNode_->GetWorldPosition();
+        return true;
+    }
+
+    Renderer* renderer = GetSubsystem<Renderer>();
+    Viewport* viewport = renderer ? renderer->GetViewport(0) : nullptr;
+    Camera* camera = viewport ? viewport->GetCamera() : nullptr;
+    if (camera && camera->GetNode() && camera->GetScene() == GetScene())
+    {
+        position = camera->GetNode()->GetWorldPosition();
+        return true;
+    }
+
+    return false;
+}
+
+void PagedTerrain::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!node_ || heightMapPrefix_.Empty())
+        return;
+
+    Vector3 focusPosition;
+    if (GetFocusPosition(focusPosition))
+        UpdateTiles(focusPosition);
+}
+
+void PagedTerrain::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    HashMap<StringHash, IntVector2>::Iterator i = loadingTiles_.Find(StringHash(eventData[P_RESOURCENAME].GetString()));
+    if (i == loadingTiles_.End())
+        return;
+
+    IntVector2 coords = i->second_;
+    loadingTiles_.Erase(i);
+
+    // If the tile was evicted while loading, release the heightmap right away
+    HashMap<IntVector2, TerrainTile>::Iterator j = tiles_.Find(coords);
+    if (j == tiles_.End() || j->second_.state_ != TILE_LOADING)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        cache->ReleaseResource<Image>(eventData[P_RESOURCENAME].GetString());
+        return;
+    }
+
+    TerrainTile& tile = j->second_;
+    tile.heightMap_ = eventData[P_SUCCESS].GetBool() ? static_cast<Image*>(eventData[P_RESOURCE].GetPtr()) : nullptr;
+    tile.state_ = tile.heightMap_ ? TILE_LOADED : TILE_FAILED;
+}
+
+}
@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Material;
+class Terrain;
+
+/// Paged terrain tile load state.
+enum TerrainTileState
+{
+    TILE_LOADING = 0,
+    TILE_LOADED,
+    TILE_CREATED,
+    TILE_FAILED
+};
+
+/// Paged terrain tile.
+struct TerrainTile
+{
+    /// Construct.
+    TerrainTile() :
+        state_(TILE_LOADING)
+    {
+    }
+
+    /// Heightmap resource name.
+    String name_;
+    /// Heightmap image, held until the tile is evicted.
+    SharedPtr<Image> heightMap_;
+    /// Scene node of the created terrain.
+    WeakPtr<Node> node_;
+    /// Load state.
+    TerrainTileState state_;
+};
+
+/// Terrain component that streams a grid of heightmap tiles around a focus position. Tiles are background loaded from "<prefix>_<x>_<z>.png", created as child Terrain components with seamless neighbor stitching, and evicted when far away.
+class URHO3D_API PagedTerrain : public Component
+{
+    URHO3D_OBJECT(PagedTerrain, Component);
+
+public:
+    /// Construct.
+    PagedTerrain(Context* context);
+    /// Destruct. Remove all tiles.
+    virtual ~PagedTerrain() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Handle enabled/disabled state change.
+    virtual void OnSetEnabled() override;
+
+    /// Set heightmap tile resource name prefix. Tile heightmaps are named "<prefix>_<x>_<z>.png" with z increasing towards positive Z.
+    void SetHeightMapPrefix(const String& prefix);
+    /// Set number of tiles in X and Z directions. The tile grid is centered on the scene node.
+    void SetNumTiles(const IntVector2& numTiles);
+    /// Set tile quads per side. Tile heightmaps must be this size + 1, and adjacent tiles share their edge row. Must be a multiple of the patch size.
+    void SetTileSize(int size);
+    /// Set vertex (XZ) and height (Y) spacing.
+    void SetSpacing(const Vector3& spacing);
+    /// Set patch quads per side. Must be a power of two.
+    void SetPatchSize(int size);
+    /// Set maximum number of LOD levels for terrain patches. This can be between 1-4.
+    void SetMaxLodLevels(unsigned levels);
+    /// Set smoothing of tile heightmaps.
+    void SetSmoothing(bool enable);
+    /// Set material.
+    void SetMaterial(Material* material);
+    /// Set distance within which tiles are loaded.
+    void SetLoadDistance(float distance);
+    /// Set distance beyond which tiles are evicted. Should be larger than the load distance to avoid thrashing.
+    void SetUnloadDistance(float distance);
+    /// Set maximum number of loaded tiles turned into terrain per frame.
+    void SetMaxTileBuildsPerFrame(unsigned num);
+    /// Set scene node that tiles are streamed around. If null (default), the camera of the first renderer viewport is used.
+    void SetFocusNode(Node* node);
+    /// Set draw distance for tile patches.
+    void SetDrawDistance(float distance);
+    /// Set shadowcaster flag for tile patches.
+    void SetCastShadows(bool enable);
+    /// Set occlusion flag for tile patches.
+    void SetOccluder(bool enable);
+    /// Remove all tiles and release their heightmaps. They are streamed in again on the next update.
+    void RemoveAllTiles();
+
+    /// Return heightmap tile resource name prefix.
+    const String& GetHeightMapPrefix() const { return heightMapPrefix_; }
+    /// Return number of tiles in X and Z directions.
+    const IntVector2& GetNumTiles() const { return numTiles_; }
+    /// Return tile quads per side.
+    int GetTileSize() const { return tileSize_; }
+    /// Return vertex and height spacing.
+    const Vector3& GetSpacing() const { return spacing_; }
+    /// Return patch quads per side.
+    int GetPatchSize() const { return patchSize_; }
+    /// Return maximum number of LOD levels for terrain patches.
+    unsigned GetMaxLodLevels() const { return maxLodLevels_; }
+    /// Return whether tile heightmaps are smoothed.
+    bool GetSmoothing() const { return smoothing_; }
+    /// Return material.
+    Material* GetMaterial() const;
+    /// Return tile load distance.
+    float GetLoadDistance() const { return loadDistance_; }
+    /// Return tile eviction distance.
+    float GetUnloadDistance() const { return unloadDistance_; }
+    /// Return maximum number of tiles turned into terrain per frame.
+    unsigned GetMaxTileBuildsPerFrame() const { return maxTileBuildsPerFrame_; }
+    /// Return focus scene node.
+    Node* GetFocusNode() const;
+    /// Return draw distance.
+    float GetDrawDistance() const { return drawDistance_; }
+    /// Return shadowcaster flag.
+    bool GetCastShadows() const { return castShadows_; }
+    /// Return occluder flag.
+    bool IsOccluder() const { return occluder_; }
+    /// Return terrain of a tile, or null if not currently resident.
+    Terrain* GetTile(int x, int z) const;
+    /// Return terrain of the tile at world position, or null if not currently resident.
+    Terrain* GetTileAt(const Vector3& worldPosition) const;
+    /// Return number of tiles being loaded or resident.
+    unsigned GetNumActiveTiles() const { return tiles_.Size(); }
+    /// Return number of tiles created as terrain.
+    unsigned GetNumCreatedTiles() const;
+    /// Return height at world coordinates, or zero if the tile is not resident.
+    float GetHeight(const Vector3& worldPosition) const;
+    /// Return normal at world coordinates.
+    Vector3 GetNormal(const Vector3& worldPosition) const;
+
+    /// Set material attribute.
+    void SetMaterialAttr(const ResourceRef& value);
+    /// Return material attribute.
+    ResourceRef GetMaterialAttr() const;
+
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene) override;
+
+private:
+    /// Update tile loading, creation and eviction around the focus position.
+    void UpdateTiles(const Vector3& focusPosition);
+    /// Queue background loading of a tile heightmap.
+    void RequestTile(const IntVector2& coords);
+    /// Create terrain for a loaded tile.
+    void CreateTile(const IntVector2& coords, TerrainTile& tile);
+    /// Remove a tile and release its heightmap.
+    void RemoveTile(HashMap<IntVector2, TerrainTile>::Iterator i);
+    /// Reassign neighbors of a tile's terrain from the currently created tiles.
+    void UpdateTileNeighbors(const IntVector2& coords);
+    /// Return tile heightmap resource name.
+    String GetTileName(const IntVector2& coords) const;
+    /// Return tile center in local space.
+    Vector3 GetTileCenter(const IntVector2& coords) const;
+    /// Return horizontal distance from a local space position to a tile's bounds.
+    float GetTileDistance(const IntVector2& coords, const Vector3& position) const;
+    /// Return tile coordinates at a local space position.
+    IntVector2 GetTileCoords(const Vector3& position) const;
+    /// Return tile focus position in world space. Return false if none available.
+    bool GetFocusPosition(Vector3& position) const;
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle heightmap background load finishing.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+
+    /// Resident and loading tiles.
+    HashMap<IntVector2, TerrainTile> tiles_;
+    /// Resource name hashes of tiles being loaded.
+    HashMap<StringHash, IntVector2> loadingTiles_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Focus scene node.
+    WeakPtr<Node> focusNode_;
+    /// Heightmap tile resource name prefix.
+    String heightMapPrefix_;
+    /// Number of tiles in X and Z directions.
+    IntVector2 numTiles_;
+    /// Tile quads per side.
+    int tileSize_;
+    /// Vertex and height spacing.
+    Vector3 spacing_;
+    /// Patch quads per side.
+    int patchSize_;
+    /// Maximum number of LOD levels.
+    unsigned maxLodLevels_;
+    /// Heightmap smoothing flag.
+    bool smoothing_;
+    /// Tile load distance.
+    float loadDistance_;
+    /// Tile eviction distance.
+    float unloadDistance_;
+    /// Maximum number of tiles turned into terrain per frame.
+    unsigned maxTileBuildsPerFrame_;
+    /// Draw distance.
+    float drawDistance_;
+    /// Shadowcaster flag.
+    bool castShadows_;
+    /// Occluder flag.
+    bool occluder_;
+};
+
+}
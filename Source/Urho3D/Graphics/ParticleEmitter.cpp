@@ -32,6 +32,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -167,91 +171,107 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         }
     }
 
-    // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
+    // Update existing particles. Gather the per-frame constants of the effect first so that the loop only touches particle data
+    const Vector3& constantForce = effect_->GetConstantForce();
+    Vector3 forceStep = lastTimeStep_ * (relative_ ? node_->GetWorldRotation().Inverse() * constantForce : constantForce);
+    float dampingScale = 1.0f - lastTimeStep_ * effect_->GetDampingForce();
     // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
+    Vector3 positionScale = Vector3(lastTimeStep_, lastTimeStep_, lastTimeStep_);
     if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
+        positionScale *= node_->GetWorldScale();
+    float sizeAdd = effect_->GetSizeAdd();
+    float sizeMul = effect_->GetSizeMul();
+    bool animateScale = sizeAdd != 0.0f || sizeMul != 1.0f;
+    float scaleAdd = lastTimeStep_ * sizeAdd;
+    float scaleMul = (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
+    const Vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    const Vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+    unsigned numColorFrames = colorFrames.Size();
+    unsigned numTextureFrames = textureFrames.Size();
+
+#ifdef URHO3D_SSE
+    __m128 forceStepVec = _mm_set_ps(0.f, forceStep.z_, forceStep.y_, forceStep.x_);
+    __m128 dampingScaleVec = _mm_set1_ps(dampingScale);
+    __m128 positionScaleVec = _mm_set_ps(0.f, positionScale.z_, positionScale.y_, positionScale.x_);
+#endif
 
     for (unsigned i = 0; i < particles_.Size(); ++i)
     {
         Particle& particle = particles_[i];
         Billboard& billboard = billboards_[i];
 
-        if (billboard.enabled_)
-        {
-            needCommit = true;
-
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
-
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
-
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            billboard.direction_ = particle.velocity_.Normalized();
+        if (!billboard.enabled_)
+            continue;
 
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+        needCommit = true;
 
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
+        // Time to live
+        if (particle.timer_ >= particle.timeToLive_)
+        {
+            billboard.enabled_ = false;
+            continue;
+        }
+        particle.timer_ += lastTimeStep_;
+
+        // Velocity & position. Constant force and damping reduce to one multiply-add per component
+#ifdef URHO3D_SSE
+        // The fourth lane loads the following struct member (size) and is never stored back
+        __m128 velocity = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&particle.velocity_.x_), forceStepVec), dampingScaleVec);
+        __m128 position = _mm_add_ps(_mm_loadu_ps(&billboard.position_.x_), _mm_mul_ps(velocity, positionScaleVec));
+        __m128 lengthSquared = _mm_mul_ps(velocity, velocity);
+        lengthSquared = _mm_add_ss(_mm_add_ss(lengthSquared, _mm_shuffle_ps(lengthSquared, lengthSquared, _MM_SHUFFLE(1, 1, 1, 1))),
+            _mm_movehl_ps(lengthSquared, lengthSquared));
+        __m128 direction = velocity;
+        if (_mm_cvtss_f32(lengthSquared) > 0.0f)
+            direction = _mm_div_ps(velocity, _mm_sqrt_ps(_mm_shuffle_ps(lengthSquared, lengthSquared, _MM_SHUFFLE(0, 0, 0, 0))));
+        _mm_storel_pi(reinterpret_cast<__m64*>(&particle.velocity_.x_), velocity);
+        _mm_store_ss(&particle.velocity_.z_, _mm_movehl_ps(velocity, velocity));
+        _mm_storel_pi(reinterpret_cast<__m64*>(&billboard.position_.x_), position);
+        _mm_store_ss(&billboard.position_.z_, _mm_movehl_ps(position, position));
+        _mm_storel_pi(reinterpret_cast<__m64*>(&billboard.direction_.x_), direction);
+        _mm_store_ss(&billboard.direction_.z_, _mm_movehl_ps(direction, direction));
+#else
+        particle.velocity_ = (particle.velocity_ + forceStep) * dampingScale;
+        billboard.position_ += particle.velocity_ * positionScale;
+        billboard.direction_ = particle.velocity_.Normalized();
+#endif
+
+        // Rotation
+        billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+
+        // Scaling
+        if (animateScale)
+        {
+            particle.scale_ += scaleAdd;
+            if (particle.scale_ < 0.0f)
+                particle.scale_ = 0.0f;
+            particle.scale_ *= scaleMul;
+            billboard.size_ = particle.size_ * particle.scale_;
+        }
 
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.Size())
+        // Color interpolation
+        unsigned& index = particle.colorIndex_;
+        if (index < numColorFrames)
+        {
+            if (index < numColorFrames - 1)
             {
-                if (index < colorFrames_.Size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.Size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
+                if (particle.timer_ >= colorFrames[index + 1].time_)
+                    ++index;
             }
+            if (index < numColorFrames - 1)
+                billboard.color_ = colorFrames[index].Interpolate(colorFrames[index + 1], particle.timer_);
+            else
+                billboard.color_ = colorFrames[index].color_;
+        }
 
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.Size() && texIndex < textureFrames_.Size() - 1)
+        // Texture animation
+        unsigned& texIndex = particle.texIndex_;
+        if (numTextureFrames && texIndex < numTextureFrames - 1)
+        {
+            if (particle.timer_ >= textureFrames[texIndex + 1].time_)
             {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
+                billboard.uv_ = textureFrames[texIndex + 1].uv_;
+                ++texIndex;
             }
         }
     }
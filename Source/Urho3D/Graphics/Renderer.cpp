@@ -1664,7 +1664,7 @@ void Renderer::LoadShaders()
     {
         deferredLightPSVariations_[i] = lightPSVariations[i % DLPS_ORTHO];
         if ((i % DLPS_ORTHO) >= DLPS_SHADOW)
-            deferredLightPSVariations_[i] += GetShadowVariations();
+            deferredLightPSVariations_[i] += GetShadowVariations(shadowQuality_);
         if (i >= DLPS_ORTHO)
             deferredLightPSVariations_[i] += "ORTHO ";
     }
@@ -1680,48 +1680,67 @@ void Renderer::LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >&
     vertexShaders.Clear();
     pixelShaders.Clear();
 
-    String vsDefines = pass->GetEffectiveVertexShaderDefines();
-    String psDefines = pass->GetEffectivePixelShaderDefines();
+    Vector<String> vsDefines;
+    Vector<String> psDefines;
+    GetPassShaderDefines(pass, queue.vsExtraDefines_, queue.psExtraDefines_, shadowQuality_, vsDefines, psDefines);
+
+    vertexShaders.Resize(vsDefines.Size());
+    for (unsigned j = 0; j < vsDefines.Size(); ++j)
+        vertexShaders[j] = graphics_->GetShader(VS, pass->GetVertexShader(), vsDefines[j]);
+    pixelShaders.Resize(psDefines.Size());
+    for (unsigned j = 0; j < psDefines.Size(); ++j)
+        pixelShaders[j] = graphics_->GetShader(PS, pass->GetPixelShader(), psDefines[j]);
+
+    pass->MarkShadersLoaded(shadersChangedFrameNumber_);
+}
+
+void Renderer::GetPassShaderDefines(Pass* pass, const String& vsExtraDefines, const String& psExtraDefines,
+    ShadowQuality shadowQuality, Vector<String>& vsDefines, Vector<String>& psDefines) const
+{
+    vsDefines.Clear();
+    psDefines.Clear();
+
+    String vsPassDefines = pass->GetEffectiveVertexShaderDefines();
+    String psPassDefines = pass->GetEffectivePixelShaderDefines();
 
     // Make sure to end defines with space to allow appending engine's defines
-    if (vsDefines.Length() && !vsDefines.EndsWith(" "))
-        vsDefines += ' ';
-    if (psDefines.Length() && !psDefines.EndsWith(" "))
-        psDefines += ' ';
+    if (vsPassDefines.Length() && !vsPassDefines.EndsWith(" "))
+        vsPassDefines += ' ';
+    if (psPassDefines.Length() && !psPassDefines.EndsWith(" "))
+        psPassDefines += ' ';
 
     // Append defines from batch queue (renderpath command) if needed
-    if (queue.vsExtraDefines_.Length())
+    if (vsExtraDefines.Length())
     {
-        vsDefines += queue.vsExtraDefines_;
-        vsDefines += ' ';
+        vsPassDefines += vsExtraDefines;
+        vsPassDefines += ' ';
     }
-    if (queue.psExtraDefines_.Length())
+    if (psExtraDefines.Length())
     {
-        psDefines += queue.psExtraDefines_;
-        psDefines += ' ';
+        psPassDefines += psExtraDefines;
+        psPassDefines += ' ';
     }
 
     // Add defines for VSM in the shadow pass if necessary
     if (pass->GetName() == "shadow"
-        && (shadowQuality_ == SHADOWQUALITY_VSM || shadowQuality_ == SHADOWQUALITY_BLUR_VSM))
+        && (shadowQuality == SHADOWQUALITY_VSM || shadowQuality == SHADOWQUALITY_BLUR_VSM))
     {
-        vsDefines += "VSM_SHADOW ";
-        psDefines += "VSM_SHADOW ";
+        vsPassDefines += "VSM_SHADOW ";
+        psPassDefines += "VSM_SHADOW ";
     }
 
     if (pass->GetLightingMode() == LIGHTING_PERPIXEL)
     {
-        // Load forward pixel lit variations
-        vertexShaders.Resize(MAX_GEOMETRYTYPES * MAX_LIGHT_VS_VARIATIONS);
-        pixelShaders.Resize(MAX_LIGHT_PS_VARIATIONS * 2);
+        // Forward pixel lit variations
+        vsDefines.Resize(MAX_GEOMETRYTYPES * MAX_LIGHT_VS_VARIATIONS);
+        psDefines.Resize(MAX_LIGHT_PS_VARIATIONS * 2);
 
         for (unsigned j = 0; j < MAX_GEOMETRYTYPES * MAX_LIGHT_VS_VARIATIONS; ++j)
         {
             unsigned g = j / MAX_LIGHT_VS_VARIATIONS;
             unsigned l = j % MAX_LIGHT_VS_VARIATIONS;
 
-            vertexShaders[j] = graphics_->GetShader(VS, pass->GetVertexShader(),
-                vsDefines + lightVSVariations[l] + geometryVSVariations[g]);
+            vsDefines[j] = vsPassDefines + lightVSVariations[l] + geometryVSVariations[g];
         }
         for (unsigned j = 0; j < MAX_LIGHT_PS_VARIATIONS * 2; ++j)
         {
@@ -1729,49 +1748,35 @@ void Renderer::LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >&
             unsigned h = j / MAX_LIGHT_PS_VARIATIONS;
 
             if (l & LPS_SHADOW)
-            {
-                pixelShaders[j] = graphics_->GetShader(PS, pass->GetPixelShader(),
-                    psDefines + lightPSVariations[l] + GetShadowVariations() +
-                    heightFogVariations[h]);
-            }
+                psDefines[j] = psPassDefines + lightPSVariations[l] + GetShadowVariations(shadowQuality) + heightFogVariations[h];
             else
-                pixelShaders[j] = graphics_->GetShader(PS, pass->GetPixelShader(),
-                    psDefines + lightPSVariations[l] + heightFogVariations[h]);
+                psDefines[j] = psPassDefines + lightPSVariations[l] + heightFogVariations[h];
         }
     }
     else
     {
-        // Load vertex light variations
+        // Vertex light variations
         if (pass->GetLightingMode() == LIGHTING_PERVERTEX)
         {
-            vertexShaders.Resize(MAX_GEOMETRYTYPES * MAX_VERTEXLIGHT_VS_VARIATIONS);
+            vsDefines.Resize(MAX_GEOMETRYTYPES * MAX_VERTEXLIGHT_VS_VARIATIONS);
             for (unsigned j = 0; j < MAX_GEOMETRYTYPES * MAX_VERTEXLIGHT_VS_VARIATIONS; ++j)
             {
                 unsigned g = j / MAX_VERTEXLIGHT_VS_VARIATIONS;
                 unsigned l = j % MAX_VERTEXLIGHT_VS_VARIATIONS;
-                vertexShaders[j] = graphics_->GetShader(VS, pass->GetVertexShader(),
-                    vsDefines + vertexLightVSVariations[l] + geometryVSVariations[g]);
+                vsDefines[j] = vsPassDefines + vertexLightVSVariations[l] + geometryVSVariations[g];
             }
         }
         else
         {
-            vertexShaders.Resize(MAX_GEOMETRYTYPES);
+            vsDefines.Resize(MAX_GEOMETRYTYPES);
             for (unsigned j = 0; j < MAX_GEOMETRYTYPES; ++j)
-            {
-                vertexShaders[j] = graphics_->GetShader(VS, pass->GetVertexShader(),
-                    vsDefines + geometryVSVariations[j]);
-            }
+                vsDefines[j] = vsPassDefines + geometryVSVariations[j];
         }
 
-        pixelShaders.Resize(2);
+        psDefines.Resize(2);
         for (unsigned j = 0; j < 2; ++j)
-        {
-            pixelShaders[j] =
-                graphics_->GetShader(PS, pass->GetPixelShader(), psDefines + heightFogVariations[j]);
-        }
+            psDefines[j] = psPassDefines + heightFogVariations[j];
     }
-
-    pass->MarkShadersLoaded(shadersChangedFrameNumber_);
 }
 
 void Renderer::ReleaseMaterialShaders()
@@ -1945,15 +1950,15 @@ void Renderer::ResetBuffers()
     screenBufferAllocations_.Clear();
 }
 
-String Renderer::GetShadowVariations() const
+String Renderer::GetShadowVariations(ShadowQuality quality) const
 {
-    switch (shadowQuality_)
+    switch (quality)
     {
         case SHADOWQUALITY_SIMPLE_16BIT:
         #ifdef URHO3D_OPENGL
             return "SIMPLE_SHADOW ";
         #else
-            if (graphics_->GetHardwareShadowSupport())
+            if (!graphics_ || graphics_->GetHardwareShadowSupport())
                 return "SIMPLE_SHADOW ";
             else
                 return "SIMPLE_SHADOW SHADOWCMP ";
@@ -1964,7 +1969,7 @@ String Renderer::GetShadowVariations() const
         #ifdef URHO3D_OPENGL
             return "PCF_SHADOW ";
         #else
-            if (graphics_->GetHardwareShadowSupport())
+            if (!graphics_ || graphics_->GetHardwareShadowSupport())
                 return "PCF_SHADOW ";
             else
                 return "PCF_SHADOW SHADOWCMP ";
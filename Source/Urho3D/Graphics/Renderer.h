@@ -414,6 +414,9 @@ public:
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders
         (Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines, const String& psDefines);
+    /// Return the defines of all vertex and pixel shader variations used for a material pass, with the extra defines of a render path command and the given shadow quality. Does not require the renderer to be initialized.
+    void GetPassShaderDefines(Pass* pass, const String& vsExtraDefines, const String& psExtraDefines, ShadowQuality shadowQuality,
+        Vector<String>& vsDefines, Vector<String>& psDefines) const;
     /// Set cull mode while taking possible projection flipping into account.
     void SetCullMode(CullMode mode, Camera* camera);
     /// Ensure sufficient size of the instancing vertex buffer. Return true if successful.
@@ -460,7 +463,7 @@ private:
     /// Remove all occlusion and screen buffers.
     void ResetBuffers();
     /// Find variations for shadow shaders
-    String GetShadowVariations() const;
+    String GetShadowVariations(ShadowQuality quality) const;
     /// Handle screen mode event.
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle render update event.
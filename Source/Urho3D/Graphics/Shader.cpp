@@ -87,8 +87,25 @@ bool Shader::BeginLoad(Deserializer& source)
     if (!graphics)
         return false;
 
+    return LoadSource(source);
+}
+
+bool Shader::EndLoad()
+{
+    // If variations had already been created, release them and require recompile
+    for (HashMap<StringHash, SharedPtr<ShaderVariation> >::Iterator i = vsVariations_.Begin(); i != vsVariations_.End(); ++i)
+        i->second_->Release();
+    for (HashMap<StringHash, SharedPtr<ShaderVariation> >::Iterator i = psVariations_.Begin(); i != psVariations_.End(); ++i)
+        i->second_->Release();
+
+    return true;
+}
+
+bool Shader::LoadSource(Deserializer& source)
+{
     // Load the shader source code and resolve any includes
     timeStamp_ = 0;
+    includeFiles_.Clear();
     String shaderCode;
     if (!ProcessSource(shaderCode, source))
         return false;
@@ -109,15 +126,20 @@ bool Shader::BeginLoad(Deserializer& source)
     return true;
 }
 
-bool Shader::EndLoad()
+void Shader::SetSourceCode(const String& vsSourceCode, const String& psSourceCode, const StringVector& includeFiles,
+    unsigned timeStamp)
 {
-    // If variations had already been created, release them and require recompile
-    for (HashMap<StringHash, SharedPtr<ShaderVariation> >::Iterator i = vsVariations_.Begin(); i != vsVariations_.End(); ++i)
-        i->second_->Release();
-    for (HashMap<StringHash, SharedPtr<ShaderVariation> >::Iterator i = psVariations_.Begin(); i != psVariations_.End(); ++i)
-        i->second_->Release();
+    vsSourceCode_ = vsSourceCode;
+    psSourceCode_ = psSourceCode;
+    includeFiles_ = includeFiles;
+    timeStamp_ = timeStamp;
 
-    return true;
+    // Store resource dependencies for includes so that the shader reloads from source if any of them changes
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    for (unsigned i = 0; i < includeFiles_.Size(); ++i)
+        cache->StoreResourceDependency(this, includeFiles_[i]);
+
+    RefreshMemoryUse();
 }
 
 ShaderVariation* Shader::GetVariation(ShaderType type, const String& defines)
@@ -157,6 +179,22 @@ ShaderVariation* Shader::GetVariation(ShaderType type, const char* defines)
     return i->second_;
 }
 
+void Shader::GetVariationDefines(ShaderType type, StringVector& dest) const
+{
+    dest.Clear();
+
+    // Skip the aliases stored for non-normalized defines
+    const HashMap<StringHash, SharedPtr<ShaderVariation> >& variations(type == VS ? vsVariations_ : psVariations_);
+    for (HashMap<StringHash, SharedPtr<ShaderVariation> >::ConstIterator i = variations.Begin(); i != variations.End(); ++i)
+    {
+        const String& defines = i->second_->GetDefines();
+        if (i->first_ == StringHash(defines))
+            dest.Push(defines);
+    }
+
+    Sort(dest.Begin(), dest.End());
+}
+
 bool Shader::ProcessSource(String& code, Deserializer& source)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -174,7 +212,10 @@ bool Shader::ProcessSource(String& code, Deserializer& source)
 
     // Store resource dependencies for includes so that we know to reload if any of them changes
     if (source.GetName() != GetName())
+    {
         cache->StoreResourceDependency(this, source.GetName());
+        includeFiles_.Push(source.GetName());
+    }
 
     while (!source.IsEof())
     {
@@ -48,6 +48,11 @@ public:
     /// Finish resource loading. Always called from the main thread. Return true if successful.
     virtual bool EndLoad() override;
 
+    /// Load and preprocess the source code without requiring the graphics subsystem. Used when building a shader cache offline. Return true if successful.
+    bool LoadSource(Deserializer& source);
+    /// Set already preprocessed vertex and pixel shader source code, the files it included and its timestamp, for example from a shader cache. The name should be set first to store the include dependencies.
+    void SetSourceCode(const String& vsSourceCode, const String& psSourceCode, const StringVector& includeFiles, unsigned timeStamp);
+
     /// Return a variation with defines. Separate multiple defines with spaces.
     ShaderVariation* GetVariation(ShaderType type, const String& defines);
     /// Return a variation with defines. Separate multiple defines with spaces.
@@ -59,6 +64,12 @@ public:
     /// Return the latest timestamp of the shader code and its includes.
     unsigned GetTimeStamp() const { return timeStamp_; }
 
+    /// Return the names of the included files.
+    const StringVector& GetIncludeFiles() const { return includeFiles_; }
+
+    /// Return the normalized defines of all variations of a type.
+    void GetVariationDefines(ShaderType type, StringVector& dest) const;
+
 private:
     /// Process source code and include files. Return true if successful.
     bool ProcessSource(String& code, Deserializer& file);
@@ -75,6 +86,8 @@ private:
     HashMap<StringHash, SharedPtr<ShaderVariation> > vsVariations_;
     /// Pixel shader variations.
     HashMap<StringHash, SharedPtr<ShaderVariation> > psVariations_;
+    /// Names of the included files.
+    StringVector includeFiles_;
     /// Source code timestamp.
     unsigned timeStamp_;
     /// Number of unique variations so far.
@@ -22,19 +22,35 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Context.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/Shader.h"
 #include "../Graphics/ShaderPrecache.h"
 #include "../Graphics/ShaderVariation.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Resource/ResourceCache.h"
 
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Packed shader cache file ID.
+static const char* SHADER_CACHE_ID = "USHC";
+/// Shading language of the cached source code. The preprocessed source differs between OpenGL and Direct3D.
+#ifdef URHO3D_OPENGL
+static const char* SHADER_CACHE_LANGUAGE = "GLSL";
+#else
+static const char* SHADER_CACHE_LANGUAGE = "HLSL";
+#endif
+/// Size of a shader cache index entry: name hash, data offset and data size.
+static const unsigned SHADER_CACHE_INDEX_ENTRY_SIZE = 3 * sizeof(unsigned);
+
 ShaderPrecache::ShaderPrecache(Context* context, const String& fileName) :
     Object(context),
     fileName_(fileName),
@@ -106,6 +122,16 @@ void ShaderPrecache::StoreShaders(ShaderVariation* vs, ShaderVariation* ps)
 
 void ShaderPrecache::LoadShaders(Graphics* graphics, Deserializer& source)
 {
+    // Check for a packed shader cache instead of an XML shader list
+    unsigned startPosition = source.GetPosition();
+    if (source.ReadFileID() == SHADER_CACHE_ID)
+    {
+        source.Seek(startPosition);
+        LoadCache(graphics->GetContext(), source);
+        return;
+    }
+    source.Seek(startPosition);
+
     URHO3D_LOGDEBUG("Begin precaching shaders");
 
     XMLFile xmlFile(graphics->GetContext());
@@ -141,4 +167,148 @@ void ShaderPrecache::LoadShaders(Graphics* graphics, Deserializer& source)
     URHO3D_LOGDEBUG("End precaching shaders");
 }
 
+bool ShaderPrecache::SaveCache(Serializer& dest, const Vector<SharedPtr<Shader> >& shaders)
+{
+    // Write the shader data first to know the offsets for the index
+    VectorBuffer data;
+    PODVector<unsigned> offsets;
+    StringVector vsDefines;
+    StringVector psDefines;
+
+    for (unsigned i = 0; i < shaders.Size(); ++i)
+    {
+        Shader* shader = shaders[i];
+        shader->GetVariationDefines(VS, vsDefines);
+        shader->GetVariationDefines(PS, psDefines);
+
+        offsets.Push(data.GetSize());
+        data.WriteString(shader->GetName());
+        data.WriteUInt(shader->GetTimeStamp());
+        data.WriteStringVector(shader->GetIncludeFiles());
+        data.WriteString(shader->GetSourceCode(VS));
+        data.WriteString(shader->GetSourceCode(PS));
+        data.WriteStringVector(vsDefines);
+        data.WriteStringVector(psDefines);
+    }
+    offsets.Push(data.GetSize());
+
+    bool success = true;
+    success &= dest.WriteFileID(SHADER_CACHE_ID);
+    success &= dest.WriteString(SHADER_CACHE_LANGUAGE);
+    success &= dest.WriteUInt(shaders.Size());
+    for (unsigned i = 0; i < shaders.Size(); ++i)
+    {
+        success &= dest.WriteUInt(StringHash(shaders[i]->GetName()).Value());
+        success &= dest.WriteUInt(offsets[i]);
+        success &= dest.WriteUInt(offsets[i + 1] - offsets[i]);
+    }
+    if (data.GetSize())
+        success &= dest.Write(data.GetData(), data.GetSize()) == data.GetSize();
+
+    return success;
+}
+
+bool ShaderPrecache::LoadCache(Context* context, Deserializer& source)
+{
+    if (source.ReadFileID() != SHADER_CACHE_ID)
+    {
+        URHO3D_LOGERROR(source.GetName() + " is not a valid shader cache file");
+        return false;
+    }
+    if (source.ReadString() != SHADER_CACHE_LANGUAGE)
+    {
+        URHO3D_LOGERROR("Shader cache " + source.GetName() + " was not built for " + String(SHADER_CACHE_LANGUAGE));
+        return false;
+    }
+
+    // Read the index and the shader data at once
+    unsigned dataSize = source.GetSize() - source.GetPosition();
+    SharedArrayPtr<unsigned char> data(new unsigned char[dataSize]);
+    if (source.Read(data.Get(), dataSize) != dataSize)
+    {
+        URHO3D_LOGERROR("Failed to read shader cache " + source.GetName());
+        return false;
+    }
+
+    MemoryBuffer index(data.Get(), dataSize);
+    unsigned numShaders = index.ReadUInt();
+    unsigned dataStart = sizeof(unsigned) + numShaders * SHADER_CACHE_INDEX_ENTRY_SIZE;
+    if (dataStart > dataSize)
+    {
+        URHO3D_LOGERROR("Shader cache " + source.GetName() + " is truncated");
+        return false;
+    }
+
+    ResourceCache* cache = context->GetSubsystem<ResourceCache>();
+    FileSystem* fileSystem = context->GetSubsystem<FileSystem>();
+    const HashMap<StringHash, ResourceGroup>& resourceGroups = cache->GetAllResources();
+    HashMap<StringHash, ResourceGroup>::ConstIterator shaderGroup = resourceGroups.Find(Shader::GetTypeStatic());
+    StringVector includeFiles;
+    StringVector vsDefines;
+    StringVector psDefines;
+    unsigned numLoaded = 0;
+    unsigned numVariations = 0;
+
+    URHO3D_LOGDEBUG("Begin loading shader cache " + source.GetName());
+
+    for (unsigned i = 0; i < numShaders; ++i)
+    {
+        StringHash nameHash(index.ReadUInt());
+        unsigned offset = index.ReadUInt();
+        unsigned size = index.ReadUInt();
+        if (offset + size > dataSize - dataStart)
+        {
+            URHO3D_LOGERROR("Shader cache " + source.GetName() + " is truncated");
+            return false;
+        }
+
+        // Shaders already loaded, for example from source files, take precedence
+        if (shaderGroup != resourceGroups.End() && shaderGroup->second_.resources_.Contains(nameHash))
+            continue;
+
+        MemoryBuffer entry(data.Get() + dataStart + offset, size);
+        String name = entry.ReadString();
+        unsigned timeStamp = entry.ReadUInt();
+        includeFiles = entry.ReadStringVector();
+
+        // Skip entries whose source file or any of its includes has been modified after the cache was built, so that the
+        // shader is loaded from source instead. Files that only exist in packages have no modification time to check
+        bool stale = false;
+        if (fileSystem)
+        {
+            for (unsigned j = 0; j <= includeFiles.Size() && !stale; ++j)
+            {
+                String fullName = cache->GetResourceFileName(j < includeFiles.Size() ? includeFiles[j] : name);
+                stale = !fullName.Empty() && fileSystem->GetLastModifiedTime(fullName) > timeStamp;
+            }
+        }
+        if (stale)
+        {
+            URHO3D_LOGWARNING("Shader " + name + " in shader cache " + source.GetName() + " is older than its source, skipping");
+            continue;
+        }
+
+        String vsSourceCode = entry.ReadString();
+        String psSourceCode = entry.ReadString();
+        vsDefines = entry.ReadStringVector();
+        psDefines = entry.ReadStringVector();
+
+        SharedPtr<Shader> shader(new Shader(context));
+        shader->SetName(name);
+        shader->SetSourceCode(vsSourceCode, psSourceCode, includeFiles, timeStamp);
+        if (!cache->AddManualResource(shader))
+            continue;
+
+        for (unsigned j = 0; j < vsDefines.Size(); ++j)
+            shader->GetVariation(VS, vsDefines[j]);
+        for (unsigned j = 0; j < psDefines.Size(); ++j)
+            shader->GetVariation(PS, psDefines[j]);
+        ++numLoaded;
+        numVariations += vsDefines.Size() + psDefines.Size();
+    }
+
+    URHO3D_LOGDEBUG("Loaded " + String(numLoaded) + " shaders with " + String(numVariations) + " variations from shader cache");
+    return true;
+}
+
 }
@@ -30,9 +30,10 @@ namespace Urho3D
 {
 
 class Graphics;
+class Shader;
 class ShaderVariation;
 
-/// Utility class for collecting used shader combinations during runtime for precaching.
+/// Utility class for collecting used shader combinations during runtime for precaching. Also reads and writes the packed shader cache of preprocessed shader source code and variations.
 class URHO3D_API ShaderPrecache : public Object
 {
     URHO3D_OBJECT(ShaderPrecache, Object);
@@ -46,8 +47,12 @@ public:
     /// Collect a shader combination. Called by Graphics when shaders have been set.
     void StoreShaders(ShaderVariation* vs, ShaderVariation* ps);
 
-    /// Load shaders from an XML file.
+    /// Load shaders from an XML file or a packed shader cache.
     static void LoadShaders(Graphics* graphics, Deserializer& source);
+    /// Write a packed shader cache of the shaders' preprocessed source code and their current variations. Return true if successful.
+    static bool SaveCache(Serializer& dest, const Vector<SharedPtr<Shader> >& shaders);
+    /// Load a packed shader cache with a single read and add its shaders as manual resources with their variations. Shaders already in the resource cache are skipped. Does not require the graphics subsystem. Return true if successful.
+    static bool LoadCache(Context* context, Deserializer& source);
 
 private:
     /// XML file name.
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
@@ -33,6 +34,10 @@
 #include "../Graphics/VertexBuffer.h"
 #include "../Scene/Scene.h"
 
+#ifdef URHO3D_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -40,6 +45,44 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Maximum number of instances in a leaf cluster.
+static const unsigned MAX_CLUSTER_INSTANCES = 64;
+/// Padding at the end of the instance bounding sphere arrays, so that four instances can always be read at a time.
+static const unsigned SPHERE_ARRAY_PADDING = 3;
+
+/// Build the cluster hierarchy of a range of instances by splitting it recursively at the median of its longest axis.
+static void BuildClusterHierarchy(PODVector<InstanceCluster>& clusters, PODVector<unsigned>& instances, unsigned start, unsigned end,
+    const PODVector<Vector3>& positions, PODVector<Pair<unsigned, unsigned> >& keys, PODVector<Pair<unsigned, unsigned> >& temp)
+{
+    unsigned index = clusters.Size();
+    clusters.Resize(index + 1);
+    clusters[index].start_ = start;
+    clusters[index].end_ = end;
+    clusters[index].dirty_ = true;
+
+    if (end - start > MAX_CLUSTER_INSTANCES)
+    {
+        BoundingBox bounds;
+        for (unsigned i = start; i < end; ++i)
+            bounds.Merge(positions[instances[i]]);
+
+        Vector3 size = bounds.Size();
+        unsigned axis = (size.x_ >= size.y_ && size.x_ >= size.z_) ? 0 : (size.y_ >= size.z_ ? 1 : 2);
+
+        for (unsigned i = start; i < end; ++i)
+            keys[i - start] = MakePair(FloatToSortKey(positions[instances[i]].Data()[axis]), instances[i]);
+        RadixSort(keys.Begin(), keys.Begin() + (end - start), temp.Begin());
+        for (unsigned i = start; i < end; ++i)
+            instances[i] = keys[i - start].second_;
+
+        unsigned middle = start + (end - start) / 2;
+        BuildClusterHierarchy(clusters, instances, start, middle, positions, keys, temp);
+        BuildClusterHierarchy(clusters, instances, middle, end, positions, keys, temp);
+    }
+
+    clusters[index].next_ = clusters.Size();
+}
+
 static const StringVector instanceNodesStructureElementNames =
 {
     "Instance Count",
@@ -48,6 +91,9 @@ static const StringVector instanceNodesStructureElementNames =
 
 StaticModelGroup::StaticModelGroup(Context* context) :
     StaticModel(context),
+    numWorldTransforms_(0),
+    clustersDirty_(false),
+    transformsDirty_(false),
     nodesDirty_(false),
     nodeIDsDirty_(false)
 {
@@ -100,8 +146,7 @@ void StaticModelGroup::ApplyAttributes()
         }
     }
 
-    worldTransforms_.Resize(instanceNodes_.Size());
-    numWorldTransforms_ = 0; // Correct amount will be found during world bounding box update
+    clustersDirty_ = true; // Clusters will be rebuilt during world bounding box update
     nodesDirty_ = false;
 
     OnMarkedDirty(GetNode());
@@ -122,51 +167,70 @@ void StaticModelGroup::ProcessRayQuery(const RayOctreeQuery& query, PODVector<Ra
     if (query.ray_.HitDistance(GetWorldBoundingBox()) >= query.maxDistance_)
         return;
 
-    for (unsigned i = 0; i < numWorldTransforms_; ++i)
+    for (unsigned c = 0; c < clusters_.Size();)
     {
-        // Initial test using AABB
-        float distance = query.ray_.HitDistance(boundingBox_.Transformed(worldTransforms_[i]));
-        Vector3 normal = -query.ray_.direction_;
+        // Skip clusters the ray does not hit, and descend into the children of non-leaf clusters
+        const InstanceCluster& cluster = clusters_[c];
+        if (query.ray_.HitDistance(cluster.worldBoundingBox_) >= query.maxDistance_)
+        {
+            c = cluster.next_;
+            continue;
+        }
+        if (cluster.next_ != c + 1)
+        {
+            ++c;
+            continue;
+        }
 
-        // Then proceed to OBB and triangle-level tests if necessary
-        if (level >= RAY_OBB && distance < query.maxDistance_)
+        for (unsigned i = cluster.start_; i < cluster.end_; ++i)
         {
-            Matrix3x4 inverse = worldTransforms_[i].Inverse();
-            Ray localRay = query.ray_.Transformed(inverse);
-            distance = localRay.HitDistance(boundingBox_);
+            // Initial test using AABB
+            float distance = query.ray_.HitDistance(boundingBox_.Transformed(worldTransforms_[i]));
+            Vector3 normal = -query.ray_.direction_;
 
-            if (level == RAY_TRIANGLE && distance < query.maxDistance_)
+            // Then proceed to OBB and triangle-level tests if necessary
+            if (level >= RAY_OBB && distance < query.maxDistance_)
             {
-                distance = M_INFINITY;
+                Matrix3x4 inverse = worldTransforms_[i].Inverse();
+                Ray localRay = query.ray_.Transformed(inverse);
+                distance = localRay.HitDistance(boundingBox_);
 
-                for (unsigned j = 0; j < batches_.Size(); ++j)
+                if (level == RAY_TRIANGLE && distance < query.maxDistance_)
                 {
-                    Geometry* geometry = batches_[j].geometry_;
-                    if (geometry)
+                    distance = M_INFINITY;
+
+                    for (unsigned j = 0; j < batches_.Size(); ++j)
                     {
-                        Vector3 geometryNormal;
-                        float geometryDistance = geometry->GetHitDistance(localRay, &geometryNormal);
-                        if (geometryDistance < query.maxDistance_ && geometryDistance < distance)
+                        Geometry* geometry = batches_[j].geometry_;
+                        if (geometry)
                         {
-                            distance = geometryDistance;
-                            normal = (worldTransforms_[i] * Vector4(geometryNormal, 0.0f)).Normalized();
+                            Vector3 geometryNormal;
+                            float geometryDistance = geometry->GetHitDistance(localRay, &geometryNormal);
+                            if (geometryDistance < query.maxDistance_ && geometryDistance < distance)
+                            {
+                                distance = geometryDistance;
+                                normal = (worldTransforms_[i] * Vector4(geometryNormal, 0.0f)).Normalized();
+                            }
                         }
                     }
                 }
             }
-        }
 
-        if (distance < query.maxDistance_)
-        {
-            RayQueryResult result;
-            result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
-            result.normal_ = normal;
-            result.distance_ = distance;
-            result.drawable_ = this;
-            result.node_ = node_;
-            result.subObject_ = i;
-            results.Push(result);
+            if (distance < query.maxDistance_)
+            {
+                RayQueryResult result;
+                result.position_ = query.ray_.origin_ + distance * query.ray_.direction_;
+                result.normal_ = normal;
+                result.distance_ = distance;
+                result.drawable_ = this;
+                result.node_ = node_;
+                // Report the instance node index, as the world transforms are in cluster order
+                result.subObject_ = transformInstances_[i];
+                results.Push(result);
+            }
         }
+
+        c = cluster.next_;
     }
 }
 
@@ -177,20 +241,31 @@ void StaticModelGroup::UpdateBatches(const FrameInfo& frame)
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
     distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
 
+    // Draw only the instances visible to the camera. The batches are also used for shadow maps, so shadow casters outside the
+    // view are kept within a shadow distance of the camera
+    const Matrix3x4* instanceTransforms = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
+    unsigned numInstanceTransforms = numWorldTransforms_;
+    if (numWorldTransforms_)
+    {
+        const CulledInstances& culled = CullInstances(frame);
+        numInstanceTransforms = culled.worldTransforms_.Size();
+        instanceTransforms = numInstanceTransforms ? &culled.worldTransforms_[0] : &Matrix3x4::IDENTITY;
+    }
+
     if (batches_.Size() > 1)
     {
         for (unsigned i = 0; i < batches_.Size(); ++i)
         {
             batches_[i].distance_ = frame.camera_->GetDistance(worldTransform * geometryData_[i].center_);
-            batches_[i].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
-            batches_[i].numWorldTransforms_ = numWorldTransforms_;
+            batches_[i].worldTransform_ = instanceTransforms;
+            batches_[i].numWorldTransforms_ = numInstanceTransforms;
         }
     }
     else if (batches_.Size() == 1)
     {
         batches_[0].distance_ = distance_;
-        batches_[0].worldTransform_ = numWorldTransforms_ ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
-        batches_[0].numWorldTransforms_ = numWorldTransforms_;
+        batches_[0].worldTransform_ = instanceTransforms;
+        batches_[0].numWorldTransforms_ = numInstanceTransforms;
     }
 
     float scale = worldBoundingBox.Size().DotProduct(DOT_SCALE);
@@ -364,40 +439,83 @@ const VariantVector& StaticModelGroup::GetNodeIDsAttr() const
     return nodeIDsAttr_;
 }
 
+void StaticModelGroup::OnMarkedDirty(Node* node)
+{
+    {
+        // Instance nodes may also be moved from worker threads, for example when they are bones of an animated model
+        MutexLock lock(instanceMutex_);
+
+        // The own node does not move the instances, but its dirtying may also mean the model's bounding box changed
+        if (node == node_)
+            transformsDirty_ = true;
+        else if (!clustersDirty_ && !transformsDirty_)
+        {
+            HashMap<Node*, unsigned>::ConstIterator i = nodeTransforms_.Find(node);
+            if (i != nodeTransforms_.End())
+            {
+                dirtyTransforms_.Push(i->second_);
+                // When most of the instances move, refresh all of them instead
+                if (dirtyTransforms_.Size() > numWorldTransforms_ / 2)
+                {
+                    transformsDirty_ = true;
+                    dirtyTransforms_.Clear();
+                }
+            }
+        }
+    }
+
+    Drawable::OnMarkedDirty(node);
+}
+
 void StaticModelGroup::OnNodeSetEnabled(Node* node)
 {
+    if (node != node_)
+    {
+        MutexLock lock(instanceMutex_);
+        clustersDirty_ = true;
+    }
+
     Drawable::OnMarkedDirty(node);
 }
 
 void StaticModelGroup::OnWorldBoundingBoxUpdate()
 {
-    // Update transforms and bounding box at the same time to have to go through the objects only once
-    unsigned index = 0;
-
-    BoundingBox worldBox;
+    // This function may be called from multiple worker threads simultaneously. The first one to get the mutex updates the
+    // instances, after which the others find nothing left to update
+    MutexLock lock(instanceMutex_);
 
-    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+    // Refresh only the moved instances, unless all have to be. Rebuild the clusters if an instance node has been destroyed
+    if (!clustersDirty_)
     {
-        Node* node = instanceNodes_[i];
-        if (!node || !node->IsEnabled())
-            continue;
-
-        const Matrix3x4& worldTransform = node->GetWorldTransform();
-        worldTransforms_[index++] = worldTransform;
-        worldBox.Merge(boundingBox_.Transformed(worldTransform));
+        if (transformsDirty_)
+        {
+            for (unsigned i = 0; i < numWorldTransforms_ && !clustersDirty_; ++i)
+                clustersDirty_ = !UpdateInstanceTransform(i);
+        }
+        else
+        {
+            for (unsigned i = 0; i < dirtyTransforms_.Size() && !clustersDirty_; ++i)
+                clustersDirty_ = !UpdateInstanceTransform(dirtyTransforms_[i]);
+        }
     }
 
-    worldBoundingBox_ = worldBox;
+    if (clustersDirty_)
+        UpdateClusters();
+    else
+        RefitClusters();
+
+    transformsDirty_ = false;
+    dirtyTransforms_.Clear();
 
-    // Store the amount of valid instances we found instead of resizing worldTransforms_. This is because this function may be
-    // called from multiple worker threads simultaneously
-    numWorldTransforms_ = index;
+    worldBoundingBox_ = clusters_.Size() ? clusters_[0].worldBoundingBox_ : BoundingBox();
+
+    for (List<CulledInstances>::Iterator i = culledInstances_.Begin(); i != culledInstances_.End(); ++i)
+        i->dirty_ = true;
 }
 
 void StaticModelGroup::UpdateNumTransforms()
 {
-    worldTransforms_.Resize(instanceNodes_.Size());
-    numWorldTransforms_ = 0; // Correct amount will be during world bounding box update
+    clustersDirty_ = true; // Clusters will be rebuilt during world bounding box update
     nodeIDsDirty_ = true;
 
     OnMarkedDirty(GetNode());
@@ -420,4 +538,263 @@ void StaticModelGroup::UpdateNodeIDs() const
     nodeIDsDirty_ = false;
 }
 
+void StaticModelGroup::UpdateClusters()
+{
+    transformInstances_.Clear();
+    PODVector<Vector3> positions(instanceNodes_.Size());
+
+    for (unsigned i = 0; i < instanceNodes_.Size(); ++i)
+    {
+        Node* node = instanceNodes_[i];
+        if (!node || !node->IsEnabled())
+            continue;
+
+        transformInstances_.Push(i);
+        positions[i] = node->GetWorldPosition();
+    }
+
+    numWorldTransforms_ = transformInstances_.Size();
+    worldTransforms_.Resize(numWorldTransforms_);
+    transformClusters_.Resize(numWorldTransforms_);
+    sphereX_.Resize(numWorldTransforms_ + SPHERE_ARRAY_PADDING);
+    sphereY_.Resize(numWorldTransforms_ + SPHERE_ARRAY_PADDING);
+    sphereZ_.Resize(numWorldTransforms_ + SPHERE_ARRAY_PADDING);
+    sphereRadius_.Resize(numWorldTransforms_ + SPHERE_ARRAY_PADDING);
+    for (unsigned i = numWorldTransforms_; i < sphereRadius_.Size(); ++i)
+    {
+        sphereX_[i] = 0.0f;
+        sphereY_[i] = 0.0f;
+        sphereZ_[i] = 0.0f;
+        sphereRadius_[i] = 0.0f;
+    }
+
+    // Reorder the instances so that each cluster covers a contiguous range of them
+    clusters_.Clear();
+    if (numWorldTransforms_)
+    {
+        PODVector<Pair<unsigned, unsigned> > keys(numWorldTransforms_);
+        PODVector<Pair<unsigned, unsigned> > temp(numWorldTransforms_);
+        BuildClusterHierarchy(clusters_, transformInstances_, 0, numWorldTransforms_, positions, keys, temp);
+    }
+
+    for (unsigned i = 0; i < clusters_.Size(); ++i)
+    {
+        const InstanceCluster& cluster = clusters_[i];
+        if (cluster.next_ == i + 1)
+        {
+            for (unsigned j = cluster.start_; j < cluster.end_; ++j)
+                transformClusters_[j] = i;
+        }
+    }
+
+    nodeTransforms_.Clear();
+    for (unsigned i = 0; i < numWorldTransforms_; ++i)
+    {
+        nodeTransforms_[instanceNodes_[transformInstances_[i]].Get()] = i;
+        UpdateInstanceTransform(i);
+    }
+
+    RefitClusters();
+    clustersDirty_ = false;
+}
+
+bool StaticModelGroup::UpdateInstanceTransform(unsigned index)
+{
+    Node* node = instanceNodes_[transformInstances_[index]];
+    if (!node || !node->IsEnabled())
+        return false;
+
+    const Matrix3x4& worldTransform = node->GetWorldTransform();
+    worldTransforms_[index] = worldTransform;
+
+    // Bound the instance for culling by the sphere around the model's bounding box, scaled by the largest axis scale
+    Vector3 center = worldTransform * boundingBox_.Center();
+    Vector3 scale = worldTransform.Scale();
+    sphereX_[index] = center.x_;
+    sphereY_[index] = center.y_;
+    sphereZ_[index] = center.z_;
+    sphereRadius_[index] = boundingBox_.HalfSize().Length() * Max(Max(scale.x_, scale.y_), scale.z_);
+
+    clusters_[transformClusters_[index]].dirty_ = true;
+    return true;
+}
+
+void StaticModelGroup::RefitClusters()
+{
+    // Children follow their parent, so going backwards refits the children first
+    for (unsigned i = clusters_.Size() - 1; i < clusters_.Size(); --i)
+    {
+        InstanceCluster& cluster = clusters_[i];
+        if (cluster.next_ == i + 1)
+        {
+            if (cluster.dirty_)
+            {
+                BoundingBox box;
+                for (unsigned j = cluster.start_; j < cluster.end_; ++j)
+                    box.Merge(boundingBox_.Transformed(worldTransforms_[j]));
+                cluster.worldBoundingBox_ = box;
+            }
+        }
+        else
+        {
+            InstanceCluster& first = clusters_[i + 1];
+            InstanceCluster& second = clusters_[first.next_];
+            if (first.dirty_ || second.dirty_)
+            {
+                cluster.worldBoundingBox_ = first.worldBoundingBox_;
+                cluster.worldBoundingBox_.Merge(second.worldBoundingBox_);
+                cluster.dirty_ = true;
+                first.dirty_ = false;
+                second.dirty_ = false;
+            }
+        }
+    }
+
+    if (clusters_.Size())
+        clusters_[0].dirty_ = false;
+}
+
+const CulledInstances& StaticModelGroup::CullInstances(const FrameInfo& frame)
+{
+    MutexLock lock(instanceMutex_);
+
+    // Reuse the camera's result from this frame if no instances have moved since. Otherwise cull into a result no view has
+    // used on this frame, as the batches of earlier views still point to the others
+    CulledInstances* culled = nullptr;
+    for (List<CulledInstances>::Iterator i = culledInstances_.Begin(); i != culledInstances_.End(); ++i)
+    {
+        if (i->frameNumber_ == frame.frameNumber_)
+        {
+            if (!i->dirty_ && i->camera_ == frame.camera_ && i->viewSize_ == frame.viewSize_)
+                return *i;
+        }
+        else if (!culled)
+            culled = &(*i);
+    }
+
+    if (!culled)
+    {
+        culledInstances_.Push(CulledInstances());
+        culled = &culledInstances_.Back();
+    }
+    culled->camera_ = frame.camera_;
+    culled->viewSize_ = frame.viewSize_;
+    culled->frameNumber_ = frame.frameNumber_;
+    culled->dirty_ = false;
+
+    const Frustum& frustum = frame.camera_->GetFrustum();
+    Vector3 cameraPos = frame.camera_->GetEffectiveWorldTransform().Translation();
+    // Without a shadow distance, fall back to the draw distance, or the far clip distance that bounds the shadowed part of the view
+    float shadowDistance = 0.0f;
+    if (castShadows_)
+    {
+        shadowDistance = shadowDistance_;
+        if (shadowDistance <= 0.0f)
+            shadowDistance = drawDistance_ > 0.0f ? drawDistance_ : frame.camera_->GetFarClip();
+    }
+
+    PODVector<Matrix3x4>& dest = culled->worldTransforms_;
+    dest.Resize(numWorldTransforms_);
+    unsigned numVisible = 0;
+
+    for (unsigned i = 0; i < clusters_.Size();)
+    {
+        const InstanceCluster& cluster = clusters_[i];
+        Intersection result = frustum.IsInside(cluster.worldBoundingBox_);
+        if (result == OUTSIDE && shadowDistance > 0.0f && cluster.worldBoundingBox_.DistanceToPoint(cameraPos) <= shadowDistance)
+            result = INTERSECTS;
+
+        if (result == OUTSIDE)
+            i = cluster.next_;
+        else if (result == INSIDE)
+        {
+            for (unsigned j = cluster.start_; j < cluster.end_; ++j)
+                dest[numVisible++] = worldTransforms_[j];
+            i = cluster.next_;
+        }
+        else if (cluster.next_ == i + 1)
+        {
+            CullClusterInstances(cluster, frustum, cameraPos, shadowDistance, dest, numVisible);
+            i = cluster.next_;
+        }
+        else
+            ++i;
+    }
+
+    dest.Resize(numVisible);
+    return *culled;
+}
+
+void StaticModelGroup::CullClusterInstances(const InstanceCluster& cluster, const Frustum& frustum, const Vector3& cameraPos,
+    float shadowDistance, PODVector<Matrix3x4>& dest, unsigned& numVisible) const
+{
+#ifdef URHO3D_SSE
+    __m128 planeX[NUM_FRUSTUM_PLANES];
+    __m128 planeY[NUM_FRUSTUM_PLANES];
+    __m128 planeZ[NUM_FRUSTUM_PLANES];
+    __m128 planeD[NUM_FRUSTUM_PLANES];
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum.planes_[i];
+        planeX[i] = _mm_set1_ps(plane.normal_.x_);
+        planeY[i] = _mm_set1_ps(plane.normal_.y_);
+        planeZ[i] = _mm_set1_ps(plane.normal_.z_);
+        planeD[i] = _mm_set1_ps(plane.d_);
+    }
+
+    __m128 cameraX = _mm_set1_ps(cameraPos.x_);
+    __m128 cameraY = _mm_set1_ps(cameraPos.y_);
+    __m128 cameraZ = _mm_set1_ps(cameraPos.z_);
+    __m128 shadowRange = _mm_set1_ps(shadowDistance);
+
+    // Test four instance bounding spheres at a time
+    for (unsigned i = cluster.start_; i < cluster.end_; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&sphereX_[i]);
+        __m128 y = _mm_loadu_ps(&sphereY_[i]);
+        __m128 z = _mm_loadu_ps(&sphereZ_[i]);
+        __m128 radius = _mm_loadu_ps(&sphereRadius_[i]);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 outside = _mm_setzero_ps();
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[j], x), _mm_mul_ps(planeY[j], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[j], z), planeD[j]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+        }
+        unsigned visibleMask = ~(unsigned)_mm_movemask_ps(outside) & 0xf;
+
+        if (shadowDistance > 0.0f)
+        {
+            __m128 dx = _mm_sub_ps(x, cameraX);
+            __m128 dy = _mm_sub_ps(y, cameraY);
+            __m128 dz = _mm_sub_ps(z, cameraZ);
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 maxDistance = _mm_add_ps(shadowRange, radius);
+            visibleMask |= (unsigned)_mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_mul_ps(maxDistance, maxDistance)));
+        }
+
+        // Mask out the instances past the end of the cluster
+        unsigned count = cluster.end_ - i;
+        if (count < 4)
+            visibleMask &= (1u << count) - 1;
+
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            if (visibleMask & (1u << j))
+                dest[numVisible++] = worldTransforms_[i + j];
+        }
+    }
+#else
+    for (unsigned i = cluster.start_; i < cluster.end_; ++i)
+    {
+        Sphere sphere(Vector3(sphereX_[i], sphereY_[i], sphereZ_[i]), sphereRadius_[i]);
+        if (frustum.IsInsideFast(sphere) != OUTSIDE ||
+            (shadowDistance > 0.0f && (sphere.center_ - cameraPos).Length() <= shadowDistance + sphere.radius_))
+            dest[numVisible++] = worldTransforms_[i];
+    }
+#endif
+}
+
 }
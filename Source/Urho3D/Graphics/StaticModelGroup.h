@@ -22,11 +22,45 @@
 
 #pragma once
 
+#include "../Container/List.h"
+#include "../Core/Mutex.h"
 #include "../Graphics/StaticModel.h"
 
 namespace Urho3D
 {
 
+class Frustum;
+
+/// %StaticModelGroup instance cluster hierarchy node. The instances of a node are a contiguous range of the world transforms.
+struct InstanceCluster
+{
+    /// World-space bounding box of the instances.
+    BoundingBox worldBoundingBox_;
+    /// Index of the first instance world transform.
+    unsigned start_;
+    /// Index after the last instance world transform.
+    unsigned end_;
+    /// Index of the node after this node's subtree. The children of a non-leaf node follow it in depth-first order.
+    unsigned next_;
+    /// Whether the bounding box needs to be recalculated.
+    bool dirty_;
+};
+
+/// %StaticModelGroup instances visible to a camera.
+struct CulledInstances
+{
+    /// Camera.
+    Camera* camera_;
+    /// View size the camera frustum was calculated for.
+    IntVector2 viewSize_;
+    /// Frame number last used on. Results used on the current frame are referenced by batches and must not be overwritten.
+    unsigned frameNumber_;
+    /// Whether instances have moved since culling.
+    bool dirty_;
+    /// World transforms of the visible instances.
+    PODVector<Matrix3x4> worldTransforms_;
+};
+
 /// Renders several object instances while culling and receiving light as one unit. Can be used as a CPU-side optimization, but note that also regular StaticModels will use instanced rendering if possible.
 class URHO3D_API StaticModelGroup : public StaticModel
 {
@@ -71,25 +105,64 @@ public:
     const VariantVector& GetNodeIDsAttr() const;
 
 protected:
+    /// Handle scene node transform dirtied.
+    virtual void OnMarkedDirty(Node* node) override;
     /// Handle scene node enabled status changing.
     virtual void OnNodeSetEnabled(Node* node) override;
     /// Recalculate the world-space bounding box.
     virtual void OnWorldBoundingBoxUpdate() override;
 
 private:
-    /// Ensure proper size of world transforms when nodes are added/removed. Also mark node IDs dirty.
+    /// Mark the instance clusters for rebuild when nodes are added/removed. Also mark node IDs dirty.
     void UpdateNumTransforms();
     /// Update node IDs attribute from the actual nodes.
     void UpdateNodeIDs() const;
+    /// Rebuild the world transforms and the cluster hierarchy from the valid instance nodes.
+    void UpdateClusters();
+    /// Refresh the world transform and bounding sphere of an instance and mark its cluster dirty. Return false if the instance node is no longer valid.
+    bool UpdateInstanceTransform(unsigned index);
+    /// Recalculate the bounding boxes of dirty clusters and their ancestors.
+    void RefitClusters();
+    /// Cull the instances against the frame's camera, reusing the result if already culled on this frame.
+    const CulledInstances& CullInstances(const FrameInfo& frame);
+    /// Append the visible instances of a leaf cluster to the culled world transforms.
+    void CullClusterInstances(const InstanceCluster& cluster, const Frustum& frustum, const Vector3& cameraPos, float shadowDistance,
+        PODVector<Matrix3x4>& dest, unsigned& numVisible) const;
 
     /// Instance nodes.
     Vector<WeakPtr<Node> > instanceNodes_;
-    /// World transforms of valid (existing and visible) instances.
+    /// World transforms of valid (existing and visible) instances, ordered by cluster.
     PODVector<Matrix3x4> worldTransforms_;
+    /// Instance node index of each world transform.
+    PODVector<unsigned> transformInstances_;
+    /// Leaf cluster index of each world transform.
+    PODVector<unsigned> transformClusters_;
+    /// World transform index of each valid instance node.
+    HashMap<Node*, unsigned> nodeTransforms_;
+    /// World-space bounding sphere center X coordinates of the instances. The sphere arrays are padded for SIMD culling.
+    PODVector<float> sphereX_;
+    /// World-space bounding sphere center Y coordinates of the instances.
+    PODVector<float> sphereY_;
+    /// World-space bounding sphere center Z coordinates of the instances.
+    PODVector<float> sphereZ_;
+    /// World-space bounding sphere radii of the instances.
+    PODVector<float> sphereRadius_;
+    /// Instance cluster hierarchy in depth-first order.
+    PODVector<InstanceCluster> clusters_;
+    /// World transform indices of moved instances.
+    PODVector<unsigned> dirtyTransforms_;
+    /// Visible instances per camera. A list so that the transforms stay in place for batches of earlier views.
+    List<CulledInstances> culledInstances_;
+    /// Mutex for updating and culling the instances, which may happen in several worker threads at once.
+    Mutex instanceMutex_;
     /// IDs of instance nodes for serialization.
     mutable VariantVector nodeIDsAttr_;
     /// Number of valid instance node transforms.
     unsigned numWorldTransforms_;
+    /// Whether the instance clusters need to be rebuilt due to instances being added, removed, enabled or disabled.
+    bool clustersDirty_;
+    /// Whether all instance transforms need to be refreshed.
+    bool transformsDirty_;
     /// Whether node IDs have been set and nodes should be searched for during ApplyAttributes.
     mutable bool nodesDirty_;
     /// Whether nodes have been manipulated by the API and node ID attribute should be refreshed.
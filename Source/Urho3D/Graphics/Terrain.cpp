@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
@@ -57,6 +58,42 @@ static const unsigned STITCH_SOUTH = 2;
 static const unsigned STITCH_WEST = 4;
 static const unsigned STITCH_EAST = 8;
 
+/// %Terrain patch vertex data built in a worker thread, to be copied to the GPU in the main thread.
+struct TerrainPatchGeometry
+{
+    /// Patch.
+    TerrainPatch* patch_;
+    /// Vertex buffer data.
+    SharedArrayPtr<float> vertexData_;
+    /// CPU-side position data for raycasts.
+    SharedArrayPtr<unsigned char> cpuVertexData_;
+    /// CPU-side position data for occlusion.
+    SharedArrayPtr<unsigned char> occlusionCpuVertexData_;
+    /// Bounding box.
+    BoundingBox box_;
+};
+
+void SmoothTerrainHeightsWork(const WorkItem* item, unsigned threadIndex)
+{
+    Terrain* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    const IntRect& region = *reinterpret_cast<IntRect*>(item->start_);
+    terrain->SmoothHeightData(region);
+}
+
+void BuildTerrainPatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Terrain* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    TerrainPatchGeometry* start = reinterpret_cast<TerrainPatchGeometry*>(item->start_);
+    TerrainPatchGeometry* end = reinterpret_cast<TerrainPatchGeometry*>(item->end_);
+
+    while (start != end)
+    {
+        terrain->BuildPatchGeometry(*start);
+        terrain->CalculateLodErrors(start->patch_);
+        ++start;
+    }
+}
+
 inline void GrowUpdateRegion(IntRect& updateRegion, int x, int y)
 {
     if (updateRegion.left_ < 0)
@@ -531,6 +568,41 @@ void Terrain::ApplyHeightMap()
         CreateGeometry();
 }
 
+void Terrain::ApplyHeightMapRegion(const IntRect& rect)
+{
+    if (!heightMap_)
+        return;
+
+    // If the geometry is not up to date with the heightmap size, do a full update instead
+    IntVector2 numPatches((heightMap_->GetWidth() - 1) / patchSize_, (heightMap_->GetHeight() - 1) / patchSize_);
+    if (!node_ || !heightData_ || recreateTerrain_ || numPatches != numPatches_ || patches_.Empty())
+    {
+        CreateGeometry();
+        return;
+    }
+
+    URHO3D_PROFILE(ApplyHeightMapRegion);
+
+    // Convert from image rows (north first) to vertex rows (south first)
+    IntRect region(Max(rect.left_, 0), Max(numVertices_.y_ - rect.bottom_, 0), Min(rect.right_, numVertices_.x_) - 1,
+        Min(numVertices_.y_ - 1 - rect.top_, numVertices_.y_ - 1));
+    if (region.left_ > region.right_ || region.top_ > region.bottom_)
+        return;
+
+    IntRect updateRegion(-1, -1, -1, -1);
+    CopyHeightData(region, false, updateRegion);
+    if (updateRegion.left_ < 0)
+        return;
+
+    UpdatePatchRegion(GetPatchUpdateRegion(updateRegion));
+
+    using namespace TerrainCreated;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_NODE] = node_;
+    node_->SendEvent(E_TERRAINCREATED, eventData);
+}
+
 Image* Terrain::GetHeightMap() const
 {
     return heightMap_;
@@ -668,112 +740,10 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
 {
     URHO3D_PROFILE(CreatePatchGeometry);
 
-    unsigned row = (unsigned)(patchSize_ + 1);
-    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
-    Geometry* geometry = patch->GetGeometry();
-    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
-    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
-
-    if (vertexBuffer->GetVertexCount() != row * row)
-        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
-
-    SharedArrayPtr<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-    SharedArrayPtr<unsigned char> occlusionCpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-
-    float* vertexData = (float*)vertexBuffer->Lock(0, vertexBuffer->GetVertexCount());
-    float* positionData = (float*)cpuVertexData.Get();
-    float* occlusionData = (float*)occlusionCpuVertexData.Get();
-    BoundingBox box;
-
-    unsigned occlusionLevel = occlusionLodLevel_;
-    if (occlusionLevel > numLodLevels_ - 1)
-        occlusionLevel = numLodLevels_ - 1;
-
-    if (vertexData)
-    {
-        const IntVector2& coords = patch->GetCoordinates();
-        int lodExpand = (1 << (occlusionLevel)) - 1;
-        int halfLodExpand = (1 << (occlusionLevel)) / 2;
-
-        for (int z = 0; z <= patchSize_; ++z)
-        {
-            for (int x = 0; x <= patchSize_; ++x)
-            {
-                int xPos = coords.x_ * patchSize_ + x;
-                int zPos = coords.y_ * patchSize_ + z;
-
-                // Position
-                Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
-                *vertexData++ = position.x_;
-                *vertexData++ = position.y_;
-                *vertexData++ = position.z_;
-                *positionData++ = position.x_;
-                *positionData++ = position.y_;
-                *positionData++ = position.z_;
-
-                box.Merge(position);
-
-                // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
-                // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
-                float minHeight = position.y_;
-                if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
-                {
-                    int minX = Max(xPos - halfLodExpand, 0);
-                    int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
-                    int minZ = Max(zPos - halfLodExpand, 0);
-                    int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
-                    for (int nZ = minZ; nZ <= maxZ; ++nZ)
-                    {
-                        for (int nX = minX; nX <= maxX; ++nX)
-                            minHeight = Min(minHeight, GetRawHeight(nX, nZ));
-                    }
-                }
-                *occlusionData++ = position.x_;
-                *occlusionData++ = minHeight;
-                *occlusionData++ = position.z_;
-
-                // Normal
-                Vector3 normal = GetRawNormal(xPos, zPos);
-                *vertexData++ = normal.x_;
-                *vertexData++ = normal.y_;
-                *vertexData++ = normal.z_;
-
-                // Texture coordinate
-                Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
-                *vertexData++ = texCoord.x_;
-                *vertexData++ = texCoord.y_;
-
-                // Tangent
-                Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
-                *vertexData++ = xyz.x_;
-                *vertexData++ = xyz.y_;
-                *vertexData++ = xyz.z_;
-                *vertexData++ = 1.0f;
-            }
-        }
-
-        vertexBuffer->Unlock();
-        vertexBuffer->ClearDataLost();
-    }
-
-    patch->SetBoundingBox(box);
-
-    if (drawRanges_.Size())
-    {
-        unsigned occlusionDrawRange = occlusionLevel << 4;
-
-        geometry->SetIndexBuffer(indexBuffer_);
-        geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        geometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
-        maxLodGeometry->SetIndexBuffer(indexBuffer_);
-        maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        maxLodGeometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
-        occlusionGeometry->SetIndexBuffer(indexBuffer_);
-        occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first_, drawRanges_[occlusionDrawRange].second_, false);
-        occlusionGeometry->SetRawVertexData(occlusionCpuVertexData, MASK_POSITION);
-    }
-
-    patch->ResetLod();
+    TerrainPatchGeometry data;
+    data.patch_ = patch;
+    BuildPatchGeometry(data);
+    CommitPatchGeometry(data);
 }
 
 void Terrain::UpdatePatchLod(TerrainPatch* patch)
@@ -945,95 +915,19 @@ void Terrain::CreateGeometry()
         }
     }
 
-    // Keep track of which patches actually need an update
-    PODVector<bool> dirtyPatches((unsigned)(numPatches_.x_ * numPatches_.y_));
-    for (unsigned i = 0; i < dirtyPatches.Size(); ++i)
-        dirtyPatches[i] = updateAll;
-
     patches_.Clear();
 
     if (heightMap_)
     {
-        // Copy heightmap data
-        const unsigned char* src = heightMap_->GetData();
-        float* dest = smoothing_ ? sourceHeightData_ : heightData_;
-        unsigned imgComps = heightMap_->GetComponents();
-        unsigned imgRow = heightMap_->GetWidth() * imgComps;
+        // Copy heightmap data and check which patches change
         IntRect updateRegion(-1, -1, -1, -1);
+        CopyHeightData(IntRect(0, 0, numVertices_.x_ - 1, numVertices_.y_ - 1), updateAll, updateRegion);
 
-        if (imgComps == 1)
-        {
-            URHO3D_PROFILE(CopyHeightData);
-
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                {
-                    float newHeight = (float)src[imgRow * (numVertices_.y_ - 1 - z) + x] * spacing_.y_;
-
-                    if (updateAll)
-                        *dest = newHeight;
-                    else
-                    {
-                        if (*dest != newHeight)
-                        {
-                            *dest = newHeight;
-                            GrowUpdateRegion(updateRegion, x, z);
-                        }
-                    }
-
-                    ++dest;
-                }
-            }
-        }
-        else
-        {
-            URHO3D_PROFILE(CopyHeightData);
-
-            // If more than 1 component, use the green channel for more accuracy
-            for (int z = 0; z < numVertices_.y_; ++z)
-            {
-                for (int x = 0; x < numVertices_.x_; ++x)
-                {
-                    float newHeight = ((float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x] +
-                                       (float)src[imgRow * (numVertices_.y_ - 1 - z) + imgComps * x + 1] / 256.0f) * spacing_.y_;
-
-                    if (updateAll)
-                        *dest = newHeight;
-                    else
-                    {
-                        if (*dest != newHeight)
-                        {
-                            *dest = newHeight;
-                            GrowUpdateRegion(updateRegion, x, z);
-                        }
-                    }
-
-                    ++dest;
-                }
-            }
-        }
-
-        // If updating a region of the heightmap, check which patches change
-        if (!updateAll)
-        {
-            int lodExpand = 1 << (numLodLevels_ - 1);
-            // Expand the right & bottom 1 pixel more, as patches share vertices at the edge
-            updateRegion.left_ -= lodExpand;
-            updateRegion.right_ += lodExpand + 1;
-            updateRegion.top_ -= lodExpand;
-            updateRegion.bottom_ += lodExpand + 1;
-
-            int sX = Max(updateRegion.left_ / patchSize_, 0);
-            int eX = Min(updateRegion.right_ / patchSize_, numPatches_.x_ - 1);
-            int sY = Max(updateRegion.top_ / patchSize_, 0);
-            int eY = Min(updateRegion.bottom_ / patchSize_, numPatches_.y_ - 1);
-            for (int y = sY; y <= eY; ++y)
-            {
-                for (int x = sX; x <= eX; ++x)
-                    dirtyPatches[y * numPatches_.x_ + x] = true;
-            }
-        }
+        IntRect patchRegion(-1, -1, -1, -1);
+        if (updateAll)
+            patchRegion = IntRect(0, 0, numPatches_.x_ - 1, numPatches_.y_ - 1);
+        else if (updateRegion.left_ >= 0)
+            patchRegion = GetPatchUpdateRegion(updateRegion);
 
         patches_.Reserve((unsigned)(numPatches_.x_ * numPatches_.y_));
 
@@ -1092,64 +986,318 @@ void Terrain::CreateGeometry()
         if (updateAll)
             CreateIndexData();
 
-        // Create vertex data for patches. First update smoothing to ensure normals are calculated correctly across patch borders
-        if (smoothing_)
+        // Create vertex data for the changed patches
+        if (patchRegion.left_ >= 0)
+            UpdatePatchRegion(patchRegion);
+
+        for (unsigned i = 0; i < patches_.Size(); ++i)
+            SetPatchNeighbors(patches_[i]);
+    }
+
+    // Send event only if new geometry was generated, or the old was cleared
+    if (patches_.Size() || prevNumPatches)
+    {
+        using namespace TerrainCreated;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_NODE] = node_;
+        node_->SendEvent(E_TERRAINCREATED, eventData);
+    }
+}
+
+void Terrain::CopyHeightData(const IntRect& region, bool updateAll, IntRect& updateRegion)
+{
+    URHO3D_PROFILE(CopyHeightData);
+
+    const unsigned char* src = heightMap_->GetData();
+    float* destData = smoothing_ ? sourceHeightData_ : heightData_;
+    unsigned imgComps = heightMap_->GetComponents();
+    unsigned imgRow = heightMap_->GetWidth() * imgComps;
+
+    for (int z = region.top_; z <= region.bottom_; ++z)
+    {
+        const unsigned char* srcRow = src + imgRow * (numVertices_.y_ - 1 - z);
+        float* dest = destData + z * numVertices_.x_ + region.left_;
+
+        for (int x = region.left_; x <= region.right_; ++x)
         {
-            URHO3D_PROFILE(UpdateSmoothing);
+            // If more than 1 component, use the green channel for more accuracy
+            float newHeight = imgComps == 1 ? (float)srcRow[x] * spacing_.y_ :
+                ((float)srcRow[imgComps * x] + (float)srcRow[imgComps * x + 1] / 256.0f) * spacing_.y_;
 
-            for (unsigned i = 0; i < patches_.Size(); ++i)
+            if (updateAll)
+                *dest = newHeight;
+            else
             {
-                if (dirtyPatches[i])
+                if (*dest != newHeight)
                 {
-                    TerrainPatch* patch = patches_[i];
-                    const IntVector2& coords = patch->GetCoordinates();
-                    int startX = coords.x_ * patchSize_;
-                    int endX = startX + patchSize_;
-                    int startZ = coords.y_ * patchSize_;
-                    int endZ = startZ + patchSize_;
-
-                    for (int z = startZ; z <= endZ; ++z)
-                    {
-                        for (int x = startX; x <= endX; ++x)
-                        {
-                            float smoothedHeight = (
-                                GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
-                                GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
-                                GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
-                            ) / 16.0f;
-
-                            heightData_[z * numVertices_.x_ + x] = smoothedHeight;
-                        }
-                    }
+                    *dest = newHeight;
+                    GrowUpdateRegion(updateRegion, x, z);
                 }
             }
+
+            ++dest;
         }
+    }
+}
 
-        for (unsigned i = 0; i < patches_.Size(); ++i)
+IntRect Terrain::GetPatchUpdateRegion(const IntRect& updateRegion) const
+{
+    int lodExpand = 1 << (numLodLevels_ - 1);
+
+    // Expand the right & bottom 1 pixel more, as patches share vertices at the edge
+    return IntRect(
+        Max((updateRegion.left_ - lodExpand) / patchSize_, 0),
+        Max((updateRegion.top_ - lodExpand) / patchSize_, 0),
+        Min((updateRegion.right_ + lodExpand + 1) / patchSize_, numPatches_.x_ - 1),
+        Min((updateRegion.bottom_ + lodExpand + 1) / patchSize_, numPatches_.y_ - 1)
+    );
+}
+
+void Terrain::UpdatePatchRegion(const IntRect& patchRegion)
+{
+    if (patchRegion.right_ < patchRegion.left_ || patchRegion.bottom_ < patchRegion.top_)
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads() && Thread::IsMainThread() && !queue->IsCompleting();
+    int numWorkItems = threaded ? (int)queue->GetNumThreads() + 1 : 1; // Worker threads + main thread
+
+    // First update smoothing to ensure normals are calculated correctly across patch borders
+    if (smoothing_)
+    {
+        URHO3D_PROFILE(UpdateSmoothing);
+
+        IntRect region(patchRegion.left_ * patchSize_, patchRegion.top_ * patchSize_, (patchRegion.right_ + 1) * patchSize_,
+            (patchRegion.bottom_ + 1) * patchSize_);
+
+        if (numWorkItems > 1)
+        {
+            // Split into row ranges, which write disjoint parts of the height data
+            int numRows = region.bottom_ - region.top_ + 1;
+            int rowsPerItem = (numRows + numWorkItems - 1) / numWorkItems;
+            PODVector<IntRect> itemRegions;
+            for (int z = region.top_; z <= region.bottom_; z += rowsPerItem)
+                itemRegions.Push(IntRect(region.left_, z, region.right_, Min(z + rowsPerItem - 1, region.bottom_)));
+
+            for (unsigned i = 0; i < itemRegions.Size(); ++i)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = SmoothTerrainHeightsWork;
+                item->aux_ = this;
+                item->start_ = &itemRegions[i];
+                queue->AddWorkItem(item);
+            }
+
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        else
+            SmoothHeightData(region);
+    }
+
+    Vector<TerrainPatchGeometry> geometries;
+    geometries.Reserve((unsigned)((patchRegion.right_ - patchRegion.left_ + 1) * (patchRegion.bottom_ - patchRegion.top_ + 1)));
+    for (int z = patchRegion.top_; z <= patchRegion.bottom_; ++z)
+    {
+        for (int x = patchRegion.left_; x <= patchRegion.right_; ++x)
+        {
+            TerrainPatch* patch = GetPatch(x, z);
+            if (patch)
+            {
+                TerrainPatchGeometry data;
+                data.patch_ = patch;
+                geometries.Push(data);
+            }
+        }
+    }
+
+    if (geometries.Empty())
+        return;
+
+    // Build vertex data and LOD errors for the patches, then copy to the GPU in the main thread
+    {
+        URHO3D_PROFILE(BuildPatchGeometry);
+
+        numWorkItems = Min(numWorkItems, (int)geometries.Size());
+        if (numWorkItems > 1)
         {
-            TerrainPatch* patch = patches_[i];
+            int patchesPerItem = (int)geometries.Size() / numWorkItems;
+            TerrainPatchGeometry* start = &geometries[0];
+            TerrainPatchGeometry* last = start + geometries.Size();
 
-            if (dirtyPatches[i])
+            for (int i = 0; i < numWorkItems; ++i)
             {
-                CreatePatchGeometry(patch);
-                CalculateLodErrors(patch);
+                TerrainPatchGeometry* end = last;
+                if (i < numWorkItems - 1 && end - start > patchesPerItem)
+                    end = start + patchesPerItem;
+
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = BuildTerrainPatchesWork;
+                item->aux_ = this;
+                item->start_ = start;
+                item->end_ = end;
+                queue->AddWorkItem(item);
+
+                start = end;
             }
 
-            SetPatchNeighbors(patch);
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        else
+        {
+            for (unsigned i = 0; i < geometries.Size(); ++i)
+            {
+                BuildPatchGeometry(geometries[i]);
+                CalculateLodErrors(geometries[i].patch_);
+            }
         }
     }
 
-    // Send event only if new geometry was generated, or the old was cleared
-    if (patches_.Size() || prevNumPatches)
     {
-        using namespace TerrainCreated;
+        URHO3D_PROFILE(CommitPatchGeometry);
 
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_NODE] = node_;
-        node_->SendEvent(E_TERRAINCREATED, eventData);
+        for (unsigned i = 0; i < geometries.Size(); ++i)
+            CommitPatchGeometry(geometries[i]);
     }
 }
 
+void Terrain::SmoothHeightData(const IntRect& region)
+{
+    for (int z = region.top_; z <= region.bottom_; ++z)
+    {
+        for (int x = region.left_; x <= region.right_; ++x)
+        {
+            float smoothedHeight = (
+                GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
+                GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
+                GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
+            ) / 16.0f;
+
+            heightData_[z * numVertices_.x_ + x] = smoothedHeight;
+        }
+    }
+}
+
+void Terrain::BuildPatchGeometry(TerrainPatchGeometry& data) const
+{
+    unsigned row = (unsigned)(patchSize_ + 1);
+
+    // Position, normal, texcoord and tangent
+    data.vertexData_ = new float[row * row * 12];
+    data.cpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+    data.occlusionCpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+    data.box_.Clear();
+
+    float* vertexData = data.vertexData_.Get();
+    float* positionData = (float*)data.cpuVertexData_.Get();
+    float* occlusionData = (float*)data.occlusionCpuVertexData_.Get();
+
+    unsigned occlusionLevel = occlusionLodLevel_;
+    if (occlusionLevel > numLodLevels_ - 1)
+        occlusionLevel = numLodLevels_ - 1;
+
+    const IntVector2& coords = data.patch_->GetCoordinates();
+    int lodExpand = (1 << (occlusionLevel)) - 1;
+    int halfLodExpand = (1 << (occlusionLevel)) / 2;
+
+    for (int z = 0; z <= patchSize_; ++z)
+    {
+        for (int x = 0; x <= patchSize_; ++x)
+        {
+            int xPos = coords.x_ * patchSize_ + x;
+            int zPos = coords.y_ * patchSize_ + z;
+
+            // Position
+            Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
+            *vertexData++ = position.x_;
+            *vertexData++ = position.y_;
+            *vertexData++ = position.z_;
+            *positionData++ = position.x_;
+            *positionData++ = position.y_;
+            *positionData++ = position.z_;
+
+            data.box_.Merge(position);
+
+            // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
+            // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
+            float minHeight = position.y_;
+            if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
+            {
+                int minX = Max(xPos - halfLodExpand, 0);
+                int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
+                int minZ = Max(zPos - halfLodExpand, 0);
+                int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
+                for (int nZ = minZ; nZ <= maxZ; ++nZ)
+                {
+                    for (int nX = minX; nX <= maxX; ++nX)
+                        minHeight = Min(minHeight, GetRawHeight(nX, nZ));
+                }
+            }
+            *occlusionData++ = position.x_;
+            *occlusionData++ = minHeight;
+            *occlusionData++ = position.z_;
+
+            // Normal
+            Vector3 normal = GetRawNormal(xPos, zPos);
+            *vertexData++ = normal.x_;
+            *vertexData++ = normal.y_;
+            *vertexData++ = normal.z_;
+
+            // Texture coordinate
+            Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
+            *vertexData++ = texCoord.x_;
+            *vertexData++ = texCoord.y_;
+
+            // Tangent
+            Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
+            *vertexData++ = xyz.x_;
+            *vertexData++ = xyz.y_;
+            *vertexData++ = xyz.z_;
+            *vertexData++ = 1.0f;
+        }
+    }
+}
+
+void Terrain::CommitPatchGeometry(TerrainPatchGeometry& data)
+{
+    TerrainPatch* patch = data.patch_;
+    unsigned row = (unsigned)(patchSize_ + 1);
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    Geometry* geometry = patch->GetGeometry();
+    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
+    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
+
+    if (vertexBuffer->GetVertexCount() != row * row)
+        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
+
+    if (vertexBuffer->SetData(data.vertexData_.Get()))
+        vertexBuffer->ClearDataLost();
+
+    patch->SetBoundingBox(data.box_);
+
+    if (drawRanges_.Size())
+    {
+        unsigned occlusionLevel = occlusionLodLevel_;
+        if (occlusionLevel > numLodLevels_ - 1)
+            occlusionLevel = numLodLevels_ - 1;
+        unsigned occlusionDrawRange = occlusionLevel << 4;
+
+        geometry->SetIndexBuffer(indexBuffer_);
+        geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
+        geometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
+        maxLodGeometry->SetIndexBuffer(indexBuffer_);
+        maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
+        maxLodGeometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
+        occlusionGeometry->SetIndexBuffer(indexBuffer_);
+        occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first_, drawRanges_[occlusionDrawRange].second_, false);
+        occlusionGeometry->SetRawVertexData(data.occlusionCpuVertexData_, MASK_POSITION);
+    }
+
+    patch->ResetLod();
+}
+
 void Terrain::CreateIndexData()
 {
     URHO3D_PROFILE(CreateIndexData);
@@ -33,6 +33,8 @@ class IndexBuffer;
 class Material;
 class Node;
 class TerrainPatch;
+struct TerrainPatchGeometry;
+struct WorkItem;
 
 /// Heightmap terrain component.
 class URHO3D_API Terrain : public Component
@@ -102,6 +104,8 @@ public:
     void SetOccludee(bool enable);
     /// Apply changes from the heightmap image.
     void ApplyHeightMap();
+    /// Apply changes from a region of the heightmap image, in image pixel coordinates. The right and bottom edges of the rect are exclusive, for example IntRect(x, y, x + 1, y + 1) covers the single pixel at x, y. Only the height data within the region is re-read and only the affected patches are regenerated.
+    void ApplyHeightMapRegion(const IntRect& rect);
 
     /// Return patch quads per side.
     int GetPatchSize() const { return patchSize_; }
@@ -216,6 +220,18 @@ public:
 private:
     /// Regenerate terrain geometry.
     void CreateGeometry();
+    /// Copy height data from the heightmap image within an inclusive vertex region. Grow the update region by the changed vertices unless updating all.
+    void CopyHeightData(const IntRect& region, bool updateAll, IntRect& updateRegion);
+    /// Return the inclusive patch region affected by a changed vertex region.
+    IntRect GetPatchUpdateRegion(const IntRect& updateRegion) const;
+    /// Regenerate smoothing, vertex data and LOD errors for an inclusive patch region, using worker threads if available.
+    void UpdatePatchRegion(const IntRect& patchRegion);
+    /// Apply smoothing to the height data within an inclusive vertex region.
+    void SmoothHeightData(const IntRect& region);
+    /// Calculate patch vertex data and bounding box. Does not access GPU resources, so may be called from worker threads.
+    void BuildPatchGeometry(TerrainPatchGeometry& data) const;
+    /// Copy built patch vertex data to the GPU and update the patch geometries. Must be called from the main thread.
+    void CommitPatchGeometry(TerrainPatchGeometry& data);
     /// Create index data shared by all patches.
     void CreateIndexData();
     /// Return an uninterpolated terrain height value, clamping to edges.
@@ -239,6 +255,11 @@ private:
     /// Update edge patch neighbors when neighbor terrain(s) change or are recreated.
     void UpdateEdgePatchNeighbors();
 
+    /// Smooth height data rows in a worker thread.
+    friend void SmoothTerrainHeightsWork(const WorkItem* item, unsigned threadIndex);
+    /// Build patch vertex data and LOD errors in a worker thread.
+    friend void BuildTerrainPatchesWork(const WorkItem* item, unsigned threadIndex);
+
     /// Shared index buffer.
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Heightmap image.
@@ -156,9 +156,9 @@ void TerrainPatch::UpdateGeometry(const FrameInfo& frame)
 
 UpdateGeometryType TerrainPatch::GetUpdateGeometryType()
 {
-    // Because there is a latency in starting worker thread updates, and the update of terrain patch LOD should not take
-    // much time, always update in the main thread
-    return UPDATE_MAIN_THREAD;
+    // Updating the LOD stitching only selects a draw range, so it can be done in a worker thread together with other patches.
+    // Restoring lost vertex data requires the main thread
+    return vertexBuffer_->IsDataLost() ? UPDATE_MAIN_THREAD : UPDATE_WORKER_THREAD;
 }
 
 Geometry* TerrainPatch::GetLodGeometry(unsigned batchIndex, unsigned level)
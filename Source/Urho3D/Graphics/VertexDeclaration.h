@@ -24,6 +24,8 @@
 
 #if defined(URHO3D_OPENGL)
 //#error OpenGL Graphics API does not have VertexDeclaration class, remove this header file in your build to fix this error
+#elif defined(URHO3D_NULL_GRAPHICS)
+//#error Null Graphics API does not have VertexDeclaration class
 #elif defined(URHO3D_D3D11)
 #include "Direct3D11/D3D11VertexDeclaration.h"
 #else
@@ -175,23 +175,26 @@ int DoSystemRun(const String& fileName, const Vector<String>& arguments)
 
     return exitCode;
 #else
+    // Build the argument list before forking, as allocating in the child is unsafe if other threads hold the allocator lock
+    PODVector<const char*> argPtrs;
+    argPtrs.Push(fixedFileName.CString());
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+        argPtrs.Push(arguments[i].CString());
+    argPtrs.Push(0);
+
     pid_t pid = fork();
     if (!pid)
     {
-        PODVector<const char*> argPtrs;
-        argPtrs.Push(fixedFileName.CString());
-        for (unsigned i = 0; i < arguments.Size(); ++i)
-            argPtrs.Push(arguments[i].CString());
-        argPtrs.Push(0);
-
         execvp(argPtrs[0], (char**)&argPtrs[0]);
-        return -1; // Return -1 if we could not spawn the process
+        _exit(-1); // Exit with -1 if we could not spawn the process
     }
     else if (pid > 0)
     {
-        int exitCode;
-        wait(&exitCode);
-        return exitCode;
+        // Wait for this child only, so that programs run concurrently from several threads get their own exit codes
+        int status;
+        if (waitpid(pid, &status, 0) != pid)
+            return -1;
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
     }
     else
         return -1;
@@ -38,6 +38,8 @@ const char* GetCompilerDefines()
     return ""
 #ifdef URHO3D_OPENGL
     "#define URHO3D_OPENGL\n"
+#elif defined(URHO3D_NULL_GRAPHICS)
+    "#define URHO3D_NULL_GRAPHICS\n"
 #elif defined(URHO3D_D3D11)
     "#define URHO3D_D3D11\n"
 #endif
@@ -98,6 +98,13 @@ inline unsigned FloatToRawIntBits(float value)
     return u;
 }
 
+/// Convert float to an unsigned integer which sorts in the same order as the float value.
+inline unsigned FloatToSortKey(float value)
+{
+    unsigned u = FloatToRawIntBits(value);
+    return (u & 0x80000000) ? ~u : u | 0x80000000;
+}
+
 /// Check whether a floating point value is NaN.
 /// Use a workaround for GCC, see https://github.com/urho3d/Urho3D/issues/655
 #ifndef __GNUC__
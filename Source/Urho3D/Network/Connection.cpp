@@ -29,6 +29,7 @@
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -46,6 +47,113 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+static const unsigned SNAPSHOT_COMPONENT_FLAG = 0x80000000;
+static const unsigned char SNAPSHOT_ENTRY_COMPONENT = 0x1;
+static const unsigned char SNAPSHOT_ENTRY_DELTA = 0x2;
+/// Maximum snapshot fragment header size: sequence, baseline sequence and timestamp, then the fragment index, fragment count
+/// and entry count as VLEs of up to 4 bytes.
+static const unsigned MAX_SNAPSHOT_FRAGMENT_HEADER = 2 * sizeof(unsigned) + 1 + 3 * 4;
+
+static float QuantizeFloat(float value, float step)
+{
+    return Round(value / step) * step;
+}
+
+/// Write a latest data attribute value for a snapshot, quantizing float based values.
+static void WriteQuantizedVariant(Serializer& dest, const Variant& value, float step)
+{
+    if (step > 0.0f)
+    {
+        switch (value.GetType())
+        {
+        case VAR_FLOAT:
+            dest.WriteFloat(QuantizeFloat(value.GetFloat(), step));
+            return;
+
+        case VAR_VECTOR2:
+            {
+                const Vector2& v = value.GetVector2();
+                dest.WriteVector2(Vector2(QuantizeFloat(v.x_, step), QuantizeFloat(v.y_, step)));
+            }
+            return;
+
+        case VAR_VECTOR3:
+            {
+                const Vector3& v = value.GetVector3();
+                dest.WriteVector3(Vector3(QuantizeFloat(v.x_, step), QuantizeFloat(v.y_, step), QuantizeFloat(v.z_, step)));
+            }
+            return;
+
+        case VAR_VECTOR4:
+            {
+                const Vector4& v = value.GetVector4();
+                dest.WriteVector4(Vector4(QuantizeFloat(v.x_, step), QuantizeFloat(v.y_, step), QuantizeFloat(v.z_, step),
+                    QuantizeFloat(v.w_, step)));
+            }
+            return;
+
+        case VAR_QUATERNION:
+            {
+                const Quaternion& q = value.GetQuaternion();
+                dest.WriteQuaternion(Quaternion(QuantizeFloat(q.w_, step), QuantizeFloat(q.x_, step), QuantizeFloat(q.y_, step),
+                    QuantizeFloat(q.z_, step)));
+            }
+            return;
+
+        default:
+            break;
+        }
+    }
+
+    dest.WriteVariantData(value);
+}
+
+/// Write data XORed with a baseline, or as is if no baseline. Zero bytes are elided: each group of 8 bytes is preceded by a mask of its nonzero bytes, so that unchanged and slightly changed values take little space.
+static void WritePackedDelta(Serializer& dest, const unsigned char* data, const unsigned char* baseline, unsigned size)
+{
+    for (unsigned i = 0; i < size; i += 8)
+    {
+        unsigned char group[8];
+        unsigned char mask = 0;
+        unsigned count = 0;
+        unsigned end = Min(i + 8, size);
+
+        for (unsigned j = i; j < end; ++j)
+        {
+            unsigned char delta = baseline ? (unsigned char)(data[j] ^ baseline[j]) : data[j];
+            if (delta)
+            {
+                mask |= (unsigned char)(1 << (j - i));
+                group[count++] = delta;
+            }
+        }
+
+        dest.WriteUByte(mask);
+        if (count)
+            dest.Write(group, count);
+    }
+}
+
+/// Read data written by WritePackedDelta. Return true on success.
+static bool ReadPackedDelta(Deserializer& source, unsigned char* dest, const unsigned char* baseline, unsigned size)
+{
+    for (unsigned i = 0; i < size; i += 8)
+    {
+        if (source.IsEof())
+            return false;
+
+        unsigned char mask = source.ReadUByte();
+        unsigned end = Min(i + 8, size);
+
+        for (unsigned j = i; j < end; ++j)
+        {
+            unsigned char delta = (mask & (1 << (j - i))) ? source.ReadUByte() : (unsigned char)0;
+            dest[j] = baseline ? (unsigned char)(baseline[j] ^ delta) : delta;
+        }
+    }
+
+    return true;
+}
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -64,10 +172,14 @@ Connection::Connection(Context* context, bool isClient, kNet::SharedPtr<kNet::Me
     Object(context),
     timeStamp_(0),
     connection_(connection),
+    snapshotSequence_(0),
+    ackedSnapshot_(0),
+    snapshotQuantization_(0.0f),
     sendMode_(OPSM_NONE),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
+    snapshotMode_(false),
     logStatistics_(false)
 {
     sceneState_.connection_ = this;
@@ -171,6 +283,7 @@ void Connection::SetScene(Scene* newScene)
     scene_ = newScene;
     sceneLoaded_ = false;
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
+    ResetSnapshots();
 
     if (!scene_)
         return;
@@ -243,15 +356,45 @@ void Connection::Disconnect(int waitMSec)
 
 void Connection::SendServerUpdate()
 {
+    BuildServerUpdate();
+    SendBufferedServerUpdate();
+}
+
+void Connection::BuildServerUpdate()
+{
+    updateBuffer_.Clear();
+    updateMessages_.Clear();
+
     if (!scene_ || !sceneLoaded_)
         return;
 
+    Network* network = GetSubsystem<Network>();
+    snapshotMode_ = network->GetSnapshotReplication();
+    snapshotQuantization_ = network->GetSnapshotQuantization();
+    // When snapshots are turned off, the next time they are sent is without a baseline
+    if (!snapshotMode_ && !snapshots_.Empty())
+        ResetSnapshots();
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
     nodesToProcess_.Insert(sceneID);
     ProcessNode(sceneID);
 
+    // Update the nodes relevant to the client, if the scene uses interest management and the client has sent its position
+    InterestGrid* grid = scene_->GetComponent<InterestGrid>();
+    if (grid && grid->IsEnabledEffective() && sendMode_ != OPSM_NONE)
+        UpdateScope(grid);
+    else if (sceneState_.scopeActive_)
+    {
+        // Interest management was turned off: mark all nodes dirty so that the ones out of scope get created
+        sceneState_.scopeActive_ = false;
+        sceneState_.scopeNodes_.Clear();
+        const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+            AddToScope(*i);
+    }
+
     // Then go through all dirtied nodes
     nodesToProcess_.Insert(sceneState_.dirtyNodes_);
     nodesToProcess_.Erase(sceneID); // Do not process the root node twice
@@ -261,6 +404,19 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    if (snapshotMode_)
+        BuildSnapshot();
+}
+
+void Connection::SendBufferedServerUpdate()
+{
+    const unsigned char* data = updateBuffer_.GetData();
+    for (PODVector<BufferedServerMessage>::ConstIterator i = updateMessages_.Begin(); i != updateMessages_.End(); ++i)
+        SendMessage(i->msgID_, i->reliable_, i->inOrder_, data + i->offset_, i->size_, i->contentID_);
+
+    updateBuffer_.Clear();
+    updateMessages_.Clear();
 }
 
 void Connection::SendClientUpdate()
@@ -438,6 +594,14 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
         ProcessPackageInfo(msgID, msg);
         break;
 
+    case MSG_SNAPSHOT:
+        ProcessSnapshot(msgID, msg);
+        break;
+
+    case MSG_SNAPSHOTACK:
+        ProcessSnapshotAck(msgID, msg);
+        break;
+
     default:
         processed = false;
         break;
@@ -467,6 +631,7 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     nodeLatestData_.Clear();
     componentLatestData_.Clear();
     downloads_.Clear();
+    ResetSnapshots();
 
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
     // to prevent resource conflicts
@@ -894,11 +1059,12 @@ void Connection::ProcessControls(int msgID, MemoryBuffer& msg)
     SetControls(newControls);
     timeStamp_ = msg.ReadUByte();
 
-    // Client may or may not send observer position & rotation for interest management
+    // Client may or may not send observer position & rotation for interest management. Record the send mode as well,
+    // so that the interest grid is only applied to clients that have a position
     if (!msg.IsEof())
-        position_ = msg.ReadVector3();
+        SetPosition(msg.ReadVector3());
     if (!msg.IsEof())
-        rotation_ = msg.ReadPackedQuaternion();
+        SetRotation(msg.ReadPackedQuaternion());
 }
 
 void Connection::ProcessSceneLoaded(int msgID, MemoryBuffer& msg)
@@ -1121,9 +1287,17 @@ void Connection::ProcessNode(unsigned nodeID)
             // Note: we will send MSG_REMOVENODE redundantly for each node in the hierarchy, even if removing the root node
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
-            SendMessage(MSG_REMOVENODE, true, true, msg_);
+            BufferServerMessage(MSG_REMOVENODE, true, true, msg_);
+
+            // Destroying the replication state releases weak references shared with other connections
+            MutexLock lock(scene_->GetReplicationMutex());
             sceneState_.nodeStates_.Erase(nodeID);
         }
+        else if (sceneState_.scopeActive_ && !IsInScope(node))
+        {
+            // The node has been reparented out of scope
+            RemoveFromScope(node, true);
+        }
         else
             ProcessExistingNode(node, i->second_);
     }
@@ -1131,7 +1305,12 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state not found: this is a new node
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        if (node && sceneState_.scopeActive_ && !IsInScope(node))
+        {
+            // Out of scope: skip until it enters scope
+            sceneState_.dirtyNodes_.Erase(nodeID);
+        }
+        else if (node)
             ProcessNewNode(node);
         else
         {
@@ -1141,6 +1320,111 @@ void Connection::ProcessNode(unsigned nodeID)
     }
 }
 
+void Connection::UpdateScope(InterestGrid* grid)
+{
+    grid->GetRelevantNodes(this, position_, sceneState_.scopeNodes_, newScopeNodes_);
+
+    if (!sceneState_.scopeActive_)
+    {
+        // Interest management was just activated: remove the nodes out of scope, which the client may already have
+        sceneState_.scopeActive_ = true;
+        const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        {
+            Node* node = *i;
+            if (node->GetID() < FIRST_LOCAL_ID && !newScopeNodes_.Contains(node->GetID()))
+                RemoveFromScope(node, true);
+        }
+    }
+    else
+    {
+        for (HashSet<unsigned>::ConstIterator i = sceneState_.scopeNodes_.Begin(); i != sceneState_.scopeNodes_.End(); ++i)
+        {
+            if (!newScopeNodes_.Contains(*i))
+            {
+                // If the node no longer exists, its replication state is removed as part of the dirty node processing
+                Node* node = scene_->GetNode(*i);
+                if (node)
+                    RemoveFromScope(node, true);
+            }
+        }
+
+        for (HashSet<unsigned>::ConstIterator i = newScopeNodes_.Begin(); i != newScopeNodes_.End(); ++i)
+        {
+            if (!sceneState_.scopeNodes_.Contains(*i))
+            {
+                Node* node = scene_->GetNode(*i);
+                if (node)
+                    AddToScope(node);
+            }
+        }
+    }
+
+    sceneState_.scopeNodes_.Swap(newScopeNodes_);
+}
+
+void Connection::AddToScope(Node* node)
+{
+    if (node->GetID() < FIRST_LOCAL_ID)
+        sceneState_.dirtyNodes_.Insert(node->GetID());
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        AddToScope(*i);
+}
+
+void Connection::RemoveFromScope(Node* node, bool sendRemove)
+{
+    unsigned nodeID = node->GetID();
+
+    HashMap<unsigned, NodeReplicationState>::Iterator i = sceneState_.nodeStates_.Find(nodeID);
+    if (i != sceneState_.nodeStates_.End())
+    {
+        // Removing the topmost node also removes its children on the client
+        if (sendRemove)
+        {
+            msg_.Clear();
+            msg_.WriteNetID(nodeID);
+            BufferServerMessage(MSG_REMOVENODE, true, true, msg_);
+            sendRemove = false;
+        }
+
+        // Detach the replication states from the node and its components before destroying them. The node and components
+        // remain in the scene, so their state lists are shared with other connections
+        MutexLock lock(scene_->GetReplicationMutex());
+        NodeReplicationState& nodeState = i->second_;
+        if (node->GetNetworkState())
+            node->GetNetworkState()->replicationStates_.Remove(&nodeState);
+        for (HashMap<unsigned, ComponentReplicationState>::Iterator j = nodeState.componentStates_.Begin();
+             j != nodeState.componentStates_.End(); ++j)
+        {
+            Component* component = j->second_.component_;
+            if (component && component->GetNetworkState())
+                component->GetNetworkState()->replicationStates_.Remove(&j->second_);
+        }
+        sceneState_.nodeStates_.Erase(i);
+    }
+
+    sceneState_.dirtyNodes_.Erase(nodeID);
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+        RemoveFromScope(*j, sendRemove);
+}
+
+bool Connection::IsInScope(Node* node) const
+{
+    // Relevance is decided by the root level parent, so that hierarchies enter and leave scope as a whole
+    Node* parent = node->GetParent();
+    while (parent && parent != scene_)
+    {
+        node = parent;
+        parent = node->GetParent();
+    }
+
+    return !parent || sceneState_.scopeNodes_.Contains(node->GetID());
+}
+
 void Connection::ProcessNewNode(Node* node)
 {
     // Process depended upon nodes first, if they are dirty
@@ -1156,10 +1440,14 @@ void Connection::ProcessNewNode(Node* node)
     msg_.WriteNetID(node->GetID());
 
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
-    nodeState.connection_ = this;
-    nodeState.sceneState_ = &sceneState_;
-    nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    {
+        // Replication states and weak references are shared with other connections, which may be building updates concurrently
+        MutexLock lock(scene_->GetReplicationMutex());
+        nodeState.connection_ = this;
+        nodeState.sceneState_ = &sceneState_;
+        nodeState.node_ = node;
+        node->AddReplicationState(&nodeState);
+    }
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1184,17 +1472,20 @@ void Connection::ProcessNewNode(Node* node)
             continue;
 
         ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
-        componentState.connection_ = this;
-        componentState.nodeState_ = &nodeState;
-        componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        {
+            MutexLock lock(scene_->GetReplicationMutex());
+            componentState.connection_ = this;
+            componentState.nodeState_ = &nodeState;
+            componentState.component_ = component;
+            component->AddReplicationState(&componentState);
+        }
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
         component->WriteInitialDeltaUpdate(msg_, timeStamp_);
     }
 
-    SendMessage(MSG_CREATENODE, true, true, msg_);
+    BufferServerMessage(MSG_CREATENODE, true, true, msg_);
 
     nodeState.markedDirty_ = false;
     sceneState_.dirtyNodes_.Erase(node->GetID());
@@ -1216,6 +1507,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     NetworkPriority* priority = node->GetComponent<NetworkPriority>();
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
+        // The world transform has been updated in Scene::PrepareNetworkUpdate(), so this is a read only
         float distance = (node->GetWorldPosition() - position_).Length();
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
@@ -1237,14 +1529,14 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             }
         }
 
-        // Send latestdata message if necessary
-        if (hasLatestData)
+        // Send latestdata message if necessary. In snapshot mode it is sent in the snapshot instead
+        if (hasLatestData && !snapshotMode_)
         {
             msg_.Clear();
             msg_.WriteNetID(node->GetID());
             node->WriteLatestDataUpdate(msg_, timeStamp_);
 
-            SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
+            BufferServerMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
         }
 
         // Send deltaupdate if remaining dirty bits, or vars have changed
@@ -1274,7 +1566,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 }
             }
 
-            SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+            BufferServerMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
 
             nodeState.dirtyAttributes_.ClearAll();
             nodeState.dirtyVars_.Clear();
@@ -1294,7 +1586,9 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             msg_.Clear();
             msg_.WriteNetID(current->first_);
 
-            SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+            BufferServerMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+
+            MutexLock lock(scene_->GetReplicationMutex());
             nodeState.componentStates_.Erase(current);
         }
         else
@@ -1315,14 +1609,14 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     }
                 }
 
-                // Send latestdata message if necessary
-                if (hasLatestData)
+                // Send latestdata message if necessary. In snapshot mode it is sent in the snapshot instead
+                if (hasLatestData && !snapshotMode_)
                 {
                     msg_.Clear();
                     msg_.WriteNetID(component->GetID());
                     component->WriteLatestDataUpdate(msg_, timeStamp_);
 
-                    SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
+                    BufferServerMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
                 }
 
                 // Send deltaupdate if remaining dirty bits
@@ -1332,7 +1626,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     msg_.WriteNetID(component->GetID());
                     component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
 
-                    SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
+                    BufferServerMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
 
                     componentState.dirtyAttributes_.ClearAll();
                 }
@@ -1356,10 +1650,13 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             {
                 // New component
                 ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
-                componentState.connection_ = this;
-                componentState.nodeState_ = &nodeState;
-                componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                {
+                    MutexLock lock(scene_->GetReplicationMutex());
+                    componentState.connection_ = this;
+                    componentState.nodeState_ = &nodeState;
+                    componentState.component_ = component;
+                    component->AddReplicationState(&componentState);
+                }
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1367,7 +1664,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 msg_.WriteNetID(component->GetID());
                 component->WriteInitialDeltaUpdate(msg_, timeStamp_);
 
-                SendMessage(MSG_CREATECOMPONENT, true, true, msg_);
+                BufferServerMessage(MSG_CREATECOMPONENT, true, true, msg_);
             }
         }
     }
@@ -1376,6 +1673,372 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+void Connection::BuildSnapshot()
+{
+    // The client keeps a limited history of snapshots, so an old baseline may no longer be available
+    if (ackedSnapshot_ && snapshotSequence_ - ackedSnapshot_ >= SNAPSHOT_HISTORY_SIZE)
+        ackedSnapshot_ = 0;
+
+    const ReplicationSnapshot* baseline = 0;
+    if (ackedSnapshot_)
+    {
+        for (List<ReplicationSnapshot>::ConstIterator i = snapshots_.Begin(); i != snapshots_.End(); ++i)
+        {
+            if (i->sequence_ == ackedSnapshot_)
+            {
+                baseline = &(*i);
+                break;
+            }
+        }
+    }
+
+    const ReplicationSnapshot* previous = !snapshots_.Empty() ? &snapshots_.Back() : 0;
+    snapshots_.Push(ReplicationSnapshot());
+    ReplicationSnapshot& snapshot = snapshots_.Back();
+    snapshot.sequence_ = snapshotSequence_ + 1;
+    snapshotEntries_.Clear();
+    snapshotFragments_.Clear();
+    snapshotFragments_.Push(MakePair(0U, 0U));
+
+    for (HashMap<unsigned, NodeReplicationState>::ConstIterator i = sceneState_.nodeStates_.Begin();
+         i != sceneState_.nodeStates_.End(); ++i)
+    {
+        Node* node = i->second_.node_;
+        if (!node)
+            continue;
+
+        WriteSnapshotObject(snapshot, baseline, previous, node, i->first_);
+
+        for (HashMap<unsigned, ComponentReplicationState>::ConstIterator j = i->second_.componentStates_.Begin();
+             j != i->second_.componentStates_.End(); ++j)
+        {
+            Component* component = j->second_.component_;
+            if (component)
+                WriteSnapshotObject(snapshot, baseline, previous, component, j->first_ | SNAPSHOT_COMPONENT_FLAG);
+        }
+    }
+
+    // If nothing changed from the baseline, there is no need to send
+    if (!snapshotFragments_.Back().second_)
+    {
+        snapshots_.Pop();
+        return;
+    }
+
+    snapshotSequence_ = snapshot.sequence_;
+    unsigned numFragments = snapshotFragments_.Size();
+    for (unsigned i = 0; i < numFragments; ++i)
+    {
+        unsigned start = snapshotFragments_[i].first_;
+        unsigned end = i + 1 < numFragments ? snapshotFragments_[i + 1].first_ : snapshotEntries_.GetSize();
+
+        msg_.Clear();
+        msg_.WriteUInt(snapshot.sequence_);
+        msg_.WriteUInt(baseline ? baseline->sequence_ : 0);
+        msg_.WriteUByte(timeStamp_);
+        msg_.WriteVLE(i);
+        msg_.WriteVLE(numFragments);
+        msg_.WriteVLE(snapshotFragments_[i].second_);
+        msg_.Write(snapshotEntries_.GetData() + start, end - start);
+
+        BufferServerMessage(MSG_SNAPSHOT, false, false, msg_);
+    }
+
+    // Drop the oldest snapshots if the client has not acknowledged in a while
+    while (snapshots_.Size() > SNAPSHOT_HISTORY_SIZE)
+    {
+        if (snapshots_.Front().sequence_ == ackedSnapshot_)
+            ackedSnapshot_ = 0;
+        snapshots_.PopFront();
+    }
+}
+
+void Connection::WriteSnapshotObject(ReplicationSnapshot& snapshot, const ReplicationSnapshot* baseline,
+    const ReplicationSnapshot* previous, Serializable* object, unsigned key)
+{
+    NetworkState* networkState = object->GetNetworkState();
+    if (!networkState || !networkState->attributes_)
+        return;
+
+    snapshotData_.Clear();
+    const Vector<AttributeInfo>* attributes = networkState->attributes_;
+    unsigned numAttributes = attributes->Size();
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (attributes->At(i).mode_ & AM_LATESTDATA)
+            WriteQuantizedVariant(snapshotData_, networkState->currentValues_[i], snapshotQuantization_);
+    }
+
+    const unsigned char* data = snapshotData_.GetData();
+    unsigned size = snapshotData_.GetSize();
+    if (!size)
+        return;
+
+    SnapshotObject& snapshotObject = snapshot.objects_[key];
+    snapshotObject.offset_ = snapshot.data_.Size();
+    snapshotObject.size_ = size;
+    snapshotObject.lastChanged_ = snapshot.sequence_;
+    snapshot.data_.Resize(snapshotObject.offset_ + size);
+    memcpy(&snapshot.data_[snapshotObject.offset_], data, size);
+
+    if (previous)
+    {
+        HashMap<unsigned, SnapshotObject>::ConstIterator i = previous->objects_.Find(key);
+        if (i != previous->objects_.End() && i->second_.size_ == size && !memcmp(&previous->data_[i->second_.offset_], data, size))
+            snapshotObject.lastChanged_ = i->second_.lastChanged_;
+    }
+
+    // Skip if the data has not changed since the baseline acknowledged by the client. Delta against the baseline only if the
+    // data size matches
+    const unsigned char* baselineData = 0;
+    if (baseline)
+    {
+        HashMap<unsigned, SnapshotObject>::ConstIterator i = baseline->objects_.Find(key);
+        if (i != baseline->objects_.End() && i->second_.size_ == size)
+        {
+            baselineData = &baseline->data_[i->second_.offset_];
+            if (snapshotObject.lastChanged_ <= baseline->sequence_)
+                return;
+        }
+    }
+
+    // Start a new fragment if this entry would exceed the fragment size. At most the entry holds the flags, the ID, the data
+    // size if not a delta, a mask byte per 8 bytes of data and the data itself
+    unsigned entryStart = snapshotEntries_.GetSize();
+    unsigned maxEntrySize = 1 + 3 + (baselineData ? 0 : 4) + (size + 7) / 8 + size;
+    if (snapshotFragments_.Back().second_ && entryStart - snapshotFragments_.Back().first_ + maxEntrySize >
+        SNAPSHOT_FRAGMENT_SIZE - MAX_SNAPSHOT_FRAGMENT_HEADER)
+        snapshotFragments_.Push(MakePair(entryStart, 0U));
+
+    unsigned char flags = 0;
+    if (key & SNAPSHOT_COMPONENT_FLAG)
+        flags |= SNAPSHOT_ENTRY_COMPONENT;
+    if (baselineData)
+        flags |= SNAPSHOT_ENTRY_DELTA;
+
+    snapshotEntries_.WriteUByte(flags);
+    snapshotEntries_.WriteNetID(key & ~SNAPSHOT_COMPONENT_FLAG);
+    if (!baselineData)
+        snapshotEntries_.WriteVLE(size);
+    WritePackedDelta(snapshotEntries_, data, baselineData, size);
+    ++snapshotFragments_.Back().second_;
+}
+
+void Connection::ProcessSnapshot(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected Snapshot message from client " + ToString());
+        return;
+    }
+
+    if (!scene_)
+        return;
+
+    unsigned sequence = msg.ReadUInt();
+    unsigned baselineSequence = msg.ReadUInt();
+    unsigned char timeStamp = msg.ReadUByte();
+    unsigned fragment = msg.ReadVLE();
+    unsigned numFragments = msg.ReadVLE();
+    unsigned numEntries = msg.ReadVLE();
+
+    // Snapshots are unreliable: discard fragments of snapshots older than the latest, as their data is out of date
+    if (sequence < snapshotSequence_ || fragment >= numFragments)
+        return;
+
+    const ReplicationSnapshot* baseline = 0;
+    if (baselineSequence)
+    {
+        for (List<ReplicationSnapshot>::ConstIterator i = snapshots_.Begin(); i != snapshots_.End(); ++i)
+        {
+            if (i->sequence_ == baselineSequence)
+            {
+                baseline = &(*i);
+                break;
+            }
+        }
+
+        // If the baseline is no longer available, wait for the server to send without it
+        if (!baseline)
+            return;
+    }
+
+    if (sequence > snapshotSequence_)
+    {
+        snapshotSequence_ = sequence;
+        receivingSnapshot_.sequence_ = sequence;
+        receivingSnapshot_.objects_.Clear();
+        receivingSnapshot_.data_.Clear();
+        receivedSnapshotFragments_.Clear();
+    }
+    else if (receivingSnapshot_.sequence_ != sequence || receivedSnapshotFragments_.Contains(fragment))
+        return;
+
+    receivedSnapshotFragments_.Insert(fragment);
+
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        unsigned char flags = msg.ReadUByte();
+        unsigned key = msg.ReadNetID();
+        if (flags & SNAPSHOT_ENTRY_COMPONENT)
+            key |= SNAPSHOT_COMPONENT_FLAG;
+
+        const unsigned char* baselineData = 0;
+        unsigned size;
+        if (flags & SNAPSHOT_ENTRY_DELTA)
+        {
+            HashMap<unsigned, SnapshotObject>::ConstIterator j = baseline ? baseline->objects_.Find(key) :
+                HashMap<unsigned, SnapshotObject>::ConstIterator();
+            if (!baseline || j == baseline->objects_.End())
+            {
+                URHO3D_LOGWARNING("Snapshot delta without baseline data, discarding snapshot");
+                receivingSnapshot_.sequence_ = 0;
+                return;
+            }
+            baselineData = &baseline->data_[j->second_.offset_];
+            size = j->second_.size_;
+        }
+        else
+            size = msg.ReadVLE();
+
+        if (!size)
+            continue;
+
+        SnapshotObject& snapshotObject = receivingSnapshot_.objects_[key];
+        snapshotObject.offset_ = receivingSnapshot_.data_.Size();
+        snapshotObject.size_ = size;
+        receivingSnapshot_.data_.Resize(snapshotObject.offset_ + size);
+        unsigned char* data = &receivingSnapshot_.data_[snapshotObject.offset_];
+        if (!ReadPackedDelta(msg, data, baselineData, size))
+        {
+            URHO3D_LOGWARNING("Truncated snapshot data, discarding snapshot");
+            receivingSnapshot_.sequence_ = 0;
+            return;
+        }
+
+        ApplySnapshotObject(key, timeStamp, data, size);
+    }
+
+    if (receivedSnapshotFragments_.Size() == numFragments)
+    {
+        // Snapshot complete: carry over the objects unchanged from the baseline, and acknowledge so that the server can use
+        // it as the next baseline
+        if (baseline)
+        {
+            for (HashMap<unsigned, SnapshotObject>::ConstIterator i = baseline->objects_.Begin(); i != baseline->objects_.End();
+                 ++i)
+            {
+                if (receivingSnapshot_.objects_.Contains(i->first_))
+                    continue;
+
+                SnapshotObject& snapshotObject = receivingSnapshot_.objects_[i->first_];
+                snapshotObject.offset_ = receivingSnapshot_.data_.Size();
+                snapshotObject.size_ = i->second_.size_;
+                receivingSnapshot_.data_.Resize(snapshotObject.offset_ + snapshotObject.size_);
+                memcpy(&receivingSnapshot_.data_[snapshotObject.offset_], &baseline->data_[i->second_.offset_],
+                    snapshotObject.size_);
+            }
+        }
+
+        snapshots_.Push(receivingSnapshot_);
+        while (snapshots_.Size() > SNAPSHOT_HISTORY_SIZE)
+            snapshots_.PopFront();
+        receivingSnapshot_.sequence_ = 0;
+
+        msg_.Clear();
+        msg_.WriteUInt(sequence);
+        SendMessage(MSG_SNAPSHOTACK, false, false, msg_);
+    }
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    unsigned sequence = msg.ReadUInt();
+    if (sequence <= ackedSnapshot_ || sequence > snapshotSequence_)
+        return;
+
+    // Snapshots older than the new baseline are no longer needed
+    ackedSnapshot_ = sequence;
+    while (!snapshots_.Empty() && snapshots_.Front().sequence_ < sequence)
+        snapshots_.PopFront();
+}
+
+void Connection::ApplySnapshotObject(unsigned key, unsigned char timeStamp, const unsigned char* data, unsigned size)
+{
+    unsigned id = key & ~SNAPSHOT_COMPONENT_FLAG;
+
+    // Format the data as a latest data message, so that it can also be cached for objects not yet created
+    snapshotData_.Clear();
+    snapshotData_.WriteNetID(id);
+    snapshotData_.WriteUByte(timeStamp);
+    snapshotData_.Write(data, size);
+
+    if (key & SNAPSHOT_COMPONENT_FLAG)
+    {
+        Component* component = scene_->GetComponent(id);
+        if (component)
+        {
+            MemoryBuffer latestData(snapshotData_.GetData(), snapshotData_.GetSize());
+            latestData.ReadNetID();
+            if (component->ReadLatestDataUpdate(latestData))
+                component->ApplyAttributes();
+        }
+        else
+        {
+            PODVector<unsigned char>& pendingData = componentLatestData_[id];
+            pendingData.Resize(snapshotData_.GetSize());
+            memcpy(&pendingData[0], snapshotData_.GetData(), snapshotData_.GetSize());
+        }
+    }
+    else
+    {
+        Node* node = scene_->GetNode(id);
+        if (node)
+        {
+            MemoryBuffer latestData(snapshotData_.GetData(), snapshotData_.GetSize());
+            latestData.ReadNetID();
+            node->ReadLatestDataUpdate(latestData);
+        }
+        else
+        {
+            PODVector<unsigned char>& pendingData = nodeLatestData_[id];
+            pendingData.Resize(snapshotData_.GetSize());
+            memcpy(&pendingData[0], snapshotData_.GetData(), snapshotData_.GetSize());
+        }
+    }
+}
+
+void Connection::ResetSnapshots()
+{
+    // The sequence number keeps increasing, so that the client never mistakes a new snapshot for an old one
+    snapshots_.Clear();
+    receivingSnapshot_.sequence_ = 0;
+    receivingSnapshot_.objects_.Clear();
+    receivingSnapshot_.data_.Clear();
+    receivedSnapshotFragments_.Clear();
+    ackedSnapshot_ = 0;
+}
+
+void Connection::BufferServerMessage(int msgID, bool reliable, bool inOrder, const VectorBuffer& msg, unsigned contentID)
+{
+    BufferedServerMessage message;
+    message.msgID_ = msgID;
+    message.contentID_ = contentID;
+    message.offset_ = updateBuffer_.GetSize();
+    message.size_ = msg.GetSize();
+    message.reliable_ = reliable;
+    message.inOrder_ = inOrder;
+    updateMessages_.Push(message);
+
+    updateBuffer_.Write(msg.GetData(), msg.GetSize());
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     ResourceCache* cache = GetSubsystem<ResourceCache>();
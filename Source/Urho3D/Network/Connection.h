@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/HashSet.h"
+#include "../Container/List.h"
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
@@ -40,6 +41,7 @@ namespace Urho3D
 {
 
 class File;
+class InterestGrid;
 class MemoryBuffer;
 class Node;
 class Scene;
@@ -93,6 +95,51 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Scene update message built ahead of sending.
+struct BufferedServerMessage
+{
+    /// Message ID.
+    int msgID_;
+    /// Content ID.
+    unsigned contentID_;
+    /// Offset of the message data in the update buffer.
+    unsigned offset_;
+    /// Message data size.
+    unsigned size_;
+    /// Reliable flag.
+    bool reliable_;
+    /// In order flag.
+    bool inOrder_;
+};
+
+/// Latest data of a replicated object within a snapshot.
+struct SnapshotObject
+{
+    /// Offset of the data in the snapshot.
+    unsigned offset_;
+    /// Data size.
+    unsigned size_;
+    /// Sequence number of the snapshot where the data last changed. Used on the server.
+    unsigned lastChanged_;
+};
+
+/// Latest data of all replicated objects known to the client at a point in time, used as a delta compression baseline.
+struct ReplicationSnapshot
+{
+    /// Construct.
+    ReplicationSnapshot() :
+        sequence_(0)
+    {
+    }
+
+    /// Sequence number.
+    unsigned sequence_;
+    /// Objects by node ID, or component ID with the high bit set.
+    HashMap<unsigned, SnapshotObject> objects_;
+    /// Latest data attribute values of all objects.
+    PODVector<unsigned char> data_;
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -138,6 +185,10 @@ public:
     void Disconnect(int waitMSec = 0);
     /// Send scene update messages. Called by Network.
     void SendServerUpdate();
+    /// Build scene update messages without sending them. Connections may build concurrently in worker threads while the scene is not modified. Called by Network.
+    void BuildServerUpdate();
+    /// Send the scene update messages built by BuildServerUpdate. Called by Network.
+    void SendBufferedServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -255,6 +306,30 @@ private:
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Update the root level nodes relevant to the client from the interest grid. Nodes entering scope are marked dirty for creation, and nodes leaving scope are removed from the client.
+    void UpdateScope(InterestGrid* grid);
+    /// Mark a node and its replicated children dirty after entering scope.
+    void AddToScope(Node* node);
+    /// Remove a node and its children from the client and release their replication states after leaving scope.
+    void RemoveFromScope(Node* node, bool sendRemove);
+    /// Return whether a node's root level parent is in scope.
+    bool IsInScope(Node* node) const;
+    /// Build the latest data snapshot of the objects known to the client and buffer its fragments for sending.
+    void BuildSnapshot();
+    /// Add an object's latest data to a snapshot and write an entry for it if changed from the baseline.
+    void WriteSnapshotObject
+        (ReplicationSnapshot& snapshot, const ReplicationSnapshot* baseline, const ReplicationSnapshot* previous, Serializable* object,
+            unsigned key);
+    /// Process a snapshot fragment from the server.
+    void ProcessSnapshot(int msgID, MemoryBuffer& msg);
+    /// Process a snapshot acknowledgement from the client.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Apply latest data received in a snapshot to a node or component, or cache it if not yet created.
+    void ApplySnapshotObject(unsigned key, unsigned char timeStamp, const unsigned char* data, unsigned size);
+    /// Release snapshot history, so that the next snapshot is sent or received without a baseline.
+    void ResetSnapshots();
+    /// Buffer a scene update message for sending in SendBufferedServerUpdate.
+    void BufferServerMessage(int msgID, bool reliable, bool inOrder, const VectorBuffer& msg, unsigned contentID = 0);
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Check a package list received from server and initiate package downloads as necessary. Return true on success, or false if failed to initialze downloads (cache dir not set)
@@ -286,8 +361,32 @@ private:
     HashMap<unsigned, PODVector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// Root level node ID's in scope after the current update.
+    HashSet<unsigned> newScopeNodes_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Scene update message data built by BuildServerUpdate.
+    VectorBuffer updateBuffer_;
+    /// Scene update messages built by BuildServerUpdate.
+    PODVector<BufferedServerMessage> updateMessages_;
+    /// Recent snapshots. On the server these are the sent snapshots from the acknowledged baseline onward, on the client the fully received ones.
+    List<ReplicationSnapshot> snapshots_;
+    /// Snapshot being received from the server.
+    ReplicationSnapshot receivingSnapshot_;
+    /// Received fragments of the snapshot being received.
+    HashSet<unsigned> receivedSnapshotFragments_;
+    /// Reusable buffer for snapshot entries.
+    VectorBuffer snapshotEntries_;
+    /// Reusable buffer for an object's snapshot data.
+    VectorBuffer snapshotData_;
+    /// Start offsets and entry counts of snapshot fragments in the entry buffer.
+    PODVector<Pair<unsigned, unsigned> > snapshotFragments_;
+    /// Latest snapshot sequence number sent or received.
+    unsigned snapshotSequence_;
+    /// Latest snapshot sequence number acknowledged by the client.
+    unsigned ackedSnapshot_;
+    /// Float quantization step for snapshots.
+    float snapshotQuantization_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
@@ -310,6 +409,8 @@ private:
     bool connectPending_;
     /// Scene loaded flag.
     bool sceneLoaded_;
+    /// Snapshot replication flag for the update being built.
+    bool snapshotMode_;
     /// Show statistics flag.
     bool logStatistics_;
 };
@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Network/InterestGrid.h"
+#include "../Network/NetworkPriority.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 50.0f;
+static const float DEFAULT_RELEVANCE_DISTANCE = 200.0f;
+static const float DEFAULT_EXIT_MARGIN = 20.0f;
+static const float MIN_CELL_SIZE = 0.1f;
+
+InterestGrid::InterestGrid(Context* context) :
+    Component(context),
+    cellSize_(DEFAULT_CELL_SIZE),
+    relevanceDistance_(DEFAULT_RELEVANCE_DISTANCE),
+    exitMargin_(DEFAULT_EXIT_MARGIN)
+{
+}
+
+InterestGrid::~InterestGrid()
+{
+}
+
+void InterestGrid::RegisterObject(Context* context)
+{
+    context->RegisterFactory<InterestGrid>(NETWORK_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Relevance Distance", GetRelevanceDistance, SetRelevanceDistance, float, DEFAULT_RELEVANCE_DISTANCE,
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Exit Margin", GetExitMargin, SetExitMargin, float, DEFAULT_EXIT_MARGIN, AM_DEFAULT);
+}
+
+void InterestGrid::SetCellSize(float size)
+{
+    cellSize_ = Max(size, MIN_CELL_SIZE);
+    MarkNetworkUpdate();
+}
+
+void InterestGrid::SetRelevanceDistance(float distance)
+{
+    relevanceDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestGrid::SetExitMargin(float margin)
+{
+    exitMargin_ = Max(margin, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestGrid::UpdateGrid()
+{
+    URHO3D_PROFILE(UpdateInterestGrid);
+
+    // Keep the cell vectors allocated between updates, and erase only the cells that become empty
+    for (HashMap<IntVector2, PODVector<InterestGridNode> >::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+        i->second_.Clear();
+    alwaysRelevantNodes_.Clear();
+    ownedNodes_.Clear();
+
+    Scene* scene = GetScene();
+    if (!scene)
+    {
+        cells_.Clear();
+        return;
+    }
+
+    const Vector<SharedPtr<Node> >& children = scene->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        Node* node = *i;
+        if (node->GetID() >= FIRST_LOCAL_ID)
+            continue;
+
+        NetworkPriority* priority = node->GetComponent<NetworkPriority>();
+        if (priority && priority->GetAlwaysRelevant())
+        {
+            alwaysRelevantNodes_.Push(node->GetID());
+            continue;
+        }
+
+        InterestGridNode entry;
+        entry.nodeID_ = node->GetID();
+        entry.position_ = node->GetWorldPosition();
+        entry.owner_ = node->GetOwner();
+        cells_[GetCell(entry.position_)].Push(entry);
+        if (entry.owner_)
+            ownedNodes_.Push(entry);
+    }
+
+    for (HashMap<IntVector2, PODVector<InterestGridNode> >::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        if (i->second_.Empty())
+            i = cells_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+void InterestGrid::GetRelevantNodes(Connection* connection, const Vector3& position, const HashSet<unsigned>& previous,
+    HashSet<unsigned>& dest) const
+{
+    dest.Clear();
+
+    float enterDistanceSquared = relevanceDistance_ * relevanceDistance_;
+    float exitDistance = relevanceDistance_ + exitMargin_;
+    float exitDistanceSquared = exitDistance * exitDistance;
+
+    IntVector2 minCell = GetCell(position - Vector3(exitDistance, 0.0f, exitDistance));
+    IntVector2 maxCell = GetCell(position + Vector3(exitDistance, 0.0f, exitDistance));
+    unsigned long long numRangeCells = (unsigned long long)(maxCell.x_ - minCell.x_ + 1) * (maxCell.y_ - minCell.y_ + 1);
+
+    // Look up the cells in range, or go through all nonempty cells if that is fewer
+    PODVector<const PODVector<InterestGridNode>*> rangeCells;
+    if (numRangeCells <= cells_.Size())
+    {
+        for (int z = minCell.y_; z <= maxCell.y_; ++z)
+        {
+            for (int x = minCell.x_; x <= maxCell.x_; ++x)
+            {
+                HashMap<IntVector2, PODVector<InterestGridNode> >::ConstIterator i = cells_.Find(IntVector2(x, z));
+                if (i != cells_.End())
+                    rangeCells.Push(&i->second_);
+            }
+        }
+    }
+    else
+    {
+        for (HashMap<IntVector2, PODVector<InterestGridNode> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            if (i->first_.x_ >= minCell.x_ && i->first_.x_ <= maxCell.x_ && i->first_.y_ >= minCell.y_ &&
+                i->first_.y_ <= maxCell.y_)
+                rangeCells.Push(&i->second_);
+        }
+    }
+
+    for (PODVector<const PODVector<InterestGridNode>*>::ConstIterator i = rangeCells.Begin(); i != rangeCells.End(); ++i)
+    {
+        const PODVector<InterestGridNode>& cell = **i;
+        for (PODVector<InterestGridNode>::ConstIterator j = cell.Begin(); j != cell.End(); ++j)
+        {
+            float dx = j->position_.x_ - position.x_;
+            float dz = j->position_.z_ - position.z_;
+            float distanceSquared = dx * dx + dz * dz;
+            if (distanceSquared <= enterDistanceSquared || (distanceSquared <= exitDistanceSquared && previous.Contains(j->nodeID_)))
+                dest.Insert(j->nodeID_);
+        }
+    }
+
+    for (PODVector<unsigned>::ConstIterator i = alwaysRelevantNodes_.Begin(); i != alwaysRelevantNodes_.End(); ++i)
+        dest.Insert(*i);
+
+    // Owned nodes are always relevant to their owner
+    for (PODVector<InterestGridNode>::ConstIterator i = ownedNodes_.Begin(); i != ownedNodes_.End(); ++i)
+    {
+        if (i->owner_ == connection)
+            dest.Insert(i->nodeID_);
+    }
+}
+
+void InterestGrid::OnSceneSet(Scene* scene)
+{
+    cells_.Clear();
+    alwaysRelevantNodes_.Clear();
+    ownedNodes_.Clear();
+}
+
+}
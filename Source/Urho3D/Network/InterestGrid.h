@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Connection;
+
+/// Replicated root node entry in the interest grid.
+struct InterestGridNode
+{
+    /// Node ID.
+    unsigned nodeID_;
+    /// World position.
+    Vector3 position_;
+    /// Owner connection.
+    Connection* owner_;
+};
+
+/// %Network interest management grid. When placed in the scene, root level replicated nodes are bucketed into horizontal grid cells, and each client is sent only the nodes (with their children) within relevance distance of its observer position. Clients that do not send an observer position receive all nodes.
+class URHO3D_API InterestGrid : public Component
+{
+    URHO3D_OBJECT(InterestGrid, Component);
+
+public:
+    /// Construct.
+    InterestGrid(Context* context);
+    /// Destruct.
+    virtual ~InterestGrid() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set grid cell size. Default 50.
+    void SetCellSize(float size);
+    /// Set distance within which nodes become relevant to a client. Default 200.
+    void SetRelevanceDistance(float distance);
+    /// Set additional distance a relevant node may move away before it is removed from a client, to avoid thrashing at the boundary. Default 20.
+    void SetExitMargin(float margin);
+
+    /// Return grid cell size.
+    float GetCellSize() const { return cellSize_; }
+    /// Return relevance distance.
+    float GetRelevanceDistance() const { return relevanceDistance_; }
+    /// Return exit margin.
+    float GetExitMargin() const { return exitMargin_; }
+    /// Return number of nonempty grid cells.
+    unsigned GetNumCells() const { return cells_.Size(); }
+
+    /// Rebuild the grid from the scene's root level replicated nodes. Called by Network before building server updates.
+    void UpdateGrid();
+    /// Return IDs of root level nodes relevant to a client at the observer position. Previously relevant nodes are kept until they move beyond the exit margin. Called by Connection, possibly from worker threads.
+    void GetRelevantNodes(Connection* connection, const Vector3& position, const HashSet<unsigned>& previous, HashSet<unsigned>& dest) const;
+
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene) override;
+
+private:
+    /// Return grid cell at world position.
+    IntVector2 GetCell(const Vector3& position) const
+    {
+        return IntVector2(FloorToInt(position.x_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+    }
+
+    /// Root level nodes by grid cell.
+    HashMap<IntVector2, PODVector<InterestGridNode> > cells_;
+    /// Root level nodes that are relevant to all clients.
+    PODVector<unsigned> alwaysRelevantNodes_;
+    /// Root level nodes that have an owner connection.
+    PODVector<InterestGridNode> ownedNodes_;
+    /// Grid cell size.
+    float cellSize_;
+    /// Relevance distance.
+    float relevanceDistance_;
+    /// Exit margin.
+    float exitMargin_;
+};
+
+}
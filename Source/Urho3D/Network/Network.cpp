@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -32,6 +33,7 @@
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestGrid.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -46,14 +48,23 @@ namespace Urho3D
 {
 
 static const int DEFAULT_UPDATE_FPS = 30;
+static const float DEFAULT_SNAPSHOT_QUANTIZATION = 1.0f / 1024.0f;
+
+static void BuildServerUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    Connection* connection = reinterpret_cast<Connection*>(item->start_);
+    connection->BuildServerUpdate();
+}
 
 Network::Network(Context* context) :
     Object(context),
     updateFps_(DEFAULT_UPDATE_FPS),
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
+    snapshotQuantization_(DEFAULT_SNAPSHOT_QUANTIZATION),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
-    updateAcc_(0.0f)
+    updateAcc_(0.0f),
+    snapshotReplication_(false)
 {
     network_ = new kNet::Network();
 
@@ -351,6 +362,16 @@ void Network::SetSimulatedPacketLoss(float loss)
     ConfigureNetworkSimulator();
 }
 
+void Network::SetSnapshotReplication(bool enable)
+{
+    snapshotReplication_ = enable;
+}
+
+void Network::SetSnapshotQuantization(float step)
+{
+    snapshotQuantization_ = Max(step, 0.0f);
+}
+
 void Network::RegisterRemoteEvent(StringHash eventType)
 {
     if (blacklistedRemoteEvents_.Find(eventType) != blacklistedRemoteEvents_.End())
@@ -508,9 +529,50 @@ void Network::PostUpdate(float timeStep)
                 }
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+                {
                     (*i)->PrepareNetworkUpdate();
+
+                    InterestGrid* grid = (*i)->GetComponent<InterestGrid>();
+                    if (grid && grid->IsEnabledEffective())
+                        grid->UpdateGrid();
+                }
             }
 
+            WorkQueue* queue = GetSubsystem<WorkQueue>();
+            if (queue && queue->GetNumThreads() && clientConnections_.Size() > 1 && !queue->IsCompleting())
+            {
+                {
+                    URHO3D_PROFILE(BuildServerUpdate);
+
+                    // The scenes are not modified until the updates have been built, so each client connection can walk
+                    // its dirty nodes in a worker thread
+                    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+                         i != clientConnections_.End(); ++i)
+                    {
+                        SharedPtr<WorkItem> item = queue->GetFreeItem();
+                        item->priority_ = M_MAX_UNSIGNED;
+                        item->workFunction_ = BuildServerUpdateWork;
+                        item->start_ = i->second_.Get();
+                        queue->AddWorkItem(item);
+                    }
+
+                    queue->Complete(M_MAX_UNSIGNED);
+                }
+
+                {
+                    URHO3D_PROFILE(SendServerUpdate);
+
+                    // Messages are queued to kNet in the main thread
+                    for (HashMap<kNet::MessageConnection*, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
+                         i != clientConnections_.End(); ++i)
+                    {
+                        i->second_->SendBufferedServerUpdate();
+                        i->second_->SendRemoteEvents();
+                        i->second_->SendPackages();
+                    }
+                }
+            }
+            else
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
@@ -596,6 +658,7 @@ void Network::ConfigureNetworkSimulator()
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
+    InterestGrid::RegisterObject(context);
 }
 
 }
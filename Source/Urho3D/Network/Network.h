@@ -91,6 +91,10 @@ public:
     void SetSimulatedLatency(int ms);
     /// Set simulated packet loss probability between 0.0 - 1.0.
     void SetSimulatedPacketLoss(float probability);
+    /// Set whether latest data attributes, such as node transforms, are sent to clients as unreliable delta-compressed snapshots against the last acknowledged baseline, instead of per-object reliable messages. Structural changes and other attributes are still sent reliably. Default false.
+    void SetSnapshotReplication(bool enable);
+    /// Set quantization step for float values in snapshots. A power of two step keeps the low mantissa bits zero, which compresses the deltas better. Zero disables quantization. Default 1/1024.
+    void SetSnapshotQuantization(float step);
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
     /// Unregister a remote event as allowed to received.
@@ -115,6 +119,12 @@ public:
     /// Return simulated packet loss probability.
     float GetSimulatedPacketLoss() const { return simulatedPacketLoss_; }
 
+    /// Return whether latest data attributes are sent as delta-compressed snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
+    /// Return quantization step for float values in snapshots.
+    float GetSnapshotQuantization() const { return snapshotQuantization_; }
+
     /// Return a client or server connection by kNet MessageConnection, or null if none exist.
     Connection* GetConnection(kNet::MessageConnection* connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -164,12 +174,16 @@ private:
     int simulatedLatency_;
     /// Simulated packet loss probability between 0.0 - 1.0.
     float simulatedPacketLoss_;
+    /// Snapshot quantization step.
+    float snapshotQuantization_;
     /// Update time interval.
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
     /// Package cache directory.
     String packageCacheDir_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
 };
 
 /// Register Network library objects.
@@ -63,10 +63,18 @@ static const int MSG_REMOTEEVENT = 0x14;
 static const int MSG_REMOTENODEEVENT = 0x15;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x16;
+/// Server->client: unreliable delta-compressed snapshot fragment of latest data attributes.
+static const int MSG_SNAPSHOT = 0x17;
+/// Client->server: acknowledge a fully received snapshot.
+static const int MSG_SNAPSHOTACK = 0x18;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+/// Maximum snapshot fragment message size including its header, to keep the unreliable messages within one datagram.
+static const unsigned SNAPSHOT_FRAGMENT_SIZE = 1024;
+/// Number of snapshots kept as possible delta compression baselines.
+static const unsigned SNAPSHOT_HISTORY_SIZE = 32;
 
 }
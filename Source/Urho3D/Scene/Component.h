@@ -45,6 +45,7 @@ enum AutoRemoveMode
 class URHO3D_API Component : public Animatable
 {
     URHO3D_OBJECT(Component, Animatable);
+    URHO3D_POOL_ALLOCATION;
 
     friend class Node;
     friend class Scene;
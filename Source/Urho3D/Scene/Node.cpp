@@ -832,10 +832,17 @@ void Node::AddChild(Node* node, unsigned index)
 
     // Add to the child vector, then add to the scene if not added yet
     children_.Insert(index, nodeShared);
-    if (scene_ && node->GetScene() != scene_)
+    bool addedToScene = scene_ && node->GetScene() != scene_;
+    if (addedToScene)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    // Now that the node is attached, connections using interest management can tell whether it is in their scope. When
+    // reparented within the scene, the new root level node may be in scope for clients that do not have the node yet
+    if (addedToScene)
+        scene_->MarkReplicationDirty(node, true);
+    else if (scene_ && oldParent)
+        scene_->MarkReplicationDirty(node, true, true);
     node->MarkDirty();
     node->MarkNetworkUpdate();
     // If the child node has components, also mark network update on them to ensure they have a valid NetworkState
@@ -73,6 +73,7 @@ struct URHO3D_API NodeImpl
 class URHO3D_API Node : public Animatable
 {
     URHO3D_OBJECT(Node, Animatable);
+    URHO3D_POOL_ALLOCATION;
 
     friend class Connection;
 
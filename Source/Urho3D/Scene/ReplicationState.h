@@ -192,15 +192,28 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
 /// Per-user scene network replication state.
 struct URHO3D_API SceneReplicationState : public ReplicationState
 {
+    /// Construct.
+    SceneReplicationState() :
+        ReplicationState(),
+        scopeActive_(false)
+    {
+    }
+
     /// Nodes by ID.
     HashMap<unsigned, NodeReplicationState> nodeStates_;
     /// Dirty node IDs.
     HashSet<unsigned> dirtyNodes_;
+    /// Root level node IDs in scope when interest management is active.
+    HashSet<unsigned> scopeNodes_;
+    /// Interest management active flag. When active, nodes out of scope are not marked dirty.
+    bool scopeActive_;
 
     void Clear()
     {
         nodeStates_.Clear();
         dirtyNodes_.Clear();
+        scopeNodes_.Clear();
+        scopeActive_ = false;
     }
 };
 
@@ -1106,6 +1106,14 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.Clear();
     networkUpdateComponents_.Clear();
+
+    // Connections read world positions for update priority while building their updates, possibly in worker threads.
+    // Update dirty world transforms now so that they are only read from there
+    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    {
+        if (i->second_->IsDirty())
+            i->second_->GetWorldTransform();
+    }
 }
 
 void Scene::CleanupConnection(Connection* connection)
@@ -1147,19 +1155,40 @@ void Scene::MarkNetworkUpdate(Component* component)
     }
 }
 
-void Scene::MarkReplicationDirty(Node* node)
+void Scene::MarkReplicationDirty(Node* node, bool recursive, bool scopedOnly)
 {
-    unsigned id = node->GetID();
+    if (!networkState_ || networkState_->replicationStates_.Empty())
+        return;
 
-    if (id < FIRST_LOCAL_ID && networkState_)
+    unsigned id = node->GetID();
+    if (id < FIRST_LOCAL_ID)
     {
+        // Interest management decides relevance by the root level node. A node that is still being added has no parent yet;
+        // Node::AddChild() marks it again once attached
+        Node* root = node;
+        while (root->GetParent() && root->GetParent() != this)
+            root = root->GetParent();
+        bool attached = root == this || root->GetParent() == this;
+
         for (PODVector<ReplicationState*>::Iterator i = networkState_->replicationStates_.Begin();
              i != networkState_->replicationStates_.End(); ++i)
         {
-            NodeReplicationState* nodeState = static_cast<NodeReplicationState*>(*i);
-            nodeState->sceneState_->dirtyNodes_.Insert(id);
+            // Skip connections the node is out of scope for, unless the client already has it
+            SceneReplicationState* sceneState = static_cast<NodeReplicationState*>(*i)->sceneState_;
+            if (scopedOnly && !sceneState->scopeActive_)
+                continue;
+            if (!sceneState->scopeActive_ || sceneState->nodeStates_.Contains(id) || (attached &&
+                (root == this || sceneState->scopeNodes_.Contains(root->GetID()))))
+                sceneState->dirtyNodes_.Insert(id);
         }
     }
+
+    if (recursive)
+    {
+        const Vector<SharedPtr<Node> >& children = node->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+            MarkReplicationDirty(*i, true, scopedOnly);
+    }
 }
 
 void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
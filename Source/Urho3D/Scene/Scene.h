@@ -245,7 +245,7 @@ public:
     void SetVarNamesAttr(const String& value);
     /// Return node user variable reverse mappings.
     String GetVarNamesAttr() const;
-    /// Prepare network update by comparing attributes and marking replication states dirty as necessary.
+    /// Prepare network update by comparing attributes and marking replication states dirty as necessary. Also resolves the world transforms of replicated nodes, so that connections can read them from worker threads.
     void PrepareNetworkUpdate();
     /// Clean up all references to a network connection that is about to be removed.
     void CleanupConnection(Connection* connection);
@@ -253,8 +253,10 @@ public:
     void MarkNetworkUpdate(Node* node);
     /// Mark a component for attribute check on the next network update.
     void MarkNetworkUpdate(Component* component);
-    /// Mark a node dirty in scene replication states. The node does not need to have own replication state yet.
-    void MarkReplicationDirty(Node* node);
+    /// Mark a node, and optionally its children, dirty in scene replication states. The node does not need to have own replication state yet. Connections using interest management skip nodes out of their scope. Optionally mark only in connections using interest management.
+    void MarkReplicationDirty(Node* node, bool recursive = false, bool scopedOnly = false);
+    /// Return mutex for adding and removing replication states while connections build their updates in worker threads.
+    Mutex& GetReplicationMutex() { return replicationMutex_; }
 
 private:
     /// Handle the logic update event to update the scene, if active.
@@ -304,6 +306,8 @@ private:
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
+    /// Mutex for replication states during threaded network updates.
+    Mutex replicationMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
     /// Next free non-local node ID.
@@ -185,6 +185,7 @@ void Cursor::SetShape(const String& shape)
     CursorShapeInfo& info = shapeInfos_[shape_];
     texture_ = info.texture_;
     imageRect_ = info.imageRect_;
+    MarkBatchesDirty();
     SetSize(info.imageRect_.Size());
 
     // To avoid flicker, the UI subsystem will apply the OS shape once per frame. Exception: if we are using the
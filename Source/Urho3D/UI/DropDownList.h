@@ -46,6 +46,8 @@ public:
     virtual void ApplyAttributes() override;
     /// Return UI rendering batches.
     virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the rendering batches can be cached. The placeholder draws the selected item, so never cache.
+    virtual bool CanCacheBatches() const override { return false; }
     /// React to the popup being shown.
     virtual void OnShowPopup() override;
     /// React to the popup being hidden.
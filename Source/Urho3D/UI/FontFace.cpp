@@ -41,7 +41,8 @@ FontGlyph::FontGlyph() :
 }
 
 FontFace::FontFace(Font* font) :
-    font_(font)
+    font_(font),
+    revision_(0)
 {
 }
 
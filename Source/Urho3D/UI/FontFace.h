@@ -96,6 +96,9 @@ public:
     /// Return textures.
     const Vector<SharedPtr<Texture2D> >& GetTextures() const { return textures_; }
 
+    /// Return glyph revision. Incremented when glyphs become resident in or are evicted from the textures, so that text using the face knows to update its layout.
+    unsigned GetRevision() const { return revision_; }
+
 protected:
     friend class FontFaceBitmap;
     /// Create a texture for font rendering.
@@ -115,6 +118,8 @@ protected:
     float pointSize_;
     /// Row height.
     float rowHeight_;
+    /// Glyph revision.
+    unsigned revision_;
 };
 
 }
@@ -23,11 +23,17 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/CoreEvents.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Texture2D.h"
+#include "../IO/Compression.h"
+#include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
+#include "../Resource/Image.h"
 #include "../UI/Font.h"
 #include "../UI/FontFaceFreeType.h"
 #include "../UI/UI.h"
@@ -43,12 +49,23 @@
 namespace Urho3D
 {
 
+/// Font cache file format version.
+static const unsigned FONT_CACHE_VERSION = 1;
+/// Number of shared glyph atlas pages after which the least recently used page is evicted. Exceeded only if all pages hold glyphs used on the current frame.
+static const unsigned MAX_GLYPH_ATLAS_PAGES = 4;
+
 inline float FixedToFloat(FT_Pos value)
 {
     return value / 64.0f;
 }
 
-/// FreeType library subsystem.
+static void RasterizeGlyphsWork(const WorkItem* item, unsigned threadIndex)
+{
+    FontFaceFreeType* face = reinterpret_cast<FontFaceFreeType*>(item->aux_);
+    face->RasterizeGlyphs();
+}
+
+/// FreeType library subsystem. Also manages the glyph atlas shared by all font faces with mutable glyphs.
 class FreeTypeLibrary : public Object
 {
     URHO3D_OBJECT(FreeTypeLibrary, Object);
@@ -56,11 +73,14 @@ class FreeTypeLibrary : public Object
 public:
     /// Construct.
     FreeTypeLibrary(Context* context) :
-        Object(context)
+        Object(context),
+        frameNumber_(0)
     {
         FT_Error error = FT_Init_FreeType(&library_);
         if (error)
             URHO3D_LOGERROR("Could not initialize FreeType library");
+
+        SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(FreeTypeLibrary, HandleBeginFrame));
     }
 
     /// Destruct.
@@ -71,21 +91,169 @@ public:
 
     FT_Library GetLibrary() const { return library_; }
 
+    /// Add a font face that uses the glyph atlas.
+    void AddFace(FontFaceFreeType* face)
+    {
+        faces_.Push(face);
+        face->textures_ = textures_;
+    }
+
+    /// Remove a font face that uses the glyph atlas.
+    void RemoveFace(FontFaceFreeType* face)
+    {
+        faces_.Remove(face);
+    }
+
+    /// Mark a glyph atlas page used on the current frame.
+    void TouchPage(unsigned page)
+    {
+        if (page < pageLastUsed_.Size())
+            pageLastUsed_[page] = frameNumber_;
+    }
+
+    /// Allocate space for a glyph, evicting the least recently used page if the atlas is full. Return false on failure.
+    bool AllocateGlyph(FontFaceFreeType* face, int width, int height, unsigned& page, int& x, int& y)
+    {
+        for (unsigned i = 0; i < allocators_.Size(); ++i)
+        {
+            if (allocators_[i].Allocate(width, height, x, y))
+            {
+                page = i;
+                pageLastUsed_[i] = frameNumber_;
+                return true;
+            }
+        }
+
+        page = M_MAX_UNSIGNED;
+        if (textures_.Size() >= MAX_GLYPH_ATLAS_PAGES)
+        {
+            unsigned oldestFrame = frameNumber_;
+            for (unsigned i = 0; i < pageLastUsed_.Size(); ++i)
+            {
+                if (pageLastUsed_[i] < oldestFrame)
+                {
+                    oldestFrame = pageLastUsed_[i];
+                    page = i;
+                }
+            }
+        }
+
+        if (page < textures_.Size())
+            EvictPage(page);
+        else
+        {
+            page = textures_.Size();
+            if (!AddPage(face))
+                return false;
+        }
+
+        pageLastUsed_[page] = frameNumber_;
+        return allocators_[page].Allocate(width, height, x, y);
+    }
+
+    /// Return glyph atlas page texture.
+    Texture2D* GetTexture(unsigned page) const { return page < textures_.Size() ? textures_[page] : nullptr; }
+
 private:
+    /// Add a glyph atlas page.
+    bool AddPage(FontFaceFreeType* face)
+    {
+        int size = GetSubsystem<UI>()->GetMaxFontTextureSize();
+        SharedPtr<Image> image(new Image(context_));
+        image->SetSize(size, size, 1);
+        memset(image->GetData(), 0, (size_t)(size * size));
+
+        SharedPtr<Texture2D> texture = face->LoadFaceTexture(image);
+        if (!texture)
+            return false;
+
+        textures_.Push(texture);
+        allocators_.Push(AreaAllocator(size, size));
+        pageLastUsed_.Push(frameNumber_);
+
+        for (PODVector<FontFaceFreeType*>::Iterator i = faces_.Begin(); i != faces_.End(); ++i)
+            (*i)->textures_ = textures_;
+
+        return true;
+    }
+
+    /// Clear a glyph atlas page and mark its glyphs not resident.
+    void EvictPage(unsigned page)
+    {
+        Texture2D* texture = textures_[page];
+        int width = texture->GetWidth();
+        int height = texture->GetHeight();
+        SharedArrayPtr<unsigned char> emptyData(new unsigned char[width * height]);
+        memset(emptyData.Get(), 0, (size_t)(width * height));
+        texture->SetData(0, 0, 0, width, height, emptyData.Get());
+        allocators_[page].Reset(width, height);
+
+        for (PODVector<FontFaceFreeType*>::Iterator i = faces_.Begin(); i != faces_.End(); ++i)
+            (*i)->EvictGlyphs(page);
+    }
+
+    /// Handle frame begin event. Upload glyphs rasterized during the previous frame.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace BeginFrame;
+
+        frameNumber_ = eventData[P_FRAMENUMBER].GetUInt();
+
+        // Pages with lost texture data have to be rasterized again
+        for (unsigned i = 0; i < textures_.Size(); ++i)
+        {
+            if (textures_[i]->IsDataLost())
+            {
+                EvictPage(i);
+                textures_[i]->ClearDataLost();
+            }
+        }
+
+        for (PODVector<FontFaceFreeType*>::Iterator i = faces_.Begin(); i != faces_.End(); ++i)
+            (*i)->UpdateGlyphs();
+    }
+
     /// FreeType library.
     FT_Library library_;
+    /// Glyph atlas page textures.
+    Vector<SharedPtr<Texture2D> > textures_;
+    /// Glyph atlas page area allocators.
+    Vector<AreaAllocator> allocators_;
+    /// Frame number on which each glyph atlas page was last used.
+    PODVector<unsigned> pageLastUsed_;
+    /// Font faces using the glyph atlas.
+    PODVector<FontFaceFreeType*> faces_;
+    /// Current frame number.
+    unsigned frameNumber_;
 };
 
 FontFaceFreeType::FontFaceFreeType(Font* font) :
     FontFace(font),
     face_(nullptr),
     loadMode_(FT_LOAD_DEFAULT),
-    hasMutableGlyph_(false)
+    hasMutableGlyph_(false),
+    rasterizing_(false)
 {
 }
 
 FontFaceFreeType::~FontFaceFreeType()
 {
+    if (rasterizing_)
+    {
+        // The work item uses the FreeType face, so wait for it to finish if it was already started. If the work queue is gone,
+        // the item will never execute
+        WorkQueue* queue = font_->GetSubsystem<WorkQueue>();
+        if (queue)
+            queue->CancelWorkItem(workItem_);
+    }
+
+    if (hasMutableGlyph_)
+    {
+        freeType_->RemoveFace(this);
+        // The glyph atlas textures are shared, and not accounted in the font's memory use
+        textures_.Clear();
+    }
+
     if (face_)
     {
         FT_Done_Face((FT_Face)face_);
@@ -129,6 +297,38 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
         return false;
     }
 
+    loadMode_ = FT_LOAD_DEFAULT;
+    if (ui->GetForceAutoHint())
+    {
+        loadMode_ |= FT_LOAD_FORCE_AUTOHINT;
+    }
+    if (ui->GetFontHintLevel() == FONT_HINT_LEVEL_NONE)
+    {
+        loadMode_ |= FT_LOAD_NO_HINTING;
+    }
+    if (ui->GetFontHintLevel() == FONT_HINT_LEVEL_LIGHT)
+    {
+        loadMode_ |= FT_LOAD_TARGET_LIGHT;
+    }
+
+    pointSize_ = pointSize;
+
+    // Use pre-rasterized glyphs from the font cache if available and up to date
+    String cacheFileName;
+    unsigned checksum = 0;
+    const String& cachePath = ui->GetFontCachePath();
+    if (!cachePath.Empty())
+    {
+        for (unsigned i = 0; i < fontDataSize; ++i)
+            checksum = SDBMHash(checksum, fontData[i]);
+
+        const String& fontName = font_->GetName();
+        cacheFileName = AddTrailingSlash(cachePath) + GetFileName(fontName) + "_" + ToStringHex(StringHash(fontName).Value()) +
+            "_" + String(pointSize) + ".fontcache";
+        if (LoadCache(cacheFileName, checksum, maxTextureSize))
+            return true;
+    }
+
     error = FT_New_Memory_Face(library, fontData, fontDataSize, 0, &face);
     if (error)
     {
@@ -164,24 +364,8 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
         charCode = FT_Get_Next_Char(face, charCode, &glyphIndex);
     }
 
-    // Load each of the glyphs to see the sizes & store other information
-    loadMode_ = FT_LOAD_DEFAULT;
-    if (ui->GetForceAutoHint())
-    {
-        loadMode_ |= FT_LOAD_FORCE_AUTOHINT;
-    }
-    if (ui->GetFontHintLevel() == FONT_HINT_LEVEL_NONE)
-    {
-        loadMode_ |= FT_LOAD_NO_HINTING;
-    }
-    if (ui->GetFontHintLevel() == FONT_HINT_LEVEL_LIGHT)
-    {
-        loadMode_ |= FT_LOAD_TARGET_LIGHT;
-    }
-
     ascender_ = FixedToFloat(face->size->metrics.ascender);
     rowHeight_ = FixedToFloat(face->size->metrics.height);
-    pointSize_ = pointSize;
 
     // Check if the font's OS/2 info gives different (larger) values for ascender & descender
     TT_OS2* os2Info = (TT_OS2*)FT_Get_Sfnt_Table(face, ft_sfnt_os2);
@@ -200,31 +384,44 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
     int textureHeight = maxTextureSize;
     hasMutableGlyph_ = false;
 
-    SharedPtr<Image> image(new Image(font_->GetContext()));
-    image->SetSize(textureWidth, textureHeight, 1);
-    unsigned char* imageData = image->GetData();
-    memset(imageData, 0, (size_t)(image->GetWidth() * image->GetHeight()));
-    allocator_.Reset(FONT_TEXTURE_MIN_SIZE, FONT_TEXTURE_MIN_SIZE, textureWidth, textureHeight);
-
-    for (unsigned i = 0; i < charCodes.Size(); ++i)
+    // If the glyphs are unlikely to fit in one texture (large CJK fonts), skip rasterizing them up front and instead
+    // rasterize them on demand in the background into the shared glyph atlas
+    SharedPtr<Image> image;
+    float estimatedArea = (float)numGlyphs * rowHeight_ * rowHeight_ * oversampling_ * 0.5f;
+    if (estimatedArea > (float)textureWidth * textureHeight)
+        SetMutableGlyphs();
+    else
     {
-        unsigned charCode = charCodes[i];
-        if (charCode == 0)
-            continue;
+        image = new Image(font_->GetContext());
+        image->SetSize(textureWidth, textureHeight, 1);
+        unsigned char* imageData = image->GetData();
+        memset(imageData, 0, (size_t)(image->GetWidth() * image->GetHeight()));
+        allocator_.Reset(FONT_TEXTURE_MIN_SIZE, FONT_TEXTURE_MIN_SIZE, textureWidth, textureHeight);
 
-        if (!LoadCharGlyph(charCode, image))
+        for (unsigned i = 0; i < charCodes.Size(); ++i)
         {
-            hasMutableGlyph_ = true;
-            break;
+            unsigned charCode = charCodes[i];
+            if (charCode == 0)
+                continue;
+
+            if (!LoadCharGlyph(charCode, image))
+            {
+                image.Reset();
+                SetMutableGlyphs();
+                break;
+            }
         }
     }
 
-    SharedPtr<Texture2D> texture = LoadFaceTexture(image);
-    if (!texture)
-        return false;
+    if (image)
+    {
+        SharedPtr<Texture2D> texture = LoadFaceTexture(image);
+        if (!texture)
+            return false;
 
-    textures_.Push(texture);
-    font_->SetMemoryUse(font_->GetMemoryUse() + textureWidth * textureHeight);
+        textures_.Push(texture);
+        font_->SetMemoryUse(font_->GetMemoryUse() + textureWidth * textureHeight);
+    }
 
     // Store kerning if face has kerning information
     if (FT_HAS_KERNING(face))
@@ -300,6 +497,9 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
 
     if (!hasMutableGlyph_)
     {
+        if (!cacheFileName.Empty())
+            SaveCache(cacheFileName, checksum, maxTextureSize, image);
+
         FT_Done_Face(face);
         face_ = nullptr;
     }
@@ -314,42 +514,297 @@ const FontGlyph* FontFaceFreeType::GetGlyph(unsigned c)
     {
         FontGlyph& glyph = i->second_;
         glyph.used_ = true;
+        if (hasMutableGlyph_)
+        {
+            // Evicted glyphs keep their metrics, but have to be rasterized again before they can be drawn
+            if (glyph.page_ == M_MAX_UNSIGNED)
+                RequestGlyph(c);
+            else
+                freeType_->TouchPage(glyph.page_);
+        }
         return &glyph;
     }
 
-    if (LoadCharGlyph(c))
+    if (hasMutableGlyph_)
+        RequestGlyph(c);
+
+    return nullptr;
+}
+
+void FontFaceFreeType::RasterizeGlyphs()
+{
+    rasterizedGlyphs_.Resize(rasterizingGlyphs_.Size());
+
+    for (unsigned i = 0; i < rasterizingGlyphs_.Size(); ++i)
     {
-        HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Find(c);
-        if (i != glyphMapping_.End())
+        RasterizedGlyph& rasterized = rasterizedGlyphs_[i];
+        rasterized.charCode_ = rasterizingGlyphs_[i];
+        rasterized.data_.Reset();
+
+        FontGlyph& fontGlyph = rasterized.glyph_;
+        if (RenderCharGlyph(rasterized.charCode_, fontGlyph))
         {
-            FontGlyph& glyph = i->second_;
-            glyph.used_ = true;
-            return &glyph;
+            unsigned size = (unsigned)(fontGlyph.texWidth_ * fontGlyph.texHeight_);
+            rasterized.data_ = new unsigned char[size];
+            memset(rasterized.data_.Get(), 0, size);
+            CopyCharGlyph(fontGlyph, rasterized.data_.Get(), (unsigned)fontGlyph.texWidth_);
         }
     }
+}
 
-    return nullptr;
+void FontFaceFreeType::RequestGlyph(unsigned charCode)
+{
+    if (face_)
+        pendingGlyphs_.Insert(charCode);
 }
 
-bool FontFaceFreeType::SetupNextTexture(int textureWidth, int textureHeight)
+void FontFaceFreeType::UpdateGlyphs()
 {
+    if (rasterizing_)
+    {
+        if (!workItem_->completed_)
+            return;
+
+        // Upload the glyphs rasterized during the previous frame
+        for (unsigned i = 0; i < rasterizedGlyphs_.Size(); ++i)
+        {
+            RasterizedGlyph& rasterized = rasterizedGlyphs_[i];
+            FontGlyph& fontGlyph = rasterized.glyph_;
+            fontGlyph.x_ = 0;
+            fontGlyph.y_ = 0;
+            fontGlyph.page_ = 0;
+
+            if (rasterized.data_)
+            {
+                unsigned page;
+                int x, y;
+                if (freeType_->AllocateGlyph(this, fontGlyph.texWidth_ + 1, fontGlyph.texHeight_ + 1, page, x, y))
+                {
+                    fontGlyph.x_ = (short)x;
+                    fontGlyph.y_ = (short)y;
+                    fontGlyph.page_ = page;
+                    freeType_->GetTexture(page)->SetData(0, x, y, fontGlyph.texWidth_, fontGlyph.texHeight_, rasterized.data_.Get());
+                }
+                else
+                {
+                    // Store as empty so that the glyph is not requested again every frame
+                    URHO3D_LOGWARNINGF("FontFaceFreeType::UpdateGlyphs: failed to position char code %u in the glyph atlas",
+                        rasterized.charCode_);
+                    fontGlyph.texWidth_ = 0;
+                    fontGlyph.texHeight_ = 0;
+                }
+
+                rasterized.data_.Reset();
+            }
+
+            glyphMapping_[rasterized.charCode_] = fontGlyph;
+        }
+
+        rasterizedGlyphs_.Clear();
+        rasterizingGlyphs_.Clear();
+        rasterizing_ = false;
+        ++revision_;
+    }
+
+    if (pendingGlyphs_.Empty())
+        return;
+
+    for (HashSet<unsigned>::ConstIterator i = pendingGlyphs_.Begin(); i != pendingGlyphs_.End(); ++i)
+    {
+        HashMap<unsigned, FontGlyph>::ConstIterator j = glyphMapping_.Find(*i);
+        if (j == glyphMapping_.End() || j->second_.page_ == M_MAX_UNSIGNED)
+            rasterizingGlyphs_.Push(*i);
+    }
+    pendingGlyphs_.Clear();
+
+    if (rasterizingGlyphs_.Empty())
+        return;
+
+    rasterizing_ = true;
+
+    WorkQueue* queue = font_->GetSubsystem<WorkQueue>();
+    if (!workItem_)
+    {
+        // Not taken from the work queue's item pool, as the item is polled across frames
+        workItem_ = new WorkItem();
+        workItem_->workFunction_ = RasterizeGlyphsWork;
+        workItem_->aux_ = this;
+        workItem_->priority_ = 0;
+    }
+    workItem_->completed_ = false;
+
+    if (queue)
+        queue->AddWorkItem(workItem_);
+    else
+    {
+        RasterizeGlyphs();
+        workItem_->completed_ = true;
+    }
+}
+
+void FontFaceFreeType::EvictGlyphs(unsigned page)
+{
+    bool evicted = false;
+    for (HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Begin(); i != glyphMapping_.End(); ++i)
+    {
+        FontGlyph& glyph = i->second_;
+        if (glyph.page_ == page && glyph.texWidth_ > 0 && glyph.texHeight_ > 0)
+        {
+            glyph.page_ = M_MAX_UNSIGNED;
+            evicted = true;
+        }
+    }
+
+    if (evicted)
+        ++revision_;
+}
+
+void FontFaceFreeType::SetMutableGlyphs()
+{
+    hasMutableGlyph_ = true;
+
+    // Glyphs rendered so far were in the discarded static texture and have to be rasterized again
+    for (HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Begin(); i != glyphMapping_.End(); ++i)
+    {
+        FontGlyph& glyph = i->second_;
+        if (glyph.texWidth_ > 0 && glyph.texHeight_ > 0)
+            glyph.page_ = M_MAX_UNSIGNED;
+    }
+
+    freeType_->AddFace(this);
+}
+
+bool FontFaceFreeType::LoadCache(const String& fileName, unsigned checksum, int textureSize)
+{
+    FileSystem* fileSystem = font_->GetSubsystem<FileSystem>();
+    if (!fileSystem || !fileSystem->FileExists(fileName))
+        return false;
+
+    File file(font_->GetContext(), fileName);
+    if (!file.IsOpen() || file.ReadFileID() != "UFCF" || file.ReadUInt() != FONT_CACHE_VERSION)
+        return false;
+
+    // The cache is only valid for the same font data and rendering settings
+    if (file.ReadUInt() != checksum || file.ReadInt() != textureSize || file.ReadInt() != loadMode_ ||
+        file.ReadInt() != oversampling_ || file.ReadBool() != subpixel_ || file.ReadFloat() != pointSize_)
+        return false;
+
+    float ascender = file.ReadFloat();
+    float rowHeight = file.ReadFloat();
+
+    HashMap<unsigned, FontGlyph> glyphMapping;
+    unsigned numGlyphs = file.ReadUInt();
+    for (unsigned i = 0; i < numGlyphs && !file.IsEof(); ++i)
+    {
+        unsigned charCode = file.ReadUInt();
+        FontGlyph& glyph = glyphMapping[charCode];
+        glyph.x_ = file.ReadShort();
+        glyph.y_ = file.ReadShort();
+        glyph.texWidth_ = file.ReadShort();
+        glyph.texHeight_ = file.ReadShort();
+        glyph.width_ = file.ReadFloat();
+        glyph.height_ = file.ReadFloat();
+        glyph.offsetX_ = file.ReadFloat();
+        glyph.offsetY_ = file.ReadFloat();
+        glyph.advanceX_ = file.ReadFloat();
+        glyph.page_ = 0;
+    }
+
+    HashMap<unsigned, float> kerningMapping;
+    unsigned numKerningPairs = file.ReadUInt();
+    for (unsigned i = 0; i < numKerningPairs && !file.IsEof(); ++i)
+    {
+        unsigned key = file.ReadUInt();
+        kerningMapping[key] = file.ReadFloat();
+    }
+
+    int width = file.ReadInt();
+    int height = file.ReadInt();
+    if (width <= 0 || height <= 0 || file.IsEof())
+        return false;
+
     SharedPtr<Image> image(new Image(font_->GetContext()));
-    image->SetSize(textureWidth, textureHeight, 1);
-    unsigned char* imageData = image->GetData();
-    memset(imageData, 0, (size_t)(image->GetWidth() * image->GetHeight()));
+    image->SetSize(width, height, 1);
+    VectorBuffer imageData;
+    if (!DecompressStream(imageData, file) || imageData.GetSize() != (unsigned)(width * height))
+    {
+        URHO3D_LOGWARNING("Corrupted font cache file " + fileName);
+        return false;
+    }
+    image->SetData(imageData.GetData());
 
     SharedPtr<Texture2D> texture = LoadFaceTexture(image);
     if (!texture)
         return false;
 
+    ascender_ = ascender;
+    rowHeight_ = rowHeight;
+    glyphMapping_ = glyphMapping;
+    kerningMapping_ = kerningMapping;
+    hasMutableGlyph_ = false;
     textures_.Push(texture);
-    allocator_.Reset(FONT_TEXTURE_MIN_SIZE, FONT_TEXTURE_MIN_SIZE, textureWidth, textureHeight);
-
-    font_->SetMemoryUse(font_->GetMemoryUse() + textureWidth * textureHeight);
+    font_->SetMemoryUse(font_->GetMemoryUse() + width * height);
 
+    URHO3D_LOGDEBUG("Loaded font face from cache " + fileName);
     return true;
 }
 
+void FontFaceFreeType::SaveCache(const String& fileName, unsigned checksum, int textureSize, Image* image) const
+{
+    if (!image)
+        return;
+
+    FileSystem* fileSystem = font_->GetSubsystem<FileSystem>();
+    if (fileSystem)
+        fileSystem->CreateDir(GetPath(fileName));
+
+    File file(font_->GetContext(), fileName, FILE_WRITE);
+    if (!file.IsOpen())
+    {
+        URHO3D_LOGWARNING("Could not write font cache file " + fileName);
+        return;
+    }
+
+    file.WriteFileID("UFCF");
+    file.WriteUInt(FONT_CACHE_VERSION);
+    file.WriteUInt(checksum);
+    file.WriteInt(textureSize);
+    file.WriteInt(loadMode_);
+    file.WriteInt(oversampling_);
+    file.WriteBool(subpixel_);
+    file.WriteFloat(pointSize_);
+    file.WriteFloat(ascender_);
+    file.WriteFloat(rowHeight_);
+
+    file.WriteUInt(glyphMapping_.Size());
+    for (HashMap<unsigned, FontGlyph>::ConstIterator i = glyphMapping_.Begin(); i != glyphMapping_.End(); ++i)
+    {
+        const FontGlyph& glyph = i->second_;
+        file.WriteUInt(i->first_);
+        file.WriteShort(glyph.x_);
+        file.WriteShort(glyph.y_);
+        file.WriteShort(glyph.texWidth_);
+        file.WriteShort(glyph.texHeight_);
+        file.WriteFloat(glyph.width_);
+        file.WriteFloat(glyph.height_);
+        file.WriteFloat(glyph.offsetX_);
+        file.WriteFloat(glyph.offsetY_);
+        file.WriteFloat(glyph.advanceX_);
+    }
+
+    file.WriteUInt(kerningMapping_.Size());
+    for (HashMap<unsigned, float>::ConstIterator i = kerningMapping_.Begin(); i != kerningMapping_.End(); ++i)
+    {
+        file.WriteUInt(i->first_);
+        file.WriteFloat(i->second_);
+    }
+
+    file.WriteInt(image->GetWidth());
+    file.WriteInt(image->GetHeight());
+    MemoryBuffer imageData(image->GetData(), (unsigned)(image->GetWidth() * image->GetHeight()));
+    CompressStream(file, imageData);
+}
+
 void FontFaceFreeType::BoxFilter(unsigned char* dest, size_t destSize, const unsigned char* src, size_t srcSize)
 {
     const int filterSize = oversampling_;
@@ -409,15 +864,11 @@ void FontFaceFreeType::BoxFilter(unsigned char* dest, size_t destSize, const uns
     }
 }
 
-bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
+bool FontFaceFreeType::RenderCharGlyph(unsigned charCode, FontGlyph& fontGlyph)
 {
-    if (!face_)
-        return false;
-
     FT_Face face = (FT_Face)face_;
     FT_GlyphSlot slot = face->glyph;
 
-    FontGlyph fontGlyph;
     FT_Error error = FT_Load_Char(face, charCode, loadMode_ | FT_LOAD_RENDER);
     if (error)
     {
@@ -458,77 +909,55 @@ bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
         fontGlyph.advanceX_ /= oversampling_;
     }
 
-    int x = 0, y = 0;
-    if (fontGlyph.texWidth_ > 0 && fontGlyph.texHeight_ > 0)
-    {
-        if (!allocator_.Allocate(fontGlyph.texWidth_ + 1, fontGlyph.texHeight_ + 1, x, y))
-        {
-            if (image)
-            {
-                // We're rendering into a fixed image and we ran out of room.
-                return false;
-            }
-
-            int w = allocator_.GetWidth();
-            int h = allocator_.GetHeight();
-            if (!SetupNextTexture(w, h))
-            {
-                URHO3D_LOGWARNINGF("FontFaceFreeType::LoadCharGlyph: failed to allocate new %dx%d texture", w, h);
-                return false;
-            }
-
-            if (!allocator_.Allocate(fontGlyph.texWidth_ + 1, fontGlyph.texHeight_ + 1, x, y))
-            {
-                URHO3D_LOGWARNINGF("FontFaceFreeType::LoadCharGlyph: failed to position char code %u in blank page", charCode);
-                return false;
-            }
-        }
+    return fontGlyph.texWidth_ > 0 && fontGlyph.texHeight_ > 0;
+}
 
-        fontGlyph.x_ = (short)x;
-        fontGlyph.y_ = (short)y;
+void FontFaceFreeType::CopyCharGlyph(const FontGlyph& fontGlyph, unsigned char* dest, unsigned pitch)
+{
+    FT_GlyphSlot slot = ((FT_Face)face_)->glyph;
 
-        unsigned char* dest = nullptr;
-        unsigned pitch = 0;
-        if (image)
+    if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+    {
+        for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
         {
-            fontGlyph.page_ = 0;
-            dest = image->GetData() + fontGlyph.y_ * image->GetWidth() + fontGlyph.x_;
-            pitch = (unsigned)image->GetWidth();
+            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* rowDest = dest + (oversampling_ - 1)/2 + y * pitch;
+
+            // Don't do any oversampling, just unpack the bits directly.
+            for (unsigned x = 0; x < (unsigned)slot->bitmap.width; ++x)
+                rowDest[x] = (unsigned char)((src[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0);
         }
-        else
+    }
+    else
+    {
+        for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
         {
-            fontGlyph.page_ = textures_.Size() - 1;
-            dest = new unsigned char[fontGlyph.texWidth_ * fontGlyph.texHeight_];
-            pitch = (unsigned)fontGlyph.texWidth_;
+            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* rowDest = dest + y * pitch;
+            BoxFilter(rowDest, fontGlyph.texWidth_, src, slot->bitmap.width);
         }
+    }
+}
 
-        if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
-        {
-            for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
-            {
-                unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
-                unsigned char* rowDest = dest + (oversampling_ - 1)/2 + y * pitch;
+bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
+{
+    if (!face_)
+        return false;
 
-                // Don't do any oversampling, just unpack the bits directly.
-                for (unsigned x = 0; x < (unsigned)slot->bitmap.width; ++x)
-                    rowDest[x] = (unsigned char)((src[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0);
-            }
-        }
-        else
-        {
-            for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
-            {
-                unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
-                unsigned char* rowDest = dest + y * pitch;
-                BoxFilter(rowDest, fontGlyph.texWidth_, src, slot->bitmap.width);
-            }
-        }
+    FontGlyph fontGlyph;
+    if (RenderCharGlyph(charCode, fontGlyph))
+    {
+        int x = 0, y = 0;
+        // We're rendering into a fixed image; fail if we ran out of room.
+        if (!allocator_.Allocate(fontGlyph.texWidth_ + 1, fontGlyph.texHeight_ + 1, x, y))
+            return false;
 
-        if (!image)
-        {
-            textures_.Back()->SetData(0, fontGlyph.x_, fontGlyph.y_, fontGlyph.texWidth_, fontGlyph.texHeight_, dest);
-            delete[] dest;
-        }
+        fontGlyph.x_ = (short)x;
+        fontGlyph.y_ = (short)y;
+        fontGlyph.page_ = 0;
+
+        unsigned pitch = (unsigned)image->GetWidth();
+        CopyCharGlyph(fontGlyph, image->GetData() + fontGlyph.y_ * pitch + fontGlyph.x_, pitch);
     }
     else
     {
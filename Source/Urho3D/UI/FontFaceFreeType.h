@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/HashSet.h"
 #include "../UI/FontFace.h"
 
 namespace Urho3D
@@ -29,10 +30,24 @@ namespace Urho3D
 
 class FreeTypeLibrary;
 class Texture2D;
+struct WorkItem;
+
+/// Glyph rasterized in the background, waiting to be uploaded to the glyph atlas.
+struct RasterizedGlyph
+{
+    /// Character code.
+    unsigned charCode_;
+    /// Glyph metrics. Position within texture is filled on upload.
+    FontGlyph glyph_;
+    /// Glyph bitmap, texWidth_ * texHeight_ bytes.
+    SharedArrayPtr<unsigned char> data_;
+};
 
 /// Free type font face description.
 class URHO3D_API FontFaceFreeType : public FontFace
 {
+    friend class FreeTypeLibrary;
+
 public:
     /// Construct.
     FontFaceFreeType(Font* font);
@@ -44,14 +59,31 @@ public:
     /// Return pointer to the glyph structure corresponding to a character. Return null if glyph not found.
     virtual const FontGlyph* GetGlyph(unsigned c) override;
 
-    /// Return if font face uses mutable glyphs.
+    /// Return if font face uses mutable glyphs, which are rasterized on demand into the shared glyph atlas.
     virtual bool HasMutableGlyphs() const override { return hasMutableGlyph_; }
 
+    /// Rasterize the glyphs queued for the background work item. Called from a worker thread.
+    void RasterizeGlyphs();
+
 private:
-    /// Setup next texture.
-    bool SetupNextTexture(int textureWidth, int textureHeight);
-    /// Load char glyph.
-    bool LoadCharGlyph(unsigned charCode, Image* image = nullptr);
+    /// Render a char glyph with FreeType and fill its metrics, except position within texture. Return true if the glyph has a non-empty bitmap.
+    bool RenderCharGlyph(unsigned charCode, FontGlyph& fontGlyph);
+    /// Copy the bitmap of the last rendered char glyph.
+    void CopyCharGlyph(const FontGlyph& fontGlyph, unsigned char* dest, unsigned pitch);
+    /// Rasterize a char glyph into the fixed face image. Return false if out of room.
+    bool LoadCharGlyph(unsigned charCode, Image* image);
+    /// Queue a glyph for background rasterization.
+    void RequestGlyph(unsigned charCode);
+    /// Upload glyphs rasterized in the background and start rasterizing the next queued glyphs. Called by the FreeType library subsystem at the beginning of each frame.
+    void UpdateGlyphs();
+    /// Mark the glyphs on an evicted glyph atlas page as not resident.
+    void EvictGlyphs(unsigned page);
+    /// Switch to rasterizing glyphs on demand into the shared glyph atlas.
+    void SetMutableGlyphs();
+    /// Load the pre-rasterized face from the font cache file. Return true if successful.
+    bool LoadCache(const String& fileName, unsigned checksum, int textureSize);
+    /// Save the pre-rasterized face to the font cache file.
+    void SaveCache(const String& fileName, unsigned checksum, int textureSize, Image* image) const;
     /// Smooth one row of a horizontally oversampled glyph image.
     void BoxFilter(unsigned char* dest, size_t destSize, const unsigned char* src, size_t srcSize);
 
@@ -71,6 +103,16 @@ private:
     bool hasMutableGlyph_;
     /// Glyph area allocator.
     AreaAllocator allocator_;
+    /// Background rasterization work item.
+    SharedPtr<WorkItem> workItem_;
+    /// Glyphs waiting to be rasterized.
+    HashSet<unsigned> pendingGlyphs_;
+    /// Glyphs being rasterized by the work item.
+    PODVector<unsigned> rasterizingGlyphs_;
+    /// Glyphs rasterized by the work item.
+    Vector<RasterizedGlyph> rasterizedGlyphs_;
+    /// Work item in progress flag.
+    bool rasterizing_;
 };
 
 }
@@ -171,7 +171,13 @@ ListView::ListView(Context* context) :
     hierarchyMode_(true),    // Init to true here so that the setter below takes effect
     baseIndent_(0),
     clearSelectionOnDefocus_(false),
-    selectOnClickEnd_(false)
+    selectOnClickEnd_(false),
+    virtualMode_(false),
+    numVirtualItems_(0),
+    virtualItemHeight_(0),
+    measuredItemHeight_(0),
+    virtualItemType_(Text::GetTypeStatic()),
+    updatingVirtualItems_(false)
 {
     resizeContentWidth_ = true;
 
@@ -203,6 +209,8 @@ void ListView::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Base Indent", GetBaseIndent, SetBaseIndent, int, 0, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Clear Sel. On Defocus", GetClearSelectionOnDefocus, SetClearSelectionOnDefocus, bool, false, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Select On Click End", GetSelectOnClickEnd, SetSelectOnClickEnd, bool, false, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Virtual Mode", GetVirtualMode, SetVirtualMode, bool, false, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Virtual Item Height", GetVirtualItemHeight, SetVirtualItemHeight, int, 0, AM_FILE);
 }
 
 void ListView::OnKey(int key, int buttons, int qualifiers)
@@ -262,6 +270,14 @@ void ListView::OnKey(int key, int buttons, int qualifiers)
                 // Convert page step to pixels and see how many items have to be skipped to reach that many pixels
                 if (selection == M_MAX_UNSIGNED)
                     selection = 0;      // Assume as if first item is selected
+                if (virtualMode_)
+                {
+                    // All virtual items have the same height, so the item count can be calculated directly
+                    int itemHeight = Max(GetVirtualItemHeight(), 1);
+                    int stepPixels = ((int)(pageStep_ * scrollPanel_->GetHeight())) - itemHeight;
+                    delta = pageDirection * Max(stepPixels / itemHeight, 0);
+                    break;
+                }
                 int stepPixels = ((int)(pageStep_ * scrollPanel_->GetHeight())) - contentElement_->GetChild(selection)->GetHeight();
                 unsigned newSelection = selection;
                 unsigned okSelection = selection;
@@ -321,6 +337,8 @@ void ListView::OnResize(const IntVector2& newSize, const IntVector2& delta)
     // When in hierarchy mode also need to resize the overlay container
     if (hierarchyMode_)
         overlayContainer_->SetSize(scrollPanel_->GetSize());
+
+    UpdateVirtualItems();
 }
 
 void ListView::AddItem(UIElement* item)
@@ -333,6 +351,12 @@ void ListView::InsertItem(unsigned index, UIElement* item, UIElement* parentItem
     if (!item || item->GetParent() == contentElement_)
         return;
 
+    if (virtualMode_)
+    {
+        URHO3D_LOGERROR("Can not insert items into a ListView in virtual mode, set the number of virtual items instead");
+        return;
+    }
+
     // Enable input so that clicking the item can be detected
     item->SetEnabled(true);
     item->SetSelected(false);
@@ -393,6 +417,12 @@ void ListView::RemoveItem(UIElement* item, unsigned index)
     if (!item)
         return;
 
+    if (virtualMode_)
+    {
+        URHO3D_LOGERROR("Can not remove items from a ListView in virtual mode, set the number of virtual items instead");
+        return;
+    }
+
     unsigned numItems = GetNumItems();
     for (unsigned i = index; i < numItems; ++i)
     {
@@ -471,6 +501,12 @@ void ListView::RemoveItem(unsigned index)
 
 void ListView::RemoveAllItems()
 {
+    if (virtualMode_)
+    {
+        SetNumVirtualItems(0);
+        return;
+    }
+
     contentElement_->DisableLayoutUpdate();
 
     ClearSelection();
@@ -497,29 +533,41 @@ void ListView::SetSelections(const PODVector<unsigned>& indices)
 
     unsigned numItems = GetNumItems();
 
-    // Remove first items that should no longer be selected
-    for (PODVector<unsigned>::Iterator i = selections_.Begin(); i != selections_.End();)
+    // Use sets for the membership tests, as virtual lists may have very large selections
+    HashSet<unsigned> newIndices;
+    for (PODVector<unsigned>::ConstIterator i = indices.Begin(); i != indices.End(); ++i)
+        newIndices.Insert(*i);
+
+    // Remove first items that should no longer be selected. Compact the selections before sending the events to avoid
+    // quadratic erasing
+    PODVector<unsigned> removed;
+    unsigned numKept = 0;
+    for (unsigned i = 0; i < selections_.Size(); ++i)
     {
-        unsigned index = *i;
-        if (!indices.Contains(index))
-        {
-            i = selections_.Erase(i);
+        if (newIndices.Contains(selections_[i]))
+            selections_[numKept++] = selections_[i];
+        else
+            removed.Push(selections_[i]);
+    }
+    selections_.Resize(numKept);
 
-            using namespace ItemSelected;
+    for (PODVector<unsigned>::ConstIterator i = removed.Begin(); i != removed.End(); ++i)
+    {
+        using namespace ItemSelected;
 
-            VariantMap& eventData = GetEventDataMap();
-            eventData[P_ELEMENT] = this;
-            eventData[P_SELECTION] = index;
-            SendEvent(E_ITEMDESELECTED, eventData);
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_ELEMENT] = this;
+        eventData[P_SELECTION] = *i;
+        SendEvent(E_ITEMDESELECTED, eventData);
 
-            if (self.Expired())
-                return;
-        }
-        else
-            ++i;
+        if (self.Expired())
+            return;
     }
 
     bool added = false;
+    HashSet<unsigned> oldIndices;
+    for (PODVector<unsigned>::ConstIterator i = selections_.Begin(); i != selections_.End(); ++i)
+        oldIndices.Insert(*i);
 
     // Then add missing items
     for (PODVector<unsigned>::ConstIterator i = indices.Begin(); i != indices.End(); ++i)
@@ -528,12 +576,13 @@ void ListView::SetSelections(const PODVector<unsigned>& indices)
         if (index < numItems)
         {
             // In singleselect mode, resend the event even for the same selection
-            bool duplicate = selections_.Contains(index);
+            bool duplicate = oldIndices.Contains(index);
             if (!duplicate || !multiselect_)
             {
                 if (!duplicate)
                 {
                     selections_.Push(index);
+                    oldIndices.Insert(index);
                     added = true;
                 }
 
@@ -655,6 +704,19 @@ void ListView::ChangeSelection(int delta, bool additive)
         if (newSelection >= numItems)
             break;
 
+        // Virtual items can not be hidden, so the target is reached directly
+        if (virtualMode_)
+        {
+            newSelection = (unsigned)Clamp((int)newSelection + delta - direction, 0, (int)numItems - 1);
+            if (additive)
+            {
+                for (unsigned i = Min(selection, newSelection); i <= Max(selection, newSelection); ++i)
+                    indices.Push(i);
+            }
+            okSelection = newSelection;
+            break;
+        }
+
         UIElement* item = GetItem(newSelection);
         if (item->IsVisible())
         {
@@ -690,6 +752,9 @@ void ListView::SetHierarchyMode(bool enable)
     if (enable == hierarchyMode_)
         return;
 
+    if (enable)
+        SetVirtualMode(false);
+
     hierarchyMode_ = enable;
     UIElement* container;
     if (enable)
@@ -803,18 +868,37 @@ void ListView::ToggleExpand(unsigned index, bool recursive)
 
 unsigned ListView::GetNumItems() const
 {
-    return contentElement_->GetNumChildren();
+    return virtualMode_ ? numVirtualItems_ : contentElement_->GetNumChildren();
 }
 
 UIElement* ListView::GetItem(unsigned index) const
 {
+    if (virtualMode_)
+    {
+        for (unsigned i = 0; i < virtualItemIndices_.Size(); ++i)
+        {
+            if (virtualItemIndices_[i] == index)
+                return contentElement_->GetChild(i);
+        }
+        return nullptr;
+    }
+
     return contentElement_->GetChild(index);
 }
 
 PODVector<UIElement*> ListView::GetItems() const
 {
     PODVector<UIElement*> items;
-    contentElement_->GetChildren(items);
+    if (virtualMode_)
+    {
+        for (unsigned i = 0; i < virtualItemIndices_.Size(); ++i)
+        {
+            if (virtualItemIndices_[i] != M_MAX_UNSIGNED)
+                items.Push(contentElement_->GetChild(i));
+        }
+    }
+    else
+        contentElement_->GetChildren(items);
     return items;
 }
 
@@ -829,6 +913,16 @@ unsigned ListView::FindItem(UIElement* item) const
 
     const Vector<SharedPtr<UIElement> >& children = contentElement_->GetChildren();
 
+    if (virtualMode_)
+    {
+        for (unsigned i = 0; i < children.Size() && i < virtualItemIndices_.Size(); ++i)
+        {
+            if (children[i] == item)
+                return virtualItemIndices_[i];
+        }
+        return M_MAX_UNSIGNED;
+    }
+
     // Binary search for list item based on screen coordinate Y
     if (contentElement_->GetLayoutMode() == LM_VERTICAL && item->GetHeight())
     {
@@ -867,7 +961,7 @@ unsigned ListView::GetSelection() const
 
 UIElement* ListView::GetSelectedItem() const
 {
-    return contentElement_->GetChild(GetSelection());
+    return GetItem(GetSelection());
 }
 
 PODVector<UIElement*> ListView::GetSelectedItems() const
@@ -901,12 +995,23 @@ void ListView::CopySelectedItemsToClipboard() const
 
 bool ListView::IsSelected(unsigned index) const
 {
-    return selections_.Contains(index);
+    // Selections are kept sorted, so use binary search
+    unsigned left = 0;
+    unsigned right = selections_.Size();
+    while (left < right)
+    {
+        unsigned mid = (left + right) / 2;
+        if (selections_[mid] < index)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+    return left < selections_.Size() && selections_[left] == index;
 }
 
 bool ListView::IsExpanded(unsigned index) const
 {
-    return GetItemExpanded(contentElement_->GetChild(index));
+    return !virtualMode_ && GetItemExpanded(contentElement_->GetChild(index));
 }
 
 bool ListView::FilterImplicitAttributes(XMLElement& dest) const
@@ -931,7 +1036,7 @@ bool ListView::FilterImplicitAttributes(XMLElement& dest) const
         return false;
     if (!RemoveChildXML(containerElem, "Is Enabled", "true"))
         return false;
-    if (!RemoveChildXML(containerElem, "Layout Mode", "Vertical"))
+    if (!virtualMode_ && !RemoveChildXML(containerElem, "Layout Mode", "Vertical"))
         return false;
     if (!RemoveChildXML(containerElem, "Size"))
         return false;
@@ -954,9 +1059,21 @@ bool ListView::FilterImplicitAttributes(XMLElement& dest) const
 
 void ListView::UpdateSelectionEffect()
 {
-    unsigned numItems = GetNumItems();
     bool highlighted = highlightMode_ == HM_ALWAYS || HasFocus();
 
+    if (virtualMode_)
+    {
+        // Only the materialized items need to be updated
+        for (unsigned i = 0; i < virtualItemIndices_.Size(); ++i)
+        {
+            unsigned index = virtualItemIndices_[i];
+            contentElement_->GetChild(i)->SetSelected(index != M_MAX_UNSIGNED && highlightMode_ != HM_NEVER && IsSelected(index) &&
+                highlighted);
+        }
+        return;
+    }
+
+    unsigned numItems = GetNumItems();
     for (unsigned i = 0; i < numItems; ++i)
     {
         UIElement* item = GetItem(i);
@@ -969,6 +1086,15 @@ void ListView::UpdateSelectionEffect()
 
 void ListView::EnsureItemVisibility(unsigned index)
 {
+    // Virtual items may not be materialized yet, but their position is known
+    if (virtualMode_)
+    {
+        int itemHeight = GetVirtualItemHeight();
+        if (index < numVirtualItems_ && itemHeight > 0)
+            EnsureVisibility((int)index * itemHeight, itemHeight);
+        return;
+    }
+
     EnsureItemVisibility(GetItem(index));
 }
 
@@ -977,18 +1103,7 @@ void ListView::EnsureItemVisibility(UIElement* item)
     if (!item || !item->IsVisible())
         return;
 
-    IntVector2 newView = GetViewPosition();
-    IntVector2 currentOffset = item->GetPosition() - newView;
-    const IntRect& clipBorder = scrollPanel_->GetClipBorder();
-    IntVector2 windowSize(scrollPanel_->GetWidth() - clipBorder.left_ - clipBorder.right_,
-        scrollPanel_->GetHeight() - clipBorder.top_ - clipBorder.bottom_);
-
-    if (currentOffset.y_ < 0)
-        newView.y_ += currentOffset.y_;
-    if (currentOffset.y_ + item->GetHeight() > windowSize.y_)
-        newView.y_ += currentOffset.y_ + item->GetHeight() - windowSize.y_;
-
-    SetViewPosition(newView);
+    EnsureVisibility(item->GetPosition().y_, item->GetHeight());
 }
 
 void ListView::HandleUIMouseClick(StringHash eventType, VariantMap& eventData)
@@ -1137,4 +1252,264 @@ void ListView::UpdateUIClickSubscription()
     SubscribeToEvent(selectOnClickEnd_ ? E_UIMOUSECLICKEND : E_UIMOUSECLICK, URHO3D_HANDLER(ListView, HandleUIMouseClick));
 }
 
+void ListView::EnsureVisibility(int y, int height)
+{
+    IntVector2 newView = GetViewPosition();
+    int currentOffset = y - newView.y_;
+    const IntRect& clipBorder = scrollPanel_->GetClipBorder();
+    int windowHeight = scrollPanel_->GetHeight() - clipBorder.top_ - clipBorder.bottom_;
+
+    if (currentOffset < 0)
+        newView.y_ += currentOffset;
+    if (currentOffset + height > windowHeight)
+        newView.y_ += currentOffset + height - windowHeight;
+
+    SetViewPosition(newView);
+}
+
+void ListView::UpdateVirtualItems(bool refresh)
+{
+    if (!virtualMode_ || updatingVirtualItems_)
+        return;
+
+    updatingVirtualItems_ = true;
+
+    // The style may have set a layout for the item container, but virtual items are positioned manually
+    if (contentElement_->GetLayoutMode() != LM_FREE)
+        contentElement_->SetLayoutMode(LM_FREE);
+
+    const Vector<SharedPtr<UIElement> >& items = contentElement_->GetChildren();
+
+    // Measure the item height from the first item if not set
+    if (GetVirtualItemHeight() <= 0 && numVirtualItems_)
+    {
+        UIElement* item = nullptr;
+        for (unsigned i = 0; i < virtualItemIndices_.Size() && !item; ++i)
+        {
+            if (virtualItemIndices_[i] == 0)
+                item = items[i];
+        }
+        if (!item)
+        {
+            item = CreateVirtualItem();
+            if (item)
+            {
+                virtualItemIndices_.Back() = 0;
+                SendVirtualItemUpdate(item, 0);
+            }
+        }
+        if (item)
+            measuredItemHeight_ = Max(item->GetHeight(), 1);
+    }
+
+    int itemHeight = GetVirtualItemHeight();
+    if (itemHeight <= 0)
+    {
+        // Without items or a known height there is nothing to show
+        for (unsigned i = 0; i < items.Size(); ++i)
+        {
+            virtualItemIndices_[i] = M_MAX_UNSIGNED;
+            items[i]->SetVisible(false);
+        }
+        contentElement_->SetHeight(0);
+        updatingVirtualItems_ = false;
+        return;
+    }
+
+    // Resizing the content may clamp the view position, so do it before determining the items in view
+    contentElement_->SetHeight((int)numVirtualItems_ * itemHeight);
+
+    const IntRect& clipBorder = scrollPanel_->GetClipBorder();
+    int windowHeight = Max(scrollPanel_->GetHeight() - clipBorder.top_ - clipBorder.bottom_, 0);
+    unsigned first = Min((unsigned)(viewPosition_.y_ / itemHeight), numVirtualItems_);
+    unsigned last = Min((unsigned)((viewPosition_.y_ + windowHeight + itemHeight - 1) / itemHeight), numVirtualItems_);
+    if (last == first && first < numVirtualItems_)
+        ++last;
+
+    // Keep the item elements that still show an item in view, and collect the rest for recycling
+    PODVector<bool> materialized(last - first, false);
+    PODVector<unsigned> freeItems;
+    for (unsigned i = 0; i < items.Size(); ++i)
+    {
+        unsigned index = virtualItemIndices_[i];
+        if (index >= first && index < last && !materialized[index - first])
+        {
+            materialized[index - first] = true;
+            if (refresh)
+                SendVirtualItemUpdate(items[i], index);
+        }
+        else
+        {
+            virtualItemIndices_[i] = M_MAX_UNSIGNED;
+            freeItems.Push(i);
+        }
+    }
+
+    for (unsigned index = first; index < last; ++index)
+    {
+        if (materialized[index - first])
+            continue;
+
+        UIElement* item;
+        if (freeItems.Size())
+        {
+            unsigned i = freeItems.Back();
+            freeItems.Pop();
+            virtualItemIndices_[i] = index;
+            item = items[i];
+        }
+        else
+        {
+            item = CreateVirtualItem();
+            if (!item)
+                break;
+            virtualItemIndices_.Back() = index;
+        }
+
+        SendVirtualItemUpdate(item, index);
+    }
+
+    int width = contentElement_->GetWidth();
+    for (unsigned i = 0; i < items.Size(); ++i)
+    {
+        UIElement* item = items[i];
+        unsigned index = virtualItemIndices_[i];
+        if (index != M_MAX_UNSIGNED)
+        {
+            item->SetPosition(0, (int)index * itemHeight);
+            item->SetWidth(width);
+            item->SetVisible(true);
+        }
+        else
+            item->SetVisible(false);
+    }
+
+    UpdateSelectionEffect();
+
+    updatingVirtualItems_ = false;
+}
+
+UIElement* ListView::CreateVirtualItem()
+{
+    SharedPtr<UIElement> item = DynamicCast<UIElement>(context_->CreateObject(virtualItemType_));
+    if (!item)
+    {
+        URHO3D_LOGERROR("Could not create virtual item element of unknown type " + virtualItemType_.ToString());
+        return nullptr;
+    }
+
+    // Item elements are managed by the list view and are not saved
+    item->SetInternal(true);
+    contentElement_->AddChild(item);
+    virtualItemIndices_.Push(M_MAX_UNSIGNED);
+    item->SetStyleAuto();
+    // Enable input so that clicking the item can be detected
+    item->SetEnabled(true);
+    return item;
+}
+
+void ListView::SendVirtualItemUpdate(UIElement* item, unsigned index)
+{
+    using namespace VirtualItemUpdate;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_ELEMENT] = this;
+    eventData[P_ITEM] = item;
+    eventData[P_INDEX] = index;
+    SendEvent(E_VIRTUALITEMUPDATE, eventData);
+}
+
+void ListView::SetVirtualMode(bool enable)
+{
+    if (enable == virtualMode_)
+        return;
+
+    if (enable)
+        SetHierarchyMode(false);
+
+    ClearSelection();
+    contentElement_->RemoveAllChildren();
+    virtualItemIndices_.Clear();
+    numVirtualItems_ = 0;
+    measuredItemHeight_ = 0;
+    virtualMode_ = enable;
+
+    if (enable)
+    {
+        SubscribeToEvent(this, E_VIEWCHANGED, URHO3D_HANDLER(ListView, HandleVirtualViewChanged));
+        SubscribeToEvent(scrollPanel_, E_RESIZED, URHO3D_HANDLER(ListView, HandleVirtualViewChanged));
+        UpdateVirtualItems();
+    }
+    else
+    {
+        UnsubscribeFromEvent(this, E_VIEWCHANGED);
+        UnsubscribeFromEvent(scrollPanel_, E_RESIZED);
+        contentElement_->SetLayoutMode(LM_VERTICAL);
+    }
+}
+
+void ListView::SetNumVirtualItems(unsigned num)
+{
+    if (!virtualMode_)
+    {
+        URHO3D_LOGERROR("ListView is not in virtual mode");
+        return;
+    }
+
+    if (num == numVirtualItems_)
+        return;
+
+    numVirtualItems_ = num;
+    if (!num)
+        measuredItemHeight_ = 0;
+
+    // Remove selections of the items that no longer exist
+    if (!selections_.Empty() && selections_.Back() >= num)
+    {
+        PODVector<unsigned> indices;
+        for (unsigned i = 0; i < selections_.Size() && selections_[i] < num; ++i)
+            indices.Push(selections_[i]);
+        SetSelections(indices);
+    }
+
+    UpdateVirtualItems();
+}
+
+void ListView::SetVirtualItemHeight(int height)
+{
+    height = Max(height, 0);
+    if (height != virtualItemHeight_)
+    {
+        virtualItemHeight_ = height;
+        UpdateVirtualItems();
+    }
+}
+
+void ListView::SetVirtualItemType(StringHash type)
+{
+    if (type == virtualItemType_)
+        return;
+
+    virtualItemType_ = type;
+
+    // Recreate the item elements with the new type
+    if (virtualMode_)
+    {
+        contentElement_->RemoveAllChildren();
+        virtualItemIndices_.Clear();
+        measuredItemHeight_ = 0;
+        UpdateVirtualItems();
+    }
+}
+
+void ListView::RefreshVirtualItems()
+{
+    UpdateVirtualItems(true);
+}
+
+void ListView::HandleVirtualViewChanged(StringHash eventType, VariantMap& eventData)
+{
+    UpdateVirtualItems();
+}
+
 }
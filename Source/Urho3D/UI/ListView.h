@@ -96,6 +96,17 @@ public:
     void SetClearSelectionOnDefocus(bool enable);
     /// Enable reacting to click end instead of click start for item selection. Default false.
     void SetSelectOnClickEnd(bool enable);
+    /// \brief Enable virtual mode for huge item counts. Items are not added as elements; instead only the items in view are materialized by recycled item elements, whose content is requested with the VirtualItemUpdate event.
+    /// Hierarchy mode is disabled. All items in the list will be lost during mode change.
+    void SetVirtualMode(bool enable);
+    /// Set number of items in virtual mode. Selections beyond the new count are removed.
+    void SetNumVirtualItems(unsigned num);
+    /// Set item height in virtual mode. Zero (default) uses the height of the first item element after its content has been updated.
+    void SetVirtualItemHeight(int height);
+    /// Set type of the item elements created in virtual mode. Default Text.
+    void SetVirtualItemType(StringHash type);
+    /// Request the content of the materialized items again in virtual mode, for example after the data source has changed.
+    void RefreshVirtualItems();
 
     /// Expand item at index. Only has effect in hierarchy mode.
     void Expand(unsigned index, bool enable, bool recursive = false);
@@ -104,9 +115,9 @@ public:
 
     /// Return number of items.
     unsigned GetNumItems() const;
-    /// Return item at index.
+    /// Return item at index. In virtual mode, return null if the item is not materialized.
     UIElement* GetItem(unsigned index) const;
-    /// Return all items.
+    /// Return all items. In virtual mode, return the materialized items.
     PODVector<UIElement*> GetItems() const;
     /// Return index of item, or M_MAX_UNSIGNED If not found.
     unsigned FindItem(UIElement* item) const;
@@ -145,6 +156,15 @@ public:
     /// Return base indent.
     int GetBaseIndent() const { return baseIndent_; }
 
+    /// Return whether virtual mode enabled.
+    bool GetVirtualMode() const { return virtualMode_; }
+
+    /// Return item height in virtual mode, or zero if not yet known.
+    int GetVirtualItemHeight() const { return virtualItemHeight_ > 0 ? virtualItemHeight_ : measuredItemHeight_; }
+
+    /// Return type of the item elements created in virtual mode.
+    StringHash GetVirtualItemType() const { return virtualItemType_; }
+
     /// Ensure full visibility of the item.
     void EnsureItemVisibility(unsigned index);
     /// Ensure full visibility of the item.
@@ -172,6 +192,20 @@ protected:
     bool clearSelectionOnDefocus_;
     /// React to click end instead of click start flag.
     bool selectOnClickEnd_;
+    /// Virtual mode flag.
+    bool virtualMode_;
+    /// Number of items in virtual mode.
+    unsigned numVirtualItems_;
+    /// Item height in virtual mode, or zero to measure.
+    int virtualItemHeight_;
+    /// Item height measured from the first item element in virtual mode.
+    int measuredItemHeight_;
+    /// Type of the item elements created in virtual mode.
+    StringHash virtualItemType_;
+    /// Index of the item materialized by each item element in virtual mode, or M_MAX_UNSIGNED if unused.
+    PODVector<unsigned> virtualItemIndices_;
+    /// Virtual item update in progress flag.
+    bool updatingVirtualItems_;
 
 private:
     /// Handle global UI mouseclick to check for selection change.
@@ -184,6 +218,16 @@ private:
     void HandleFocusChanged(StringHash eventType, VariantMap& eventData);
     /// Update subscription to UI click events
     void UpdateUIClickSubscription();
+    /// Materialize the items in view in virtual mode, recycling the item elements of items no longer in view. Optionally request the content of all materialized items again.
+    void UpdateVirtualItems(bool refresh = false);
+    /// Create a new item element for virtual mode.
+    UIElement* CreateVirtualItem();
+    /// Send the event to request the content of a materialized item.
+    void SendVirtualItemUpdate(UIElement* item, unsigned index);
+    /// Scroll the view to fully show the content area at the vertical position.
+    void EnsureVisibility(int y, int height);
+    /// Handle view or scroll panel size change in virtual mode.
+    void HandleVirtualViewChanged(StringHash eventType, VariantMap& eventData);
 };
 
 }
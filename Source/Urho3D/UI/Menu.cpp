@@ -330,6 +330,7 @@ void Menu::ShowPopup(bool enable)
 
     showPopup_ = enable;
     selected_ = enable;
+    MarkBatchesDirty();
 }
 
 void Menu::SetAccelerator(int key, int qualifiers)
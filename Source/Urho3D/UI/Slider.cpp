@@ -99,6 +99,7 @@ void Slider::OnClickBegin(const IntVector2& position, const IntVector2& screenPo
     Cursor* cursor)
 {
     selected_ = true;
+    MarkBatchesDirty();
     hovering_ = knob_->IsInside(screenPosition, true);
     if (!hovering_ && button == MOUSEB_LEFT)
         Page(position, true);
@@ -157,6 +158,7 @@ void Slider::OnDragEnd(const IntVector2& position, const IntVector2& screenPosit
     {
         dragSlider_ = false;
         selected_ = false;
+        MarkBatchesDirty();
     }
 }
 
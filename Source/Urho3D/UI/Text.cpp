@@ -51,6 +51,21 @@ static const float MIN_ROW_SPACING = 0.5f;
 extern const char* horizontalAlignments[];
 extern const char* UI_CATEGORY;
 
+void TextParagraph::Swap(TextParagraph& rhs)
+{
+    text_.Swap(rhs.text_);
+    Urho3D::Swap(hash_, rhs.hash_);
+    Urho3D::Swap(first_, rhs.first_);
+    printText_.Swap(rhs.printText_);
+    printToText_.Swap(rhs.printToText_);
+    rowWidths_.Swap(rhs.rowWidths_);
+    rowStarts_.Swap(rhs.rowStarts_);
+    charLocations_.Swap(rhs.charLocations_);
+    pageGlyphLocations_.Swap(rhs.pageGlyphLocations_);
+    Urho3D::Swap(endPosition_, rhs.endPosition_);
+    Urho3D::Swap(charLocationsValid_, rhs.charLocationsValid_);
+}
+
 Text::Text(Context* context) :
     UIElement(context),
     fontSize_(DEFAULT_FONT_SIZE),
@@ -59,6 +74,7 @@ Text::Text(Context* context) :
     wordWrap_(false),
     autoLocalizable_(false),
     charLocationsDirty_(true),
+    glyphRevision_(0),
     selectionStart_(0),
     selectionLength_(0),
     selectionColor_(Color::TRANSPARENT),
@@ -69,7 +85,10 @@ Text::Text(Context* context) :
     roundStroke_(false),
     effectColor_(Color::BLACK),
     effectDepthBias_(0.0f),
-    rowHeight_(0)
+    rowHeight_(0),
+    paragraphRevision_(0),
+    paragraphWrapWidth_(-1),
+    paragraphRowHeight_(0)
 {
     // By default Text does not derive opacity from parent elements
     useDerivedOpacity_ = false;
@@ -123,6 +142,15 @@ void Text::ApplyAttributes()
     UpdateText();
 }
 
+void Text::Update(float timeStep)
+{
+    UIElement::Update(timeStep);
+
+    // Glyphs rasterized in the background may change the text size, so update layout before rendering
+    if (IsGlyphLayoutDirty() && font_ && font_->GetFace(fontSize_) == fontFace_)
+        UpdateText();
+}
+
 void Text::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
 {
     FontFace* face = font_ ? font_->GetFace(fontSize_) : nullptr;
@@ -132,6 +160,10 @@ void Text::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData,
         return;
     }
 
+    // If glyphs of the face have changed since the last layout, update it first
+    if (face == fontFace_ && face->GetRevision() != glyphRevision_)
+        UpdateText();
+
     // If face has changed or char locations are not valid anymore, update before rendering
     if (charLocationsDirty_ || !fontFace_ || face != fontFace_)
         UpdateCharLocations();
@@ -254,6 +286,19 @@ void Text::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData,
     hovering_ = false;
 }
 
+bool Text::IsGlyphLayoutDirty() const
+{
+    return fontFace_ && fontFace_->GetRevision() != glyphRevision_;
+}
+
+bool Text::CanCacheBatches() const
+{
+    // Char locations must be updated for a changed face, and glyphs of a mutable face may move in the texture between frames
+    if (!font_ || !fontFace_ || charLocationsDirty_)
+        return false;
+    return font_->GetFace(fontSize_) == fontFace_ && !fontFace_->HasMutableGlyphs();
+}
+
 void Text::OnResize(const IntVector2& newSize, const IntVector2& delta)
 {
     if (wordWrap_)
@@ -390,52 +435,62 @@ void Text::SetSelection(unsigned start, unsigned length)
     selectionStart_ = start;
     selectionLength_ = length;
     ValidateSelection();
+    MarkBatchesDirty();
 }
 
 void Text::ClearSelection()
 {
     selectionStart_ = 0;
     selectionLength_ = 0;
+    MarkBatchesDirty();
 }
 
 void Text::SetSelectionColor(const Color& color)
 {
     selectionColor_ = color;
+    MarkBatchesDirty();
 }
 
 void Text::SetHoverColor(const Color& color)
 {
     hoverColor_ = color;
+    MarkBatchesDirty();
 }
 
 void Text::SetTextEffect(TextEffect textEffect)
 {
     textEffect_ = textEffect;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectShadowOffset(const IntVector2& offset)
 {
     shadowOffset_ = offset;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectStrokeThickness(int thickness)
 {
     strokeThickness_ = Abs(thickness);
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectRoundStroke(bool roundStroke)
 {
     roundStroke_ = roundStroke;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectColor(const Color& effectColor)
 {
     effectColor_ = effectColor;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectDepthBias(float bias)
 {
     effectDepthBias_ = bias;
+    MarkBatchesDirty();
 }
 
 float Text::GetRowWidth(unsigned index) const
@@ -523,149 +578,88 @@ void Text::UpdateText(bool onResize)
             return;
 
         rowHeight_ = face->GetRowHeight();
+        glyphRevision_ = face->GetRevision();
 
         int width = 0;
         int height = 0;
-        int rowWidth = 0;
         int rowHeight = (int)(rowSpacing_ * rowHeight_ + 0.5f);
 
-        // First see if the text must be split up
-        if (!wordWrap_)
+        // Paragraphs laid out with different glyphs or wrap width can not be reused
+        int wrapWidth = wordWrap_ ? GetWidth() : -1;
+        if (face != paragraphFace_ || glyphRevision_ != paragraphRevision_ || wrapWidth != paragraphWrapWidth_)
         {
-            printText_ = unicodeText_;
-            printToText_.Resize(printText_.Size());
-            for (unsigned i = 0; i < printText_.Size(); ++i)
-                printToText_[i] = i;
+            paragraphs_.Clear();
+            paragraphFace_ = face;
+            paragraphRevision_ = glyphRevision_;
+            paragraphWrapWidth_ = wrapWidth;
         }
-        else
-        {
-            int maxWidth = GetWidth();
-            unsigned nextBreak = 0;
-            unsigned lineStart = 0;
-            printToText_.Clear();
-
-            for (unsigned i = 0; i < unicodeText_.Size(); ++i)
-            {
-                unsigned j;
-                unsigned c = unicodeText_[i];
-
-                if (c != '\n')
-                {
-                    bool ok = true;
-
-                    if (nextBreak <= i)
-                    {
-                        int futureRowWidth = rowWidth;
-                        for (j = i; j < unicodeText_.Size(); ++j)
-                        {
-                            unsigned d = unicodeText_[j];
-                            if (d == ' ' || d == '\n')
-                            {
-                                nextBreak = j;
-                                break;
-                            }
-                            const FontGlyph* glyph = face->GetGlyph(d);
-                            if (glyph)
-                            {
-                                futureRowWidth += glyph->advanceX_;
-                                if (j < unicodeText_.Size() - 1)
-                                    futureRowWidth += face->GetKerning(d, unicodeText_[j + 1]);
-                            }
-                            if (d == '-' && futureRowWidth <= maxWidth)
-                            {
-                                nextBreak = j + 1;
-                                break;
-                            }
-                            if (futureRowWidth > maxWidth)
-                            {
-                                ok = false;
-                                break;
-                            }
-                        }
-                    }
 
-                    if (!ok)
-                    {
-                        // If did not find any breaks on the line, copy until j, or at least 1 char, to prevent infinite loop
-                        if (nextBreak == lineStart)
-                        {
-                            while (i < j)
-                            {
-                                printText_.Push(unicodeText_[i]);
-                                printToText_.Push(i);
-                                ++i;
-                            }
-                        }
-                        // Eliminate spaces that have been copied before the forced break
-                        while (printText_.Size() && printText_.Back() == ' ')
-                        {
-                            printText_.Pop();
-                            printToText_.Pop();
-                        }
-                        printText_.Push('\n');
-                        printToText_.Push(Min(i, unicodeText_.Size() - 1));
-                        rowWidth = 0;
-                        nextBreak = lineStart = i;
-                    }
+        // Index the previous paragraphs by hash so that unchanged ones are found even if their position in the text changed
+        HashMap<unsigned, unsigned> oldParagraphIndices;
+        for (unsigned i = 0; i < paragraphs_.Size(); ++i)
+            oldParagraphIndices[paragraphs_[i].hash_] = i;
 
-                    if (i < unicodeText_.Size())
-                    {
-                        // When copying a space, position is allowed to be over row width
-                        c = unicodeText_[i];
-                        const FontGlyph* glyph = face->GetGlyph(c);
-                        if (glyph)
-                        {
-                            rowWidth += glyph->advanceX_;
-                            if (i < unicodeText_.Size() - 1)
-                                rowWidth += face->GetKerning(c, unicodeText_[i + 1]);
-                        }
-                        if (rowWidth <= maxWidth)
-                        {
-                            printText_.Push(c);
-                            printToText_.Push(i);
-                        }
-                    }
-                }
-                else
-                {
-                    printText_.Push('\n');
-                    printToText_.Push(Min(i, unicodeText_.Size() - 1));
-                    rowWidth = 0;
-                    nextBreak = lineStart = i;
-                }
+        Vector<TextParagraph> paragraphs;
+        unsigned paragraphStart = 0;
+        while (paragraphStart < unicodeText_.Size())
+        {
+            unsigned paragraphEnd = paragraphStart;
+            unsigned hash = 0;
+            while (paragraphEnd < unicodeText_.Size())
+            {
+                unsigned c = unicodeText_[paragraphEnd++];
+                hash = SDBMHash(hash, (unsigned char)c);
+                hash = SDBMHash(hash, (unsigned char)(c >> 8));
+                hash = SDBMHash(hash, (unsigned char)(c >> 16));
+                if (c == '\n')
+                    break;
             }
-        }
 
-        rowWidth = 0;
+            unsigned length = paragraphEnd - paragraphStart;
+            bool first = paragraphStart == 0;
+            paragraphs.Resize(paragraphs.Size() + 1);
+            TextParagraph& paragraph = paragraphs.Back();
 
-        for (unsigned i = 0; i < printText_.Size(); ++i)
-        {
-            unsigned c = printText_[i];
-
-            if (c != '\n')
+            HashMap<unsigned, unsigned>::ConstIterator i = oldParagraphIndices.Find(hash);
+            if (i != oldParagraphIndices.End())
             {
-                const FontGlyph* glyph = face->GetGlyph(c);
-                if (glyph)
-                {
-                    rowWidth += glyph->advanceX_;
-                    if (i < printText_.Size() - 1)
-                        rowWidth += face->GetKerning(c, printText_[i + 1]);
-                }
+                TextParagraph& oldParagraph = paragraphs_[i->second_];
+                // Take over the old paragraph's data instead of copying it. A repeated paragraph finds it emptied and is laid
+                // out again
+                if (oldParagraph.first_ == first && oldParagraph.text_.Size() == length &&
+                    !memcmp(&oldParagraph.text_[0], &unicodeText_[paragraphStart], length * sizeof(unsigned)))
+                    paragraph.Swap(oldParagraph);
             }
-            else
+
+            if (paragraph.text_.Empty())
             {
-                width = Max(width, rowWidth);
-                height += rowHeight;
-                rowWidths_.Push(rowWidth);
-                rowWidth = 0;
+                paragraph.text_.Resize(length);
+                memcpy(&paragraph.text_[0], &unicodeText_[paragraphStart], length * sizeof(unsigned));
+                paragraph.hash_ = hash;
+                paragraph.first_ = first;
+                LayoutParagraph(paragraph, face, wrapWidth);
             }
+
+            paragraphStart = paragraphEnd;
         }
+        paragraphs_.Swap(paragraphs);
 
-        if (rowWidth)
+        // Combine the paragraphs into the printed form of the whole text
+        printToText_.Clear();
+        paragraphStart = 0;
+        for (unsigned i = 0; i < paragraphs_.Size(); ++i)
         {
-            width = Max(width, rowWidth);
-            height += rowHeight;
-            rowWidths_.Push(rowWidth);
+            const TextParagraph& paragraph = paragraphs_[i];
+            printText_.Push(paragraph.printText_);
+            for (unsigned j = 0; j < paragraph.printToText_.Size(); ++j)
+                printToText_.Push(paragraphStart + paragraph.printToText_[j]);
+            for (unsigned j = 0; j < paragraph.rowWidths_.Size(); ++j)
+            {
+                width = Max(width, (int)paragraph.rowWidths_[j]);
+                height += rowHeight;
+            }
+            rowWidths_.Push(paragraph.rowWidths_);
+            paragraphStart += paragraph.text_.Size();
         }
 
         // Set at least one row height even if text is empty
@@ -691,6 +685,7 @@ void Text::UpdateText(bool onResize)
     {
         // No font, nothing to render
         pageGlyphLocations_.Clear();
+        paragraphs_.Clear();
     }
 
     // If wordwrap is on, parent may need layout update to correct for overshoot in size. However, do not do this when the
@@ -703,6 +698,152 @@ void Text::UpdateText(bool onResize)
     }
 }
 
+void Text::LayoutParagraph(TextParagraph& paragraph, FontFace* face, int maxWidth)
+{
+    const PODVector<unsigned>& text = paragraph.text_;
+    PODVector<unsigned>& printText = paragraph.printText_;
+    PODVector<unsigned>& printToText = paragraph.printToText_;
+
+    printText.Clear();
+    printToText.Clear();
+    paragraph.rowWidths_.Clear();
+    paragraph.charLocationsValid_ = false;
+
+    int rowWidth = 0;
+
+    // First see if the text must be split up
+    if (maxWidth < 0)
+    {
+        printText = text;
+        printToText.Resize(printText.Size());
+        for (unsigned i = 0; i < printText.Size(); ++i)
+            printToText[i] = i;
+    }
+    else
+    {
+        // Break positions are relative to the preceding line break, which is outside the paragraph except for the first one
+        int nextBreak = paragraph.first_ ? 0 : -1;
+        int lineStart = nextBreak;
+
+        for (unsigned i = 0; i < text.Size(); ++i)
+        {
+            unsigned j;
+            unsigned c = text[i];
+
+            if (c != '\n')
+            {
+                bool ok = true;
+
+                if (nextBreak <= (int)i)
+                {
+                    int futureRowWidth = rowWidth;
+                    for (j = i; j < text.Size(); ++j)
+                    {
+                        unsigned d = text[j];
+                        if (d == ' ' || d == '\n')
+                        {
+                            nextBreak = j;
+                            break;
+                        }
+                        const FontGlyph* glyph = face->GetGlyph(d);
+                        if (glyph)
+                        {
+                            futureRowWidth += glyph->advanceX_;
+                            if (j < text.Size() - 1)
+                                futureRowWidth += face->GetKerning(d, text[j + 1]);
+                        }
+                        if (d == '-' && futureRowWidth <= maxWidth)
+                        {
+                            nextBreak = j + 1;
+                            break;
+                        }
+                        if (futureRowWidth > maxWidth)
+                        {
+                            ok = false;
+                            break;
+                        }
+                    }
+                }
+
+                if (!ok)
+                {
+                    // If did not find any breaks on the line, copy until j, or at least 1 char, to prevent infinite loop
+                    if (nextBreak == lineStart)
+                    {
+                        while (i < j)
+                        {
+                            printText.Push(text[i]);
+                            printToText.Push(i);
+                            ++i;
+                        }
+                    }
+                    // Eliminate spaces that have been copied before the forced break
+                    while (printText.Size() && printText.Back() == ' ')
+                    {
+                        printText.Pop();
+                        printToText.Pop();
+                    }
+                    printText.Push('\n');
+                    printToText.Push(Min(i, text.Size() - 1));
+                    rowWidth = 0;
+                    nextBreak = lineStart = i;
+                }
+
+                if (i < text.Size())
+                {
+                    // When copying a space, position is allowed to be over row width
+                    c = text[i];
+                    const FontGlyph* glyph = face->GetGlyph(c);
+                    if (glyph)
+                    {
+                        rowWidth += glyph->advanceX_;
+                        if (i < text.Size() - 1)
+                            rowWidth += face->GetKerning(c, text[i + 1]);
+                    }
+                    if (rowWidth <= maxWidth)
+                    {
+                        printText.Push(c);
+                        printToText.Push(i);
+                    }
+                }
+            }
+            else
+            {
+                printText.Push('\n');
+                printToText.Push(Min(i, text.Size() - 1));
+                rowWidth = 0;
+                nextBreak = lineStart = i;
+            }
+        }
+    }
+
+    rowWidth = 0;
+
+    for (unsigned i = 0; i < printText.Size(); ++i)
+    {
+        unsigned c = printText[i];
+
+        if (c != '\n')
+        {
+            const FontGlyph* glyph = face->GetGlyph(c);
+            if (glyph)
+            {
+                rowWidth += glyph->advanceX_;
+                if (i < printText.Size() - 1)
+                    rowWidth += face->GetKerning(c, printText[i + 1]);
+            }
+        }
+        else
+        {
+            paragraph.rowWidths_.Push(rowWidth);
+            rowWidth = 0;
+        }
+    }
+
+    if (rowWidth)
+        paragraph.rowWidths_.Push(rowWidth);
+}
+
 void Text::UpdateCharLocations()
 {
     // Remember the font face to see if it's still valid when it's time to render
@@ -710,8 +851,19 @@ void Text::UpdateCharLocations()
     if (!face)
         return;
     fontFace_ = face;
+    MarkBatchesDirty();
 
     int rowHeight = (int)(rowSpacing_ * rowHeight_ + 0.5f);
+    IntVector2 offset = font_->GetTotalGlyphOffset(fontSize_);
+
+    // Paragraph layouts are made with the current face in UpdateText(), but row height or offset may have changed since
+    if (rowHeight != paragraphRowHeight_ || offset != paragraphOffset_)
+    {
+        for (unsigned i = 0; i < paragraphs_.Size(); ++i)
+            paragraphs_[i].charLocationsValid_ = false;
+        paragraphRowHeight_ = rowHeight;
+        paragraphOffset_ = offset;
+    }
 
     // Store position & size of each character, and locations per texture page
     unsigned numChars = unicodeText_.Size();
@@ -720,19 +872,88 @@ void Text::UpdateCharLocations()
     for (unsigned i = 0; i < pageGlyphLocations_.Size(); ++i)
         pageGlyphLocations_[i].Clear();
 
-    IntVector2 offset = font_->GetTotalGlyphOffset(fontSize_);
-
     unsigned rowIndex = 0;
-    unsigned lastFilled = 0;
+    unsigned paragraphStart = 0;
     float x = floor(GetRowStartPosition(rowIndex) + offset.x_ + 0.5f);
     float y = floor(offset.y_ + 0.5f);
+    PODVector<float> rowStarts;
 
-    for (unsigned i = 0; i < printText_.Size(); ++i)
+    for (unsigned i = 0; i < paragraphs_.Size(); ++i)
+    {
+        TextParagraph& paragraph = paragraphs_[i];
+
+        // Calculate the start positions of the rows occupied by the paragraph. Only the first row of the text uses the offset
+        unsigned numLineBreaks = 0;
+        for (unsigned j = 0; j < paragraph.printText_.Size(); ++j)
+        {
+            if (paragraph.printText_[j] == '\n')
+                ++numLineBreaks;
+        }
+        bool endsWithLineBreak = paragraph.printText_.Size() && paragraph.printText_.Back() == '\n';
+        unsigned numRows = endsWithLineBreak ? numLineBreaks : numLineBreaks + 1;
+
+        rowStarts.Resize(numRows);
+        rowStarts[0] = x;
+        for (unsigned j = 1; j < numRows; ++j)
+            rowStarts[j] = (float)GetRowStartPosition(rowIndex + j);
+
+        // Recalculate the locations only if the paragraph or the positions of its rows changed
+        if (!paragraph.charLocationsValid_ || paragraph.rowStarts_ != rowStarts)
+        {
+            paragraph.rowStarts_ = rowStarts;
+            UpdateParagraphCharLocations(paragraph, face, rowHeight);
+        }
+
+        for (unsigned j = 0; j < paragraph.charLocations_.Size(); ++j)
+        {
+            CharLocation& loc = charLocations_[paragraphStart + j];
+            loc = paragraph.charLocations_[j];
+            loc.position_.y_ += y;
+        }
+        for (unsigned j = 0; j < paragraph.pageGlyphLocations_.Size() && j < pageGlyphLocations_.Size(); ++j)
+        {
+            const PODVector<GlyphLocation>& src = paragraph.pageGlyphLocations_[j];
+            PODVector<GlyphLocation>& dest = pageGlyphLocations_[j];
+            for (unsigned k = 0; k < src.Size(); ++k)
+                dest.Push(GlyphLocation(src[k].x_, src[k].y_ + y, src[k].glyph_));
+        }
+
+        paragraphStart += paragraph.text_.Size();
+        rowIndex += numLineBreaks;
+        y += numLineBreaks * rowHeight;
+        // The row following a paragraph's line break belongs to the next paragraph
+        x = endsWithLineBreak ? GetRowStartPosition(rowIndex) : paragraph.endPosition_.x_;
+    }
+
+    // Store the ending position
+    charLocations_[numChars].position_ = Vector2(x, y);
+    charLocations_[numChars].size_ = Vector2::ZERO;
+
+    charLocationsDirty_ = false;
+}
+
+void Text::UpdateParagraphCharLocations(TextParagraph& paragraph, FontFace* face, int rowHeight)
+{
+    unsigned numChars = paragraph.text_.Size();
+    paragraph.charLocations_.Clear();
+    paragraph.charLocations_.Resize(numChars);
+    paragraph.pageGlyphLocations_.Resize(face->GetTextures().Size());
+    for (unsigned i = 0; i < paragraph.pageGlyphLocations_.Size(); ++i)
+        paragraph.pageGlyphLocations_[i].Clear();
+
+    const PODVector<unsigned>& printText = paragraph.printText_;
+    const PODVector<unsigned>& printToText = paragraph.printToText_;
+    unsigned rowIndex = 0;
+    unsigned lastFilled = 0;
+    float x = paragraph.rowStarts_[0];
+    float y = 0.0f;
+
+    for (unsigned i = 0; i < printText.Size(); ++i)
     {
         CharLocation loc;
         loc.position_ = Vector2(x, y);
 
-        unsigned c = printText_[i];
+        unsigned c = printText[i];
         if (c != '\n')
         {
             const FontGlyph* glyph = face->GetGlyph(c);
@@ -740,33 +961,39 @@ void Text::UpdateCharLocations()
             if (glyph)
             {
                 // Store glyph's location for rendering. Verify that glyph page is valid
-                if (glyph->page_ < pageGlyphLocations_.Size())
-                    pageGlyphLocations_[glyph->page_].Push(GlyphLocation(x, y, glyph));
+                if (glyph->page_ < paragraph.pageGlyphLocations_.Size())
+                    paragraph.pageGlyphLocations_[glyph->page_].Push(GlyphLocation(x, y, glyph));
                 x += glyph->advanceX_;
-                if (i < printText_.Size() - 1)
-                    x += face->GetKerning(c, printText_[i + 1]);
+                if (i < printText.Size() - 1)
+                    x += face->GetKerning(c, printText[i + 1]);
             }
         }
         else
         {
             loc.size_ = Vector2::ZERO;
-            x = GetRowStartPosition(++rowIndex);
+            if (++rowIndex < paragraph.rowStarts_.Size())
+                x = paragraph.rowStarts_[rowIndex];
             y += rowHeight;
         }
 
-        if (lastFilled > printToText_[i])
-            lastFilled = printToText_[i];
+        if (lastFilled > printToText[i])
+            lastFilled = printToText[i];
 
         // Fill gaps in case characters were skipped from printing
-        for (unsigned j = lastFilled; j <= printToText_[i]; ++j)
-            charLocations_[j] = loc;
-        lastFilled = printToText_[i] + 1;
+        for (unsigned j = lastFilled; j <= printToText[i]; ++j)
+            paragraph.charLocations_[j] = loc;
+        lastFilled = printToText[i] + 1;
     }
-    // Store the ending position
-    charLocations_[numChars].position_ = Vector2(x, y);
-    charLocations_[numChars].size_ = Vector2::ZERO;
 
-    charLocationsDirty_ = false;
+    // Characters skipped from printing at the end of the paragraph are located at its end
+    CharLocation endLoc;
+    endLoc.position_ = Vector2(x, y);
+    endLoc.size_ = Vector2::ZERO;
+    for (unsigned j = lastFilled; j < numChars; ++j)
+        paragraph.charLocations_[j] = endLoc;
+
+    paragraph.endPosition_ = Vector2(x, y);
+    paragraph.charLocationsValid_ = true;
 }
 
 void Text::ValidateSelection()
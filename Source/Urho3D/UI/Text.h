@@ -69,6 +69,44 @@ struct GlyphLocation
     const FontGlyph* glyph_;
 };
 
+/// Cached layout of one paragraph of text, which is the source text up to and including a line break. Used to lay out only the changed paragraphs when text is updated.
+struct TextParagraph
+{
+    /// Construct.
+    TextParagraph() :
+        hash_(0),
+        first_(false),
+        charLocationsValid_(false)
+    {
+    }
+
+    /// Swap contents with another paragraph.
+    void Swap(TextParagraph& rhs);
+
+    /// Source characters.
+    PODVector<unsigned> text_;
+    /// Hash of the source characters.
+    unsigned hash_;
+    /// First paragraph of the text flag. The first row is wrapped and offset slightly differently.
+    bool first_;
+    /// Characters in printed form.
+    PODVector<unsigned> printText_;
+    /// Mapping of printed form back to char indices within the paragraph.
+    PODVector<unsigned> printToText_;
+    /// Widths of the rows in the paragraph.
+    PODVector<float> rowWidths_;
+    /// Start X positions of the rows the char locations were calculated with.
+    PODVector<float> rowStarts_;
+    /// Character locations relative to the paragraph's first row.
+    PODVector<CharLocation> charLocations_;
+    /// Glyph locations per each texture in the font, relative to the paragraph's first row.
+    Vector<PODVector<GlyphLocation> > pageGlyphLocations_;
+    /// Position after the last character, relative to the paragraph's first row.
+    Vector2 endPosition_;
+    /// Character and glyph locations valid flag.
+    bool charLocationsValid_;
+};
+
 /// %Text %UI element.
 class URHO3D_API Text : public UIElement
 {
@@ -86,8 +124,12 @@ public:
 
     /// Apply attribute changes that can not be applied immediately.
     virtual void ApplyAttributes() override;
+    /// Perform UI element update. Update layout if the font face's glyphs have changed.
+    virtual void Update(float timeStep) override;
     /// Return UI rendering batches.
     virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the rendering batches can be cached.
+    virtual bool CanCacheBatches() const override;
     /// React to resize.
     virtual void OnResize(const IntVector2& newSize, const IntVector2& delta) override;
     /// React to indent change.
@@ -179,6 +221,9 @@ public:
     /// Return row height.
     float GetRowHeight() const { return rowHeight_; }
 
+    /// Return whether glyphs have become resident in or been evicted from the font face textures since the last layout update.
+    bool IsGlyphLayoutDirty() const;
+
     /// Return number of rows.
     unsigned GetNumRows() const { return rowWidths_.Size(); }
 
@@ -214,6 +259,10 @@ protected:
     void UpdateText(bool onResize = false);
     /// Update cached character locations after text update, or when text alignment or indent has changed.
     void UpdateCharLocations();
+    /// Word wrap a paragraph and calculate its row widths.
+    void LayoutParagraph(TextParagraph& paragraph, FontFace* face, int maxWidth);
+    /// Calculate character and glyph locations of a paragraph.
+    void UpdateParagraphCharLocations(TextParagraph& paragraph, FontFace* face, int rowHeight);
     /// Validate text selection to be within the text.
     void ValidateSelection();
     /// Return row start X position.
@@ -239,6 +288,8 @@ protected:
     bool wordWrap_;
     /// Char positions dirty flag.
     bool charLocationsDirty_;
+    /// Font face glyph revision at the last layout update.
+    unsigned glyphRevision_;
     /// Selection start.
     unsigned selectionStart_;
     /// Selection length.
@@ -273,6 +324,18 @@ protected:
     Vector<PODVector<GlyphLocation> > pageGlyphLocations_;
     /// Cached locations of each character in the text.
     PODVector<CharLocation> charLocations_;
+    /// Cached layout of each paragraph in the text.
+    Vector<TextParagraph> paragraphs_;
+    /// Font face the paragraphs were laid out with.
+    WeakPtr<FontFace> paragraphFace_;
+    /// Font face glyph revision the paragraphs were laid out with.
+    unsigned paragraphRevision_;
+    /// Word wrap width the paragraphs were laid out with, or -1 if not wrapped.
+    int paragraphWrapWidth_;
+    /// Row height the paragraph char locations were calculated with.
+    int paragraphRowHeight_;
+    /// Glyph offset the paragraph char locations were calculated with.
+    IntVector2 paragraphOffset_;
     /// The text will be automatically translated.
     bool autoLocalizable_;
     /// Localization string id storage. Used when autoLocalizable flag is set.
@@ -135,6 +135,10 @@ void Text3D::UpdateBatches(const FrameInfo& frame)
             break;
         }
     }
+
+    // Glyphs rasterized in the background or evicted from the glyph atlas also require re-evaluating the text
+    if (text_.IsGlyphLayoutDirty())
+        fontDataLost_ = true;
 }
 
 void Text3D::UpdateGeometry(const FrameInfo& frame)
@@ -111,12 +111,17 @@ UI::UI(Context* context) :
     useScreenKeyboard_(false),
 #endif
     useMutableGlyphs_(false),
+    useBatchCaching_(true),
     forceAutoHint_(false),
     fontHintLevel_(FONT_HINT_LEVEL_NORMAL),
     fontSubpixelThreshold_(12),
     fontOversampling_(2),
     uiRendered_(false),
     nonModalBatchSize_(0),
+    batchesRegenerated_(false),
+    batchSignature_(0),
+    lastBatchSignature_(0),
+    vertexDataDirty_(true),
     dragElementsCount_(0),
     dragConfirmedCount_(0),
     uiScale_(1.0f),
@@ -203,6 +208,8 @@ void UI::SetFocusElement(UIElement* element, bool byKey)
     {
         UIElement* oldFocusElement = focusElement_;
         focusElement_.Reset();
+        // Focus affects the appearance of some elements
+        oldFocusElement->MarkBatchesDirty();
 
         VariantMap& focusEventData = GetEventDataMap();
         focusEventData[Defocused::P_ELEMENT] = oldFocusElement;
@@ -213,6 +220,7 @@ void UI::SetFocusElement(UIElement* element, bool byKey)
     if (element && element->GetFocusMode() >= FM_FOCUSABLE)
     {
         focusElement_ = element;
+        element->MarkBatchesDirty();
 
         VariantMap& focusEventData = GetEventDataMap();
         focusEventData[Focused::P_ELEMENT] = element;
@@ -419,6 +427,8 @@ void UI::RenderUpdate()
     // Get rendering batches from the non-modal UI elements
     batches_.Clear();
     vertexData_.Clear();
+    batchesRegenerated_ = false;
+    batchSignature_ = 0;
     const IntVector2& rootSize = rootElement_->GetSize();
     const IntVector2& rootPos = rootElement_->GetPosition();
     // Note: the scissors operate on unscaled coordinates. Scissor scaling is only performed during render
@@ -436,10 +446,15 @@ void UI::RenderUpdate()
     if (cursor_ && cursor_->IsVisible() && !osCursorVisible)
     {
         currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
-        cursor_->GetBatches(batches_, vertexData_, currentScissor);
+        GetElementBatches(batches_, vertexData_, cursor_, currentScissor);
         GetBatches(batches_, vertexData_, cursor_, currentScissor);
     }
 
+    // The vertex data is unchanged if no element regenerated its batches and the same elements were rendered in the same order
+    if (batchesRegenerated_ || batchSignature_ != lastBatchSignature_)
+        vertexDataDirty_ = true;
+    lastBatchSignature_ = batchSignature_;
+
     // Get batches for UI elements rendered into textures. Each element rendered into texture is treated as root element.
     for (Vector<WeakPtr<UIComponent> >::Iterator it = renderToTexture_.Begin(); it != renderToTexture_.End();)
     {
@@ -485,7 +500,11 @@ void UI::Render(bool renderUICommand)
     // Perform the default backbuffer render only if not rendered yet, or additional renders through RenderUI command
     if (renderUICommand || !uiRendered_)
     {
-        SetVertexData(vertexBuffer_, vertexData_);
+        if (vertexDataDirty_ || vertexBuffer_->IsDataLost())
+        {
+            SetVertexData(vertexBuffer_, vertexData_);
+            vertexDataDirty_ = false;
+        }
         SetVertexData(debugVertexBuffer_, debugVertexData_);
 
         if (!renderUICommand)
@@ -681,6 +700,11 @@ void UI::SetUseMutableGlyphs(bool enable)
     }
 }
 
+void UI::SetUseBatchCaching(bool enable)
+{
+    useBatchCaching_ = enable;
+}
+
 void UI::SetForceAutoHint(bool enable)
 {
     if (enable != forceAutoHint_)
@@ -720,6 +744,11 @@ void UI::SetFontOversampling(int oversampling)
     }
 }
 
+void UI::SetFontCachePath(const String& path)
+{
+    fontCachePath_ = path.Trimmed();
+}
+
 void UI::SetScale(float scale)
 {
     uiScale_ = Max(scale, M_EPSILON);
@@ -1107,7 +1136,7 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
             while (j != children.End() && (*j)->GetPriority() == currentPriority)
             {
                 if ((*j)->IsWithinScissor(currentScissor) && (*j) != cursor_)
-                    (*j)->GetBatches(batches, vertexData, currentScissor);
+                    GetElementBatches(batches, vertexData, *j, currentScissor);
                 ++j;
             }
             // Now recurse into the children
@@ -1127,7 +1156,7 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
             if ((*i) != cursor_)
             {
                 if ((*i)->IsWithinScissor(currentScissor))
-                    (*i)->GetBatches(batches, vertexData, currentScissor);
+                    GetElementBatches(batches, vertexData, *i, currentScissor);
                 if ((*i)->IsVisible())
                     GetBatches(batches, vertexData, *i, currentScissor);
             }
@@ -1136,6 +1165,25 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
     }
 }
 
+void UI::GetElementBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element,
+    const IntRect& currentScissor)
+{
+    if (useBatchCaching_)
+    {
+        if (element->GetCachedBatches(batches, vertexData, currentScissor))
+            batchesRegenerated_ = true;
+    }
+    else
+    {
+        element->GetBatches(batches, vertexData, currentScissor);
+        element->MarkBatchesDirty();
+        batchesRegenerated_ = true;
+    }
+
+    batchSignature_ = batchSignature_ * 31 + MakeHash(element);
+    batchSignature_ = batchSignature_ * 31 + vertexData.Size();
+}
+
 void UI::GetElementAt(UIElement*& result, UIElement* current, const IntVector2& position, bool enabledOnly)
 {
     if (!current)
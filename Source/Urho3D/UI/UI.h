@@ -108,6 +108,8 @@ public:
     void SetUseScreenKeyboard(bool enable);
     /// Set whether to use mutable (eraseable) glyphs to ensure a font face never expands to more than one texture. Default false.
     void SetUseMutableGlyphs(bool enable);
+    /// Set whether to cache the rendering batches of unchanged UI elements between frames. Default true.
+    void SetUseBatchCaching(bool enable);
     /// Set whether to force font autohinting instead of using FreeType's TTF bytecode interpreter.
     void SetForceAutoHint(bool enable);
     /// Set the hinting level used by FreeType fonts.
@@ -116,6 +118,8 @@ public:
     void SetFontSubpixelThreshold(float threshold);
     /// Set the oversampling (horizonal stretching) used to improve subpixel font rendering. Only affects fonts smaller than the subpixel limit.
     void SetFontOversampling(int oversampling);
+    /// Set directory for caching pre-rasterized font faces between runs. Faces whose glyphs fit in one texture are loaded from the cache when it matches the font data and rendering settings. Empty (default) to disable.
+    void SetFontCachePath(const String& path);
     /// Set %UI scale. 1.0 is default (pixel perfect). Resize the root element to match.
     void SetScale(float scale);
     /// Scale %UI to the specified width in pixels.
@@ -188,6 +192,9 @@ public:
     /// Return whether is using mutable (eraseable) glyphs for fonts.
     bool GetUseMutableGlyphs() const { return useMutableGlyphs_; }
 
+    /// Return whether is caching the rendering batches of unchanged UI elements.
+    bool GetUseBatchCaching() const { return useBatchCaching_; }
+
     /// Return whether is using forced autohinting.
     bool GetForceAutoHint() const { return forceAutoHint_; }
 
@@ -200,6 +207,9 @@ public:
     /// Get the oversampling (horizonal stretching) used to improve subpixel font rendering. Only affects fonts smaller than the subpixel limit.
     int GetFontOversampling() const { return fontOversampling_; }
 
+    /// Return font cache directory.
+    const String& GetFontCachePath() const { return fontCachePath_; }
+
     /// Return true when UI has modal element(s).
     bool HasModalElement() const;
 
@@ -243,6 +253,8 @@ private:
     void Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
     /// Generate batches from an UI element recursively. Skip the cursor element.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor);
+    /// Generate batches from a single UI element, reusing its cached batches if possible.
+    void GetElementBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, const IntRect& currentScissor);
     /// Return UI element at global screen coordinates. Return position converted to element's screen coordinates.
     UIElement* GetElementAt(const IntVector2& position, bool enabledOnly, IntVector2* elementScreenPosition);
     /// Return UI element at screen position recursively.
@@ -365,6 +377,8 @@ private:
     bool useScreenKeyboard_;
     /// Flag for using mutable (erasable) font glyphs.
     bool useMutableGlyphs_;
+    /// Flag for caching UI element batches between frames.
+    bool useBatchCaching_;
     /// Flag for forcing FreeType auto hinting.
     bool forceAutoHint_;
     /// FreeType hinting level (default is FONT_HINT_LEVEL_NORMAL).
@@ -373,10 +387,20 @@ private:
     float fontSubpixelThreshold_;
     /// Horizontal oversampling for subpixel fonts (default is 2).
     int fontOversampling_;
+    /// Font cache directory.
+    String fontCachePath_;
     /// Flag for UI already being rendered this frame.
     bool uiRendered_;
     /// Non-modal batch size (used internally for rendering).
     unsigned nonModalBatchSize_;
+    /// Flag for any element batches having been regenerated during the batch update.
+    bool batchesRegenerated_;
+    /// Signature of the elements and vertex ranges generated during the batch update.
+    unsigned batchSignature_;
+    /// Signature of the previous non-texture batch update.
+    unsigned lastBatchSignature_;
+    /// Flag for vertex data needing to be uploaded to the vertex buffer.
+    bool vertexDataDirty_;
     /// Timer used to trigger double click.
     Timer clickTimer_;
     /// UI element last clicked for tracking double clicks.
@@ -26,6 +26,7 @@
 #include "../Core/CoreEvents.h"
 #include "../Container/HashSet.h"
 #include "../Container/Sort.h"
+#include "../Graphics/Texture.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/ObjectAnimation.h"
@@ -139,7 +140,10 @@ UIElement::UIElement(Context* context) :
     maxOffset_(IntVector2::ZERO),
     enableAnchor_(false),
     pivot_(std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
-    pivotSet_(false)
+    pivotSet_(false),
+    cachedScissor_(IntRect::ZERO),
+    cachedHovering_(false),
+    batchesDirty_(true)
 {
     SetEnabled(false);
 }
@@ -201,6 +205,14 @@ void UIElement::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Tags", StringVector, tags_, Variant::emptyStringVector, AM_FILE);
 }
 
+void UIElement::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
+{
+    Animatable::OnSetAttribute(attr, src);
+
+    // Some attributes write directly to members that affect rendering, so regenerate the batches
+    MarkBatchesDirty();
+}
+
 void UIElement::ApplyAttributes()
 {
     colorGradient_ = false;
@@ -870,6 +882,7 @@ void UIElement::SetColor(const Color& color)
         color_[i] = color;
     colorGradient_ = false;
     derivedColorDirty_ = true;
+    batchesDirty_ = true;
 }
 
 void UIElement::SetColor(Corner corner, const Color& color)
@@ -877,6 +890,7 @@ void UIElement::SetColor(Corner corner, const Color& color)
     color_[corner] = color;
     colorGradient_ = false;
     derivedColorDirty_ = true;
+    batchesDirty_ = true;
 
     for (unsigned i = 0; i < MAX_UIELEMENT_CORNERS; ++i)
     {
@@ -927,6 +941,7 @@ void UIElement::SetSortChildren(bool enable)
 void UIElement::SetUseDerivedOpacity(bool enable)
 {
     useDerivedOpacity_ = enable;
+    batchesDirty_ = true;
 }
 
 void UIElement::SetEnabled(bool enable)
@@ -997,6 +1012,7 @@ void UIElement::SetFocus(bool enable)
 void UIElement::SetSelected(bool enable)
 {
     selected_ = enable;
+    batchesDirty_ = true;
 }
 
 void UIElement::SetVisible(bool enable)
@@ -1119,6 +1135,7 @@ void UIElement::SetLayoutFlexScale(const Vector2& scale)
 void UIElement::SetIndent(int indent)
 {
     indent_ = indent;
+    batchesDirty_ = true;
     if (parent_)
         parent_->UpdateLayout();
     UpdateLayout();
@@ -1128,6 +1145,7 @@ void UIElement::SetIndent(int indent)
 void UIElement::SetIndentSpacing(int indentSpacing)
 {
     indentSpacing_ = Max(indentSpacing, 0);
+    batchesDirty_ = true;
     if (parent_)
         parent_->UpdateLayout();
     UpdateLayout();
@@ -1873,6 +1891,64 @@ void UIElement::GetBatchesWithOffset(IntVector2& offset, PODVector<UIBatch>& bat
     }
 }
 
+bool UIElement::GetCachedBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
+{
+    if (!CanCacheBatches())
+    {
+        GetBatches(batches, vertexData, currentScissor);
+        batchesDirty_ = true;
+        return true;
+    }
+
+    bool regenerate = batchesDirty_ || hovering_ != cachedHovering_ || currentScissor != cachedScissor_;
+    if (!regenerate)
+    {
+        // Texture coordinates were calculated from the texture size, so regenerate if a texture has been resized
+        for (PODVector<UIBatch>::ConstIterator i = cachedBatches_.Begin(); i != cachedBatches_.End(); ++i)
+        {
+            if (i->texture_ && i->invTextureSize_ != Vector2(1.0f / (float)i->texture_->GetWidth(), 1.0f /
+                (float)i->texture_->GetHeight()))
+            {
+                regenerate = true;
+                break;
+            }
+        }
+    }
+
+    if (regenerate)
+    {
+        cachedBatches_.Clear();
+        cachedVertexData_.Clear();
+        cachedHovering_ = hovering_;
+        cachedScissor_ = currentScissor;
+        GetBatches(cachedBatches_, cachedVertexData_, currentScissor);
+        batchesDirty_ = false;
+    }
+    else
+    {
+        // Reset hovering for next frame, as GetBatches() would have done
+        hovering_ = false;
+    }
+
+    unsigned vertexStart = vertexData.Size();
+    if (cachedVertexData_.Size())
+    {
+        vertexData.Resize(vertexStart + cachedVertexData_.Size());
+        memcpy(&vertexData[vertexStart], &cachedVertexData_[0], cachedVertexData_.Size() * sizeof(float));
+    }
+
+    for (PODVector<UIBatch>::ConstIterator i = cachedBatches_.Begin(); i != cachedBatches_.End(); ++i)
+    {
+        UIBatch batch(*i);
+        batch.vertexData_ = &vertexData;
+        batch.vertexStart_ += vertexStart;
+        batch.vertexEnd_ += vertexStart;
+        UIBatch::AddOrMerge(batch, batches);
+    }
+
+    return regenerate;
+}
+
 UIElement* UIElement::GetElementEventSender() const
 {
     UIElement* element = const_cast<UIElement*>(this);
@@ -1960,6 +2036,7 @@ void UIElement::MarkDirty()
     positionDirty_ = true;
     opacityDirty_ = true;
     derivedColorDirty_ = true;
+    batchesDirty_ = true;
 
     for (Vector<SharedPtr<UIElement> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
         (*i)->MarkDirty();
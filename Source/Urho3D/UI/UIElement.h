@@ -123,6 +123,8 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
 
+    /// Handle attribute write access.
+    virtual void OnSetAttribute(const AttributeInfo& attr, const Variant& src) override;
     /// Apply attribute changes that can not be applied immediately.
     virtual void ApplyAttributes() override;
     /// Load from XML data. Return true if successful.
@@ -142,6 +144,8 @@ public:
     virtual const IntVector2& GetScreenPosition() const;
     /// Return UI rendering batches.
     virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+    /// Return whether the rendering batches can be cached and reused until the element is marked dirty. Elements whose batches depend on state outside their own setters should return false.
+    virtual bool CanCacheBatches() const { return true; }
     /// Return UI rendering batches for debug draw.
     virtual void GetDebugDrawBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
     /// React to mouse hover.
@@ -618,6 +622,10 @@ public:
     void AdjustScissor(IntRect& currentScissor);
     /// Get UI rendering batches with a specified offset. Also recurse to child elements.
     void GetBatchesWithOffset(IntVector2& offset, PODVector<UIBatch>& batches, PODVector<float>& vertexData, IntRect currentScissor);
+    /// Get UI rendering batches, reusing the batches cached on the previous call if the element has not changed. Return true if the batches were regenerated.
+    bool GetCachedBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+    /// Mark cached rendering batches as needing regeneration. Called automatically by setters; call manually after changing rendering state by other means.
+    void MarkBatchesDirty() { batchesDirty_ = true; }
 
     /// Return color attribute. Uses just the top-left color.
     const Color& GetColorAttr() const { return color_[0]; }
@@ -799,6 +807,16 @@ private:
     static XPathQuery styleXPathQuery_;
     /// Tag list.
     StringVector tags_;
+    /// Cached rendering batches. Vertex ranges refer to the cached vertex data.
+    PODVector<UIBatch> cachedBatches_;
+    /// Cached rendering vertex data.
+    PODVector<float> cachedVertexData_;
+    /// Scissor used when the cached batches were generated.
+    IntRect cachedScissor_;
+    /// Hovering state when the cached batches were generated.
+    bool cachedHovering_;
+    /// Cached batches dirty flag.
+    bool batchesDirty_;
 };
 
 template <class T> T* UIElement::CreateChild(const String& name, unsigned index)
@@ -301,6 +301,14 @@ URHO3D_EVENT(E_ITEMDOUBLECLICKED, ItemDoubleClicked)
     URHO3D_PARAM(P_QUALIFIERS, Qualifiers);        // int
 }
 
+/// Listview in virtual mode requests the content of an item element, which now represents the item at the index.
+URHO3D_EVENT(E_VIRTUALITEMUPDATE, VirtualItemUpdate)
+{
+    URHO3D_PARAM(P_ELEMENT, Element);              // UIElement pointer
+    URHO3D_PARAM(P_ITEM, Item);                    // UIElement pointer
+    URHO3D_PARAM(P_INDEX, Index);                  // int
+}
+
 /// LineEdit or ListView unhandled key pressed.
 URHO3D_EVENT(E_UNHANDLEDKEY, UnhandledKey)
 {
@@ -289,6 +289,7 @@ void Window::SetModal(bool modal)
     if (ui->SetModalElement(this, modal))
     {
         modal_ = modal;
+        MarkBatchesDirty();
 
         using namespace ModalChanged;
 
@@ -57,6 +57,8 @@ public:
 
     /// Return UI rendering batches.
     virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the rendering batches can be cached. The modal shade depends on the root element size.
+    virtual bool CanCacheBatches() const override { return !modal_; }
 
     /// React to mouse hover.
     virtual void OnHover(const IntVector2& position, const IntVector2& screenPosition, int buttons, int qualifiers, Cursor* cursor) override;
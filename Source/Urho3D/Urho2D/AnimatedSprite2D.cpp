@@ -303,7 +303,7 @@ void AnimatedSprite2D::UpdateSpineAnimation(float timeStep)
     spSkeleton_updateWorldTransform(skeleton_);
 
     sourceBatchesDirty_ = true;
-    worldBoundingBoxDirty_ = true;
+    MarkBoundingBoxDirty();
 }
 
 void AnimatedSprite2D::UpdateSourceBatchesSpine()
@@ -431,7 +431,7 @@ void AnimatedSprite2D::UpdateSpriterAnimation(float timeStep)
 {
     spriterInstance_->Update(timeStep * speed_);
     sourceBatchesDirty_ = true;
-    worldBoundingBoxDirty_ = true;
+    MarkBoundingBoxDirty();
 }
 
 void AnimatedSprite2D::UpdateSourceBatchesSpriter()
@@ -47,7 +47,12 @@ Drawable2D::Drawable2D(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY2D),
     layer_(0),
     orderInLayer_(0),
-    sourceBatchesDirty_(true)
+    sourceBatchesDirty_(true),
+    gridCell_(IntVector2::ZERO),
+    gridIndex_(M_MAX_UNSIGNED),
+    gridLarge_(false),
+    gridQueued_(false),
+    gridAdded_(false)
 {
 }
 
@@ -127,6 +132,17 @@ void Drawable2D::OnMarkedDirty(Node* node)
     Drawable::OnMarkedDirty(node);
 
     sourceBatchesDirty_ = true;
+
+    if (renderer_)
+        renderer_->QueueUpdate(this);
+}
+
+void Drawable2D::MarkBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+
+    if (renderer_)
+        renderer_->QueueUpdate(this);
 }
 
 }
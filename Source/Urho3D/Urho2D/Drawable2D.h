@@ -70,6 +70,8 @@ class URHO3D_API Drawable2D : public Drawable
 {
     URHO3D_OBJECT(Drawable2D, Drawable);
 
+    friend class Renderer2D;
+
 public:
     /// Construct.
     Drawable2D(Context* context);
@@ -107,6 +109,8 @@ protected:
 
     /// Return draw order by layer and order in layer.
     int GetDrawOrder() const { return (layer_ << 20) + (orderInLayer_ << 10); }
+    /// Mark world bounding box dirty when the geometry changes without the node moving. Queues an update of the Renderer2D spatial index.
+    void MarkBoundingBoxDirty();
 
     /// Layer.
     int layer_;
@@ -118,6 +122,18 @@ protected:
     bool sourceBatchesDirty_;
     /// Renderer2D.
     WeakPtr<Renderer2D> renderer_;
+
+private:
+    /// Renderer2D spatial index cell.
+    IntVector2 gridCell_;
+    /// Index in the spatial index cell or large drawable list. M_MAX_UNSIGNED if not inserted yet.
+    unsigned gridIndex_;
+    /// Whether is in the large drawable list instead of a cell.
+    bool gridLarge_;
+    /// Whether is queued for a spatial index update.
+    bool gridQueued_;
+    /// Whether is added to the Renderer2D.
+    bool gridAdded_;
 };
 
 }
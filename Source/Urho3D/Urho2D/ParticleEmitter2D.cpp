@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Material.h"
 #include "../Resource/ResourceCache.h"
@@ -42,6 +43,36 @@ namespace Urho3D
 extern const char* URHO2D_CATEGORY;
 extern const char* blendModeNames[];
 
+static const unsigned MIN_PARTICLES_PER_WORK_ITEM = 1024;
+
+/// Range of particles updated by one work item, and the resulting bounds.
+struct Particle2DUpdateRange
+{
+    /// Emitter.
+    ParticleEmitter2D* emitter_;
+    /// First particle index.
+    unsigned start_;
+    /// End particle index (exclusive).
+    unsigned end_;
+    /// Timestep.
+    float timeStep_;
+    /// World scale.
+    float worldScale_;
+    /// Bounding box min point of the range.
+    Vector3 minPoint_;
+    /// Bounding box max point of the range.
+    Vector3 maxPoint_;
+};
+
+void UpdateParticles2DWork(const WorkItem* item, unsigned threadIndex)
+{
+    Particle2DUpdateRange& range = *(reinterpret_cast<Particle2DUpdateRange*>(item->aux_));
+    ParticleEmitter2D* emitter = range.emitter_;
+
+    for (unsigned i = range.start_; i < range.end_; ++i)
+        emitter->UpdateParticle(emitter->particles_[i], range.timeStep_, range.worldScale_, range.minPoint_, range.maxPoint_);
+}
+
 ParticleEmitter2D::ParticleEmitter2D(Context* context) :
     Drawable2D(context),
     blendMode_(BLEND_ADDALPHA),
@@ -240,6 +271,10 @@ void ParticleEmitter2D::UpdateSourceBatches()
     vertex2.uv_ = textureRect.max_;
     vertex3.uv_ = Vector2(textureRect.max_.x_, textureRect.min_.y_);
 
+    // Size the vertex array once and write the quads in place
+    vertices.Resize(numParticles_ * 4);
+    Vertex2D* dest = vertices.Buffer();
+
     for (unsigned i = 0; i < numParticles_; ++i)
     {
         Particle2D& p = particles_[i];
@@ -257,10 +292,11 @@ void ParticleEmitter2D::UpdateSourceBatches()
 
         vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ = p.color_.ToUInt();
 
-        vertices.Push(vertex0);
-        vertices.Push(vertex1);
-        vertices.Push(vertex2);
-        vertices.Push(vertex3);
+        dest[0] = vertex0;
+        dest[1] = vertex1;
+        dest[2] = vertex2;
+        dest[3] = vertex3;
+        dest += 4;
     }
 
     sourceBatchesDirty_ = false;
@@ -319,15 +355,12 @@ void ParticleEmitter2D::Update(float timeStep)
     boundingBoxMinPoint_ = Vector3(M_INFINITY, M_INFINITY, M_INFINITY);
     boundingBoxMaxPoint_ = Vector3(-M_INFINITY, -M_INFINITY, -M_INFINITY);
 
+    // Remove expired particles first, so that the remaining ones can be updated independently of each other
     unsigned particleIndex = 0;
     while (particleIndex < numParticles_)
     {
-        Particle2D& particle = particles_[particleIndex];
-        if (particle.timeToLive_ > 0.0f)
-        {
-            UpdateParticle(particle, timeStep, worldPosition, worldScale);
+        if (particles_[particleIndex].timeToLive_ > 0.0f)
             ++particleIndex;
-        }
         else
         {
             if (particleIndex != numParticles_ - 1)
@@ -336,6 +369,45 @@ void ParticleEmitter2D::Update(float timeStep)
         }
     }
 
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = Min(queue->GetNumThreads() + 1, numParticles_ / MIN_PARTICLES_PER_WORK_ITEM);
+    if (numWorkItems > 1 && !queue->IsCompleting())
+    {
+        // Split large emitters into ranges updated in parallel, then merge the bounds of each range
+        PODVector<Particle2DUpdateRange> ranges(numWorkItems);
+        unsigned particlesPerItem = numParticles_ / numWorkItems;
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            Particle2DUpdateRange& range = ranges[i];
+            range.emitter_ = this;
+            range.start_ = i * particlesPerItem;
+            range.end_ = i < numWorkItems - 1 ? range.start_ + particlesPerItem : numParticles_;
+            range.timeStep_ = timeStep;
+            range.worldScale_ = worldScale;
+            range.minPoint_ = boundingBoxMinPoint_;
+            range.maxPoint_ = boundingBoxMaxPoint_;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = UpdateParticles2DWork;
+            item->aux_ = &range;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            boundingBoxMinPoint_ = VectorMin(boundingBoxMinPoint_, ranges[i].minPoint_);
+            boundingBoxMaxPoint_ = VectorMax(boundingBoxMaxPoint_, ranges[i].maxPoint_);
+        }
+    }
+    else
+    {
+        for (unsigned i = 0; i < numParticles_; ++i)
+            UpdateParticle(particles_[i], timeStep, worldScale, boundingBoxMinPoint_, boundingBoxMaxPoint_);
+    }
+
     if (emitting_ && emissionTime_ > 0.0f)
     {
         float worldAngle = GetNode()->GetWorldRotation().RollAngle();
@@ -346,7 +418,7 @@ void ParticleEmitter2D::Update(float timeStep)
         while (emitParticleTime_ > 0.0f)
         {
             if (EmitParticle(worldPosition, worldAngle, worldScale))
-                UpdateParticle(particles_[numParticles_ - 1], emitParticleTime_, worldPosition, worldScale);
+                UpdateParticle(particles_[numParticles_ - 1], emitParticleTime_, worldScale, boundingBoxMinPoint_, boundingBoxMaxPoint_);
 
             emitParticleTime_ -= timeBetweenParticles;
         }
@@ -414,7 +486,7 @@ bool ParticleEmitter2D::EmitParticle(const Vector3& worldPosition, float worldAn
     return true;
 }
 
-void ParticleEmitter2D::UpdateParticle(Particle2D& particle, float timeStep, const Vector3& worldPosition, float worldScale)
+void ParticleEmitter2D::UpdateParticle(Particle2D& particle, float timeStep, float worldScale, Vector3& minPoint, Vector3& maxPoint) const
 {
     if (timeStep > particle.timeToLive_)
         timeStep = particle.timeToLive_;
@@ -462,12 +534,12 @@ void ParticleEmitter2D::UpdateParticle(Particle2D& particle, float timeStep, con
     particle.color_ += particle.colorDelta_ * timeStep;
 
     float halfSize = particle.size_ * 0.5f;
-    boundingBoxMinPoint_.x_ = Min(boundingBoxMinPoint_.x_, particle.position_.x_ - halfSize);
-    boundingBoxMinPoint_.y_ = Min(boundingBoxMinPoint_.y_, particle.position_.y_ - halfSize);
-    boundingBoxMinPoint_.z_ = Min(boundingBoxMinPoint_.z_, particle.position_.z_);
-    boundingBoxMaxPoint_.x_ = Max(boundingBoxMaxPoint_.x_, particle.position_.x_ + halfSize);
-    boundingBoxMaxPoint_.y_ = Max(boundingBoxMaxPoint_.y_, particle.position_.y_ + halfSize);
-    boundingBoxMaxPoint_.z_ = Max(boundingBoxMaxPoint_.z_, particle.position_.z_);
+    minPoint.x_ = Min(minPoint.x_, particle.position_.x_ - halfSize);
+    minPoint.y_ = Min(minPoint.y_, particle.position_.y_ - halfSize);
+    minPoint.z_ = Min(minPoint.z_, particle.position_.z_);
+    maxPoint.x_ = Max(maxPoint.x_, particle.position_.x_ + halfSize);
+    maxPoint.y_ = Max(maxPoint.y_, particle.position_.y_ + halfSize);
+    maxPoint.z_ = Max(maxPoint.z_, particle.position_.z_);
 }
 
 }
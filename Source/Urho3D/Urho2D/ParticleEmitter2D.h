@@ -29,6 +29,7 @@ namespace Urho3D
 
 class ParticleEffect2D;
 class Sprite2D;
+struct WorkItem;
 
 /// 2D particle.
 struct Particle2D
@@ -77,6 +78,8 @@ class URHO3D_API ParticleEmitter2D : public Drawable2D
 {
     URHO3D_OBJECT(ParticleEmitter2D, Drawable2D);
 
+    friend void UpdateParticles2DWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     ParticleEmitter2D(Context* context);
@@ -138,8 +141,8 @@ private:
     void Update(float timeStep);
     /// Emit particle.
     bool EmitParticle(const Vector3& worldPosition, float worldAngle, float worldScale);
-    /// Update particle.
-    void UpdateParticle(Particle2D& particle, float timeStep, const Vector3& worldPosition, float worldScale);
+    /// Update particle and merge it into the bounding box points. May be called from worker threads on separate particles.
+    void UpdateParticle(Particle2D& particle, float timeStep, float worldScale, Vector3& minPoint, Vector3& maxPoint) const;
 
     /// Particle effect.
     SharedPtr<ParticleEffect2D> effect_;
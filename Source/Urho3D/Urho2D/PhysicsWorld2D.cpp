@@ -24,6 +24,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Renderer.h"
@@ -45,12 +47,102 @@ extern const char* SUBSYSTEM_CATEGORY;
 static const Vector2 DEFAULT_GRAVITY(0.0f, -9.81f);
 static const int DEFAULT_VELOCITY_ITERATIONS = 8;
 static const int DEFAULT_POSITION_ITERATIONS = 3;
+static const unsigned WORK_ITEMS_PER_THREAD = 4;
+static const unsigned MIN_QUERIES_PER_WORK_ITEM = 16;
+
+/// Range of Box2D islands solved by one work item.
+struct PhysicsSolveRange2D
+{
+    /// Box2D solver task.
+    b2Task* task_;
+    /// First island index.
+    int32 start_;
+    /// End island index (exclusive).
+    int32 end_;
+};
+
+/// Batched 2D physics query type.
+enum PhysicsQueryType2D
+{
+    PQT_RAYCASTSINGLE = 0,
+    PQT_POINT,
+    PQT_AABB
+};
+
+/// Batch of 2D physics queries, or a range of it executed by one work item.
+struct PhysicsQueryBatch2D
+{
+    /// Physics world.
+    PhysicsWorld2D* world_;
+    /// Query type.
+    PhysicsQueryType2D type_;
+    /// Query parameters.
+    const void* queries_;
+    /// Query results.
+    void* results_;
+    /// Collision mask for point and box queries.
+    unsigned collisionMask_;
+    /// First query index.
+    unsigned start_;
+    /// End query index (exclusive).
+    unsigned end_;
+};
+
+static void SolveIslandsWork(const WorkItem* item, unsigned threadIndex)
+{
+    const PhysicsSolveRange2D& range = *(reinterpret_cast<PhysicsSolveRange2D*>(item->aux_));
+    range.task_->Execute(range.start_, range.end_);
+}
+
+static void ExecuteQueries(const PhysicsQueryBatch2D& batch)
+{
+    PhysicsWorld2D* world = batch.world_;
+
+    switch (batch.type_)
+    {
+    case PQT_RAYCASTSINGLE:
+        {
+            const PhysicsRaycastQuery2D* queries = reinterpret_cast<const PhysicsRaycastQuery2D*>(batch.queries_);
+            PhysicsRaycastResult2D* results = reinterpret_cast<PhysicsRaycastResult2D*>(batch.results_);
+            for (unsigned i = batch.start_; i < batch.end_; ++i)
+                world->RaycastSingle(results[i], queries[i].startPoint_, queries[i].endPoint_, queries[i].collisionMask_);
+        }
+        break;
+
+    case PQT_POINT:
+        {
+            const Vector2* points = reinterpret_cast<const Vector2*>(batch.queries_);
+            RigidBody2D** results = reinterpret_cast<RigidBody2D**>(batch.results_);
+            for (unsigned i = batch.start_; i < batch.end_; ++i)
+                results[i] = world->GetRigidBody(points[i], batch.collisionMask_);
+        }
+        break;
+
+    case PQT_AABB:
+        {
+            const Rect* aabbs = reinterpret_cast<const Rect*>(batch.queries_);
+            PODVector<RigidBody2D*>* results = reinterpret_cast<PODVector<RigidBody2D*>*>(batch.results_);
+            for (unsigned i = batch.start_; i < batch.end_; ++i)
+            {
+                results[i].Clear();
+                world->GetRigidBodies(results[i], aabbs[i], batch.collisionMask_);
+            }
+        }
+        break;
+    }
+}
+
+static void ExecuteQueriesWork(const WorkItem* item, unsigned threadIndex)
+{
+    ExecuteQueries(*(reinterpret_cast<PhysicsQueryBatch2D*>(item->aux_)));
+}
 
 PhysicsWorld2D::PhysicsWorld2D(Context* context) :
     Component(context),
     gravity_(DEFAULT_GRAVITY),
     velocityIterations_(DEFAULT_VELOCITY_ITERATIONS),
     positionIterations_(DEFAULT_POSITION_ITERATIONS),
+    parallelSolve_(true),
     debugRenderer_(nullptr),
     physicsStepping_(false),
     applyingTransforms_(false),
@@ -65,6 +157,8 @@ PhysicsWorld2D::PhysicsWorld2D(Context* context) :
     world_->SetContactListener(this);
     // Set debug draw
     world_->SetDebugDraw(this);
+    // Set island solver task executor
+    world_->SetTaskExecutor(this);
 }
 
 PhysicsWorld2D::~PhysicsWorld2D()
@@ -93,6 +187,7 @@ void PhysicsWorld2D::RegisterObject(Context* context)
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Position Iterations", GetPositionIterations, SetPositionIterations, int, DEFAULT_POSITION_ITERATIONS,
         AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Parallel Solve", GetParallelSolve, SetParallelSolve, bool, true, AM_DEFAULT);
 }
 
 void PhysicsWorld2D::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -280,6 +375,35 @@ void PhysicsWorld2D::DrawTransform(const b2Transform& xf)
     debugRenderer_->AddLine(Vector3(p1.x, p1.y, 0.0f), Vector3(p2.x, p2.y, 0.0f), Color::GREEN, debugDepthTest_);
 }
 
+void PhysicsWorld2D::ParallelFor(b2Task* task, int32 count)
+{
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? Min((queue->GetNumThreads() + 1) * WORK_ITEMS_PER_THREAD, (unsigned)count) : 0;
+    if (numWorkItems > 1 && queue->GetNumThreads() && Thread::IsMainThread() && !queue->IsCompleting())
+    {
+        // Use more work items than threads, as island sizes vary a lot
+        PODVector<PhysicsSolveRange2D> ranges(numWorkItems);
+        int32 islandsPerItem = count / numWorkItems;
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            PhysicsSolveRange2D& range = ranges[i];
+            range.task_ = task;
+            range.start_ = i * islandsPerItem;
+            range.end_ = i < numWorkItems - 1 ? range.start_ + islandsPerItem : count;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = SolveIslandsWork;
+            item->aux_ = &range;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+        task->Execute(0, count);
+}
+
 void PhysicsWorld2D::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics2D);
@@ -431,6 +555,12 @@ void PhysicsWorld2D::SetPositionIterations(int positionIterations)
     positionIterations_ = positionIterations;
 }
 
+void PhysicsWorld2D::SetParallelSolve(bool enable)
+{
+    parallelSolve_ = enable;
+    world_->SetTaskExecutor(enable ? this : nullptr);
+}
+
 void PhysicsWorld2D::AddRigidBody(RigidBody2D* rigidBody)
 {
     if (!rigidBody)
@@ -681,6 +811,83 @@ void PhysicsWorld2D::GetRigidBodies(PODVector<RigidBody2D*>& results, const Rect
     world_->QueryAABB(&callback, b2Aabb);
 }
 
+void PhysicsWorld2D::RaycastSingleBatch(PODVector<PhysicsRaycastResult2D>& results, const PODVector<PhysicsRaycastQuery2D>& queries)
+{
+    URHO3D_PROFILE(Physics2DRaycastBatch);
+
+    results.Resize(queries.Size());
+
+    PhysicsQueryBatch2D batch;
+    batch.type_ = PQT_RAYCASTSINGLE;
+    batch.queries_ = queries.Buffer();
+    batch.results_ = results.Buffer();
+    batch.collisionMask_ = M_MAX_UNSIGNED;
+    ExecuteQueryBatch(batch, queries.Size());
+}
+
+void PhysicsWorld2D::GetRigidBodyBatch(PODVector<RigidBody2D*>& results, const PODVector<Vector2>& points, unsigned collisionMask)
+{
+    URHO3D_PROFILE(Physics2DPointQueryBatch);
+
+    results.Resize(points.Size());
+
+    PhysicsQueryBatch2D batch;
+    batch.type_ = PQT_POINT;
+    batch.queries_ = points.Buffer();
+    batch.results_ = results.Buffer();
+    batch.collisionMask_ = collisionMask;
+    ExecuteQueryBatch(batch, points.Size());
+}
+
+void PhysicsWorld2D::GetRigidBodiesBatch(Vector<PODVector<RigidBody2D*> >& results, const PODVector<Rect>& aabbs,
+    unsigned collisionMask)
+{
+    URHO3D_PROFILE(Physics2DBoxQueryBatch);
+
+    results.Resize(aabbs.Size());
+
+    PhysicsQueryBatch2D batch;
+    batch.type_ = PQT_AABB;
+    batch.queries_ = aabbs.Buffer();
+    batch.results_ = results.Buffer();
+    batch.collisionMask_ = collisionMask;
+    ExecuteQueryBatch(batch, aabbs.Size());
+}
+
+void PhysicsWorld2D::ExecuteQueryBatch(const PhysicsQueryBatch2D& batch, unsigned numQueries)
+{
+    PhysicsQueryBatch2D fullBatch = batch;
+    fullBatch.world_ = this;
+    fullBatch.start_ = 0;
+    fullBatch.end_ = numQueries;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? Min(queue->GetNumThreads() + 1, numQueries / MIN_QUERIES_PER_WORK_ITEM) : 0;
+    if (numWorkItems > 1 && Thread::IsMainThread() && !queue->IsCompleting())
+    {
+        // The Box2D broadphase and shapes are only read by the queries, so they can run concurrently
+        PODVector<PhysicsQueryBatch2D> ranges(numWorkItems);
+        unsigned queriesPerItem = numQueries / numWorkItems;
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            PhysicsQueryBatch2D& range = ranges[i];
+            range = fullBatch;
+            range.start_ = i * queriesPerItem;
+            range.end_ = i < numWorkItems - 1 ? range.start_ + queriesPerItem : numQueries;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = ExecuteQueriesWork;
+            item->aux_ = &range;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+        ExecuteQueries(fullBatch);
+}
+
 bool PhysicsWorld2D::GetAllowSleeping() const
 {
     return world_->GetAllowSleeping();
@@ -33,6 +33,7 @@ namespace Urho3D
 class Camera;
 class CollisionShape2D;
 class RigidBody2D;
+struct PhysicsQueryBatch2D;
 
 /// 2D Physics raycast hit.
 struct URHO3D_API PhysicsRaycastResult2D
@@ -59,6 +60,31 @@ struct URHO3D_API PhysicsRaycastResult2D
     RigidBody2D* body_;
 };
 
+/// 2D physics raycast for batched queries.
+struct URHO3D_API PhysicsRaycastQuery2D
+{
+    /// Construct with defaults.
+    PhysicsRaycastQuery2D() :
+        collisionMask_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Construct with parameters.
+    PhysicsRaycastQuery2D(const Vector2& startPoint, const Vector2& endPoint, unsigned collisionMask = M_MAX_UNSIGNED) :
+        startPoint_(startPoint),
+        endPoint_(endPoint),
+        collisionMask_(collisionMask)
+    {
+    }
+
+    /// Ray start point.
+    Vector2 startPoint_;
+    /// Ray end point.
+    Vector2 endPoint_;
+    /// Collision mask.
+    unsigned collisionMask_;
+};
+
 /// Delayed world transform assignment for parented 2D rigidbodies.
 struct DelayedWorldTransform2D
 {
@@ -73,7 +99,7 @@ struct DelayedWorldTransform2D
 };
 
 /// 2D physics simulation world component. Should be added only to the root scene node.
-class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw
+class URHO3D_API PhysicsWorld2D : public Component, public b2ContactListener, public b2Draw, public b2TaskExecutor
 {
     URHO3D_OBJECT(PhysicsWorld2D, Component);
 
@@ -112,6 +138,10 @@ public:
     /// Draw a point.
     virtual void DrawPoint(const b2Vec2& p, float32 size, const b2Color& color) override;
 
+    // Implement b2TaskExecutor
+    /// Execute a Box2D solver task on the work queue.
+    virtual void ParallelFor(b2Task* task, int32 count) override;
+
     /// Step the simulation forward.
     void Update(float timeStep);
     /// Add debug geometry to the debug renderer.
@@ -144,6 +174,8 @@ public:
     void SetVelocityIterations(int velocityIterations);
     /// Set position iterations.
     void SetPositionIterations(int positionIterations);
+    /// Enable or disable solving independent groups of touching or jointed bodies (islands) in worker threads. Enabled by default. The result is identical to solving serially.
+    void SetParallelSolve(bool enable);
     /// Add rigid body.
     void AddRigidBody(RigidBody2D* rigidBody);
     /// Remove rigid body.
@@ -163,6 +195,13 @@ public:
     RigidBody2D* GetRigidBody(int screenX, int screenY, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Return rigid bodies by a box query.
     void GetRigidBodies(PODVector<RigidBody2D*>& result, const Rect& aabb, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of physics world raycasts in worker threads and return the closest hit of each, in the same order.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult2D>& results, const PODVector<PhysicsRaycastQuery2D>& queries);
+    /// Return rigid bodies at a batch of points, queried in worker threads. The result is null for points without a rigid body.
+    void GetRigidBodyBatch(PODVector<RigidBody2D*>& results, const PODVector<Vector2>& points, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Return rigid bodies by a batch of box queries, queried in worker threads.
+    void GetRigidBodiesBatch(Vector<PODVector<RigidBody2D*> >& results, const PODVector<Rect>& aabbs,
+        unsigned collisionMask = M_MAX_UNSIGNED);
 
     /// Return whether physics world will automatically simulate during scene update.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -202,6 +241,9 @@ public:
     /// Return position iterations.
     int GetPositionIterations() const { return positionIterations_; }
 
+    /// Return whether islands are solved in worker threads.
+    bool GetParallelSolve() const { return parallelSolve_; }
+
     /// Return the Box2D physics world.
     b2World* GetWorld() { return world_.Get(); }
 
@@ -221,6 +263,8 @@ protected:
     void SendBeginContactEvents();
     /// Send end contact events.
     void SendEndContactEvents();
+    /// Execute a batch of queries, split to worker threads if there are enough of them.
+    void ExecuteQueryBatch(const PhysicsQueryBatch2D& batch, unsigned numQueries);
 
     /// Box2D physics world.
     UniquePtr<b2World> world_;
@@ -230,6 +274,8 @@ protected:
     int velocityIterations_;
     /// Position iterations.
     int positionIterations_;
+    /// Parallel island solving flag.
+    bool parallelSolve_;
 
     /// Extra weak pointer to scene to allow for cleanup in case the world is destroyed before other components.
     WeakPtr<Scene> scene_;
@@ -23,7 +23,9 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/ParallelSort.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Geometry.h"
@@ -49,6 +51,7 @@ namespace Urho3D
 extern const char* blendModeNames[];
 
 static const unsigned MASK_VERTEX2D = MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1;
+static const float DEFAULT_CELL_SIZE = 4.0f;
 
 ViewBatchInfo2D::ViewBatchInfo2D() :
     vertexBufferUpdateFrameNumber_(0),
@@ -63,6 +66,7 @@ Renderer2D::Renderer2D(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     material_(new Material(context)),
     indexBuffer_(new IndexBuffer(context_)),
+    cellSize_(DEFAULT_CELL_SIZE),
     viewMask_(DEFAULT_VIEWMASK)
 {
     material_->SetName("Urho2D");
@@ -83,11 +87,26 @@ Renderer2D::Renderer2D(Context* context) :
 
 Renderer2D::~Renderer2D()
 {
+    // Detach the remaining drawables so that they can be added to another renderer
+    drawableUpdates_.Push(threadedDrawableUpdates_);
+    drawableUpdates_.Push(largeDrawables_);
+    for (HashMap<IntVector2, PODVector<Drawable2D*> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        drawableUpdates_.Push(i->second_);
+
+    for (unsigned i = 0; i < drawableUpdates_.Size(); ++i)
+    {
+        Drawable2D* drawable = drawableUpdates_[i];
+        drawable->gridIndex_ = M_MAX_UNSIGNED;
+        drawable->gridQueued_ = false;
+        drawable->gridAdded_ = false;
+    }
 }
 
 void Renderer2D::RegisterObject(Context* context)
 {
     context->RegisterFactory<Renderer2D>();
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
 }
 
 static inline bool CompareRayQueryResults(RayQueryResult& lr, RayQueryResult& rr)
@@ -103,13 +122,59 @@ static inline bool CompareRayQueryResults(RayQueryResult& lr, RayQueryResult& rr
     return lhs->GetID() > rhs->GetID();
 }
 
+// Return bounding box of the part of a ray that lies within a box, or an undefined box if the ray misses
+static BoundingBox GetRaySegmentBox(const Ray& ray, float maxDistance, const BoundingBox& box)
+{
+    BoundingBox segmentBox;
+    if (!box.Defined())
+        return segmentBox;
+
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float origin = ray.origin_.Data()[i];
+        float direction = ray.direction_.Data()[i];
+        float min = box.min_.Data()[i];
+        float max = box.max_.Data()[i];
+
+        if (Abs(direction) < M_EPSILON)
+        {
+            if (origin < min || origin > max)
+                return segmentBox;
+        }
+        else
+        {
+            float t1 = (min - origin) / direction;
+            float t2 = (max - origin) / direction;
+            if (t1 > t2)
+                Swap(t1, t2);
+            tMin = Max(tMin, t1);
+            tMax = Min(tMax, t2);
+            if (tMin > tMax)
+                return segmentBox;
+        }
+    }
+
+    segmentBox.Define(ray.origin_ + tMin * ray.direction_);
+    segmentBox.Merge(ray.origin_ + tMax * ray.direction_);
+    return segmentBox;
+}
+
 void Renderer2D::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
 {
+    if (Thread::IsMainThread())
+        UpdateSpatialIndex();
+
+    // Only test the drawables in cells along the ray
+    PODVector<Drawable2D*> drawables;
+    GetCellDrawables(drawables, GetRaySegmentBox(query.ray_, query.maxDistance_, gridBounds_));
+
     unsigned resultSize = results.Size();
-    for (unsigned i = 0; i < drawables_.Size(); ++i)
+    for (unsigned i = 0; i < drawables.Size(); ++i)
     {
-        if (drawables_[i]->GetViewMask() & query.viewMask_)
-            drawables_[i]->ProcessRayQuery(query, results);
+        if (drawables[i]->GetViewMask() & query.viewMask_)
+            drawables[i]->ProcessRayQuery(query, results);
     }
 
     if (results.Size() != resultSize)
@@ -228,18 +293,100 @@ UpdateGeometryType Renderer2D::GetUpdateGeometryType()
 
 void Renderer2D::AddDrawable(Drawable2D* drawable)
 {
-    if (!drawable)
+    if (!drawable || drawable->gridAdded_)
         return;
 
-    drawables_.Push(drawable);
+    drawable->gridAdded_ = true;
+    QueueUpdate(drawable);
 }
 
 void Renderer2D::RemoveDrawable(Drawable2D* drawable)
 {
-    if (!drawable)
+    if (!drawable || !drawable->gridAdded_)
         return;
 
-    drawables_.Remove(drawable);
+    RemoveFromCell(drawable);
+
+    // Removal only happens from the main thread, so the threaded queue does not need to be checked
+    if (drawable->gridQueued_)
+    {
+        drawableUpdates_.Remove(drawable);
+        drawable->gridQueued_ = false;
+    }
+
+    drawable->gridAdded_ = false;
+}
+
+void Renderer2D::QueueUpdate(Drawable2D* drawable)
+{
+    if (!drawable->gridAdded_ || drawable->gridQueued_)
+        return;
+
+    Scene* scene = GetScene();
+    if (scene && scene->IsThreadedUpdate())
+    {
+        MutexLock lock(updateMutex_);
+        threadedDrawableUpdates_.Push(drawable);
+    }
+    else
+        drawableUpdates_.Push(drawable);
+
+    drawable->gridQueued_ = true;
+}
+
+void Renderer2D::SetCellSize(float size)
+{
+    size = Max(size, M_EPSILON);
+    if (size == cellSize_)
+        return;
+
+    cellSize_ = size;
+
+    // Reinsert all drawables
+    for (HashMap<IntVector2, PODVector<Drawable2D*> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        for (unsigned j = 0; j < i->second_.Size(); ++j)
+        {
+            i->second_[j]->gridIndex_ = M_MAX_UNSIGNED;
+            QueueUpdate(i->second_[j]);
+        }
+    }
+    for (unsigned i = 0; i < largeDrawables_.Size(); ++i)
+    {
+        largeDrawables_[i]->gridIndex_ = M_MAX_UNSIGNED;
+        QueueUpdate(largeDrawables_[i]);
+    }
+
+    cells_.Clear();
+    largeDrawables_.Clear();
+    gridBounds_.Clear();
+
+    MarkNetworkUpdate();
+}
+
+void Renderer2D::GetDrawables(OctreeQuery& query)
+{
+    if (Thread::IsMainThread())
+        UpdateSpatialIndex();
+
+    PODVector<Drawable*> drawables;
+    for (unsigned i = 0; i < largeDrawables_.Size(); ++i)
+        drawables.Push(largeDrawables_[i]);
+
+    // Drawables may extend up to one cell beyond their cell
+    for (HashMap<IntVector2, PODVector<Drawable2D*> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+    {
+        BoundingBox cellBox(Vector3((i->first_.x_ - 1) * cellSize_, (i->first_.y_ - 1) * cellSize_, gridBounds_.min_.z_),
+            Vector3((i->first_.x_ + 2) * cellSize_, (i->first_.y_ + 2) * cellSize_, gridBounds_.max_.z_));
+        if (query.TestOctant(cellBox, false) == OUTSIDE)
+            continue;
+
+        for (unsigned j = 0; j < i->second_.Size(); ++j)
+            drawables.Push(i->second_[j]);
+    }
+
+    if (drawables.Size())
+        query.TestDrawables(drawables.Buffer(), drawables.Buffer() + drawables.Size(), false);
 }
 
 Material* Renderer2D::GetMaterial(Texture2D* texture, BlendMode blendMode)
@@ -335,15 +482,24 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
     frustum_ = camera->GetFrustum();
     viewMask_ = camera->GetViewMask();
 
+    // Gather drawables from the spatial index cells the view may see
+    {
+        URHO3D_PROFILE(GetViewDrawables2D);
+
+        UpdateSpatialIndex();
+        viewDrawables_.Clear();
+        GetCellDrawables(viewDrawables_, BoundingBox(frustum_));
+    }
+
     // Check visibility
     {
         URHO3D_PROFILE(CheckDrawableVisibility);
 
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = drawables_.Size() / numWorkItems;
+        int drawablesPerItem = viewDrawables_.Size() / numWorkItems;
 
-        PODVector<Drawable2D*>::Iterator start = drawables_.Begin();
+        PODVector<Drawable2D*>::Iterator start = viewDrawables_.Begin();
         for (int i = 0; i < numWorkItems; ++i)
         {
             SharedPtr<WorkItem> item = queue->GetFreeItem();
@@ -351,7 +507,7 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
             item->workFunction_ = CheckDrawableVisibilityWork;
             item->aux_ = this;
 
-            PODVector<Drawable2D*>::Iterator end = drawables_.End();
+            PODVector<Drawable2D*>::Iterator end = viewDrawables_.End();
             if (i < numWorkItems - 1 && end - start > drawablesPerItem)
                 end = start + drawablesPerItem;
 
@@ -404,6 +560,116 @@ void Renderer2D::GetDrawables(PODVector<Drawable2D*>& dest, Node* node)
         GetDrawables(dest, i->Get());
 }
 
+void Renderer2D::UpdateSpatialIndex()
+{
+    if (!threadedDrawableUpdates_.Empty())
+    {
+        MutexLock lock(updateMutex_);
+        drawableUpdates_.Push(threadedDrawableUpdates_);
+        threadedDrawableUpdates_.Clear();
+    }
+
+    if (drawableUpdates_.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateSpatialIndex2D);
+
+    for (unsigned i = 0; i < drawableUpdates_.Size(); ++i)
+    {
+        Drawable2D* drawable = drawableUpdates_[i];
+        drawable->gridQueued_ = false;
+
+        // Drawables are stored in the cell of their center, so a drawable at most twice the cell size extends at most
+        // one cell beyond it. Larger drawables and those without geometry are tested individually
+        const BoundingBox& box = drawable->GetWorldBoundingBox();
+        Vector3 halfSize = box.HalfSize();
+        bool large = !box.Defined() || halfSize.x_ > cellSize_ || halfSize.y_ > cellSize_;
+        IntVector2 cell = large ? IntVector2::ZERO : GetCell(box.Center());
+
+        if (box.Defined())
+            gridBounds_.Merge(box);
+
+        if (drawable->gridIndex_ != M_MAX_UNSIGNED && drawable->gridLarge_ == large && drawable->gridCell_ == cell)
+            continue;
+
+        RemoveFromCell(drawable);
+
+        PODVector<Drawable2D*>& drawables = large ? largeDrawables_ : cells_[cell];
+        drawable->gridCell_ = cell;
+        drawable->gridLarge_ = large;
+        drawable->gridIndex_ = drawables.Size();
+        drawables.Push(drawable);
+    }
+
+    drawableUpdates_.Clear();
+}
+
+void Renderer2D::RemoveFromCell(Drawable2D* drawable)
+{
+    if (drawable->gridIndex_ == M_MAX_UNSIGNED)
+        return;
+
+    HashMap<IntVector2, PODVector<Drawable2D*> >::Iterator cell = cells_.End();
+    PODVector<Drawable2D*>* drawables = &largeDrawables_;
+    if (!drawable->gridLarge_)
+    {
+        cell = cells_.Find(drawable->gridCell_);
+        drawables = &cell->second_;
+    }
+
+    // Swap the last drawable of the cell into the removed position
+    Drawable2D* last = drawables->Back();
+    (*drawables)[drawable->gridIndex_] = last;
+    last->gridIndex_ = drawable->gridIndex_;
+    drawables->Pop();
+    drawable->gridIndex_ = M_MAX_UNSIGNED;
+
+    if (cell != cells_.End() && drawables->Empty())
+        cells_.Erase(cell);
+}
+
+void Renderer2D::GetCellDrawables(PODVector<Drawable2D*>& dest, const BoundingBox& box) const
+{
+    dest.Push(largeDrawables_);
+
+    BoundingBox clippedBox(box);
+    clippedBox.Clip(gridBounds_);
+    if (!clippedBox.Defined() || cells_.Empty())
+        return;
+
+    // Drawables may extend up to one cell beyond their cell
+    IntVector2 minCell = GetCell(clippedBox.min_) - IntVector2::ONE;
+    IntVector2 maxCell = GetCell(clippedBox.max_) + IntVector2::ONE;
+
+    // When the range covers more cells than exist, go through the existing cells instead
+    if ((long long)(maxCell.x_ - minCell.x_ + 1) * (maxCell.y_ - minCell.y_ + 1) > (long long)cells_.Size())
+    {
+        for (HashMap<IntVector2, PODVector<Drawable2D*> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            if (i->first_.x_ >= minCell.x_ && i->first_.x_ <= maxCell.x_ && i->first_.y_ >= minCell.y_ &&
+                i->first_.y_ <= maxCell.y_)
+                dest.Push(i->second_);
+        }
+    }
+    else
+    {
+        for (int y = minCell.y_; y <= maxCell.y_; ++y)
+        {
+            for (int x = minCell.x_; x <= maxCell.x_; ++x)
+            {
+                HashMap<IntVector2, PODVector<Drawable2D*> >::ConstIterator i = cells_.Find(IntVector2(x, y));
+                if (i != cells_.End())
+                    dest.Push(i->second_);
+            }
+        }
+    }
+}
+
+IntVector2 Renderer2D::GetCell(const Vector3& position) const
+{
+    return IntVector2(FloorToInt(position.x_ / cellSize_), FloorToInt(position.y_ / cellSize_));
+}
+
 static inline bool CompareSourceBatch2Ds(const SourceBatch2D* lhs, const SourceBatch2D* rhs)
 {
     if (lhs->distance_ != rhs->distance_)
@@ -426,12 +692,12 @@ void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* cam
 
     PODVector<const SourceBatch2D*>& sourceBatches = viewBatchInfo.sourceBatches_;
     sourceBatches.Clear();
-    for (unsigned d = 0; d < drawables_.Size(); ++d)
+    for (unsigned d = 0; d < viewDrawables_.Size(); ++d)
     {
-        if (!drawables_[d]->IsInView(camera))
+        if (!viewDrawables_[d]->IsInView(camera))
             continue;
 
-        const Vector<SourceBatch2D>& batches = drawables_[d]->GetSourceBatches();
+        const Vector<SourceBatch2D>& batches = viewDrawables_[d]->GetSourceBatches();
         for (unsigned b = 0; b < batches.Size(); ++b)
         {
             if (batches[b].material_ && !batches[b].vertices_.Empty())
@@ -446,7 +712,9 @@ void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* cam
         sourceBatch->distance_ = camera->GetDistance(worldPos);
     }
     
-    Sort(sourceBatches.Begin(), sourceBatches.End(), CompareSourceBatch2Ds);
+    sourceBatchSortTemp_.Resize(sourceBatches.Size());
+    ParallelSort(GetSubsystem<WorkQueue>(), sourceBatches.Begin(), sourceBatches.End(), sourceBatchSortTemp_.Begin(),
+        CompareSourceBatch2Ds);
 
     viewBatchInfo.batchCount_ = 0;
     Material* currMaterial = nullptr;
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
 #include "../Math/Frustum.h"
 
@@ -31,7 +32,9 @@ namespace Urho3D
 class Drawable2D;
 class IndexBuffer;
 class Material;
+class OctreeQuery;
 class Technique;
+class Texture2D;
 class VertexBuffer;
 struct FrameInfo;
 struct SourceBatch2D;
@@ -64,7 +67,7 @@ struct ViewBatchInfo2D
     Vector<SharedPtr<Geometry> > geometries_;
 };
 
-/// 2D renderer component.
+/// 2D renderer component. Keeps the Drawable2D's in a loose grid spatial index on the XY plane for visibility and ray queries.
 class URHO3D_API Renderer2D : public Drawable
 {
     URHO3D_OBJECT(Renderer2D, Drawable);
@@ -92,9 +95,18 @@ public:
     void AddDrawable(Drawable2D* drawable);
     /// Remove Drawable2D.
     void RemoveDrawable(Drawable2D* drawable);
+    /// Queue a Drawable2D for spatial index update after its bounding box changed.
+    void QueueUpdate(Drawable2D* drawable);
+    /// Set spatial index cell size. Drawables larger than twice the cell size are tested individually.
+    void SetCellSize(float size);
     /// Return material by texture and blend mode.
     Material* GetMaterial(Texture2D* texture, BlendMode blendMode);
 
+    /// Return spatial index cell size.
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return Drawable2D's with a custom query.
+    void GetDrawables(OctreeQuery& query);
     /// Check visibility.
     bool CheckVisibility(Drawable2D* drawable) const;
 
@@ -107,6 +119,14 @@ private:
     void HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData);
     /// Get all drawables in node.
     void GetDrawables(PODVector<Drawable2D*>& drawables, Node* node);
+    /// Process queued spatial index updates.
+    void UpdateSpatialIndex();
+    /// Remove drawable from its spatial index cell.
+    void RemoveFromCell(Drawable2D* drawable);
+    /// Return drawables from the spatial index cells that may intersect a world bounding box, and all large drawables.
+    void GetCellDrawables(PODVector<Drawable2D*>& dest, const BoundingBox& box) const;
+    /// Return spatial index cell containing a position.
+    IntVector2 GetCell(const Vector3& position) const;
     /// Update view batch info.
     void UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* camera);
     /// Add view batch.
@@ -117,12 +137,28 @@ private:
     SharedPtr<IndexBuffer> indexBuffer_;
     /// Material.
     SharedPtr<Material> material_;
-    /// Drawables.
-    PODVector<Drawable2D*> drawables_;
+    /// Drawables in the spatial index cells intersecting the current view.
+    PODVector<Drawable2D*> viewDrawables_;
+    /// Spatial index cells.
+    HashMap<IntVector2, PODVector<Drawable2D*> > cells_;
+    /// Drawables too large for a cell or without a bounding box, tested individually.
+    PODVector<Drawable2D*> largeDrawables_;
+    /// Drawables queued for spatial index update.
+    PODVector<Drawable2D*> drawableUpdates_;
+    /// Drawables queued for spatial index update during threaded scene update.
+    PODVector<Drawable2D*> threadedDrawableUpdates_;
+    /// Mutex for threaded spatial index update queuing.
+    Mutex updateMutex_;
+    /// Bounds of all drawables inserted into cells. Only grows.
+    BoundingBox gridBounds_;
+    /// Spatial index cell size.
+    float cellSize_;
     /// View frame info for current frame.
     FrameInfo frame_;
     /// View batch info.
     HashMap<Camera*, ViewBatchInfo2D> viewBatchInfos_;
+    /// Temporary buffer for sorting source batches.
+    PODVector<const SourceBatch2D*> sourceBatchSortTemp_;
     /// Frustum for current frame.
     Frustum frustum_;
     /// View mask of current camera for visibility checking.
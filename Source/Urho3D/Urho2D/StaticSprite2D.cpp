@@ -103,6 +103,7 @@ void StaticSprite2D::SetDrawRect(const Rect& rect)
     if(useDrawRect_)
     {
         sourceBatchesDirty_ = true;
+        MarkBoundingBoxDirty();
     }
 }
 
@@ -355,6 +356,8 @@ void StaticSprite2D::UpdateMaterial()
 
 void StaticSprite2D::UpdateDrawRect()
 {
+    MarkBoundingBoxDirty();
+
     if (!useDrawRect_)
     {
         if (useHotSpot_)
@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Texture2D.h"
+#include "../Scene/Node.h"
+#include "../Urho2D/Renderer2D.h"
+#include "../Urho2D/Sprite2D.h"
+#include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
+#include "../Urho2D/TileMapLayer2D.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Maximum draw order offset between source batches of a chunk, limited by the bits below order in layer.
+static const int MAX_BATCH_ORDER_OFFSET = (1 << 10) - 1;
+
+TileMapChunk2D::TileMapChunk2D(Context* context) :
+    Drawable2D(context),
+    tileRect_(IntRect::ZERO),
+    framesOutOfView_(0)
+{
+}
+
+TileMapChunk2D::~TileMapChunk2D()
+{
+}
+
+void TileMapChunk2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<TileMapChunk2D>();
+}
+
+void TileMapChunk2D::Initialize(TileMapLayer2D* layer, const IntRect& tileRect)
+{
+    layer_ = layer;
+    tileRect_ = tileRect;
+
+    MarkTilesDirty();
+}
+
+void TileMapChunk2D::MarkTilesDirty()
+{
+    UpdateLocalBoundingBox();
+    OnMarkedDirty(node_);
+}
+
+void TileMapChunk2D::ReleaseVertices()
+{
+    sourceBatches_.Clear();
+    sourceBatchesDirty_ = true;
+}
+
+TileMapLayer2D* TileMapChunk2D::GetLayer() const
+{
+    return layer_;
+}
+
+void TileMapChunk2D::OnWorldBoundingBoxUpdate()
+{
+    // Use the tile bounds instead of vertex data, so that visibility can be tested without building the vertices
+    if (boundingBox_.Defined())
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    else
+        worldBoundingBox_.Clear();
+}
+
+void TileMapChunk2D::OnDrawOrderChanged()
+{
+    // Batches are in tile order, offset their draw order so that tiles with different materials keep sorting correctly
+    int drawOrder = GetDrawOrder();
+    for (unsigned i = 0; i < sourceBatches_.Size(); ++i)
+        sourceBatches_[i].drawOrder_ = drawOrder + Min((int)i, MAX_BATCH_ORDER_OFFSET);
+}
+
+void TileMapChunk2D::UpdateSourceBatches()
+{
+    if (!sourceBatchesDirty_)
+        return;
+
+    sourceBatches_.Clear();
+    sourceBatchesDirty_ = false;
+
+    if (!layer_ || !renderer_ || !layer_->GetTileMap())
+        return;
+
+    const TileMapInfo2D& info = layer_->GetTileMap()->GetInfo();
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    unsigned color = Color::WHITE.ToUInt();
+
+    Rect drawRect;
+    Rect textureRect;
+    Vertex2D vertex0;
+    Vertex2D vertex1;
+    Vertex2D vertex2;
+    Vertex2D vertex3;
+    vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ = color;
+
+    SourceBatch2D* batch = nullptr;
+
+    for (int y = tileRect_.top_; y < tileRect_.bottom_; ++y)
+    {
+        for (int x = tileRect_.left_; x < tileRect_.right_; ++x)
+        {
+            Sprite2D* sprite = layer_->GetTileSprite(x, y);
+            if (!sprite || !sprite->GetDrawRectangle(drawRect, false, false) ||
+                !sprite->GetTextureRectangle(textureRect, false, false))
+                continue;
+
+            // Start a new batch whenever the material changes, so that the original tile order is preserved
+            Material* material = renderer_->GetMaterial(sprite->GetTexture(), BLEND_ALPHA);
+            if (!batch || batch->material_ != material)
+            {
+                sourceBatches_.Resize(sourceBatches_.Size() + 1);
+                batch = &sourceBatches_.Back();
+                batch->owner_ = this;
+                batch->material_ = material;
+                // Usually all tiles of a chunk share one tileset
+                if (sourceBatches_.Size() == 1)
+                    batch->vertices_.Reserve((unsigned)(tileRect_.Width() * tileRect_.Height() * 4));
+            }
+
+            Vector2 position = info.TileIndexToPosition(x, y);
+            drawRect.min_ += position;
+            drawRect.max_ += position;
+
+            vertex0.position_ = worldTransform * Vector3(drawRect.min_.x_, drawRect.min_.y_, 0.0f);
+            vertex1.position_ = worldTransform * Vector3(drawRect.min_.x_, drawRect.max_.y_, 0.0f);
+            vertex2.position_ = worldTransform * Vector3(drawRect.max_.x_, drawRect.max_.y_, 0.0f);
+            vertex3.position_ = worldTransform * Vector3(drawRect.max_.x_, drawRect.min_.y_, 0.0f);
+
+            vertex0.uv_ = textureRect.min_;
+            vertex1.uv_ = Vector2(textureRect.min_.x_, textureRect.max_.y_);
+            vertex2.uv_ = textureRect.max_;
+            vertex3.uv_ = Vector2(textureRect.max_.x_, textureRect.min_.y_);
+
+            batch->vertices_.Push(vertex0);
+            batch->vertices_.Push(vertex1);
+            batch->vertices_.Push(vertex2);
+            batch->vertices_.Push(vertex3);
+        }
+    }
+
+    OnDrawOrderChanged();
+}
+
+void TileMapChunk2D::UpdateLocalBoundingBox()
+{
+    boundingBox_.Clear();
+
+    if (!layer_ || !layer_->GetTileMap())
+        return;
+
+    const TileMapInfo2D& info = layer_->GetTileMap()->GetInfo();
+    Rect drawRect;
+
+    for (int y = tileRect_.top_; y < tileRect_.bottom_; ++y)
+    {
+        for (int x = tileRect_.left_; x < tileRect_.right_; ++x)
+        {
+            Sprite2D* sprite = layer_->GetTileSprite(x, y);
+            if (!sprite || !sprite->GetDrawRectangle(drawRect, false, false))
+                continue;
+
+            Vector2 position = info.TileIndexToPosition(x, y);
+            boundingBox_.Merge(Vector3(drawRect.min_ + position));
+            boundingBox_.Merge(Vector3(drawRect.max_ + position));
+        }
+    }
+}
+
+}
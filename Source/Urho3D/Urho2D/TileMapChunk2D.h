@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Urho2D/Drawable2D.h"
+
+namespace Urho3D
+{
+
+class TileMapLayer2D;
+
+/// Drawable for a rectangular block of tiles in a tile map layer. Builds the vertices of all its tiles on demand, batched by material. Created by TileMapLayer2D.
+class URHO3D_API TileMapChunk2D : public Drawable2D
+{
+    URHO3D_OBJECT(TileMapChunk2D, Drawable2D);
+
+public:
+    /// Construct.
+    TileMapChunk2D(Context* context);
+    /// Destruct.
+    virtual ~TileMapChunk2D() override;
+    /// Register object factory. Drawable2D must be registered first.
+    static void RegisterObject(Context* context);
+
+    /// Initialize with tile map layer and the range of tiles covered. The range is exclusive of right and bottom.
+    void Initialize(TileMapLayer2D* layer, const IntRect& tileRect);
+    /// Mark tiles changed. Recalculates the bounding box and rebuilds vertices when next drawn.
+    void MarkTilesDirty();
+    /// Release vertex data. It is rebuilt when the chunk is next drawn.
+    void ReleaseVertices();
+
+    /// Return tile map layer.
+    TileMapLayer2D* GetLayer() const;
+
+    /// Return range of tiles covered.
+    const IntRect& GetTileRect() const { return tileRect_; }
+
+    /// Return whether vertex data currently exists.
+    bool HasVertices() const { return !sourceBatches_.Empty(); }
+
+    /// Return number of consecutive frames the chunk has not been in view. Updated by TileMapLayer2D.
+    unsigned GetFramesOutOfView() const { return framesOutOfView_; }
+
+    /// Set number of consecutive frames the chunk has not been in view. Called by TileMapLayer2D.
+    void SetFramesOutOfView(unsigned frames) { framesOutOfView_ = frames; }
+
+protected:
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate() override;
+    /// Handle draw order changed.
+    virtual void OnDrawOrderChanged() override;
+    /// Update source batches.
+    virtual void UpdateSourceBatches() override;
+
+private:
+    /// Recalculate the local bounding box from tile positions and sprite sizes.
+    void UpdateLocalBoundingBox();
+
+    /// Tile map layer.
+    WeakPtr<TileMapLayer2D> layer_;
+    /// Range of tiles covered.
+    IntRect tileRect_;
+    /// Consecutive frames not in view.
+    unsigned framesOutOfView_;
+};
+
+}
@@ -26,8 +26,13 @@
 #include "../Graphics/DebugRenderer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+#include "../Urho2D/Renderer2D.h"
+#include "../Urho2D/Sprite2D.h"
 #include "../Urho2D/StaticSprite2D.h"
 #include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
 #include "../Urho2D/TileMapLayer2D.h"
 #include "../Urho2D/TmxFile2D.h"
 
@@ -36,11 +41,21 @@
 namespace Urho3D
 {
 
+/// Maximum number of tiles per side of a tile layer chunk.
+static const int TILE_CHUNK_SIZE = 32;
+/// Number of frames a chunk may stay out of view before its vertex data is released.
+static const unsigned CHUNK_RELEASE_FRAMES = 60;
+
 TileMapLayer2D::TileMapLayer2D(Context* context) :
     Component(context),
     tmxLayer_(nullptr),
+    tileLayer_(nullptr),
+    objectGroup_(nullptr),
+    imageLayer_(nullptr),
     drawOrder_(0),
-    visible_(true)
+    visible_(true),
+    numChunksX_(0),
+    chunkSize_(TILE_CHUNK_SIZE, TILE_CHUNK_SIZE)
 {
 }
 
@@ -183,6 +198,16 @@ void TileMapLayer2D::Initialize(TileMap2D* tileMap, const TmxLayer2D* tmxLayer)
         }
 
         nodes_.Clear();
+
+        for (unsigned i = 0; i < chunks_.Size(); ++i)
+        {
+            if (chunks_[i])
+                chunks_[i]->Remove();
+        }
+
+        chunks_.Clear();
+        tileSprites_.Clear();
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
     }
 
     tileLayer_ = nullptr;
@@ -232,6 +257,12 @@ void TileMapLayer2D::SetDrawOrder(int drawOrder)
         if (staticSprite)
             staticSprite->SetLayer(drawOrder_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+    {
+        if (chunks_[i])
+            chunks_[i]->SetLayer(drawOrder_);
+    }
 }
 
 void TileMapLayer2D::SetVisible(bool visible)
@@ -246,6 +277,27 @@ void TileMapLayer2D::SetVisible(bool visible)
         if (nodes_[i])
             nodes_[i]->SetEnabled(visible_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+    {
+        if (chunks_[i])
+            chunks_[i]->SetEnabled(visible_);
+    }
+}
+
+void TileMapLayer2D::SetTileSprite(int x, int y, Sprite2D* sprite)
+{
+    if (!tileLayer_)
+        return;
+
+    if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
+        return;
+
+    tileSprites_[(unsigned)(y * tileLayer_->GetWidth() + x)] = sprite;
+
+    TileMapChunk2D* chunk = GetChunk(x, y, sprite != nullptr);
+    if (chunk)
+        chunk->MarkTilesDirty();
 }
 
 TileMap2D* TileMapLayer2D::GetTileMap() const
@@ -291,7 +343,7 @@ Tile2D* TileMapLayer2D::GetTile(int x, int y) const
     return tileLayer_->GetTile(x, y);
 }
 
-Node* TileMapLayer2D::GetTileNode(int x, int y) const
+Sprite2D* TileMapLayer2D::GetTileSprite(int x, int y) const
 {
     if (!tileLayer_)
         return nullptr;
@@ -299,7 +351,20 @@ Node* TileMapLayer2D::GetTileNode(int x, int y) const
     if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
         return nullptr;
 
-    return nodes_[y * tileLayer_->GetWidth() + x];
+    if (!tileSprites_.Empty())
+    {
+        HashMap<unsigned, SharedPtr<Sprite2D> >::ConstIterator i = tileSprites_.Find((unsigned)(y * tileLayer_->GetWidth() + x));
+        if (i != tileSprites_.End())
+            return i->second_;
+    }
+
+    const Tile2D* tile = tileLayer_->GetTile(x, y);
+    return tile ? tile->GetSprite() : nullptr;
+}
+
+Node* TileMapLayer2D::GetTileNode(int x, int y) const
+{
+    return nullptr;
 }
 
 unsigned TileMapLayer2D::GetNumObjects() const
@@ -343,26 +408,90 @@ void TileMapLayer2D::SetTileLayer(const TmxTileLayer2D* tileLayer)
 
     int width = tileLayer->GetWidth();
     int height = tileLayer->GetHeight();
-    nodes_.Resize((unsigned)(width * height));
 
-    const TileMapInfo2D& info = tileMap_->GetInfo();
+    // Keep chunks within one cell of the 2D renderer's spatial grid, so that they are culled through the grid instead of
+    // being tested as large drawables. The rest of the allowed size is left for sprites extending beyond their tile
+    chunkSize_ = IntVector2(TILE_CHUNK_SIZE, TILE_CHUNK_SIZE);
+    Scene* scene = GetScene();
+    if (scene && tileMap_)
+    {
+        const TileMapInfo2D& info = tileMap_->GetInfo();
+        float cellSize = scene->GetOrCreateComponent<Renderer2D>()->GetCellSize();
+        Vector3 scale = GetNode()->GetWorldScale().Abs();
+        if (info.tileWidth_ * scale.x_ > 0.0f)
+            chunkSize_.x_ = Clamp(FloorToInt(cellSize / (info.tileWidth_ * scale.x_)), 1, TILE_CHUNK_SIZE);
+        if (info.tileHeight_ * scale.y_ > 0.0f)
+            chunkSize_.y_ = Clamp(FloorToInt(cellSize / (info.tileHeight_ * scale.y_)), 1, TILE_CHUNK_SIZE);
+    }
+
+    numChunksX_ = (width + chunkSize_.x_ - 1) / chunkSize_.x_;
+    int numChunksY = (height + chunkSize_.y_ - 1) / chunkSize_.y_;
+    chunks_.Resize((unsigned)(numChunksX_ * numChunksY));
+
+    // Draw tiles in chunks instead of a node per tile. Chunks without tiles are created on demand
     for (int y = 0; y < height; ++y)
     {
         for (int x = 0; x < width; ++x)
         {
-            const Tile2D* tile = tileLayer->GetTile(x, y);
-            if (!tile)
-                continue;
+            if (tileLayer->GetTile(x, y))
+                GetChunk(x, y, true);
+        }
+    }
 
-            SharedPtr<Node> tileNode(GetNode()->CreateTemporaryChild("Tile"));
-            tileNode->SetPosition(info.TileIndexToPosition(x, y));
+    if (GetScene())
+        SubscribeToEvent(GetScene(), E_SCENEPOSTUPDATE, URHO3D_HANDLER(TileMapLayer2D, HandleScenePostUpdate));
+}
 
-            StaticSprite2D* staticSprite = tileNode->CreateComponent<StaticSprite2D>();
-            staticSprite->SetSprite(tile->GetSprite());
-            staticSprite->SetLayer(drawOrder_);
-            staticSprite->SetOrderInLayer(y * width + x);
+TileMapChunk2D* TileMapLayer2D::GetChunk(int x, int y, bool create)
+{
+    int chunkX = x / chunkSize_.x_;
+    int chunkY = y / chunkSize_.y_;
+    SharedPtr<TileMapChunk2D>& chunk = chunks_[chunkY * numChunksX_ + chunkX];
+    if (chunk || !create)
+        return chunk;
+
+    IntRect tileRect(chunkX * chunkSize_.x_, chunkY * chunkSize_.y_, 0, 0);
+    tileRect.right_ = Min(tileRect.left_ + chunkSize_.x_, tileLayer_->GetWidth());
+    tileRect.bottom_ = Min(tileRect.top_ + chunkSize_.y_, tileLayer_->GetHeight());
+
+    chunk = GetNode()->CreateComponent<TileMapChunk2D>(LOCAL);
+    chunk->SetTemporary(true);
+    chunk->Initialize(this, tileRect);
+    chunk->SetLayer(drawOrder_);
+    chunk->SetOrderInLayer(chunkY * numChunksX_ + chunkX);
+    chunk->SetEnabled(visible_);
+
+    return chunk;
+}
+
+void TileMapLayer2D::OnSceneSet(Scene* scene)
+{
+    if (scene && tileLayer_)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(TileMapLayer2D, HandleScenePostUpdate));
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void TileMapLayer2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // Chunks build their vertices again when they come back into view
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+    {
+        TileMapChunk2D* chunk = chunks_[i];
+        if (!chunk || !chunk->HasVertices())
+            continue;
 
-            nodes_[y * width + x] = tileNode;
+        if (chunk->IsInView())
+            chunk->SetFramesOutOfView(0);
+        else
+        {
+            unsigned frames = chunk->GetFramesOutOfView() + 1;
+            chunk->SetFramesOutOfView(frames);
+            if (frames > CHUNK_RELEASE_FRAMES)
+            {
+                chunk->ReleaseVertices();
+                chunk->SetFramesOutOfView(0);
+            }
         }
     }
 }
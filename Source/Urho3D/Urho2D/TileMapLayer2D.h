@@ -34,7 +34,9 @@ namespace Urho3D
 
 class DebugRenderer;
 class Node;
+class Sprite2D;
 class TileMap2D;
+class TileMapChunk2D;
 class TmxImageLayer2D;
 class TmxLayer2D;
 class TmxObjectGroup2D;
@@ -62,6 +64,8 @@ public:
     void SetDrawOrder(int drawOrder);
     /// Set visible.
     void SetVisible(bool visible);
+    /// Set sprite drawn for a tile, overriding the tmx tile's sprite. Null hides the tile (for tile layer only).
+    void SetTileSprite(int x, int y, Sprite2D* sprite);
 
     /// Return tile map.
     TileMap2D* GetTileMap() const;
@@ -86,10 +90,12 @@ public:
     int GetWidth() const;
     /// Return height (for tile layer only).
     int GetHeight() const;
-    /// Return tile node (for tile layer only).
+    /// Return tile node. Tile layers are drawn in chunks without per-tile nodes, so this always returns null; use SetTileSprite() to change tiles.
     Node* GetTileNode(int x, int y) const;
     /// Return tile (for tile layer only).
     Tile2D* GetTile(int x, int y) const;
+    /// Return sprite drawn for a tile, including overrides (for tile layer only).
+    Sprite2D* GetTileSprite(int x, int y) const;
 
     /// Return number of tile map objects (for object group only).
     unsigned GetNumObjects() const;
@@ -101,9 +107,17 @@ public:
     /// Return image node (for image layer only).
     Node* GetImageNode() const;
 
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene) override;
+
 private:
     /// Set tile layer.
     void SetTileLayer(const TmxTileLayer2D* tileLayer);
+    /// Return chunk containing a tile, optionally creating it.
+    TileMapChunk2D* GetChunk(int x, int y, bool create);
+    /// Handle scene post-update event. Release vertex data of chunks that have been out of view for long.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
     /// Set object group.
     void SetObjectGroup(const TmxObjectGroup2D* objectGroup);
     /// Set image layer.
@@ -123,8 +137,16 @@ private:
     int drawOrder_;
     /// Visible.
     bool visible_;
-    /// Tile node or image nodes.
+    /// Object nodes or image node.
     Vector<SharedPtr<Node> > nodes_;
+    /// Tile chunks in row-major order, null where a chunk has no tiles (for tile layer only).
+    Vector<SharedPtr<TileMapChunk2D> > chunks_;
+    /// Number of chunks horizontally.
+    int numChunksX_;
+    /// Number of tiles per side of a chunk.
+    IntVector2 chunkSize_;
+    /// Tile sprite overrides by tile index.
+    HashMap<unsigned, SharedPtr<Sprite2D> > tileSprites_;
 };
 
 }
@@ -150,13 +150,7 @@ bool TmxTileLayer2D::Load(const XMLElement& element, const TileMapInfo2D& info)
 
                 int gid = tileElem.GetInt("gid");
                 if (gid > 0)
-                {
-                    SharedPtr<Tile2D> tile(new Tile2D());
-                    tile->gid_ = gid;
-                    tile->sprite_ = tmxFile_->GetTileSprite(gid);
-                    tile->propertySet_ = tmxFile_->GetTilePropertySet(gid);
-                    tiles_[y * width_ + x] = tile;
-                }
+                    tiles_[y * width_ + x] = GetOrCreateTile(gid);
 
                 tileElem = tileElem.GetNext("tile");
             }
@@ -174,13 +168,7 @@ bool TmxTileLayer2D::Load(const XMLElement& element, const TileMapInfo2D& info)
                 gidVector[currentIndex].Replace("\n", "");
                 int gid = ToInt(gidVector[currentIndex]);
                 if (gid > 0)
-                {
-                    SharedPtr<Tile2D> tile(new Tile2D());
-                    tile->gid_ = gid;
-                    tile->sprite_ = tmxFile_->GetTileSprite(gid);
-                    tile->propertySet_ = tmxFile_->GetTilePropertySet(gid);
-                    tiles_[y * width_ + x] = tile;
-                }
+                    tiles_[y * width_ + x] = GetOrCreateTile(gid);
                 ++currentIndex;
             }
         }
@@ -202,18 +190,14 @@ bool TmxTileLayer2D::Load(const XMLElement& element, const TileMapInfo2D& info)
                 int gid = (buffer[currentIndex+3] << 24) | (buffer[currentIndex+2] << 16)
                         | (buffer[currentIndex+1] << 8) | buffer[currentIndex];
                 if (gid > 0)
-                {
-                    SharedPtr<Tile2D> tile(new Tile2D());
-                    tile->gid_ = gid;
-                    tile->sprite_ = tmxFile_->GetTileSprite(gid);
-                    tile->propertySet_ = tmxFile_->GetTilePropertySet(gid);
-                    tiles_[y * width_ + x] = tile;
-                }
+                    tiles_[y * width_ + x] = GetOrCreateTile(gid);
                 currentIndex += 4;
             }
         }
     }
 
+    gidTiles_.Clear();
+
     if (element.HasChild("properties"))
         LoadPropertySet(element.GetChild("properties"));
 
@@ -228,6 +212,22 @@ Tile2D* TmxTileLayer2D::GetTile(int x, int y) const
     return tiles_[y * width_ + x];
 }
 
+Tile2D* TmxTileLayer2D::GetOrCreateTile(int gid)
+{
+    // Tile data depends only on the gid, so cells with the same gid share one tile
+    HashMap<int, SharedPtr<Tile2D> >::Iterator i = gidTiles_.Find(gid);
+    if (i != gidTiles_.End())
+        return i->second_;
+
+    SharedPtr<Tile2D> tile(new Tile2D());
+    tile->gid_ = gid;
+    tile->sprite_ = tmxFile_->GetTileSprite(gid);
+    tile->propertySet_ = tmxFile_->GetTilePropertySet(gid);
+    gidTiles_[gid] = tile;
+
+    return tile;
+}
+
 TmxObjectGroup2D::TmxObjectGroup2D(TmxFile2D* tmxFile) :
     TmxLayer2D(tmxFile, LT_OBJECT_GROUP)
 {
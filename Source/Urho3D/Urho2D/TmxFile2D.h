@@ -99,8 +99,13 @@ public:
     Tile2D* GetTile(int x, int y) const;
 
 protected:
+    /// Return tile for gid, shared between all cells with the same gid during load.
+    Tile2D* GetOrCreateTile(int gid);
+
     /// Tiles.
     Vector<SharedPtr<Tile2D> > tiles_;
+    /// Tiles by gid while loading.
+    HashMap<int, SharedPtr<Tile2D> > gidTiles_;
 };
 
 /// Tmx objects layer.